@@ -0,0 +1,38 @@
+# Compile model
+#
+# Packs the trees of a fitted model into flat arrays held on the C++ side,
+# so that predictions do not convert the tree lists on every call.
+#
+# @usage compile_gbm_fit(gbm_fit_obj)
+#
+# @param gbm_fit_obj a \code{GBMFit} object.
+#
+# @return gbm_fit_obj holding an external pointer to the compiled model in
+# \code{compiled_model}.
+#
+
+compile_gbm_fit <- function(gbm_fit_obj) {
+  gbm_fit_obj$compiled_model <- .Call("gbm_compile_model",
+                                      trees=gbm_fit_obj$trees,
+                                      c.split=gbm_fit_obj$c.splits,
+                                      var.type=as.integer(gbm_fit_obj$variables$var_type),
+                                      PACKAGE = "gbm")
+  return(gbm_fit_obj)
+}
+
+# Has compiled model
+#
+# Checks whether a fitted model holds a compiled model that can still be
+# used - external pointers do not survive saving and reloading.
+#
+# @usage has_compiled_model(gbm_fit_obj)
+#
+# @param gbm_fit_obj a \code{GBMFit} object.
+#
+# @return TRUE if the compiled model can be used, FALSE otherwise.
+#
+
+has_compiled_model <- function(gbm_fit_obj) {
+  !is.null(gbm_fit_obj$compiled_model) &&
+    .Call("gbm_compiled_model_valid", gbm_fit_obj$compiled_model, PACKAGE = "gbm")
+}
@@ -2,7 +2,8 @@
 # 
 # Extract the relevant observations to fit a CV fold - reorders appropriately.
 # 
-# @usage extract_obs_in_fold(gbm_data_obj, gbm_dist_obj, train_params, cv_groups, fold_num, is_verbose)
+# @usage extract_obs_in_fold(gbm_data_obj, gbm_dist_obj, train_params, cv_groups, fold_num,
+#  par_details=gbmParallel())
 # 
 # @param gbm_data_obj a GBMData object containing all of the data used to fit a gbm model. 
 # 
@@ -15,12 +16,14 @@
 # 
 # @param fold_num integer (>=1) specifying which fold under consideration.
 #
-# @param is_verbose if TRUE, will print out progress and performance of the fitting.
+# @param par_details Details of the parallelization to use in the
+#     core algorithm.
 # 
 # @return list of input gbm objects updated so cross_validated data is ready for gbm_call
 # 
 
-extract_obs_in_fold <- function(gbm_data_obj, gbm_dist_obj, train_params, cv_groups, fold_num) {
+extract_obs_in_fold <- function(gbm_data_obj, gbm_dist_obj, train_params, cv_groups, fold_num,
+                                par_details=gbmParallel()) {
   # Observations in the training set
   obs_in_training_set <- train_params$id %in% as.integer(names(train_params$num_rows_per_obs[seq_len(train_params$num_train)]))
   train_params$id <- train_params$id[obs_in_training_set]
@@ -33,11 +36,18 @@ extract_obs_in_fold <- function(gbm_data_obj, gbm_dist_obj, train_params, cv_gro
   train_params$num_train <- length(unique(train_params$id[!obs_id_in_cv_group]))
   train_params$num_train_rows <- length(train_params$id[!obs_id_in_cv_group])
 
-  gbm_data_obj <- split_and_join(gbm_data_obj, train_params, obs_in_training_set, obs_id_in_cv_group)
-  gbm_dist_obj <- update_fold_dist_data(gbm_dist_obj, gbm_data_obj, train_params, obs_in_training_set, obs_id_in_cv_group)
+  fold_data_obj <- split_and_join(gbm_data_obj, train_params, obs_in_training_set, obs_id_in_cv_group)
+  gbm_dist_obj <- update_fold_dist_data(gbm_dist_obj, fold_data_obj, train_params, obs_in_training_set, obs_id_in_cv_group)
   
   # NB: Update train_params id afterwards
   train_params$id <- train_params$id[!obs_id_in_cv_group]
   
+  # Fold's prepared data are taken from those of the full training set
+  if(has_prepared_data(gbm_data_obj)) {
+    fold_data_obj <- prepare_fold_data(fold_data_obj, gbm_data_obj$prepared, gbm_dist_obj, train_params,
+                                       obs_in_training_set, obs_id_in_cv_group, par_details)
+  }
+  gbm_data_obj <- fold_data_obj
+  
   return(list("data"=gbm_data_obj, "dist"=gbm_dist_obj, "params"=train_params))
 }
@@ -46,13 +46,22 @@ gbm_call <- function(gbm_data_obj, gbm_dist_obj, train_params, var_container, pa
       y_input <- as.integer(gbm_data_obj$y[,1])
   }
 
+  # Prepared data already hold the converted predictors, their order,
+  # the strata and the ids
+  if(has_prepared_data(gbm_data_obj)) {
+    x_input <- gbm_data_obj$prepared
+    x_order_input <- integer(0)
+  } else {
+    x_input <- as.matrix(as.data.frame(gbm_data_obj$x))
+    x_order_input <- as.integer(gbm_data_obj$x_order)
+  }
   
   fit <- .Call("gbm",
                 Y=as.matrix(as.data.frame(y_input)),
                 intResponse = as.matrix(cbind(gbm_dist_obj$strata, gbm_dist_obj$sorted)),
                 Offset=as.double(gbm_data_obj$offset),
-                X=as.matrix(as.data.frame(gbm_data_obj$x)),
-                X.order=as.integer(gbm_data_obj$x_order),
+                X=x_input,
+                X.order=x_order_input,
                 weights=as.double(gbm_data_obj$weights),
                 Misc=get_misc(gbm_dist_obj),
                 prior.node.coeff.var = ifelse(is.null(gbm_dist_obj$prior_node_coeff_var), as.double(0),
@@ -46,12 +46,16 @@ gbm_cross_val <- function(gbm_data_obj, gbm_dist_obj, train_params, var_containe
     return(gbm_results[[1]])
   }
 
+  # Only the full model fit is traced
+  if(!is.null(par_details$trace_file)) par_details$trace_file <- ""
+
   # Loop over folds
   for(fold_num in seq_len(cv_folds)) {
     if(is_verbose) message("CV:", fold_num, "\n")
     
     # Extract observations in cv fold
-    gbm_object_list <- extract_obs_in_fold(gbm_data_obj, gbm_dist_obj, train_params, cv_groups, fold_num)
+    gbm_object_list <- extract_obs_in_fold(gbm_data_obj, gbm_dist_obj, train_params, cv_groups, fold_num,
+                                           par_details)
     
     # Fit to fold
     gbm_results[[length(gbm_results)+1]] <- gbm_call(gbm_object_list$data, gbm_object_list$dist, 
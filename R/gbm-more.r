@@ -78,7 +78,8 @@ gbm_more <- function(gbm_fit_obj, num_new_trees=100, data=NULL, weights=NULL, of
     gbm_data_obj <- validate_gbm_data(gbm_data_obj, distribution)
     
     # Order the data
-    gbm_data_obj <- order_data(gbm_data_obj, distribution, gbm_fit_obj$params)
+    gbm_data_obj <- order_data(gbm_data_obj, distribution, gbm_fit_obj$params,
+                               gbm_fit_obj$par_details)
     
   } else {
     gbm_data_obj <- gbm_fit_obj$gbm_data_obj
@@ -93,13 +94,22 @@ gbm_more <- function(gbm_fit_obj, num_new_trees=100, data=NULL, weights=NULL, of
     gbm_fit_obj$fit <- gbm_fit_obj$fit[gbm_fit_obj$time_order]
   }
 
+  # Reuse the prepared data kept with the fit
+  if(has_prepared_data(gbm_data_obj)) {
+    x_input <- gbm_data_obj$prepared
+    x_order_input <- integer(0)
+  } else {
+    x_input <- as.matrix(as.data.frame(gbm_data_obj$x))
+    x_order_input <- as.integer(gbm_data_obj$x_order)
+  }
+
   # Call GBM package
   gbm_more_fit <- .Call("gbm",
                         Y=as.matrix(as.data.frame(gbm_data_obj$y)),
                         intResponse = as.matrix(cbind(distribution$strata, distribution$sorted)),
                         Offset=as.double(gbm_data_obj$offset),
-                        X=as.matrix(as.data.frame(gbm_data_obj$x)),
-                        X.order=as.integer(gbm_data_obj$x_order),
+                        X=x_input,
+                        X.order=x_order_input,
                         weights=as.double(gbm_data_obj$weights),
                         Misc=get_misc(distribution),
                         prior.node.coeff.var = ifelse(is.null(distribution$prior_node_coeff_var), as.double(0),
@@ -141,6 +151,9 @@ gbm_more <- function(gbm_fit_obj, num_new_trees=100, data=NULL, weights=NULL, of
   gbm_more_fit$oobag.improve <- c(gbm_fit_obj$oobag.improve, gbm_more_fit$oobag.improve)
   gbm_more_fit$trees         <- c(gbm_fit_obj$trees, gbm_more_fit$trees)
   gbm_more_fit$c.splits      <- c(gbm_fit_obj$c.splits, gbm_more_fit$c.splits)
+  if(!is.null(gbm_more_fit$timings)) {
+    gbm_more_fit$timings     <- rbind(gbm_fit_obj$timings, gbm_more_fit$timings)
+  }
   gbm_more_fit$params$num_trees <- length(gbm_more_fit$trees)
     
   # cv_error not updated when using gbm.more
@@ -162,6 +175,9 @@ gbm_more <- function(gbm_fit_obj, num_new_trees=100, data=NULL, weights=NULL, of
   gbm_more_fit$par_details <- gbm_fit_obj$par_details
   gbm_more_fit$call <- the_call
   
+  # Compile the trees for prediction
+  gbm_more_fit <- compile_gbm_fit(gbm_more_fit)
+  
   return(gbm_more_fit)
   
 }
\ No newline at end of file
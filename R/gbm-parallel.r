@@ -5,6 +5,39 @@
 ##' \code{num_threads} to the number of cores on your computer, and set
 ##' \code{array_chunk_size} to a reasonable - not necessarily small -
 ##' size.
+##'
+##' By default the best split of each node is found by an exact search
+##' over the sorted predictor values.  Setting \code{split_search} to
+##' \code{"histogram"} instead quantizes each continuous predictor into
+##' at most \code{num_bins} bins once, before fitting, and searches for
+##' splits over the per-node bin totals.  This is considerably faster on
+##' large data sets at the cost of only considering splits at the bin
+##' boundaries.  Training then runs from one or two byte bin codes
+##' instead of the predictor values and their sort order, which
+##' greatly reduces its memory footprint.  With few predictors the
+##' histogram search also divides the rows of each node into shards
+##' whose totals are built in parallel, so tall, narrow data sets use
+##' all of the threads.  The shards depend only on the rows, so fits
+##' are the same whatever the number of threads.
+##'
+##' Predictions from a fit use its \code{num_threads}, scoring the
+##' rows in blocks of at most \code{array_chunk_size} rows.
+##'
+##' With \code{timings=TRUE} the fit records the seconds spent in
+##' each phase of fitting each tree - the working response, the split
+##' search, reassigning rows to the new nodes, fitting the terminal
+##' nodes, updating the fit, the deviances and converting the tree -
+##' and counts of the rows scanned by the split search, the nodes
+##' searched and the bytes allocated.  These are returned as the data
+##' frame \code{timings} of the fit, a row for each tree.
+##'
+##' Setting \code{trace_file} writes a trace of what each thread does
+##' while fitting - each tree, its phases, the search of each
+##' predictor and the row reassignments - to that file at the end of
+##' the fit.  The file is a Chrome trace, shown as a timeline per thread
+##' by \code{chrome://tracing} or \url{https://ui.perfetto.dev}.  Only
+##' the latest 65536 events of each thread are kept.  Cross-validation
+##' traces the fit to all of the data.
 ##' 
 ##' @param num_threads the number of threads to use (a positive
 ##'     integer).  The number of cores on your computer is a
@@ -12,11 +45,25 @@
 ##' @param array_chunk_size the size of chunks to use in array scans.
 ##'     Values that are too small result in a great deal of overhead;
 ##'     The default of 1024 appears reasonable, but do experiment.
+##' @param split_search the split search algorithm, either
+##'     \code{"exact"} or \code{"histogram"}.
+##' @param num_bins the maximum number of bins per continuous
+##'     predictor used by the histogram split search (between 2 and
+##'     65535).  Ignored by the exact search.
+##' @param timings whether to record the timings of each tree.
+##' @param trace_file the file to write a trace of the fit to, or
+##'     \code{""} for no trace.
 ##' @return an object of type \code{gbmParallel}
 ##' @export
-gbmParallel <- function(num_threads=1, array_chunk_size=1024) {
+gbmParallel <- function(num_threads=1, array_chunk_size=1024,
+                        split_search="exact", num_bins=255,
+                        timings=FALSE, trace_file="") {
     res <- list(num_threads=num_threads,
-                array_chunk_size=array_chunk_size)
+                array_chunk_size=array_chunk_size,
+                split_search=split_search,
+                num_bins=num_bins,
+                timings=timings,
+                trace_file=trace_file)
     class(res) <- "gbmParallel"
     res
 }
@@ -26,6 +73,10 @@ print.gbmParallel <- function(x, ...) {
     cat("GBM parallelization\n\n",
         "number of threads: ", x$num_threads, "\n",
         "array chunk size : ", x$array_chunk_size, "\n",
+        "split search     : ", x$split_search, "\n",
+        "number of bins   : ", x$num_bins, "\n",
+        "record timings   : ", isTRUE(x$timings), "\n",
+        "trace file       : ", x$trace_file, "\n",
         sep="")
     invisible(x)
 }
@@ -114,14 +114,26 @@ predict.GBMFit <- function(gbm_fit_obj, new_data, num_trees,
     gbm_fit_obj$num.classes <- 1
   }
   
+  # Use the compiled trees when they are available
+  if(has_compiled_model(gbm_fit_obj)) {
+    trees <- gbm_fit_obj$compiled_model
+  } else {
+    trees <- gbm_fit_obj$trees
+  }
+  
+  # Score with the fit's threads - fold fits and older objects have none
+  par_details <- gbm_fit_obj$par_details
+  if(is.null(par_details)) par_details <- getOption('gbm.parallel', gbmParallel())
+  
   predF <- .Call("gbm_pred",
                  X=as.matrix(as.data.frame(x)),
                  n.trees=as.integer(num_trees[order(num_trees)]),
                  initF=gbm_fit_obj$initF,
-                 trees=gbm_fit_obj$trees,
+                 trees=trees,
                  c.split=gbm_fit_obj$c.split,
                  var.type=as.integer(gbm_fit_obj$variables$var_type),
                  single.tree = as.integer(single_tree),
+                 par_details,
                  PACKAGE = "gbm")
   
   # Convert into matrix of predictions
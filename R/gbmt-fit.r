@@ -83,7 +83,7 @@ gbmt_fit <- function(x, y, distribution=gbm_dist("Gaussian"), weights=rep(1, nro
   gbm_data_obj <- validate_gbm_data(gbm_data_obj, distribution)
   
   # Order the data
-  gbm_data_obj <- order_data(gbm_data_obj, distribution, train_params)
+  gbm_data_obj <- order_data(gbm_data_obj, distribution, train_params, par_details)
   
   # Order ids according to group_order if necessary
   if(!is.null(distribution$group_order)) {
@@ -91,6 +91,10 @@ gbmt_fit <- function(x, y, distribution=gbm_dist("Gaussian"), weights=rep(1, nro
   } 
   train_params$id <- train_params$id[train_params$id_order]
   
+  # Prepare the data once for the full fit, the CV folds and gbm_more
+  gbm_data_obj <- prepare_gbm_data(gbm_data_obj, distribution, train_params, variables,
+                                   par_details)
+  
   # Get CV groups
   cv_groups <- create_cv_groups(gbm_data_obj, distribution, train_params, cv_folds,
                                 cv_class_stratify, fold_id)
@@ -108,5 +112,8 @@ gbmt_fit <- function(x, y, distribution=gbm_dist("Gaussian"), weights=rep(1, nro
   gbm_fit_obj$par_details <- par_details
   gbm_fit_obj$response_name <- response_name
   
+  # Compile the trees for prediction
+  gbm_fit_obj <- compile_gbm_fit(gbm_fit_obj)
+  
   return(gbm_fit_obj)
 } 
\ No newline at end of file
@@ -0,0 +1,63 @@
+#' Generate C code for a fitted model
+#' 
+#' Writes the trees of a \code{GBMFit} object out as standalone C source,
+#' for predicting without R - for instance from a shared library built with
+#' \code{R CMD SHLIB}.
+#' 
+#' Each tree becomes a function of nested branches and the categorical
+#' splits become static bitsets.  The source defines
+#' \code{<prefix>_predict(const double* row)}, predicting one row, and
+#' \code{<prefix>_predict_batch(const double* x, const int* num_rows, double*
+#' predictions)}, predicting the rows of a column-major matrix - it can be
+#' called through \code{\link{.C}}.  Rows hold the predictors in the order
+#' they were fitted, factors as level codes starting from 0, and missing
+#' values as \code{NA}; the predictions are on the scale of f(x) and match
+#' those of \code{\link{predict.GBMFit}}.
+#' 
+#' @usage gbm_generate_c(gbm_fit_obj, num_trees=length(gbm_fit_obj$trees),
+#' file=NULL, prefix="gbm")
+#' 
+#' @param gbm_fit_obj a \code{GBMFit} object produced by a call to \code{\link{gbmt}}.
+#' 
+#' @param num_trees the number of trees to predict with.
+#' 
+#' @param file if given, the file the source is written to.
+#' 
+#' @param prefix the prefix of the names in the source, a C identifier.
+#' 
+#' @return the C source, invisibly if it is written to \code{file}.
+#' 
+#' @export
+
+gbm_generate_c <- function(gbm_fit_obj, num_trees=length(gbm_fit_obj$trees),
+                           file=NULL, prefix="gbm") {
+  # Check inputs
+  check_if_gbm_fit(gbm_fit_obj)
+  if(length(num_trees) != 1 || is.na(num_trees) ||
+     num_trees != as.integer(num_trees) || num_trees < 0 ||
+     num_trees > length(gbm_fit_obj$trees)) {
+    stop("num_trees must be a single integer between 0 and the number of trees fitted")
+  }
+  
+  # Use the compiled trees when they are available
+  if(has_compiled_model(gbm_fit_obj)) {
+    trees <- gbm_fit_obj$compiled_model
+  } else {
+    trees <- gbm_fit_obj$trees
+  }
+  
+  code <- .Call("gbm_generate_code",
+                trees=trees,
+                c.split=gbm_fit_obj$c.splits,
+                var.type=as.integer(gbm_fit_obj$variables$var_type),
+                initF=gbm_fit_obj$initF,
+                num_trees=as.integer(num_trees),
+                prefix=as.character(prefix),
+                PACKAGE = "gbm")
+  
+  if(is.null(file)) {
+    return(code)
+  }
+  writeLines(code, file, sep="")
+  invisible(code)
+}
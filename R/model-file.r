@@ -0,0 +1,71 @@
+#' Write and read model files
+#' 
+#' Writes the trees of a \code{GBMFit} object to a binary model file, and
+#' maps a model file back into memory for predicting.
+#' 
+#' Model files hold the trees packed into flat arrays, with the categorical
+#' splits as bitsets, after a short versioned header.  Reading a file maps
+#' it into memory and predictions use the arrays in place, so even models
+#' of many trees load quickly and are not copied onto the heap.  Files are
+#' in the byte order of the machine that wrote them.
+#' 
+#' The file holds only the trees and the initial estimate.
+#' \code{read_gbm_model} attaches the mapped trees to a \code{GBMFit}
+#' object which \code{\link{predict.GBMFit}} then uses, so the object
+#' passed to it may have its \code{trees} and \code{c.splits} removed
+#' before being saved.  Like other external pointers the mapped trees do
+#' not survive saving and reloading the object.
+#' 
+#' @usage write_gbm_model(gbm_fit_obj, file)
+#' 
+#' read_gbm_model(file, gbm_fit_obj)
+#' 
+#' @param gbm_fit_obj a \code{GBMFit} object produced by a call to \code{\link{gbmt}}.
+#' 
+#' @param file the path of the model file.
+#' 
+#' @return \code{write_gbm_model} returns \code{file} invisibly.
+#' \code{read_gbm_model} returns \code{gbm_fit_obj} predicting with the
+#' trees of the file.
+#' 
+#' @export
+
+write_gbm_model <- function(gbm_fit_obj, file) {
+  # Check inputs
+  check_if_gbm_fit(gbm_fit_obj)
+  
+  # Use the compiled trees when they are available
+  if(has_compiled_model(gbm_fit_obj)) {
+    trees <- gbm_fit_obj$compiled_model
+  } else {
+    trees <- gbm_fit_obj$trees
+  }
+  
+  .Call("gbm_write_model",
+        trees=trees,
+        c.split=gbm_fit_obj$c.splits,
+        var.type=as.integer(gbm_fit_obj$variables$var_type),
+        initF=gbm_fit_obj$initF,
+        path=path.expand(file),
+        PACKAGE = "gbm")
+  invisible(file)
+}
+
+#' @rdname write_gbm_model
+#' @export
+
+read_gbm_model <- function(file, gbm_fit_obj) {
+  # Check inputs
+  check_if_gbm_fit(gbm_fit_obj)
+  
+  model <- .Call("gbm_read_model", path=path.expand(file), PACKAGE = "gbm")
+  
+  if((model$num_vars != length(gbm_fit_obj$variables$var_type)) ||
+     (model$num_trees != gbm_fit_obj$params$num_trees) ||
+     !isTRUE(all.equal(model$initF, gbm_fit_obj$initF))) {
+    stop("model file does not hold the trees of gbm_fit_obj")
+  }
+  
+  gbm_fit_obj$compiled_model <- model$compiled_model
+  return(gbm_fit_obj)
+}
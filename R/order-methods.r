@@ -39,10 +39,10 @@ reorder_fit.PairwiseGBMDist <- function(gbm_fit_obj, distribution_obj) {
 }
 
 #### Data ordering - internal methods ####
-order_data <- function(gbm_data_obj, distribution_obj, train_params) {
+order_data <- function(gbm_data_obj, distribution_obj, train_params, par_details=gbmParallel()) {
   gbm_data_obj <- order_by_groupings(gbm_data_obj, distribution_obj)
   gbm_data_obj <- order_by_id(gbm_data_obj, train_params)
-  gbm_data_obj <- predictor_order(gbm_data_obj, train_params)
+  gbm_data_obj <- predictor_order(gbm_data_obj, train_params, par_details)
   return(gbm_data_obj)
 }
 
@@ -4,17 +4,43 @@
 # This is used internally to create the order of variables when growing
 # trees in the C++ layer.
 # 
-# @usage predictor_order(gbm_data_obj, train_params)
+# The columns are sorted in parallel in C++.  The histogram split search
+# bins the predictors without their order, so none is made for it.
+# 
+# @usage predictor_order(gbm_data_obj, train_params, par_details=gbmParallel())
 # 
 # @param gbm_data_obj a \code{GBMData} object.
 # 
 # @param train_params a \code{GBMTrainParams} object.
 #
-# @return an updated gbm_data_object that now contains the predictor variable order.
+# @param par_details a \code{gbmParallel} object giving the number of
+# threads to sort with.
+#
+# @return an updated gbm_data_object that now contains the predictor variable
+# order, or none for the histogram split search.
 #
 # @author James Hickey
 
-predictor_order <- function(gbm_data_obj, train_params) {
-  gbm_data_obj$x_order <- apply(gbm_data_obj$x[seq_len(train_params$num_train_rows),,drop=FALSE],2,order,na.last=FALSE)-1
+predictor_order <- function(gbm_data_obj, train_params, par_details=gbmParallel()) {
+  if(is.null(par_details)) par_details <- gbmParallel()
+  if(identical(par_details$split_search, "histogram")) {
+    gbm_data_obj$x_order <- NULL
+    return(gbm_data_obj)
+  }
+  
+  x <- gbm_data_obj$x[seq_len(train_params$num_train_rows),,drop=FALSE]
+  
+  # Predictors not yet converted to numbers are ordered as they stand
+  if(!all(vapply(as.data.frame(x), is.numeric, logical(1)))) {
+    gbm_data_obj$x_order <- apply(x,2,order,na.last=FALSE)-1
+    return(gbm_data_obj)
+  }
+  
+  gbm_data_obj$x_order <- .Call("gbm_order_predictors",
+                                X=as.matrix(as.data.frame(x)),
+                                nTrainRows=as.integer(nrow(x)),
+                                par_details,
+                                PACKAGE = "gbm")
+  dimnames(gbm_data_obj$x_order) <- list(NULL, colnames(x))
   return(gbm_data_obj)
 }
\ No newline at end of file
@@ -0,0 +1,103 @@
+# Prepare data
+#
+# Converts the predictors of a GBMData object to a matrix, together with
+# their order, the strata/sort vectors and the observation index, once
+# and keeps them on the C++ side.  The full fit, each CV fold and
+# gbm_more then use the prepared data instead of converting them again.
+# For the histogram split search only the predictors' bin codes are
+# kept; the CV folds code their rows with the bins of the whole training
+# set.
+#
+# @usage prepare_gbm_data(gbm_data_obj, gbm_dist_obj, train_params, var_container, par_details=gbmParallel())
+#
+# @param gbm_data_obj a GBMData object containing correctly ordered and validated data.
+#
+# @param gbm_dist_obj a GBMDist object with its strata set up.
+#
+# @param train_params a GBMTrainParams object with ids ordered as the data.
+#
+# @param var_container a GBMVarCont object giving the types of the predictors.
+#
+# @param par_details a \code{gbmParallel} object giving the number of
+# threads to use.
+#
+# @return gbm_data_obj holding an external pointer to the prepared data in
+# \code{prepared}.
+#
+
+prepare_gbm_data <- function(gbm_data_obj, gbm_dist_obj, train_params, var_container,
+                             par_details=gbmParallel()) {
+  check_if_gbm_data(gbm_data_obj)
+  check_if_gbm_dist(gbm_dist_obj)
+  check_if_gbm_train_params(train_params)
+  check_if_gbm_var_container(var_container)
+
+  if(is.null(par_details)) par_details <- gbmParallel()
+  gbm_data_obj$prepared <- .Call("gbm_prepare_data",
+                                 X=as.matrix(as.data.frame(gbm_data_obj$x)),
+                                 X.order=as.integer(gbm_data_obj$x_order),
+                                 var.type=as.integer(var_container$var_type),
+                                 intResponse=as.matrix(cbind(gbm_dist_obj$strata, gbm_dist_obj$sorted)),
+                                 id=as.integer(train_params$id),
+                                 nTrainRows=as.integer(train_params$num_train_rows),
+                                 par_details,
+                                 PACKAGE = "gbm")
+  return(gbm_data_obj)
+}
+
+# Prepare fold data
+#
+# Prepares the data of a CV fold from the prepared data of the whole
+# training set, without converting or sorting the predictors again.
+#
+# @usage prepare_fold_data(gbm_data_obj, prepared, fold_dist_obj, fold_params,
+#  rows_in_training, rows_in_fold, par_details=gbmParallel())
+#
+# @param gbm_data_obj the GBMData object of the fold as returned by \code{split_and_join}.
+#
+# @param prepared external pointer to the prepared data of all of the rows.
+#
+# @param fold_dist_obj the GBMDist object of the fold.
+#
+# @param fold_params the GBMTrainParams object of the fold.
+#
+# @param rows_in_training vector of logicals that determine what data rows are in the training set.
+#
+# @param rows_in_fold vector of logicals indicating whether a row of training data is in the fold or not.
+#
+# @param par_details a \code{gbmParallel} object giving the number of
+# threads to use.
+#
+# @return gbm_data_obj holding an external pointer to the fold's prepared data.
+#
+
+prepare_fold_data <- function(gbm_data_obj, prepared, fold_dist_obj, fold_params,
+                              rows_in_training, rows_in_fold, par_details=gbmParallel()) {
+  if(is.null(par_details)) par_details <- gbmParallel()
+  gbm_data_obj$prepared <- .Call("gbm_prepare_fold",
+                                 prepared,
+                                 rows_in_training,
+                                 rows_in_fold,
+                                 intResponse=as.matrix(cbind(fold_dist_obj$strata, fold_dist_obj$sorted)),
+                                 id=as.integer(fold_params$id),
+                                 par_details,
+                                 PACKAGE = "gbm")
+  return(gbm_data_obj)
+}
+
+# Has prepared data
+#
+# Checks whether a GBMData object holds prepared data that can still be
+# used - external pointers do not survive saving and reloading.
+#
+# @usage has_prepared_data(gbm_data_obj)
+#
+# @param gbm_data_obj a GBMData object.
+#
+# @return TRUE if the prepared data can be used, FALSE otherwise.
+#
+
+has_prepared_data <- function(gbm_data_obj) {
+  !is.null(gbm_data_obj$prepared) &&
+    .Call("gbm_prepared_data_valid", gbm_data_obj$prepared, PACKAGE = "gbm")
+}
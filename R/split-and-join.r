@@ -47,8 +47,22 @@ split_and_join <- function(gbm_data_obj, train_params, rows_in_training, rows_in
   gbm_data_obj_train$offset <- gbm_data_obj$offset[rows_in_training][!rows_in_fold]
   gbm_data_obj_train$weights <- gbm_data_obj$weights[rows_in_training][!rows_in_fold]
 
-  # Reorder predictors for fitting
-  gbm_data_obj_train <- predictor_order(gbm_data_obj_train, train_params)
+  # Reorder predictors for fitting - the fold's training rows are a subset
+  # of the ordered training rows, so their order is read off it without sorting.
+  # Data without an order, for the histogram split search, need none
+  num_rows_ordered <- NROW(gbm_data_obj$x_order)
+  if(is.null(gbm_data_obj$x_order)) {
+    gbm_data_obj_train$x_order <- NULL
+  } else if((sum(rows_in_training) == num_rows_ordered) &&
+     all(rows_in_training[seq_len(num_rows_ordered)])) {
+    gbm_data_obj_train$x_order <- .Call("gbm_subset_order",
+                                        as.matrix(gbm_data_obj$x_order),
+                                        !rows_in_fold,
+                                        PACKAGE = "gbm")
+    dimnames(gbm_data_obj_train$x_order) <- list(NULL, colnames(gbm_data_obj$x_order))
+  } else {
+    gbm_data_obj_train <- predictor_order(gbm_data_obj_train, train_params)
+  }
   
   # Copy column names - required for recombination
   colnames(y_valid) <- colnames(gbm_data_obj_train$y)
@@ -58,7 +72,12 @@ split_and_join <- function(gbm_data_obj, train_params, rows_in_training, rows_in
   gbm_data_obj$y <- rbind(gbm_data_obj_train$y, y_valid)
   gbm_data_obj$offset <- c(gbm_data_obj_train$offset, offset_valid)
   gbm_data_obj$weights <- c(gbm_data_obj_train$weights, weights_valid)
-  gbm_data_obj$x_order <- as.matrix(gbm_data_obj_train$x_order)
+  if(!is.null(gbm_data_obj_train$x_order)) {
+    gbm_data_obj$x_order <- as.matrix(gbm_data_obj_train$x_order)
+  }
+  
+  # Prepared data no longer match the rearranged rows
+  gbm_data_obj$prepared <- NULL
   
   return(gbm_data_obj)
 }
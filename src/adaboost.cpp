@@ -10,8 +10,24 @@
 // Includes
 //-----------------------------------
 #include "adaboost.h"
+#include "block_sums.h"
+#include "vector_math.h"
 #include <memory>
 
+namespace {
+// the deviance from the total loss and weight of a set's rows
+double MeanDeviance(double loss, double weight) {
+  // TODO: Check if weights are all zero for validation set
+  if ((weight == 0.0) && (loss == 0.0)) {
+    return nan("");
+  } else if (weight == 0.0) {
+    return HUGE_VAL;
+  }
+
+  return loss / weight;
+}
+}
+
 //----------------------------------------
 // Function Members - Private
 //----------------------------------------
@@ -30,57 +46,93 @@ CAdaBoost::~CAdaBoost() {}
 void CAdaBoost::ComputeWorkingResponse(const CDataset& kData, const Bag& kBag,
                                        const double* kFuncEstimate,
                                        std::vector<double>& residuals) {
-#pragma omp parallel for schedule(static, get_array_chunk_size()) \
-  num_threads(get_num_threads())
-  for (unsigned long i = 0; i < kData.get_trainsize(); i++) {
-    residuals[i] = -(2 * kData.y_ptr()[i] - 1) *
-                   std::exp(-(2 * kData.y_ptr()[i] - 1) *
-                            (kData.offset_ptr()[i] + kFuncEstimate[i]));
+  const unsigned long kNumRows = kData.get_trainsize();
+
+#pragma omp parallel for schedule( \
+    static, gbm_vector_math::BlocksPerChunk(get_array_chunk_size())) \
+    num_threads(get_num_threads())
+  for (unsigned long block = 0; block < gbm_vector_math::NumBlocks(kNumRows);
+       block++) {
+    const unsigned long kBegin = block * gbm_vector_math::kBlockSize;
+    const unsigned long kSize = gbm_vector_math::BlockSize(block, kNumRows);
+    double exp_losses[gbm_vector_math::kBlockSize];
+
+    for (unsigned long j = 0; j < kSize; j++) {
+      const unsigned long i = kBegin + j;
+      exp_losses[j] = -(2 * kData.y_ptr()[i] - 1) *
+                      (kData.offset_ptr()[i] + kFuncEstimate[i]);
+    }
+    gbm_vector_math::Exp(exp_losses, kSize, exp_losses);
+
+    for (unsigned long j = 0; j < kSize; j++) {
+      residuals[kBegin + j] =
+          -(2 * kData.y_ptr()[kBegin + j] - 1) * exp_losses[j];
+    }
   }
 }
 
 double CAdaBoost::InitF(const CDataset& kData) {
-  double numerator = 0.0;
-  double denominator = 0.0;
-
-#pragma omp parallel for schedule(static, get_array_chunk_size()) \
-    reduction(+ : numerator, denominator) num_threads(get_num_threads())
-  for (unsigned long i = 0; i < kData.get_trainsize(); i++) {
-    if (kData.y_ptr()[i] == 1.0) {
-      numerator += kData.weight_ptr()[i] * std::exp(-kData.offset_ptr()[i]);
-    } else {
-      denominator += kData.weight_ptr()[i] * std::exp(kData.offset_ptr()[i]);
+  BlockSums sums(kData.get_trainsize(), 2);
+
+#pragma omp parallel for schedule( \
+    static, gbm_vector_math::BlocksPerChunk(get_array_chunk_size())) \
+    num_threads(get_num_threads())
+  for (unsigned long block = 0; block < sums.num_blocks(); block++) {
+    double numerator = 0.0;
+    double denominator = 0.0;
+    for (unsigned long i = sums.begin(block); i < sums.end(block); i++) {
+      if (kData.y_ptr()[i] == 1.0) {
+        numerator += kData.weight_ptr()[i] * std::exp(-kData.offset_ptr()[i]);
+      } else {
+        denominator += kData.weight_ptr()[i] * std::exp(kData.offset_ptr()[i]);
+      }
     }
+    sums(block, 0) = numerator;
+    sums(block, 1) = denominator;
   }
 
+  double numerator = sums.Total(0);
+  double denominator = sums.Total(1);
+
   return 0.5 * std::log(numerator / denominator);
 }
 
 double CAdaBoost::Deviance(const CDataset& kData, const Bag& kBag,
                            const double* kFuncEstimate) {
-  double loss = 0.0;
-  double weight = 0.0;
-
   // Switch to validation set if necessary
-  unsigned long num_of_rows_in_set = kData.get_size_of_set();
-
-#pragma omp parallel for schedule(static, get_array_chunk_size()) \
-    reduction(+ : loss, weight) num_threads(get_num_threads())
-  for (unsigned long i = 0; i < num_of_rows_in_set; i++) {
-    loss += kData.weight_ptr()[i] *
-            std::exp(-(2 * kData.y_ptr()[i] - 1) *
-                     (kData.offset_ptr()[i] + kFuncEstimate[i]));
-    weight += kData.weight_ptr()[i];
-  }
+  const unsigned long kNumRows = kData.get_size_of_set();
+  BlockSums sums(kNumRows, 2);
 
-  // TODO: Check if weights are all zero for validation set
-  if ((weight == 0.0) && (loss == 0.0)) {
-    return nan("");
-  } else if (weight == 0.0) {
-    return HUGE_VAL;
+#pragma omp parallel for schedule( \
+    static, gbm_vector_math::BlocksPerChunk(get_array_chunk_size())) \
+    num_threads(get_num_threads())
+  for (unsigned long block = 0; block < sums.num_blocks(); block++) {
+    const unsigned long kBegin = block * gbm_vector_math::kBlockSize;
+    const unsigned long kSize = gbm_vector_math::BlockSize(block, kNumRows);
+    double exp_losses[gbm_vector_math::kBlockSize];
+    double loss = 0.0;
+    double weight = 0.0;
+
+    for (unsigned long j = 0; j < kSize; j++) {
+      const unsigned long i = kBegin + j;
+      exp_losses[j] = -(2 * kData.y_ptr()[i] - 1) *
+                      (kData.offset_ptr()[i] + kFuncEstimate[i]);
+    }
+    gbm_vector_math::Exp(exp_losses, kSize, exp_losses);
+
+    for (unsigned long j = 0; j < kSize; j++) {
+      loss += kData.weight_ptr()[kBegin + j] * exp_losses[j];
+      weight += kData.weight_ptr()[kBegin + j];
+    }
+
+    sums(block, 0) = loss;
+    sums(block, 1) = weight;
   }
 
-  return loss / weight;
+  double loss = sums.Total(0);
+  double weight = sums.Total(1);
+
+  return MeanDeviance(loss, weight);
 }
 
 void CAdaBoost::FitBestConstant(const CDataset& kData, const Bag& kBag,
@@ -125,23 +177,109 @@ double CAdaBoost::BagImprovement(const CDataset& kData, const Bag& kBag,
                                  const double* kFuncEstimate,
                                  const double kShrinkage,
                                  const std::vector<double>& kDeltaEstimate) {
-  double returnvalue = 0.0;
-  double weight = 0.0;
-
-#pragma omp parallel for schedule(static, get_array_chunk_size()) \
-    reduction(+ : returnvalue, weight) num_threads(get_num_threads())
-  for (unsigned long i = 0; i < kData.get_trainsize(); i++) {
-    if (!kBag.get_element(i)) {
-      const double func_est = kFuncEstimate[i] + kData.offset_ptr()[i];
-
-      returnvalue +=
-          kData.weight_ptr()[i] *
-          (std::exp(-(2 * kData.y_ptr()[i] - 1) * func_est) -
-           std::exp(-(2 * kData.y_ptr()[i] - 1) *
-                    (func_est + (kShrinkage) * (kDeltaEstimate[i]))));
-      weight += kData.weight_ptr()[i];
+  const unsigned long kNumRows = kData.get_trainsize();
+  BlockSums sums(kNumRows, 2);
+
+  // the terms of every row are computed, and those of the rows in the bag
+  // then dropped, so that the kernels run over whole blocks
+#pragma omp parallel for schedule( \
+    static, gbm_vector_math::BlocksPerChunk(get_array_chunk_size())) \
+    num_threads(get_num_threads())
+  for (unsigned long block = 0; block < sums.num_blocks(); block++) {
+    const unsigned long kBegin = block * gbm_vector_math::kBlockSize;
+    const unsigned long kSize = gbm_vector_math::BlockSize(block, kNumRows);
+    double exp_losses[gbm_vector_math::kBlockSize];
+    double new_exp_losses[gbm_vector_math::kBlockSize];
+    double returnvalue = 0.0;
+    double weight = 0.0;
+
+    for (unsigned long j = 0; j < kSize; j++) {
+      const unsigned long i = kBegin + j;
+      exp_losses[j] = -(2 * kData.y_ptr()[i] - 1) *
+                      (kFuncEstimate[i] + kData.offset_ptr()[i]);
+      new_exp_losses[j] =
+          -(2 * kData.y_ptr()[i] - 1) *
+          (kData.offset_ptr()[i] +
+           (kFuncEstimate[i] + kShrinkage * kDeltaEstimate[i]));
     }
+    gbm_vector_math::Exp(exp_losses, kSize, exp_losses);
+    gbm_vector_math::Exp(new_exp_losses, kSize, new_exp_losses);
+
+    for (unsigned long j = 0; j < kSize; j++) {
+      const unsigned long i = kBegin + j;
+      const double kTerm =
+          kData.weight_ptr()[i] * (exp_losses[j] - new_exp_losses[j]);
+      returnvalue += kBag.get_element(i) ? 0.0 : kTerm;
+      weight += kBag.get_element(i) ? 0.0 : kData.weight_ptr()[i];
+    }
+
+    sums(block, 0) = returnvalue;
+    sums(block, 1) = weight;
   }
 
+  double returnvalue = sums.Total(0);
+  double weight = sums.Total(1);
+
   return returnvalue / weight;
 }
+
+bool CAdaBoost::FusedUpdate(const CDataset& kData, const Bag& kBag,
+                             const double kShrinkage,
+                             const std::vector<double>& kDeltaEstimate,
+                             double* func_estimate,
+                             std::vector<double>& residuals,
+                             double& oobag_improvement, double& deviance) {
+  const unsigned long kNumRows = kData.get_trainsize();
+  BlockSums sums(kNumRows, 4);
+
+#pragma omp parallel for schedule( \
+    static, gbm_vector_math::BlocksPerChunk(get_array_chunk_size())) \
+    num_threads(get_num_threads())
+  for (unsigned long block = 0; block < sums.num_blocks(); block++) {
+    const unsigned long kBegin = block * gbm_vector_math::kBlockSize;
+    const unsigned long kSize = gbm_vector_math::BlockSize(block, kNumRows);
+    double exp_losses[gbm_vector_math::kBlockSize];
+    double new_exp_losses[gbm_vector_math::kBlockSize];
+    double improvement = 0.0;
+    double oobag_weight = 0.0;
+    double loss = 0.0;
+    double weight = 0.0;
+
+    for (unsigned long j = 0; j < kSize; j++) {
+      const unsigned long i = kBegin + j;
+      exp_losses[j] = -(2 * kData.y_ptr()[i] - 1) *
+                      (func_estimate[i] + kData.offset_ptr()[i]);
+      func_estimate[i] += kShrinkage * kDeltaEstimate[i];
+      new_exp_losses[j] = -(2 * kData.y_ptr()[i] - 1) *
+                          (kData.offset_ptr()[i] + func_estimate[i]);
+    }
+    gbm_vector_math::Exp(exp_losses, kSize, exp_losses);
+    gbm_vector_math::Exp(new_exp_losses, kSize, new_exp_losses);
+
+    for (unsigned long j = 0; j < kSize; j++) {
+      const unsigned long i = kBegin + j;
+      const double kTerm =
+          kData.weight_ptr()[i] * (exp_losses[j] - new_exp_losses[j]);
+      improvement += kBag.get_element(i) ? 0.0 : kTerm;
+      oobag_weight += kBag.get_element(i) ? 0.0 : kData.weight_ptr()[i];
+
+      loss += kData.weight_ptr()[i] * new_exp_losses[j];
+      weight += kData.weight_ptr()[i];
+      residuals[i] = -(2 * kData.y_ptr()[i] - 1) * new_exp_losses[j];
+    }
+
+    sums(block, 0) = improvement;
+    sums(block, 1) = oobag_weight;
+    sums(block, 2) = loss;
+    sums(block, 3) = weight;
+  }
+
+  double improvement = sums.Total(0);
+  double oobag_weight = sums.Total(1);
+  double loss = sums.Total(2);
+  double weight = sums.Total(3);
+
+  oobag_improvement = improvement / oobag_weight;
+  deviance = MeanDeviance(loss, weight);
+  return true;
+}
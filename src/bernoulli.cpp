@@ -11,8 +11,24 @@
 //-----------------------------------
 
 #include "bernoulli.h"
+#include "block_sums.h"
+#include "vector_math.h"
 #include <memory>
 
+namespace {
+// the deviance from the total loss and weight of a set's rows
+double MeanDeviance(double loss, double weight) {
+  // TODO: Check if weights are all zero for validation set
+  if ((weight == 0.0) && (loss == 0.0)) {
+    return nan("");
+  } else if (weight == 0.0) {
+    return copysign(HUGE_VAL, -loss);
+  }
+
+  return -2 * loss / weight;
+}
+}
+
 //----------------------------------------
 // Function Members - Private
 //----------------------------------------
@@ -33,13 +49,27 @@ CBernoulli::~CBernoulli() {}
 void CBernoulli::ComputeWorkingResponse(const CDataset& kData, const Bag& kBag,
                                         const double* kFuncEstimate,
                                         std::vector<double>& residuals) {
-#pragma omp parallel for schedule(static, get_array_chunk_size()) \
-  num_threads(get_num_threads())
-  for (unsigned long i = 0; i < kData.get_trainsize(); i++) {
-    const double deltafunc_est = kFuncEstimate[i] + kData.offset_ptr()[i];
-    const double prob = 1.0 / (1.0 + std::exp(-deltafunc_est));
+  const unsigned long kNumRows = kData.get_trainsize();
+
+#pragma omp parallel for schedule( \
+    static, gbm_vector_math::BlocksPerChunk(get_array_chunk_size())) \
+    num_threads(get_num_threads())
+  for (unsigned long block = 0; block < gbm_vector_math::NumBlocks(kNumRows);
+       block++) {
+    const unsigned long kBegin = block * gbm_vector_math::kBlockSize;
+    const unsigned long kSize = gbm_vector_math::BlockSize(block, kNumRows);
+    double exp_terms[gbm_vector_math::kBlockSize];
 
-    residuals[i] = kData.y_ptr()[i] - prob;
+    for (unsigned long j = 0; j < kSize; j++) {
+      exp_terms[j] =
+          -(kFuncEstimate[kBegin + j] + kData.offset_ptr()[kBegin + j]);
+    }
+    gbm_vector_math::Exp(exp_terms, kSize, exp_terms);
+
+    for (unsigned long j = 0; j < kSize; j++) {
+      residuals[kBegin + j] =
+          kData.y_ptr()[kBegin + j] - 1.0 / (1.0 + exp_terms[j]);
+    }
   }
 }
 
@@ -71,29 +101,42 @@ double CBernoulli::InitF(const CDataset& kData) {
 
 double CBernoulli::Deviance(const CDataset& kData, const Bag& kBag,
                             const double* kFuncEstimate) {
-  double loss = 0.0;
-  double weight = 0.0;
-
   // Switch to validation set if necessary
-  unsigned long num_of_rows_in_set = kData.get_size_of_set();
-
-#pragma omp parallel for schedule(static, get_array_chunk_size()) \
-    reduction(+ : loss, weight) num_threads(get_num_threads())
-  for (unsigned long i = 0; i < num_of_rows_in_set; i++) {
-    const double deltafunc_est = kFuncEstimate[i] + kData.offset_ptr()[i];
-    loss += kData.weight_ptr()[i] * (kData.y_ptr()[i] * deltafunc_est -
-                                     std::log(1.0 + std::exp(deltafunc_est)));
-    weight += kData.weight_ptr()[i];
-  }
+  const unsigned long kNumRows = kData.get_size_of_set();
+  BlockSums sums(kNumRows, 2);
 
-  // TODO: Check if weights are all zero for validation set
-  if ((weight == 0.0) && (loss == 0.0)) {
-    return nan("");
-  } else if (weight == 0.0) {
-    return copysign(HUGE_VAL, -loss);
+#pragma omp parallel for schedule( \
+    static, gbm_vector_math::BlocksPerChunk(get_array_chunk_size())) \
+    num_threads(get_num_threads())
+  for (unsigned long block = 0; block < sums.num_blocks(); block++) {
+    const unsigned long kBegin = block * gbm_vector_math::kBlockSize;
+    const unsigned long kSize = gbm_vector_math::BlockSize(block, kNumRows);
+    double deltafunc_est[gbm_vector_math::kBlockSize];
+    double log_terms[gbm_vector_math::kBlockSize];
+    double loss = 0.0;
+    double weight = 0.0;
+
+    for (unsigned long j = 0; j < kSize; j++) {
+      deltafunc_est[j] =
+          kFuncEstimate[kBegin + j] + kData.offset_ptr()[kBegin + j];
+    }
+    gbm_vector_math::Log1pExp(deltafunc_est, kSize, log_terms);
+
+    for (unsigned long j = 0; j < kSize; j++) {
+      const unsigned long i = kBegin + j;
+      loss += kData.weight_ptr()[i] *
+              (kData.y_ptr()[i] * deltafunc_est[j] - log_terms[j]);
+      weight += kData.weight_ptr()[i];
+    }
+
+    sums(block, 0) = loss;
+    sums(block, 1) = weight;
   }
 
-  return -2 * loss / weight;
+  double loss = sums.Total(0);
+  double weight = sums.Total(1);
+
+  return MeanDeviance(loss, weight);
 }
 
 void CBernoulli::FitBestConstant(const CDataset& kData, const Bag& kBag,
@@ -128,7 +171,7 @@ void CBernoulli::FitBestConstant(const CDataset& kData, const Bag& kBag,
           if (!terminalnode_capped_) {
             // set fCappedPred=true so that warning only issued once
             terminalnode_capped_ = true;
-            Rcpp::warning(
+            gbm_platform::Warning(
                 "Some terminal node predictions were excessively large for "
                 "Bernoulli and have been capped. Likely due to a "
                 "feature that separates the 0/1 outcomes. Consider reducing "
@@ -151,25 +194,113 @@ double CBernoulli::BagImprovement(const CDataset& kData, const Bag& kBag,
                                   const double* kFuncEstimate,
                                   const double kShrinkage,
                                   const std::vector<double>& kDeltaEstimate) {
-  double returnvalue = 0.0;
-  double weight = 0.0;
+  const unsigned long kNumRows = kData.get_trainsize();
+  BlockSums sums(kNumRows, 2);
 
-#pragma omp parallel for schedule(static, get_array_chunk_size()) \
-    reduction(+ : returnvalue, weight) num_threads(get_num_threads())
-  for (unsigned long i = 0; i < kData.get_trainsize(); i++) {
-    if (!kBag.get_element(i)) {
-      const double deltafunc_est = kFuncEstimate[i] + kData.offset_ptr()[i];
+  // the terms of every row are computed, and those of the rows in the bag
+  // then dropped, so that the kernels run over whole blocks
+#pragma omp parallel for schedule( \
+    static, gbm_vector_math::BlocksPerChunk(get_array_chunk_size())) \
+    num_threads(get_num_threads())
+  for (unsigned long block = 0; block < sums.num_blocks(); block++) {
+    const unsigned long kBegin = block * gbm_vector_math::kBlockSize;
+    const unsigned long kSize = gbm_vector_math::BlockSize(block, kNumRows);
+    double log_terms[gbm_vector_math::kBlockSize];
+    double new_log_terms[gbm_vector_math::kBlockSize];
+    double returnvalue = 0.0;
+    double weight = 0.0;
 
-      if (kData.y_ptr()[i] == 1.0) {
-        returnvalue += kData.weight_ptr()[i] * kShrinkage * kDeltaEstimate[i];
-      }
-      returnvalue += kData.weight_ptr()[i] *
-                     (std::log(1.0 + std::exp(deltafunc_est)) -
-                      std::log(1.0 + std::exp(deltafunc_est +
-                                              kShrinkage * kDeltaEstimate[i])));
-      weight += kData.weight_ptr()[i];
+    for (unsigned long j = 0; j < kSize; j++) {
+      const unsigned long i = kBegin + j;
+      log_terms[j] = kFuncEstimate[i] + kData.offset_ptr()[i];
+      new_log_terms[j] = (kFuncEstimate[i] + kShrinkage * kDeltaEstimate[i]) +
+                         kData.offset_ptr()[i];
+    }
+    gbm_vector_math::Log1pExp(log_terms, kSize, log_terms);
+    gbm_vector_math::Log1pExp(new_log_terms, kSize, new_log_terms);
+
+    for (unsigned long j = 0; j < kSize; j++) {
+      const unsigned long i = kBegin + j;
+      const double kTerm =
+          kData.weight_ptr()[i] *
+          (kData.y_ptr()[i] * kShrinkage * kDeltaEstimate[i] + log_terms[j] -
+           new_log_terms[j]);
+      returnvalue += kBag.get_element(i) ? 0.0 : kTerm;
+      weight += kBag.get_element(i) ? 0.0 : kData.weight_ptr()[i];
     }
+
+    sums(block, 0) = returnvalue;
+    sums(block, 1) = weight;
   }
 
+  double returnvalue = sums.Total(0);
+  double weight = sums.Total(1);
+
   return returnvalue / weight;
 }
+
+bool CBernoulli::FusedUpdate(const CDataset& kData, const Bag& kBag,
+                              const double kShrinkage,
+                              const std::vector<double>& kDeltaEstimate,
+                              double* func_estimate,
+                              std::vector<double>& residuals,
+                              double& oobag_improvement, double& deviance) {
+  const unsigned long kNumRows = kData.get_trainsize();
+  BlockSums sums(kNumRows, 4);
+
+#pragma omp parallel for schedule( \
+    static, gbm_vector_math::BlocksPerChunk(get_array_chunk_size())) \
+    num_threads(get_num_threads())
+  for (unsigned long block = 0; block < sums.num_blocks(); block++) {
+    const unsigned long kBegin = block * gbm_vector_math::kBlockSize;
+    const unsigned long kSize = gbm_vector_math::BlockSize(block, kNumRows);
+    double log_terms[gbm_vector_math::kBlockSize];
+    double deltafunc_est[gbm_vector_math::kBlockSize];
+    double new_log_terms[gbm_vector_math::kBlockSize];
+    double exp_terms[gbm_vector_math::kBlockSize];
+    double improvement = 0.0;
+    double oobag_weight = 0.0;
+    double loss = 0.0;
+    double weight = 0.0;
+
+    for (unsigned long j = 0; j < kSize; j++) {
+      const unsigned long i = kBegin + j;
+      log_terms[j] = func_estimate[i] + kData.offset_ptr()[i];
+      func_estimate[i] += kShrinkage * kDeltaEstimate[i];
+      deltafunc_est[j] = func_estimate[i] + kData.offset_ptr()[i];
+      exp_terms[j] = -deltafunc_est[j];
+    }
+    gbm_vector_math::Log1pExp(log_terms, kSize, log_terms);
+    gbm_vector_math::Log1pExp(deltafunc_est, kSize, new_log_terms);
+    gbm_vector_math::Exp(exp_terms, kSize, exp_terms);
+
+    for (unsigned long j = 0; j < kSize; j++) {
+      const unsigned long i = kBegin + j;
+      const double kTerm =
+          kData.weight_ptr()[i] *
+          (kData.y_ptr()[i] * kShrinkage * kDeltaEstimate[i] + log_terms[j] -
+           new_log_terms[j]);
+      improvement += kBag.get_element(i) ? 0.0 : kTerm;
+      oobag_weight += kBag.get_element(i) ? 0.0 : kData.weight_ptr()[i];
+
+      loss += kData.weight_ptr()[i] *
+              (kData.y_ptr()[i] * deltafunc_est[j] - new_log_terms[j]);
+      weight += kData.weight_ptr()[i];
+      residuals[i] = kData.y_ptr()[i] - 1.0 / (1.0 + exp_terms[j]);
+    }
+
+    sums(block, 0) = improvement;
+    sums(block, 1) = oobag_weight;
+    sums(block, 2) = loss;
+    sums(block, 3) = weight;
+  }
+
+  double improvement = sums.Total(0);
+  double oobag_weight = sums.Total(1);
+  double loss = sums.Total(2);
+  double weight = sums.Total(3);
+
+  oobag_improvement = improvement / oobag_weight;
+  deviance = MeanDeviance(loss, weight);
+  return true;
+}
@@ -54,6 +54,12 @@ class CBernoulli : public CDistribution {
                         const double* kFuncEstimate, const double kShrinkage,
                         const std::vector<double>& kDeltaEstimate);
 
+  bool FusedUpdate(const CDataset& kData, const Bag& kBag,
+                   const double kShrinkage,
+                   const std::vector<double>& kDeltaEstimate,
+                   double* func_estimate, std::vector<double>& residuals,
+                   double& oobag_improvement, double& deviance);
+
  private:
   //----------------------
   // Private Constructors
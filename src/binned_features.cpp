@@ -0,0 +1,198 @@
+//-----------------------------------
+//
+// File: binned_features.cpp
+//
+// Description: quantizes the predictors into per-variable bins so that
+//   splits can be searched over histograms rather than sorted rows.
+//
+//-----------------------------------
+
+//-----------------------------------
+// Includes
+//-----------------------------------
+#include "binned_features.h"
+#include "gbm_platform.h"
+#include <algorithm>
+
+//----------------------------------------
+// Function Members - Public
+//----------------------------------------
+//-----------------------------------
+// Function: Initialize
+//
+// Returns: none
+//
+// Description: computes the bin boundaries of each variable from the
+//   training rows and codes every row of the data.  Each variable's
+//   training values are sorted on their own, so no order of the rows is
+//   needed and the values can be released once the codes are built.
+//
+// Parameters:
+//  kXMatrix - the predictor values of all rows
+//  num_trainrows - number of rows in the training set, which come first
+//  kVarClasses - 0 for continuous variables, the number of levels for
+//                categorical ones.
+//  max_bins - maximum number of value bins for a continuous variable.
+//  num_threads - the number of threads the variables are shared between
+//-----------------------------------
+void BinnedFeatures::Initialize(const MatrixSpan<const double>& kXMatrix,
+                                unsigned long num_trainrows,
+                                const Span<int>& kVarClasses,
+                                unsigned long max_bins, int num_threads) {
+  const int kNumVars = kXMatrix.ncol();
+  num_rows_ = kXMatrix.nrow();
+  max_bins_ = max_bins;
+  num_bins_.assign(kNumVars, 0);
+  is_categorical_.assign(kNumVars, false);
+  cut_offsets_.assign(kNumVars + 1, 0);
+  for (int var = 0; var < kNumVars; var++) {
+    is_categorical_[var] = (kVarClasses[var] > 0);
+  }
+
+  // the cuts of each variable are found on their own
+  std::vector<std::vector<double> > var_cuts(kNumVars);
+#pragma omp parallel for schedule(dynamic, 1) num_threads(num_threads)
+  for (int var = 0; var < kNumVars; var++) {
+    if (is_categorical_[var]) {
+      num_bins_[var] = kVarClasses[var];
+      continue;
+    }
+
+    // the training values in order - missing values and other NaNs, which
+    // cannot be sorted, are left out
+    std::vector<double> sorted;
+    sorted.reserve(num_trainrows);
+    for (unsigned long row = 0; row < num_trainrows; row++) {
+      const double kXVal = kXMatrix(row, var);
+      if (!gbm_platform::IsNaN(kXVal)) sorted.push_back(kXVal);
+    }
+    std::sort(sorted.begin(), sorted.end());
+
+    // distinct values and their counts
+    std::vector<double> values;
+    std::vector<unsigned long> counts;
+    for (unsigned long ind = 0; ind < sorted.size(); ind++) {
+      if (values.empty() || (values.back() != sorted[ind])) {
+        values.push_back(sorted[ind]);
+        counts.push_back(0);
+      }
+      counts.back()++;
+    }
+    std::vector<double>().swap(sorted);
+
+    // place cuts half way between distinct values, merging neighbours
+    // into roughly equally populated bins if there are too many
+    std::vector<double>& cuts = var_cuts[var];
+    unsigned long remaining = 0;
+    for (unsigned long ind = 0; ind < counts.size(); ind++) {
+      remaining += counts[ind];
+    }
+    unsigned long in_bin = 0;
+    for (unsigned long ind = 0; ind + 1 < values.size(); ind++) {
+      const unsigned long kBinsLeft = max_bins - cuts.size();
+      in_bin += counts[ind];
+      remaining -= counts[ind];
+      if (kBinsLeft <= 1) break;
+      if ((values.size() <= max_bins) ||
+          (in_bin * kBinsLeft >= remaining + in_bin)) {
+        cuts.push_back(0.5 * (values[ind] + values[ind + 1]));
+        in_bin = 0;
+      }
+    }
+    num_bins_[var] = cuts.size() + 1;
+  }
+
+  cuts_.clear();
+  for (int var = 0; var < kNumVars; var++) {
+    cut_offsets_[var] = cuts_.size();
+    cuts_.insert(cuts_.end(), var_cuts[var].begin(), var_cuts[var].end());
+  }
+  cut_offsets_[kNumVars] = cuts_.size();
+  LayOutCodes();
+
+  // and code all of the rows
+#pragma omp parallel for schedule(dynamic, 1) num_threads(num_threads)
+  for (int var = 0; var < kNumVars; var++) {
+    const std::vector<double>::const_iterator kCutsBegin =
+        cuts_.begin() + cut_offsets_[var];
+    const std::vector<double>::const_iterator kCutsEnd =
+        cuts_.begin() + cut_offsets_[var + 1];
+    for (unsigned long row = 0; row < num_rows_; row++) {
+      // NaNs go to the missing bin along with R's NA
+      const double kXVal = kXMatrix(row, var);
+      unsigned long bin = missing_bin(var);
+      if (!gbm_platform::IsNaN(kXVal) && is_categorical_[var]) {
+        // levels outside of the training levels are treated as missing
+        const unsigned long kLevel = kXVal;
+        if (kLevel < num_bins_[var]) bin = kLevel;
+      } else if (!gbm_platform::IsNaN(kXVal)) {
+        bin = std::upper_bound(kCutsBegin, kCutsEnd, kXVal) - kCutsBegin;
+      }
+      set_code(row, var, bin);
+    }
+  }
+}
+
+//-----------------------------------
+// Function: Initialize
+//
+// Returns: none
+//
+// Description: codes some of the rows of a parent's data with the
+//   parent's bins - used for the cross-validation folds of prepared data,
+//   whose predictor values are no longer kept.
+//
+// Parameters:
+//  kParent - the binned data the rows are taken from
+//  kRows - the rows of the parent, in their new order
+//-----------------------------------
+void BinnedFeatures::Initialize(const BinnedFeatures& kParent,
+                                const std::vector<int>& kRows) {
+  num_rows_ = kRows.size();
+  max_bins_ = kParent.max_bins_;
+  num_bins_ = kParent.num_bins_;
+  is_categorical_ = kParent.is_categorical_;
+  cut_offsets_ = kParent.cut_offsets_;
+  cuts_ = kParent.cuts_;
+  LayOutCodes();
+
+  for (int var = 0; var < num_vars(); var++) {
+    for (unsigned long row = 0; row < num_rows_; row++) {
+      set_code(row, var, kParent.code(kRows[row], var));
+    }
+  }
+}
+
+//----------------------------------------
+// Function Members - Private
+//----------------------------------------
+//-----------------------------------
+// Function: LayOutCodes
+//
+// Returns: none
+//
+// Description: makes room for the codes of each variable, one byte a
+//   row if it has at most 256 bins including the missing bin and two
+//   otherwise.
+//
+// Parameters: none
+//-----------------------------------
+void BinnedFeatures::LayOutCodes() {
+  const int kNumVars = num_vars();
+  is_narrow_.assign(kNumVars, false);
+  code_offsets_.assign(kNumVars, 0);
+
+  unsigned long num_narrow = 0, num_wide = 0;
+  for (int var = 0; var < kNumVars; var++) {
+    is_narrow_[var] = (num_bins_[var] < 256);
+    if (is_narrow_[var]) {
+      code_offsets_[var] = num_narrow * num_rows_;
+      num_narrow++;
+    } else {
+      code_offsets_[var] = num_wide * num_rows_;
+      num_wide++;
+    }
+  }
+  narrow_codes_.assign(num_narrow * num_rows_, 0);
+  wide_codes_.assign(num_wide * num_rows_, 0);
+}
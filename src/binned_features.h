@@ -0,0 +1,100 @@
+//------------------------------------------------------------------------------
+//
+//  File:       binned_features.h
+//
+//  Description: header for the binned (quantized) predictor codes used by
+//    the histogram split search.
+//
+//------------------------------------------------------------------------------
+
+#ifndef BINNEDFEATURES_H
+#define BINNEDFEATURES_H
+
+//------------------------------
+// Includes
+//------------------------------
+#include "gbm_exception.h"
+#include "span.h"
+#include <cmath>
+#include <vector>
+
+//------------------------------
+// Class definition
+//------------------------------
+class BinnedFeatures {
+ public:
+  //----------------------
+  // Public Constructors
+  //----------------------
+  BinnedFeatures() : num_rows_(0), max_bins_(0){};
+
+  //---------------------
+  // Public destructor
+  //---------------------
+  ~BinnedFeatures(){};
+
+  //---------------------
+  // Public Functions
+  //---------------------
+  void Initialize(const MatrixSpan<const double>& kXMatrix,
+                  unsigned long num_trainrows, const Span<int>& kVarClasses,
+                  unsigned long max_bins, int num_threads);
+  void Initialize(const BinnedFeatures& kParent, const std::vector<int>& kRows);
+
+  bool empty() const { return num_rows_ == 0; };
+  unsigned long num_rows() const { return num_rows_; };
+  int num_vars() const { return num_bins_.size(); };
+  unsigned long max_bins() const { return max_bins_; };
+
+  // number of value bins for a variable - the missing bin comes after these
+  unsigned long num_bins(int var) const { return num_bins_[var]; };
+  unsigned long missing_bin(int var) const { return num_bins_[var]; };
+
+  // codes of a variable, one per row of the data - one byte wide when
+  // the variable has at most 256 bins including the missing bin
+  bool is_narrow(int var) const { return is_narrow_[var]; };
+  const unsigned char* narrow_codes(int var) const {
+    return &narrow_codes_[code_offsets_[var]];
+  };
+  const unsigned short* wide_codes(int var) const {
+    return &wide_codes_[code_offsets_[var]];
+  };
+  unsigned long code(unsigned long row, int var) const {
+    return is_narrow_[var] ? narrow_codes_[code_offsets_[var] + row]
+                           : wide_codes_[code_offsets_[var] + row];
+  };
+
+  // split value separating bin-1 from bin for a continuous variable,
+  // the category itself for a categorical one
+  double bin_value(int var, unsigned long bin) const {
+    if (is_categorical_[var]) return bin;
+    if (bin == 0) return -HUGE_VAL;
+    return cuts_[cut_offsets_[var] + bin - 1];
+  };
+
+ private:
+  //---------------------
+  // Private Functions
+  //---------------------
+  void LayOutCodes();
+  void set_code(unsigned long row, int var, unsigned long bin) {
+    if (is_narrow_[var]) {
+      narrow_codes_[code_offsets_[var] + row] = bin;
+    } else {
+      wide_codes_[code_offsets_[var] + row] = bin;
+    }
+  };
+
+  //-------------------
+  // Private Variables
+  //-------------------
+  unsigned long num_rows_, max_bins_;
+  std::vector<unsigned long> num_bins_;
+  std::vector<bool> is_categorical_, is_narrow_;
+  std::vector<unsigned long> cut_offsets_, code_offsets_;
+  std::vector<double> cuts_;
+  std::vector<unsigned char> narrow_codes_;
+  std::vector<unsigned short> wide_codes_;
+};
+
+#endif  // BINNEDFEATURES_H
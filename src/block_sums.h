@@ -0,0 +1,73 @@
+//------------------------------------------------------------------------------
+//
+//  File:       block_sums.h
+//
+//  Description: sums over the rows of a parallel loop that are the same
+//    whatever the number of threads.  The loop takes the rows in blocks of
+//    gbm_vector_math::kBlockSize, sums each block on its own and the
+//    blocks' sums are then added in order, so that no sum depends on how
+//    the blocks were shared between the threads.
+//
+//------------------------------------------------------------------------------
+
+#ifndef BLOCK_SUMS_H
+#define BLOCK_SUMS_H
+
+//------------------------------
+// Includes
+//------------------------------
+#include "vector_math.h"
+#include <vector>
+
+//------------------------------
+// Class definition
+//------------------------------
+class BlockSums {
+ public:
+  //----------------------
+  // Public Constructors
+  //----------------------
+  BlockSums(unsigned long num_rows, int num_sums)
+      : num_rows_(num_rows),
+        num_sums_(num_sums),
+        sums_(gbm_vector_math::NumBlocks(num_rows) * num_sums, 0.0){};
+
+  //---------------------
+  // Public Functions
+  //---------------------
+  unsigned long num_blocks() const {
+    return gbm_vector_math::NumBlocks(num_rows_);
+  };
+
+  // the rows of a block are [begin(block), end(block))
+  unsigned long begin(unsigned long block) const {
+    return block * gbm_vector_math::kBlockSize;
+  };
+  unsigned long end(unsigned long block) const {
+    return begin(block) + gbm_vector_math::BlockSize(block, num_rows_);
+  };
+
+  // the sum of a block, set once by the thread summing the block
+  double& operator()(unsigned long block, int sum) {
+    return sums_[block * num_sums_ + sum];
+  };
+
+  // a sum over all the rows
+  double Total(int sum) const {
+    double total = 0.0;
+    for (unsigned long block = 0; block < num_blocks(); block++) {
+      total += sums_[block * num_sums_ + sum];
+    }
+    return total;
+  };
+
+ private:
+  //---------------------
+  // Private Variables
+  //---------------------
+  unsigned long num_rows_;
+  int num_sums_;
+  std::vector<double> sums_;
+};
+
+#endif  // BLOCK_SUMS_H
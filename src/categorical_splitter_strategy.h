@@ -1,21 +1,26 @@
 #ifndef CATEGORICAL_SPLITTER_STRATEGY_H
 #define CATEGORICAL_SPLITTER_STRATEGY_H
 
-#include "generic_splitter_strategy.h"
+#include "gbm_platform.h"
+#include "node_parameters.h"
+#include "splitter_arena.h"
+#include <algorithm>
 
-class categorical_splitter_strategy : public generic_splitter_strategy {
+// the category totals and their order are kept in the thread's arena
+class categorical_splitter_strategy {
  public:
   categorical_splitter_strategy(unsigned long min_num_node_obs,
-                                unsigned long size)
-      : min_num_node_obs_(min_num_node_obs), group_(size){};
-
-  generic_splitter_strategy* clone() const {
-    return new categorical_splitter_strategy(*this);
-  }
+                                unsigned long size, long monotonicity,
+                                SplitterArena& arena)
+      : min_num_node_obs_(min_num_node_obs),
+        group_(arena.groups),
+        groupMeanAndCat_(arena.group_means) {
+    group_.assign(size, NodeDef());
+  };
 
   void incorporate_obs(NodeParams& bestsplit, NodeParams& proposedsplit,
                        double xval, double residval, double weight) {
-    if (ISNA(xval)) {
+    if (gbm_platform::IsNA(xval)) {
       proposedsplit.UpdateMissingNode(weight * residval, weight);
       return;
     }
@@ -24,8 +29,21 @@ class categorical_splitter_strategy : public generic_splitter_strategy {
     group_[cat].increment(weight * residval, weight, 1);
   }
 
+  void incorporate_bin(NodeParams& bestsplit, NodeParams& proposedsplit,
+                       double xval, const NodeDef& bin) {
+    if (gbm_platform::IsNA(xval)) {
+      proposedsplit.UpdateMissingNode(bin);
+      return;
+    }
+
+    unsigned long cat = xval;
+    group_[cat].increment(bin.get_weightresid(), bin.get_totalweight(),
+                          bin.get_num_obs());
+  }
+
   void wrap_up(NodeParams& bestsplit, NodeParams& proposedsplit) {
-    std::vector<std::pair<double, int> > groupMeanAndCat(group_.size());
+    std::vector<std::pair<double, int> >& groupMeanAndCat = groupMeanAndCat_;
+    groupMeanAndCat.resize(group_.size());
     unsigned long num_finite_means = 0;
 
     // sort the groups
@@ -63,7 +81,8 @@ class categorical_splitter_strategy : public generic_splitter_strategy {
 
  private:
   unsigned long min_num_node_obs_;
-  std::vector<NodeDef> group_;
+  std::vector<NodeDef>& group_;
+  std::vector<std::pair<double, int> >& groupMeanAndCat_;
 };
 
 #endif
@@ -16,7 +16,6 @@
 #include "dataset.h"
 #include "distribution.h"
 #include "generic_cox_state.h"
-#include <Rcpp.h>
 
 //------------------------------
 // Class Definition
@@ -45,6 +44,8 @@ class CensoredCoxState : public GenericCoxState {
                   &martingale_resid[0], false);
 
     // Fill up response
+#pragma omp parallel for schedule(static, coxph_->get_array_chunk_size()) \
+    num_threads(coxph_->get_num_threads())
     for (unsigned long i = 0; i < kData.get_trainsize(); i++) {
       if (kBag.get_element(i)) {
         residuals[i] =
@@ -111,6 +112,8 @@ class CensoredCoxState : public GenericCoxState {
     std::vector<double> eta_adj(kData.get_trainsize(), 0.0);
 
     // Fill up the adjusted and shrunk eta
+#pragma omp parallel for schedule(static, coxph_->get_array_chunk_size()) \
+    num_threads(coxph_->get_num_threads())
     for (unsigned long i = 0; i < kData.get_trainsize(); i++) {
       if (!kBag.get_element(i)) {
         eta_adj[i] = kFuncEstimate[i] + kShrinkage * kDeltaEstimate[i];
@@ -173,6 +176,9 @@ class CensoredCoxState : public GenericCoxState {
       }
     }
 
+    // Risk scores of the rows relative to the center
+    ComputeRiskScores(*coxph_, n, kData, eta, center);
+
     // Loop over patients
     for (person = 0; person < n;) {
       p2 = kData.yint_ptr(1)[person];
@@ -180,10 +186,9 @@ class CensoredCoxState : public GenericCoxState {
       if (skipbag || (kBag.get_element(p2) == checkinbag)) {
         if (kData.y_ptr(1)[p2] == 0) {
           /* add the subject to the risk set */
-          resid[p2] = exp(eta[p2] + kData.offset_ptr()[p2] - center) * cumhaz;
+          resid[p2] = risk_scores_[p2] * cumhaz;
           nrisk++;
-          denom += kData.weight_ptr()[p2] *
-                   exp(eta[p2] + kData.offset_ptr()[p2] - center);
+          denom += kData.weight_ptr()[p2] * risk_scores_[p2];
           esum += eta[p2] + kData.offset_ptr()[p2];
           person++;
         } else {
@@ -202,14 +207,12 @@ class CensoredCoxState : public GenericCoxState {
                 break;  // only tied times
               }
               nrisk++;
-              denom += kData.weight_ptr()[p2] *
-                       exp(eta[p2] + kData.offset_ptr()[p2] - center);
+              denom += kData.weight_ptr()[p2] * risk_scores_[p2];
               esum += eta[p2] + kData.offset_ptr()[p2];
               if (kData.y_ptr(1)[p2] == 1) {
                 ndeath++;
                 deathwt += kData.weight_ptr()[p2];
-                d_denom += kData.weight_ptr()[p2] *
-                           exp(eta[p2] + kData.offset_ptr()[p2] - center);
+                d_denom += kData.weight_ptr()[p2] * risk_scores_[p2];
                 loglik += kData.weight_ptr()[p2] *
                           (eta[p2] + kData.offset_ptr()[p2] - center);
               }
@@ -246,11 +249,9 @@ class CensoredCoxState : public GenericCoxState {
             // Check if person in stratum in/out of bag
             if (skipbag || (kBag.get_element(p2) == checkinbag)) {
               if (kData.y_ptr(1)[p2] == 1)
-                resid[p2] =
-                    1 + temp * exp(eta[p2] + kData.offset_ptr()[p2] - center);
+                resid[p2] = 1 + temp * risk_scores_[p2];
               else
-                resid[p2] =
-                    cumhaz * exp(eta[p2] + kData.offset_ptr()[p2] - center);
+                resid[p2] = cumhaz * risk_scores_[p2];
             }
           }
           cumhaz += hazard;
@@ -260,6 +261,7 @@ class CensoredCoxState : public GenericCoxState {
             temp = esum / nrisk - center;
             center += temp;
             denom /= exp(temp);
+            ComputeRiskScores(*coxph_, n, kData, eta, center);
           }
         }
       } else {
@@ -274,8 +276,7 @@ class CensoredCoxState : public GenericCoxState {
 
           // Check bagging status
           if (skipbag || (kBag.get_element(p2) == checkinbag)) {
-            resid[p2] -=
-            		    cumhaz * exp(eta[p2] + kData.offset_ptr()[p2] - center);
+            resid[p2] -= cumhaz * risk_scores_[p2];
           }
         }
         cumhaz = 0;
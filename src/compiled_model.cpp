@@ -0,0 +1,450 @@
+//-----------------------------------
+//
+// File: compiled_model.cpp
+//
+// Description: packs the fitted trees into flat arrays once so that
+//   predictions need not walk the separate trees again.
+//
+//-----------------------------------
+
+//-----------------------------------
+// Includes
+//-----------------------------------
+#include "compiled_model.h"
+#include <algorithm>
+
+//----------------------------------------
+// Function Members - Public
+//----------------------------------------
+//-----------------------------------
+// Function: CompiledModel
+//
+// Returns: none
+//
+// Description: packs the trees and categorical splits of a fitted model.
+//
+// Parameters:
+//  kFittedTrees - the fitted trees - only their split variables, split
+//                 values, left, right and missing nodes are used
+//  kCategoricalSplits - the categorical splits, -1 for levels going left,
+//                       1 for those going right
+//  kVarTypes - 0 for a continuous variable, its number of levels for a
+//              categorical one
+//-----------------------------------
+CompiledModel::CompiledModel(
+    const std::vector<TreeArrays>& kFittedTrees,
+    const std::vector<std::vector<int> >& kCategoricalSplits,
+    const Span<const int>& kVarTypes) {
+  const int kNumVars = kVarTypes.size();
+  std::vector<int> tree_roots;
+  std::vector<int> split_var, left_node, right_node, missing_node;
+  std::vector<int> category_split;
+  std::vector<double> split_value;
+  for (unsigned long tree = 0; tree < kFittedTrees.size(); tree++) {
+    const std::vector<int>& kThisSplitVar = kFittedTrees[tree].split_vars;
+    const std::vector<double>& kThisSplitCode =
+        kFittedTrees[tree].split_values;
+    const std::vector<int>& kThisLeftNode = kFittedTrees[tree].left_nodes;
+    const std::vector<int>& kThisRightNode = kFittedTrees[tree].right_nodes;
+    const std::vector<int>& kThisMissingNode =
+        kFittedTrees[tree].missing_nodes;
+    const int kRoot = split_var.size();
+
+    tree_roots.push_back(kRoot);
+    for (unsigned long node = 0; node < kThisSplitVar.size(); node++) {
+      const int kVar = kThisSplitVar[node];
+      split_var.push_back(kVar);
+      split_value.push_back(kThisSplitCode[node]);
+      if (kVar == -1) {
+        left_node.push_back(-1);
+        right_node.push_back(-1);
+        missing_node.push_back(-1);
+        category_split.push_back(-1);
+        continue;
+      }
+
+      if ((kVar < 0) || (kVar >= kNumVars)) {
+        throw gbm_exception::InvalidArgument(
+            "split variable out of range of the variable types");
+      }
+      left_node.push_back(kRoot + kThisLeftNode[node]);
+      right_node.push_back(kRoot + kThisRightNode[node]);
+      missing_node.push_back(kRoot + kThisMissingNode[node]);
+      if (kVarTypes[kVar] == 0) {
+        category_split.push_back(-1);
+      } else {
+        const int kCatSplit = (int)kThisSplitCode[node];
+        if ((kCatSplit < 0) || (kCatSplit >= int(kCategoricalSplits.size()))) {
+          throw gbm_exception::InvalidArgument(
+              "categorical split out of range of the splits");
+        }
+        category_split.push_back(kCatSplit);
+      }
+    }
+  }
+
+  std::vector<int> category_levels;
+  std::vector<unsigned int> category_words, left_bits, right_bits;
+  for (unsigned long split = 0; split < kCategoricalSplits.size(); split++) {
+    const std::vector<int>& kThisSplit = kCategoricalSplits[split];
+    const int kNumWords = (kThisSplit.size() + kWordBits - 1) / kWordBits;
+    const unsigned int kFirstWord = left_bits.size();
+
+    category_levels.push_back(kThisSplit.size());
+    category_words.push_back(kFirstWord);
+    left_bits.resize(kFirstWord + kNumWords, 0);
+    right_bits.resize(kFirstWord + kNumWords, 0);
+    for (int level = 0; level < int(kThisSplit.size()); level++) {
+      const unsigned int kBit = 1u << (level % kWordBits);
+      if (kThisSplit[level] == -1) {
+        left_bits[kFirstWord + level / kWordBits] |= kBit;
+      } else if (kThisSplit[level] == 1) {
+        right_bits[kFirstWord + level / kWordBits] |= kBit;
+      }
+    }
+  }
+
+  ImageSizes sizes;
+  sizes.num_vars = kNumVars;
+  sizes.num_trees = tree_roots.size();
+  sizes.num_nodes = split_var.size();
+  sizes.num_category_splits = category_levels.size();
+  sizes.num_words = left_bits.size();
+  sizes.unused = 0;
+
+  // doubles keep the image aligned for its split values
+  storage_.resize(ImageBytes(sizes) / sizeof(double), 0.0);
+  char* image = reinterpret_cast<char*>(&storage_[0]);
+  *reinterpret_cast<ImageSizes*>(image) = sizes;
+  SetArrays(image);
+  std::copy(tree_roots.begin(), tree_roots.end(),
+            const_cast<int*>(tree_roots_));
+  std::copy(split_var.begin(), split_var.end(), const_cast<int*>(split_var_));
+  std::copy(left_node.begin(), left_node.end(), const_cast<int*>(left_node_));
+  std::copy(right_node.begin(), right_node.end(),
+            const_cast<int*>(right_node_));
+  std::copy(missing_node.begin(), missing_node.end(),
+            const_cast<int*>(missing_node_));
+  std::copy(category_split.begin(), category_split.end(),
+            const_cast<int*>(category_split_));
+  std::copy(split_value.begin(), split_value.end(),
+            const_cast<double*>(split_value_));
+  std::copy(category_levels.begin(), category_levels.end(),
+            const_cast<int*>(category_levels_));
+  std::copy(category_words.begin(), category_words.end(),
+            const_cast<unsigned int*>(category_words_));
+  std::copy(left_bits.begin(), left_bits.end(),
+            const_cast<unsigned int*>(left_bits_));
+  std::copy(right_bits.begin(), right_bits.end(),
+            const_cast<unsigned int*>(right_bits_));
+
+  quick_scorer_.Initialize(*this);
+}
+
+//-----------------------------------
+// Function: CompiledModel
+//
+// Returns: none
+//
+// Description: uses the image of a model file in place, checking that
+//   it describes valid trees - every child after its parent and within
+//   its tree, every node reached once and every index in range - so
+//   that corrupt files cannot be scored.
+//
+// Parameters:
+//  file - the model file, held by the model from now on
+//-----------------------------------
+CompiledModel::CompiledModel(std::auto_ptr<ModelFile> file) {
+  if (file->image_bytes() < sizeof(ImageSizes)) {
+    throw gbm_exception::InvalidArgument("model file is truncated");
+  }
+  const ImageSizes* kSizes =
+      reinterpret_cast<const ImageSizes*>(file->image());
+  if ((kSizes->num_vars < 0) || (kSizes->num_trees < 0) ||
+      (kSizes->num_nodes < 0) || (kSizes->num_category_splits < 0) ||
+      (kSizes->num_words < 0) ||
+      (ImageBytes(*kSizes) != file->image_bytes())) {
+    throw gbm_exception::InvalidArgument(
+        "model file sizes do not match its length");
+  }
+
+  SetArrays(file->image());
+  CheckArrays();
+  file_ = file;
+  quick_scorer_.Initialize(*this);
+}
+
+//-----------------------------------
+// Function: Predict
+//
+// Returns: none
+//
+// Description: predicts the rows of column-major data for each number of
+//   trees asked for.  Rows are scored in blocks, in parallel, and each
+//   block runs through all of the trees before the next is started - a
+//   block holds at most array chunk size rows, fewer for wide data so
+//   that the block's part of each column stays in cache.  The trees of
+//   a row are summed in order whatever the number of threads.  Models of
+//   small trees are scored with their leaf bitvectors when at least half
+//   of their trees are used, giving the same predictions.
+//
+// Parameters:
+//  kCovariates - the predictor values, column-major
+//  num_rows - the number of rows of the data
+//  kNumTrees - the increasing numbers of trees to predict with
+//  num_iterations - the number of entries of kNumTrees
+//  initial_estimate - the initial function estimate
+//  single_tree - if true, predict with tree kNumTrees[i] alone
+//  kParallel - parallelization-related constants
+//  predictions - set to num_rows predictions for each number of trees
+//-----------------------------------
+void CompiledModel::Predict(const double* kCovariates, long num_rows,
+                            const int* kNumTrees, int num_iterations,
+                            double initial_estimate, bool single_tree,
+                            const parallel_details& kParallel,
+                            double* predictions) const {
+  for (int iteration = 0; iteration < num_iterations; iteration++) {
+    if ((kNumTrees[iteration] > num_trees()) ||
+        (kNumTrees[iteration] < (single_tree ? 1 : 0))) {
+      throw gbm_exception::InvalidArgument(
+          "number of trees out of range of the model");
+    }
+  }
+
+  const long kBlockRows = std::max(
+      1L, std::min((long)kParallel.get_array_chunk_size(),
+                   kBlockValues / std::max(num_vars(), 1)));
+  const long kNumBlocks = (num_rows + kBlockRows - 1) / kBlockRows;
+  const bool kUseQuickScorer =
+      !quick_scorer_.empty() && !single_tree && (num_iterations > 0) &&
+      (2 * kNumTrees[num_iterations - 1] >= num_trees());
+
+#pragma omp parallel for schedule(static) num_threads(kParallel.get_num_threads())
+  for (long block = 0; block < kNumBlocks; block++) {
+    const long kBlockBegin = block * kBlockRows;
+    const long kBlockEnd = std::min(kBlockBegin + kBlockRows, num_rows);
+    if (kUseQuickScorer) {
+      QuickPredictBlock(kCovariates, num_rows, kBlockBegin, kBlockEnd,
+                        kNumTrees, num_iterations, initial_estimate,
+                        predictions);
+    } else {
+      PredictBlock(kCovariates, num_rows, kBlockBegin, kBlockEnd, kNumTrees,
+                   num_iterations, initial_estimate, single_tree,
+                   predictions);
+    }
+  }
+}
+
+//----------------------------------------
+// Function Members - Private
+//----------------------------------------
+//-----------------------------------
+// Function: ImageBytes
+//
+// Returns: the length of the image of a model, a multiple of 8 bytes
+//
+// Description: the image holds the sizes, the split values, the node
+//   arrays and then the categorical splits.
+//
+// Parameters:
+//  kSizes - the numbers of entries of the arrays
+//-----------------------------------
+unsigned long CompiledModel::ImageBytes(const ImageSizes& kSizes) {
+  const unsigned long kNumInts =
+      (unsigned long)kSizes.num_trees + 5UL * kSizes.num_nodes +
+      2UL * kSizes.num_category_splits + 2UL * kSizes.num_words;
+  const unsigned long kBytes = sizeof(ImageSizes) +
+                               kSizes.num_nodes * sizeof(double) +
+                               kNumInts * sizeof(int);
+  return (kBytes + sizeof(double) - 1) / sizeof(double) * sizeof(double);
+}
+
+//-----------------------------------
+// Function: SetArrays
+//
+// Returns: none
+//
+// Description: points the arrays of the model into an image.
+//
+// Parameters:
+//  kImage - the image, aligned for doubles, starting with its sizes
+//-----------------------------------
+void CompiledModel::SetArrays(const char* kImage) {
+  image_ = kImage;
+  sizes_ = reinterpret_cast<const ImageSizes*>(kImage);
+  split_value_ = reinterpret_cast<const double*>(kImage + sizeof(ImageSizes));
+
+  const int* next = reinterpret_cast<const int*>(split_value_ +
+                                                 sizes_->num_nodes);
+  tree_roots_ = next;
+  next += sizes_->num_trees;
+  split_var_ = next;
+  next += sizes_->num_nodes;
+  left_node_ = next;
+  next += sizes_->num_nodes;
+  right_node_ = next;
+  next += sizes_->num_nodes;
+  missing_node_ = next;
+  next += sizes_->num_nodes;
+  category_split_ = next;
+  next += sizes_->num_nodes;
+  category_levels_ = next;
+  next += sizes_->num_category_splits;
+
+  category_words_ = reinterpret_cast<const unsigned int*>(next);
+  left_bits_ = category_words_ + sizes_->num_category_splits;
+  right_bits_ = left_bits_ + sizes_->num_words;
+}
+
+//-----------------------------------
+// Function: CheckArrays
+//
+// Returns: none
+//
+// Description: checks the arrays describe trees that can be scored - the
+//   nodes of each tree run from its root to the next tree's root, and each
+//   of them is reached once from the root, its children coming after it.
+//
+// Parameters: none
+//-----------------------------------
+void CompiledModel::CheckArrays() const {
+  const int kNumNodes = sizes_->num_nodes;
+  if ((num_trees() == 0) ? (kNumNodes != 0) : (tree_roots_[0] != 0)) {
+    throw gbm_exception::InvalidArgument("model file has an invalid tree");
+  }
+
+  // the number of splits leading to each node
+  std::vector<int> num_parents(kNumNodes, 0);
+  for (int tree = 0; tree < num_trees(); tree++) {
+    const int kRoot = tree_roots_[tree];
+    const int kEnd =
+        (tree + 1 < num_trees()) ? tree_roots_[tree + 1] : kNumNodes;
+    if ((kRoot >= kEnd) || (kEnd > kNumNodes)) {
+      throw gbm_exception::InvalidArgument("model file has an invalid tree");
+    }
+
+    for (int node = kRoot; node < kEnd; node++) {
+      if (split_var_[node] == -1) continue;
+
+      const bool kValidNode =
+          (split_var_[node] >= 0) && (split_var_[node] < num_vars()) &&
+          (left_node_[node] > node) && (left_node_[node] < kEnd) &&
+          (right_node_[node] > node) && (right_node_[node] < kEnd) &&
+          (missing_node_[node] > node) && (missing_node_[node] < kEnd) &&
+          (category_split_[node] >= -1) &&
+          (category_split_[node] < num_category_splits());
+      if (!kValidNode) {
+        throw gbm_exception::InvalidArgument("model file has an invalid node");
+      }
+      num_parents[left_node_[node]]++;
+      num_parents[right_node_[node]]++;
+      num_parents[missing_node_[node]]++;
+    }
+
+    // with the children after their parents, one parent each reaches every
+    // node of the tree once
+    for (int node = kRoot + 1; node < kEnd; node++) {
+      if (num_parents[node] != 1) {
+        throw gbm_exception::InvalidArgument("model file has an invalid node");
+      }
+    }
+  }
+
+  for (int split = 0; split < num_category_splits(); split++) {
+    const int kNumWords =
+        (category_levels_[split] + kWordBits - 1) / kWordBits;
+    if ((category_levels_[split] < 0) || (kNumWords > sizes_->num_words) ||
+        (category_words_[split] >
+         (unsigned int)(sizes_->num_words - kNumWords))) {
+      throw gbm_exception::InvalidArgument(
+          "model file has an invalid categorical split");
+    }
+  }
+}
+
+//-----------------------------------
+// Function: PredictBlock
+//
+// Returns: none
+//
+// Description: predicts a block of rows for each number of trees asked
+//   for, summing the trees of each row in order.
+//
+// Parameters:
+//  kCovariates - the predictor values, column-major
+//  num_rows - the number of rows of the data
+//  block_begin, block_end - the rows of the block
+//  kNumTrees - the increasing numbers of trees to predict with
+//  num_iterations - the number of entries of kNumTrees
+//  initial_estimate - the initial function estimate
+//  single_tree - if true, predict with tree kNumTrees[i] alone
+//  predictions - set to num_rows predictions for each number of trees
+//-----------------------------------
+void CompiledModel::PredictBlock(const double* kCovariates, long num_rows,
+                                 long block_begin, long block_end,
+                                 const int* kNumTrees, int num_iterations,
+                                 double initial_estimate, bool single_tree,
+                                 double* predictions) const {
+  int tree = 0;
+  for (int iteration = 0; iteration < num_iterations; iteration++) {
+    double* iteration_predictions = predictions + num_rows * iteration;
+    if (single_tree) {
+      std::fill(iteration_predictions + block_begin,
+                iteration_predictions + block_end, 0.0);
+      tree = kNumTrees[iteration] - 1;
+    } else if (iteration == 0) {
+      std::fill(iteration_predictions + block_begin,
+                iteration_predictions + block_end, initial_estimate);
+    } else {
+      std::copy(iteration_predictions - num_rows + block_begin,
+                iteration_predictions - num_rows + block_end,
+                iteration_predictions + block_begin);
+    }
+
+    for (; tree < kNumTrees[iteration]; tree++) {
+      for (long row = block_begin; row < block_end; row++) {
+        iteration_predictions[row] +=
+            PredictTree(tree, kCovariates, num_rows, row);
+      }
+    }
+  }
+}
+
+//-----------------------------------
+// Function: QuickPredictBlock
+//
+// Returns: none
+//
+// Description: predicts a block of rows for each number of trees asked
+//   for from the leaves each row reaches, summing the trees of each row
+//   in order.
+//
+// Parameters:
+//  kCovariates - the predictor values, column-major
+//  num_rows - the number of rows of the data
+//  block_begin, block_end - the rows of the block
+//  kNumTrees - the increasing numbers of trees to predict with
+//  num_iterations - the number of entries of kNumTrees
+//  initial_estimate - the initial function estimate
+//  predictions - set to num_rows predictions for each number of trees
+//-----------------------------------
+void CompiledModel::QuickPredictBlock(const double* kCovariates,
+                                      long num_rows, long block_begin,
+                                      long block_end, const int* kNumTrees,
+                                      int num_iterations,
+                                      double initial_estimate,
+                                      double* predictions) const {
+  std::vector<unsigned int> leaf_bits(num_trees());
+  for (long row = block_begin; row < block_end; row++) {
+    quick_scorer_.ScoreRow(*this, kCovariates, num_rows, row, &leaf_bits[0]);
+
+    double prediction = initial_estimate;
+    int tree = 0;
+    for (int iteration = 0; iteration < num_iterations; iteration++) {
+      for (; tree < kNumTrees[iteration]; tree++) {
+        prediction += quick_scorer_.leaf_value(tree, leaf_bits[tree]);
+      }
+      predictions[num_rows * iteration + row] = prediction;
+    }
+  }
+}
@@ -0,0 +1,174 @@
+//------------------------------------------------------------------------------
+//
+//  File:       compiled_model.h
+//
+//  Description: header for the compiled model - the fitted trees packed
+//    into flat arrays, with categorical splits as bitsets, for prediction.
+//    The arrays lie one after another in a single image, which model files
+//    hold as it stands so that it can be mapped and scored in place.
+//
+//------------------------------------------------------------------------------
+
+#ifndef COMPILEDMODEL_H
+#define COMPILEDMODEL_H
+
+//------------------------------
+// Includes
+//------------------------------
+#include "gbm_exception.h"
+#include "model_file.h"
+#include "parallel_details.h"
+#include "gbm_platform.h"
+#include "quick_scorer.h"
+#include "span.h"
+#include "tree_arrays.h"
+#include <memory>
+#include <vector>
+
+//------------------------------
+// Class definition
+//------------------------------
+class CompiledModel {
+ public:
+  //----------------------
+  // Public Constructors
+  //----------------------
+  CompiledModel(const std::vector<TreeArrays>& kFittedTrees,
+                const std::vector<std::vector<int> >& kCategoricalSplits,
+                const Span<const int>& kVarTypes);
+  explicit CompiledModel(std::auto_ptr<ModelFile> file);
+
+  //---------------------
+  // Public destructor
+  //---------------------
+  ~CompiledModel(){};
+
+  //---------------------
+  // Public Functions
+  //---------------------
+  int num_trees() const { return sizes_->num_trees; };
+  int num_vars() const { return sizes_->num_vars; };
+
+  // the arrays of the model as a single image
+  const char* image() const { return image_; };
+  unsigned long image_bytes() const { return ImageBytes(*sizes_); };
+
+  void Predict(const double* kCovariates, long num_rows,
+               const int* kNumTrees, int num_iterations,
+               double initial_estimate, bool single_tree,
+               const parallel_details& kParallel,
+               double* predictions) const;
+
+  // prediction of one tree for a row of column-major data
+  double PredictTree(int tree, const double* kCovariates, long num_rows,
+                     long row) const {
+    int node = tree_roots_[tree];
+    while (split_var_[node] != -1) {
+      node = NextNode(node,
+                      kCovariates[split_var_[node] * num_rows + row]);
+    }
+    return split_value_[node];
+  };
+
+  // child of a node a predictor value goes to
+  int NextNode(int node, double x_value) const {
+    if (gbm_platform::IsNA(x_value)) return missing_node_[node];
+
+    const int kCatSplit = category_split_[node];
+    if (kCatSplit < 0) {
+      return (x_value < split_value_[node]) ? left_node_[node]
+                                            : right_node_[node];
+    }
+
+    // levels beyond those seen in training go to the missing node
+    const int kLevel = (int)x_value;
+    if ((kLevel < 0) || (kLevel >= category_levels_[kCatSplit])) {
+      return missing_node_[node];
+    }
+    const unsigned int kWord = category_words_[kCatSplit] + kLevel / kWordBits;
+    const unsigned int kBit = 1u << (kLevel % kWordBits);
+    if (left_bits_[kWord] & kBit) return left_node_[node];
+    if (right_bits_[kWord] & kBit) return right_node_[node];
+    return missing_node_[node];
+  };
+
+  // nodes of the packed trees
+  int tree_root(int tree) const { return tree_roots_[tree]; };
+  int split_var(int node) const { return split_var_[node]; };
+  double split_value(int node) const { return split_value_[node]; };
+  int left_node(int node) const { return left_node_[node]; };
+  int right_node(int node) const { return right_node_[node]; };
+  int missing_node(int node) const { return missing_node_[node]; };
+  bool is_categorical(int node) const { return category_split_[node] >= 0; };
+  int num_levels(int node) const {
+    return category_levels_[category_split_[node]];
+  };
+  int category_split(int node) const { return category_split_[node]; };
+
+  // categorical splits, a bit per level in words of kWordBits
+  static const int kWordBits = 32;
+  int num_category_splits() const { return sizes_->num_category_splits; };
+  int category_levels(int split) const { return category_levels_[split]; };
+  unsigned int left_bits(int split, int word) const {
+    return left_bits_[category_words_[split] + word];
+  };
+  unsigned int right_bits(int split, int word) const {
+    return right_bits_[category_words_[split] + word];
+  };
+
+ private:
+  // numbers of entries of the arrays, at the start of the image
+  struct ImageSizes {
+    int num_vars, num_trees, num_nodes, num_category_splits, num_words;
+    int unused;
+  };
+
+  //---------------------
+  // Private Functions
+  //---------------------
+  static unsigned long ImageBytes(const ImageSizes& kSizes);
+  void SetArrays(const char* kImage);
+  void CheckArrays() const;
+  void PredictBlock(const double* kCovariates, long num_rows,
+                    long block_begin, long block_end, const int* kNumTrees,
+                    int num_iterations, double initial_estimate,
+                    bool single_tree, double* predictions) const;
+  void QuickPredictBlock(const double* kCovariates, long num_rows,
+                         long block_begin, long block_end,
+                         const int* kNumTrees, int num_iterations,
+                         double initial_estimate, double* predictions) const;
+
+  //-------------------
+  // Private Variables
+  //-------------------
+  // number of predictor values of a block of rows kept in cache
+  static const long kBlockValues = 32768;
+
+  // the image, held by the model or by the file it was mapped from
+  std::vector<double> storage_;
+  std::auto_ptr<ModelFile> file_;
+  const char* image_;
+  const ImageSizes* sizes_;
+
+  // nodes of all trees, each tree's children indexed from the start of
+  // the arrays - leaves have split var -1 and their prediction as split
+  // value
+  const int* tree_roots_;
+  const int* split_var_;
+  const int* left_node_;
+  const int* right_node_;
+  const int* missing_node_;
+  const int* category_split_;
+  const double* split_value_;
+
+  // categorical splits - a bit per level for the left and right children
+  const int* category_levels_;
+  const unsigned int* category_words_;
+  const unsigned int* left_bits_;
+  const unsigned int* right_bits_;
+
+  // bitvector scoring, empty when a tree has too many leaves
+  QuickScorer quick_scorer_;
+};
+
+#endif  // COMPILEDMODEL_H
@@ -16,7 +16,6 @@
 #include "dataset.h"
 #include "distribution.h"
 #include "generic_cox_state.h"
-#include <Rcpp.h>
 
 //------------------------------
 // Class Definition
@@ -45,6 +44,8 @@ class CountingCoxState : public GenericCoxState {
                            &martingale_resid[0], false);
 
     // Fill up response
+#pragma omp parallel for schedule(static, coxph_->get_array_chunk_size()) \
+    num_threads(coxph_->get_num_threads())
     for (unsigned long i = 0; i < kData.get_trainsize(); i++) {
       if (kBag.get_element(i)) {
         residuals[i] =
@@ -111,6 +112,8 @@ class CountingCoxState : public GenericCoxState {
     std::vector<double> eta_adj(kData.get_trainsize(), 0.0);
 
     // Fill up the adjusted and shrunk eta
+#pragma omp parallel for schedule(static, coxph_->get_array_chunk_size()) \
+    num_threads(coxph_->get_num_threads())
     for (unsigned long i = 0; i < kData.get_trainsize(); i++) {
       if (!kBag.get_element(i)) {
         eta_adj[i] = kFuncEstimate[i] + kShrinkage * kDeltaEstimate[i];
@@ -188,16 +191,18 @@ class CountingCoxState : public GenericCoxState {
       }
     }
 
+    // Risk scores of the rows relative to the center
+    ComputeRiskScores(*coxph_, n, kData, eta, center);
+
     for (person = 0; person < n;) {
       p2 = kData.yint_ptr(2)[person];
       // Check if bagging is required
       if (skipbag || (kBag.get_element(p2) == checkinbag)) {
         if (kData.y_ptr(2)[p2] == 0) {
           // add the subject to the risk set
-          resid[p2] = exp(eta[p2] + kData.offset_ptr()[p2] - center) * cumhaz;
+          resid[p2] = risk_scores_[p2] * cumhaz;
           nrisk++;
-          denom += kData.weight_ptr()[p2] *
-                   exp(eta[p2] + kData.offset_ptr()[p2] - center);
+          denom += kData.weight_ptr()[p2] * risk_scores_[p2];
           esum += eta[p2] + kData.offset_ptr()[p2];
           person++;
         } else {
@@ -212,10 +217,8 @@ class CountingCoxState : public GenericCoxState {
             if (skipbag || (kBag.get_element(p1) == checkinbag)) {
               if (kData.y_ptr(0)[p1] < dtime) break; /* still in the risk set */
               nrisk--;
-              resid[p1] -=
-                  cumhaz * exp(eta[p1] + kData.offset_ptr()[p1] - center);
-              denom -= kData.weight_ptr()[p1] *
-                       exp(eta[p1] + kData.offset_ptr()[p1] - center);
+              resid[p1] -= cumhaz * risk_scores_[p1];
+              denom -= kData.weight_ptr()[p1] * risk_scores_[p1];
               esum -= eta[p1] + kData.offset_ptr()[p1];
             }
           }
@@ -237,14 +240,12 @@ class CountingCoxState : public GenericCoxState {
             if (skipbag || (kBag.get_element(p2) == checkinbag)) {
               if (kData.y_ptr(1)[p2] < dtime) break;  // only tied times
               nrisk++;
-              denom += kData.weight_ptr()[p2] *
-                       exp(eta[p2] + kData.offset_ptr()[p2] - center);
+              denom += kData.weight_ptr()[p2] * risk_scores_[p2];
               esum += eta[p2];
               if (kData.y_ptr(2)[p2] == 1) {
                 ndeath++;
                 deathwt += kData.weight_ptr()[p2];
-                d_denom += kData.weight_ptr()[p2] *
-                           exp(eta[p2] + kData.offset_ptr()[p2] - center);
+                d_denom += kData.weight_ptr()[p2] * risk_scores_[p2];
                 loglik += kData.weight_ptr()[p2] *
                           (eta[p2] + kData.offset_ptr()[p2] - center);
               }
@@ -281,11 +282,9 @@ class CountingCoxState : public GenericCoxState {
             p2 = kData.yint_ptr(2)[person];
             if (skipbag || (kBag.get_element(p2) == checkinbag)) {
               if (kData.y_ptr(2)[p2] == 1)
-                resid[p2] =
-                    1 + temp * exp(eta[p2] + kData.offset_ptr()[p2] - center);
+                resid[p2] = 1 + temp * risk_scores_[p2];
               else
-                resid[p2] =
-                    cumhaz * exp(eta[p2] + kData.offset_ptr()[p2] - center);
+                resid[p2] = cumhaz * risk_scores_[p2];
             }
           }
           cumhaz += hazard;
@@ -295,6 +294,7 @@ class CountingCoxState : public GenericCoxState {
             temp = esum / nrisk - center;
             center += temp;
             denom /= exp(temp);
+            ComputeRiskScores(*coxph_, n, kData, eta, center);
           }
         }
       } else {
@@ -307,8 +307,7 @@ class CountingCoxState : public GenericCoxState {
         for (; indx1 < kData.yint_ptr()[istrat]; indx1++) {
           p1 = kData.yint_ptr(1)[indx1];
           if (skipbag || (kBag.get_element(p1) == checkinbag)) {
-            resid[p1] -=
-                cumhaz * exp(eta[p1] + kData.offset_ptr()[p1] - center);
+            resid[p1] -= cumhaz * risk_scores_[p1];
           }
         }
         cumhaz = 0;
@@ -12,7 +12,6 @@
 #include "coxph.h"
 #include "censored_cox_state.h"
 #include "counting_cox_state.h"
-#include <Rinternals.h>
 #include <math.h>
 
 namespace {
@@ -30,8 +29,10 @@ int GetTiesMethod(const std::string& selection) {
 //----------------------------------------
 // Function Members - Private
 //----------------------------------------
-CCoxPH::CCoxPH(bool is_startstop, int tiesmethod, double priorcoeff)
-    : kStartStopCase_(is_startstop),
+CCoxPH::CCoxPH(const parallel_details& parallel, bool is_startstop,
+               int tiesmethod, double priorcoeff)
+    : CDistribution(parallel),
+      kStartStopCase_(is_startstop),
       kPriorCoeffVariation_(priorcoeff) {
   tiedtimesmethod_ = tiesmethod;
 
@@ -48,9 +49,9 @@ CCoxPH::CCoxPH(bool is_startstop, int tiesmethod, double priorcoeff)
 //----------------------------------------
 CDistribution* CCoxPH::Create(DataDistParams& distparams) {
   // Initialize variables to pass to constructor
-  int tiesmethod = GetTiesMethod(Rcpp::as<string>(distparams.misc[0]));
+  int tiesmethod = GetTiesMethod(distparams.misc_string);
 
-  return new CCoxPH(distparams.response.ncol() > 2,
+  return new CCoxPH(distparams.parallel, distparams.response.ncol() > 2,
 		    tiesmethod,
 		    distparams.prior_coefficient_variation);
 }
@@ -67,7 +67,8 @@ class CCoxPH : public CDistribution {
   //----------------------
   // Private Constructors
   //----------------------
-  CCoxPH(bool is_startstop, int tiesmethod, double priorcoeff);
+  CCoxPH(const parallel_details& parallel, bool is_startstop, int tiesmethod,
+         double priorcoeff);
 
 
   //-------------------
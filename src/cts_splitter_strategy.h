@@ -1,22 +1,23 @@
 #ifndef CTS_SPLITTER_STRATEGY_H
 #define CTS_SPLITTER_STRATEGY_H
 
-#include "generic_splitter_strategy.h"
+#include "gbm_exception.h"
+#include "gbm_platform.h"
+#include "node_parameters.h"
+#include "splitter_arena.h"
 
-class cts_splitter_strategy : public generic_splitter_strategy {
+class cts_splitter_strategy {
  public:
-  cts_splitter_strategy(unsigned long min_num_node_obs, long monotonicity)
+  cts_splitter_strategy(unsigned long min_num_node_obs,
+                        unsigned long num_classes, long monotonicity,
+                        SplitterArena& arena)
       : last_xvalue_(-HUGE_VAL),
         min_num_node_obs_(min_num_node_obs),
         monotonicity_(monotonicity){};
 
-  generic_splitter_strategy* clone() const {
-    return new cts_splitter_strategy(*this);
-  }
-
   void incorporate_obs(NodeParams& bestsplit, NodeParams& proposedsplit,
                        double xval, double residval, double weight) {
-    if (ISNA(xval)) {
+    if (gbm_platform::IsNA(xval)) {
       proposedsplit.UpdateMissingNode(weight * residval, weight);
       return;
     }
@@ -47,6 +48,30 @@ class cts_splitter_strategy : public generic_splitter_strategy {
     last_xvalue_ = xval;
   };
 
+  // bins arrive in increasing order with xval the boundary between
+  // this bin and the one before it
+  void incorporate_bin(NodeParams& bestsplit, NodeParams& proposedsplit,
+                       double xval, const NodeDef& bin) {
+    if (gbm_platform::IsNA(xval)) {
+      proposedsplit.UpdateMissingNode(bin);
+      return;
+    }
+
+    // Evaluate the split below this bin
+    proposedsplit.set_split_value(xval);
+
+    if (proposedsplit.has_min_num_obs(min_num_node_obs_) &&
+        proposedsplit.split_is_correct_monotonicity(monotonicity_)) {
+      proposedsplit.NodeGradResiduals();
+      if (proposedsplit.get_improvement() > bestsplit.get_improvement()) {
+        bestsplit = proposedsplit;
+      }
+    }
+
+    // and move the whole bin to the left
+    proposedsplit.UpdateLeftNode(bin);
+  };
+
   void wrap_up(NodeParams& bestsplit, NodeParams& proposedsplit) { return; };
 
  private:
@@ -11,7 +11,6 @@
 // Includes
 //-----------------------------------
 #include "dataset.h"
-#include <Rcpp.h>
 
 //----------------------------------------
 // Function Members - Public
@@ -37,10 +36,27 @@ CDataset::CDataset(const DataDistParams& dataparams)
       variable_monotonicity_(dataparams.variable_monotonicity),
       order_xvals_(dataparams.xorder),
       observation_ids_(dataparams.observationids) {
+  // Prepared data may come with the predictors binned in place of their
+  // values
+  bins_ = &binned_features_;
+  num_rows_ = xmatrix_.nrow();
+  num_cols_ = xmatrix_.ncol();
+  if (dataparams.binned_features) {
+    if (!dataparams.parallel.use_histograms() ||
+        (dataparams.binned_features->max_bins() !=
+         (unsigned long)dataparams.parallel.get_histogram_bins())) {
+      throw gbm_exception::InvalidArgument(
+          "the prepared data were binned for another split search");
+    }
+    bins_ = dataparams.binned_features;
+    num_rows_ = bins_->num_rows();
+    num_cols_ = bins_->num_vars();
+  }
+
   // If you've no offset set to 0
   if (!gbm_functions::has_value(response_offset_)) {
-    Rcpp::NumericVector new_offset(xmatrix_.nrow());
-    std::swap(response_offset_, new_offset);
+    zero_offset_.assign(num_rows_, 0.0);
+    response_offset_ = Span<double>(&zero_offset_[0], zero_offset_.size());
   }
 
   // Set-up pointers
@@ -51,7 +67,7 @@ CDataset::CDataset(const DataDistParams& dataparams)
   // Set-up data properties
   num_traindata_ = dataparams.num_trainrows;
   num_trainobservations_ = dataparams.num_trainobservations;
-  num_validationdata_ = xmatrix_.nrow() - dataparams.num_trainrows;
+  num_validationdata_ = num_rows_ - dataparams.num_trainrows;
   num_features_ = dataparams.num_features;
   point_at_trainingset_ = true;
 
@@ -60,20 +76,51 @@ CDataset::CDataset(const DataDistParams& dataparams)
     throw gbm_exception::InvalidArgument("you've <= 0 training instances");
   }
   // Check for errors on initialization
-  if (xmatrix_.ncol() != variable_monotonicity_.size()) {
+  if ((variable_monotonicity_.size() < 0) ||
+      (num_cols_ != (unsigned long)variable_monotonicity_.size())) {
     throw gbm_exception::InvalidArgument(
         "shape mismatch (monotone does not match data)");
   }
 
-  if (xmatrix_.ncol() != num_variable_classes_.size()) {
+  if ((num_variable_classes_.size() < 0) ||
+      (num_cols_ != (unsigned long)num_variable_classes_.size())) {
     throw gbm_exception::InvalidArgument(
         "shape mismatch (var classes does not match data)");
   }
 
-  if (xmatrix_.nrow() < int(dataparams.num_trainrows)) {
+  if (num_rows_ < dataparams.num_trainrows) {
     throw gbm_exception::InvalidArgument(
         "your training instances don't make sense");
   }
+
+  // Group the training rows by observation for bagging - prepared data
+  // come with the rows already grouped
+  if (dataparams.observation_starts.empty()) {
+    if (observation_ids_.size() < int(num_traindata_)) {
+      throw gbm_exception::InvalidArgument(
+          "shape mismatch (observation ids do not match training rows)");
+    }
+    gbm_functions::IndexObservations(observation_ids_.begin(), num_traindata_,
+                                     observation_rows_, observation_starts_);
+  } else {
+    observation_rows_ = dataparams.observation_rows;
+    observation_starts_ = dataparams.observation_starts;
+  }
+
+  // Quantize the predictors for the histogram split search - training
+  // then runs from the codes alone, so the dataset lets go of its views of
+  // the values and their order and the host may free them once it is built
+  if (dataparams.parallel.use_histograms() && !dataparams.binned_features) {
+    binned_features_.Initialize(
+        MatrixSpan<const double>(xmatrix_.begin(), num_rows_, num_cols_),
+        num_traindata_, num_variable_classes_,
+        dataparams.parallel.get_histogram_bins(),
+        dataparams.parallel.get_num_threads());
+  }
+  if (has_bins()) {
+    xmatrix_ = MatrixSpan<double>();
+    order_xvals_ = Span<int>();
+  }
 }
 
 //-----------------------------------
@@ -18,13 +18,15 @@
 //------------------------------
 // Includes
 //------------------------------
+#include "binned_features.h"
 #include "datadistparams.h"
 #include "gbm_exception.h"
 #include "gbm_functions.h"
+#include "gbm_platform.h"
+#include "span.h"
 #include <algorithm>
 #include <memory>
 #include <vector>
-#include <Rcpp.h>
 
 //------------------------------
 // Type Defs
@@ -49,8 +51,8 @@ class CDataset {
   //---------------------
   // Public Functions
   //---------------------
-  unsigned int nrow() const { return xmatrix_.nrow(); };
-  unsigned int ncol() const { return xmatrix_.ncol(); };
+  unsigned int nrow() const { return num_rows_; };
+  unsigned int ncol() const { return num_cols_; };
 
   double* y_ptr(long colIndex = 0) {
     return yptrs_[colIndex];
@@ -79,9 +81,23 @@ class CDataset {
 
   const int* order_ptr() const { return order_xvals_.begin(); };
 
+  // binned predictor codes - empty unless histogram split search is used
+  bool has_bins() const { return !bins_->empty(); };
+  const BinnedFeatures& bins() const { return *bins_; };
+
+  // retrieve predictor value - binned data only keep the lower boundary
+  // of the value's bin, which falls on the same side of every split
   double x_value(const int row, const int col) const {
+    if (has_bins()) {
+      const unsigned long kBin = bins_->code(row, col);
+      if (kBin == bins_->missing_bin(col)) return gbm_platform::NA();
+      return bins_->bin_value(col, kBin);
+    }
     return xmatrix_(row, col);
-  };  // retrieve predictor value
+  };
+
+  // the values of a predictor of data without bins
+  const double* x_column(const int col) const { return xmatrix_.column(col); };
 
   unsigned long get_trainsize() const {
     return num_traindata_;
@@ -132,7 +148,18 @@ class CDataset {
     return num_trainobservations_;
   }
   int get_row_observation_id(int row_number) const {
-    return observation_ids_(row_number);
+    return observation_ids_[row_number];
+  }
+
+  // training rows grouped by observation, observations in id order
+  unsigned long num_indexed_observations() const {
+    return observation_starts_.size() - 1;
+  }
+  const int* observation_rows_begin(unsigned long obs) const {
+    return &observation_rows_[0] + observation_starts_[obs];
+  }
+  const int* observation_rows_end(unsigned long obs) const {
+    return &observation_rows_[0] + observation_starts_[obs + 1];
   }
 
  private:
@@ -141,10 +168,10 @@ class CDataset {
   //-------------------
   void set_up_yptrs() {
     for (long i = 0; i < response_.ncol(); i++) {
-      yptrs_.push_back(response_(Rcpp::_, i).begin());
+      yptrs_.push_back(response_.column(i));
     }
     for (long i = 0; i < intResponse_.ncol(); i++) {
-      yintptrs_.push_back(intResponse_(Rcpp::_, i).begin());
+      yintptrs_.push_back(intResponse_.column(i));
     }
   }
 
@@ -169,12 +196,17 @@ class CDataset {
   // Private Variables
   //-------------------
 
-  // Numeric vectors storing data
-  Rcpp::NumericMatrix xmatrix_, response_;
-  Rcpp::IntegerMatrix intResponse_;
-  Rcpp::NumericVector response_offset_, data_weights_;
-  Rcpp::IntegerVector num_variable_classes_, variable_monotonicity_,
-      order_xvals_, observation_ids_;
+  // Views of the data held by the host
+  MatrixSpan<double> xmatrix_, response_;
+  MatrixSpan<int> intResponse_;
+  Span<double> response_offset_, data_weights_;
+  Span<int> num_variable_classes_, variable_monotonicity_, order_xvals_,
+      observation_ids_;
+  std::vector<double> zero_offset_;
+  // the bin codes built here, or those of prepared data
+  BinnedFeatures binned_features_;
+  const BinnedFeatures* bins_;
+  std::vector<int> observation_rows_, observation_starts_;
 
   // Ptrs to numeric vectors - these must be mutable
   std::vector<double*> yptrs_;
@@ -183,6 +215,8 @@ class CDataset {
   double* weights_ptr_;
 
   // Properties of the data
+  unsigned long num_rows_;
+  unsigned long num_cols_;
   unsigned long num_traindata_;
   unsigned long num_trainobservations_;
   unsigned long num_validationdata_;
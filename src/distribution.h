@@ -27,7 +27,6 @@
 #include "parallel_details.h"
 #include "tree.h"
 #include <vector>
-#include <Rcpp.h>
 
 //------------------------------
 // Class definition
@@ -64,14 +63,7 @@ class CDistribution {
   //---------------------
   // Public Virtual Functions
   //---------------------
-  virtual void Initialize(const CDataset& kData) {
-
-    // Set up multi map
-    for (unsigned long i = 0;
-         i < (kData.get_trainsize()); i++) {
-      obsid_to_row_.insert(pair<int, int>(kData.get_row_observation_id(i), i));
-    }
-  };
+  virtual void Initialize(const CDataset& kData){};
   virtual void ComputeWorkingResponse(const CDataset& kData, const Bag& kBag,
                                       const double* kFuncEstimate,
                                       std::vector<double>& residuals) = 0;
@@ -92,6 +84,20 @@ class CDistribution {
       const double kShrinkage,
       const std::vector<double>& kDeltaFuncEstimate) = 0;
 
+  // one sweep of the training rows once a tree is fitted: returns the out
+  // of bag improvement of the shrunken tree, adds it to the fit, returns
+  // the training deviance of the new fit and computes its working
+  // response, which does not depend on the bag, for the next tree -
+  // distributions without the sweep return false and change nothing
+  virtual bool FusedUpdate(const CDataset& kData, const Bag& kBag,
+                           const double kShrinkage,
+                           const std::vector<double>& kDeltaEstimate,
+                           double* func_estimate,
+                           std::vector<double>& residuals,
+                           double& oobag_improvement, double& deviance) {
+    return false;
+  };
+
   virtual void BagData(const CDataset& kData, Bag& bag);
   virtual void ShiftDistPtrs(unsigned long shift){};
 
@@ -104,7 +110,6 @@ class CDistribution {
   //---------------------
   parallel_details parallel_;
   int num_groups_;
-  std::multimap<int, int> obsid_to_row_;  // Map from observation unit to row
 };
 
 #endif  // DISTRIBUTION_H
@@ -18,7 +18,6 @@
 #include "dataset.h"
 #include <map>
 #include <memory>
-#include <Rcpp.h>
 
 //------------------------------
 // Class definition
@@ -0,0 +1,118 @@
+//------------------------------------------------------------------------------
+//
+//  File:       fit_timings.h
+//
+//  Description: the time spent in each phase of fitting a tree and counts
+//    of the work done, recorded when the host asks for them.
+//
+//------------------------------------------------------------------------------
+
+#ifndef FITTIMINGS_H
+#define FITTIMINGS_H
+
+//------------------------------
+// Includes
+//------------------------------
+#include "gbm_platform.h"
+#include "trace.h"
+#include <algorithm>
+#include <cstddef>
+
+// the phases of fitting a tree:
+//  residuals - bagging and the working response
+//  split_search - the root and the search for the best splits
+//  reassign - making the best split and moving its rows to the children
+//  terminal_fit - the best constants in the terminal nodes
+//  update - adding the tree to the fit and predicting the validation rows,
+//    with the out of bag improvement, training error and next working
+//    response of the distributions that sweep the rows once
+//  deviance - the out of bag improvement and the errors
+//  conversion - the tree's node arrays for the host
+enum FitPhase {
+  kResidualsPhase,
+  kSplitSearchPhase,
+  kReassignPhase,
+  kTerminalFitPhase,
+  kUpdatePhase,
+  kDeviancePhase,
+  kConversionPhase,
+  kNumFitPhases
+};
+
+inline const char* FitPhaseName(int phase) {
+  static const char* kNames[kNumFitPhases] = {
+      "residuals", "split_search", "reassign",  "terminal_fit",
+      "update",    "deviance",     "conversion"};
+  return kNames[phase];
+}
+
+//------------------------------
+// Struct definition
+//------------------------------
+struct FitTimings {
+  //----------------------
+  // Public Constructors
+  //----------------------
+  FitTimings() : rows_scanned(0.0), nodes_searched(0.0), bytes_allocated(0.0) {
+    std::fill(seconds, seconds + kNumFitPhases, 0.0);
+  };
+
+  double total_seconds() const {
+    double total = 0.0;
+    for (int phase = 0; phase < kNumFitPhases; phase++) {
+      total += seconds[phase];
+    }
+    return total;
+  };
+
+  //-------------------
+  // Public Variables
+  //-------------------
+  //  seconds - the time spent in each phase
+  //  rows_scanned - the rows passed to the split search, once for each
+  //    predictor searched
+  //  nodes_searched - the nodes whose best split was searched for
+  //  bytes_allocated - the bytes of the buffers and nodes made for the tree
+  // the counts are doubles as they may overflow 32 bit integers
+  double seconds[kNumFitPhases];
+  double rows_scanned;
+  double nodes_searched;
+  double bytes_allocated;
+};
+
+//------------------------------
+// Class definition
+//------------------------------
+// times a phase, from construction to Stop or destruction, into timings
+// and the trace - nothing is timed without timings or tracing
+class PhaseTimer {
+ public:
+  PhaseTimer(FitTimings* timings, FitPhase phase)
+      : timings_(timings),
+        phase_(phase),
+        is_traced_(gbm_trace::IsEnabled()),
+        start_((timings || is_traced_) ? gbm_platform::MonotonicSeconds()
+                                       : 0.0){};
+  ~PhaseTimer() { Stop(); };
+
+  void Stop() {
+    if (timings_ || is_traced_) {
+      const double kEnd = gbm_platform::MonotonicSeconds();
+      if (timings_) timings_->seconds[phase_] += kEnd - start_;
+      if (is_traced_) gbm_trace::Record(FitPhaseName(phase_), start_, kEnd);
+      timings_ = NULL;
+      is_traced_ = false;
+    }
+  };
+
+ private:
+  PhaseTimer(const PhaseTimer&);
+  PhaseTimer& operator=(const PhaseTimer&);
+
+  FitTimings* timings_;
+  FitPhase phase_;
+  bool is_traced_;
+  double start_;
+};
+
+#endif  // FITTIMINGS_H
@@ -13,6 +13,8 @@
 //-----------------------------------
 
 #include "gamma.h"
+#include "block_sums.h"
+#include "vector_math.h"
 #include <cmath>
 
 //----------------------------------------
@@ -37,28 +39,55 @@ void CGamma::ComputeWorkingResponse(const CDataset& kData, const Bag& kBag,
     throw gbm_exception::InvalidArgument();
   }
 
-#pragma omp parallel for schedule(static, get_array_chunk_size()) num_threads(get_num_threads())
-  for (unsigned long i = 0; i < kData.get_trainsize(); i++) {
-    const double deltafunc_est = kFuncEstimate[i] + kData.offset_ptr()[i];
-    residuals[i] = kData.y_ptr()[i] * std::exp(-deltafunc_est) - 1.0;
+  const unsigned long kNumRows = kData.get_trainsize();
+
+#pragma omp parallel for schedule( \
+    static, gbm_vector_math::BlocksPerChunk(get_array_chunk_size())) \
+    num_threads(get_num_threads())
+  for (unsigned long block = 0; block < gbm_vector_math::NumBlocks(kNumRows);
+       block++) {
+    const unsigned long kBegin = block * gbm_vector_math::kBlockSize;
+    const unsigned long kSize = gbm_vector_math::BlockSize(block, kNumRows);
+    double inverse_means[gbm_vector_math::kBlockSize];
+
+    for (unsigned long j = 0; j < kSize; j++) {
+      inverse_means[j] =
+          -(kFuncEstimate[kBegin + j] + kData.offset_ptr()[kBegin + j]);
+    }
+    gbm_vector_math::Exp(inverse_means, kSize, inverse_means);
+
+    for (unsigned long j = 0; j < kSize; j++) {
+      residuals[kBegin + j] =
+          kData.y_ptr()[kBegin + j] * inverse_means[j] - 1.0;
+    }
   }
 }
 
 double CGamma::InitF(const CDataset& kData) {
-  double sum = 0.0;
-  double totalweight = 0.0;
   double min = -19.0;
   double max = +19.0;
   double initfunc_est = 0.0;
 
-#pragma omp parallel for schedule(static, get_array_chunk_size()) \
-    reduction(+ : sum, totalweight) num_threads(get_num_threads())
-  for (unsigned long i = 0; i < kData.get_trainsize(); i++) {
-    sum += kData.weight_ptr()[i] * kData.y_ptr()[i] *
-           std::exp(-kData.offset_ptr()[i]);
-    totalweight += kData.weight_ptr()[i];
+  BlockSums sums(kData.get_trainsize(), 2);
+
+#pragma omp parallel for schedule( \
+    static, gbm_vector_math::BlocksPerChunk(get_array_chunk_size())) \
+    num_threads(get_num_threads())
+  for (unsigned long block = 0; block < sums.num_blocks(); block++) {
+    double sum = 0.0;
+    double totalweight = 0.0;
+    for (unsigned long i = sums.begin(block); i < sums.end(block); i++) {
+      sum += kData.weight_ptr()[i] * kData.y_ptr()[i] *
+             std::exp(-kData.offset_ptr()[i]);
+      totalweight += kData.weight_ptr()[i];
+    }
+    sums(block, 0) = sum;
+    sums(block, 1) = totalweight;
   }
 
+  double sum = sums.Total(0);
+  double totalweight = sums.Total(1);
+
   if (sum <= 0.0) {
     initfunc_est = min;
   } else {
@@ -76,20 +105,41 @@ double CGamma::InitF(const CDataset& kData) {
 
 double CGamma::Deviance(const CDataset& kData, const Bag& kBag,
                         const double* kFuncEstimate) {
-  double loss = 0.0;
-  double weight = 0.0;
-
-  unsigned long num_rows_in_set = kData.get_size_of_set();
-
-#pragma omp parallel for schedule(static, get_array_chunk_size()) \
-    reduction(+ : loss, weight) num_threads(get_num_threads())
-  for (unsigned long i = 0; i < num_rows_in_set; i++) {
-    const double deltafunc_est = kFuncEstimate[i] + kData.offset_ptr()[i];
-    loss += kData.weight_ptr()[i] *
-            (kData.y_ptr()[i] * std::exp(-deltafunc_est) + deltafunc_est);
-    weight += kData.weight_ptr()[i];
+  const unsigned long kNumRows = kData.get_size_of_set();
+  BlockSums sums(kNumRows, 2);
+
+#pragma omp parallel for schedule( \
+    static, gbm_vector_math::BlocksPerChunk(get_array_chunk_size())) \
+    num_threads(get_num_threads())
+  for (unsigned long block = 0; block < sums.num_blocks(); block++) {
+    const unsigned long kBegin = block * gbm_vector_math::kBlockSize;
+    const unsigned long kSize = gbm_vector_math::BlockSize(block, kNumRows);
+    double deltafunc_est[gbm_vector_math::kBlockSize];
+    double inverse_means[gbm_vector_math::kBlockSize];
+    double loss = 0.0;
+    double weight = 0.0;
+
+    for (unsigned long j = 0; j < kSize; j++) {
+      deltafunc_est[j] =
+          kFuncEstimate[kBegin + j] + kData.offset_ptr()[kBegin + j];
+      inverse_means[j] = -deltafunc_est[j];
+    }
+    gbm_vector_math::Exp(inverse_means, kSize, inverse_means);
+
+    for (unsigned long j = 0; j < kSize; j++) {
+      const unsigned long i = kBegin + j;
+      loss += kData.weight_ptr()[i] *
+              (kData.y_ptr()[i] * inverse_means[j] + deltafunc_est[j]);
+      weight += kData.weight_ptr()[i];
+    }
+
+    sums(block, 0) = loss;
+    sums(block, 1) = weight;
   }
 
+  double loss = sums.Total(0);
+  double weight = sums.Total(1);
+
   // TODO: Check if weights are all zero for validation set
   if ((weight == 0.0) && (loss == 0.0)) {
     return nan("");
@@ -125,9 +175,9 @@ void CGamma::FitBestConstant(const CDataset& kData, const Bag& kBag,
           kData.weight_ptr()[obs_num];
 
       // Keep track of largest and smallest prediction in each node
-      max_vec[tree.get_node_assignments()[obs_num]] = R::fmax2(
+      max_vec[tree.get_node_assignments()[obs_num]] = gbm_platform::Max(
           deltafunc_estimate, max_vec[tree.get_node_assignments()[obs_num]]);
-      min_vec[tree.get_node_assignments()[obs_num]] = R::fmin2(
+      min_vec[tree.get_node_assignments()[obs_num]] = gbm_platform::Min(
           deltafunc_estimate, min_vec[tree.get_node_assignments()[obs_num]]);
     }
   }
@@ -173,21 +223,46 @@ double CGamma::BagImprovement(const CDataset& kData, const Bag& kBag,
                               const double* kFuncEstimate,
                               const double kShrinkage,
                               const std::vector<double>& kDeltaEstimate) {
-  double returnvalue = 0.0;
-  double weight = 0.0;
-
-#pragma omp parallel for schedule(static, get_array_chunk_size()) \
-    reduction(+ : returnvalue, weight) num_threads(get_num_threads())
-  for (unsigned long i = 0; i < kData.get_trainsize(); i++) {
-    if (!kBag.get_element(i)) {
-      const double deltafunc_est = kFuncEstimate[i] + kData.offset_ptr()[i];
-      returnvalue += kData.weight_ptr()[i] *
-                     (kData.y_ptr()[i] * std::exp(-deltafunc_est) *
-                          (1.0 - exp(-kShrinkage * kDeltaEstimate[i])) -
-                      kShrinkage * kDeltaEstimate[i]);
-      weight += kData.weight_ptr()[i];
+  const unsigned long kNumRows = kData.get_trainsize();
+  BlockSums sums(kNumRows, 2);
+
+  // the terms of every row are computed, and those of the rows in the bag
+  // then dropped, so that the kernels run over whole blocks
+#pragma omp parallel for schedule( \
+    static, gbm_vector_math::BlocksPerChunk(get_array_chunk_size())) \
+    num_threads(get_num_threads())
+  for (unsigned long block = 0; block < sums.num_blocks(); block++) {
+    const unsigned long kBegin = block * gbm_vector_math::kBlockSize;
+    const unsigned long kSize = gbm_vector_math::BlockSize(block, kNumRows);
+    double inverse_means[gbm_vector_math::kBlockSize];
+    double step_factors[gbm_vector_math::kBlockSize];
+    double returnvalue = 0.0;
+    double weight = 0.0;
+
+    for (unsigned long j = 0; j < kSize; j++) {
+      const unsigned long i = kBegin + j;
+      inverse_means[j] = -(kFuncEstimate[i] + kData.offset_ptr()[i]);
+      step_factors[j] = -kShrinkage * kDeltaEstimate[i];
+    }
+    gbm_vector_math::Exp(inverse_means, kSize, inverse_means);
+    gbm_vector_math::Exp(step_factors, kSize, step_factors);
+
+    for (unsigned long j = 0; j < kSize; j++) {
+      const unsigned long i = kBegin + j;
+      const double kTerm =
+          kData.weight_ptr()[i] *
+          (kData.y_ptr()[i] * inverse_means[j] * (1.0 - step_factors[j]) -
+           kShrinkage * kDeltaEstimate[i]);
+      returnvalue += kBag.get_element(i) ? 0.0 : kTerm;
+      weight += kBag.get_element(i) ? 0.0 : kData.weight_ptr()[i];
     }
+
+    sums(block, 0) = returnvalue;
+    sums(block, 1) = weight;
   }
 
+  double returnvalue = sums.Total(0);
+  double weight = sums.Total(1);
+
   return 2 * returnvalue / weight;
 }
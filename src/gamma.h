@@ -13,7 +13,7 @@
 // Includes
 //------------------------------
 #include "distribution.h"
-#include <Rmath.h>
+#include <cmath>
 #include <memory>
 
 //------------------------------
@@ -10,6 +10,21 @@
 // Includes
 //-----------------------------------
 #include "gaussian.h"
+#include "block_sums.h"
+
+namespace {
+// the deviance from the total loss and weight of a set's rows
+double MeanDeviance(double loss, double weight) {
+  // TODO: Check if weights are all zero for validation set
+  if ((weight == 0.0) && (loss == 0.0)) {
+    return nan("");
+  } else if (weight == 0.0) {
+    return copysign(HUGE_VAL, loss);
+  }
+
+  return loss / weight;
+}
+}
 
 //----------------------------------------
 // Function Members - Private
@@ -42,44 +57,54 @@ void CGaussian::ComputeWorkingResponse(const CDataset& kData, const Bag& kBag,
 }
 
 double CGaussian::InitF(const CDataset& kData) {
-  double sum = 0.0;
-  double totalweight = 0.0;
-
-// compute the mean
-
-#pragma omp parallel for schedule(static, get_array_chunk_size()) \
-    reduction(+ : sum, totalweight) num_threads(get_num_threads())
-  for (unsigned long i = 0; i < kData.get_trainsize(); i++) {
-    sum += kData.weight_ptr()[i] * (kData.y_ptr()[i] - kData.offset_ptr()[i]);
-    totalweight += kData.weight_ptr()[i];
+  // compute the mean
+  BlockSums sums(kData.get_trainsize(), 2);
+
+#pragma omp parallel for schedule( \
+    static, gbm_vector_math::BlocksPerChunk(get_array_chunk_size())) \
+    num_threads(get_num_threads())
+  for (unsigned long block = 0; block < sums.num_blocks(); block++) {
+    double sum = 0.0;
+    double totalweight = 0.0;
+    for (unsigned long i = sums.begin(block); i < sums.end(block); i++) {
+      sum += kData.weight_ptr()[i] * (kData.y_ptr()[i] - kData.offset_ptr()[i]);
+      totalweight += kData.weight_ptr()[i];
+    }
+    sums(block, 0) = sum;
+    sums(block, 1) = totalweight;
   }
 
+  double sum = sums.Total(0);
+  double totalweight = sums.Total(1);
+
   return sum / totalweight;
 }
 
 double CGaussian::Deviance(const CDataset& kData, const Bag& kBag,
                            const double* kFuncEstimate) {
-  double loss = 0.0;
-  double weight = 0.0;
-
   unsigned long num_rows_in_set = kData.get_size_of_set();
-#pragma omp parallel for schedule(static, get_array_chunk_size()) \
-    reduction(+ : loss, weight) num_threads(get_num_threads())
-  for (unsigned long i = 0; i < num_rows_in_set; i++) {
-    const double tmp =
-        (kData.y_ptr()[i] - kData.offset_ptr()[i] - kFuncEstimate[i]);
-    loss += kData.weight_ptr()[i] * tmp * tmp;
-    weight += kData.weight_ptr()[i];
+  BlockSums sums(num_rows_in_set, 2);
+
+#pragma omp parallel for schedule( \
+    static, gbm_vector_math::BlocksPerChunk(get_array_chunk_size())) \
+    num_threads(get_num_threads())
+  for (unsigned long block = 0; block < sums.num_blocks(); block++) {
+    double loss = 0.0;
+    double weight = 0.0;
+    for (unsigned long i = sums.begin(block); i < sums.end(block); i++) {
+      const double tmp =
+          (kData.y_ptr()[i] - kData.offset_ptr()[i] - kFuncEstimate[i]);
+      loss += kData.weight_ptr()[i] * tmp * tmp;
+      weight += kData.weight_ptr()[i];
+    }
+    sums(block, 0) = loss;
+    sums(block, 1) = weight;
   }
 
-  // TODO: Check if weights are all zero for validation set
-  if ((weight == 0.0) && (loss == 0.0)) {
-    return nan("");
-  } else if (weight == 0.0) {
-    return copysign(HUGE_VAL, loss);
-  }
+  double loss = sums.Total(0);
+  double weight = sums.Total(1);
 
-  return loss / weight;
+  return MeanDeviance(loss, weight);
 }
 
 void CGaussian::FitBestConstant(const CDataset& kData, const Bag& kBag,
@@ -95,21 +120,80 @@ double CGaussian::BagImprovement(const CDataset& kData, const Bag& kBag,
                                  const double* kFuncEstimate,
                                  const double kShrinkage,
                                  const std::vector<double>& kDeltaEstimate) {
-  double returnvalue = 0.0;
-  double weight = 0.0;
+  BlockSums sums(kData.get_trainsize(), 2);
+
+#pragma omp parallel for schedule( \
+    static, gbm_vector_math::BlocksPerChunk(get_array_chunk_size())) \
+    num_threads(get_num_threads())
+  for (unsigned long block = 0; block < sums.num_blocks(); block++) {
+    double returnvalue = 0.0;
+    double weight = 0.0;
+    for (unsigned long i = sums.begin(block); i < sums.end(block); i++) {
+      if (!kBag.get_element(i)) {
+        const double deltafunc_est = kFuncEstimate[i] + kData.offset_ptr()[i];
+
+        returnvalue += kData.weight_ptr()[i] * kShrinkage * kDeltaEstimate[i] *
+                       (2.0 * (kData.y_ptr()[i] - deltafunc_est) -
+                        kShrinkage * kDeltaEstimate[i]);
+        weight += kData.weight_ptr()[i];
+      }
+    }
+    sums(block, 0) = returnvalue;
+    sums(block, 1) = weight;
+  }
 
-#pragma omp parallel for schedule(static, get_array_chunk_size()) \
-    reduction(+ : returnvalue, weight) num_threads(get_num_threads())
-  for (unsigned long i = 0; i < kData.get_trainsize(); i++) {
-    if (!kBag.get_element(i)) {
-      const double deltafunc_est = kFuncEstimate[i] + kData.offset_ptr()[i];
+  double returnvalue = sums.Total(0);
+  double weight = sums.Total(1);
 
-      returnvalue += kData.weight_ptr()[i] * kShrinkage * kDeltaEstimate[i] *
-                     (2.0 * (kData.y_ptr()[i] - deltafunc_est) -
-                      kShrinkage * kDeltaEstimate[i]);
+  return returnvalue / weight;
+}
+
+bool CGaussian::FusedUpdate(const CDataset& kData, const Bag& kBag,
+                             const double kShrinkage,
+                             const std::vector<double>& kDeltaEstimate,
+                             double* func_estimate,
+                             std::vector<double>& residuals,
+                             double& oobag_improvement, double& deviance) {
+  BlockSums sums(kData.get_trainsize(), 4);
+
+#pragma omp parallel for schedule( \
+    static, gbm_vector_math::BlocksPerChunk(get_array_chunk_size())) \
+    num_threads(get_num_threads())
+  for (unsigned long block = 0; block < sums.num_blocks(); block++) {
+    double improvement = 0.0;
+    double oobag_weight = 0.0;
+    double loss = 0.0;
+    double weight = 0.0;
+    for (unsigned long i = sums.begin(block); i < sums.end(block); i++) {
+      if (!kBag.get_element(i)) {
+        const double deltafunc_est = func_estimate[i] + kData.offset_ptr()[i];
+
+        improvement += kData.weight_ptr()[i] * kShrinkage * kDeltaEstimate[i] *
+                       (2.0 * (kData.y_ptr()[i] - deltafunc_est) -
+                        kShrinkage * kDeltaEstimate[i]);
+        oobag_weight += kData.weight_ptr()[i];
+      }
+
+      func_estimate[i] += kShrinkage * kDeltaEstimate[i];
+
+      const double tmp =
+          (kData.y_ptr()[i] - kData.offset_ptr()[i] - func_estimate[i]);
+      loss += kData.weight_ptr()[i] * tmp * tmp;
       weight += kData.weight_ptr()[i];
+      residuals[i] = tmp;
     }
+    sums(block, 0) = improvement;
+    sums(block, 1) = oobag_weight;
+    sums(block, 2) = loss;
+    sums(block, 3) = weight;
   }
 
-  return returnvalue / weight;
+  double improvement = sums.Total(0);
+  double oobag_weight = sums.Total(1);
+  double loss = sums.Total(2);
+  double weight = sums.Total(3);
+
+  oobag_improvement = improvement / oobag_weight;
+  deviance = MeanDeviance(loss, weight);
+  return true;
 }
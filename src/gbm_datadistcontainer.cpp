@@ -135,6 +135,32 @@ double CGBMDataDistContainer::ComputeBagImprovement(
                                     kShrinkage, kDeltaEstimate);
 }
 
+//-----------------------------------
+// Function: FusedUpdate
+//
+// Returns: bool - whether the distribution made the sweep
+//
+// Description: the out of bag improvement, the update of the fit of the
+//   training rows, their deviance and the next working response in one
+//   sweep of the rows, for the distributions that have one.
+//
+// Parameters: double ptr - ptr to function estimates, updated
+//    const double - the shrinkage of the tree
+//    vector<double> - the tree's predictions for the training rows
+//    vector<double> - the working response of the new fit
+//    double& - the out of bag improvement
+//    double& - the training deviance of the new fit
+//
+//-----------------------------------
+bool CGBMDataDistContainer::FusedUpdate(
+    double* func_estimate, const double kShrinkage,
+    const std::vector<double>& kDeltaEstimate, std::vector<double>& residuals,
+    double& oobag_improvement, double& train_error) {
+  return get_dist()->FusedUpdate(get_data(), get_bag(), kShrinkage,
+                                 kDeltaEstimate, func_estimate, residuals,
+                                 oobag_improvement, train_error);
+}
+
 //-----------------------------------
 // Function: BagData
 //
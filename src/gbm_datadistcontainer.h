@@ -20,7 +20,6 @@
 #include "distribution_factory.h"
 #include "tree.h"
 #include "treeparams.h"
-#include <Rcpp.h>
 #include <vector>
 #include <memory>
 
@@ -54,6 +53,10 @@ class CGBMDataDistContainer {
   double ComputeBagImprovement(const double* kFuncEstimate,
                                const double kShrinkage,
                                const std::vector<double>& kDeltaEstimate);
+  bool FusedUpdate(double* func_estimate, const double kShrinkage,
+                   const std::vector<double>& kDeltaEstimate,
+                   std::vector<double>& residuals, double& oobag_improvement,
+                   double& train_error);
   void BagData();
 
   std::auto_ptr<CDistribution>& get_dist() { return distptr_; }
@@ -6,11 +6,15 @@
 CGBMEngine::CGBMEngine(DataDistParams& datadistparams, TreeParams& treeparams)
     : datacontainer_(datadistparams),
       tree_params_(treeparams),
-      residuals_(datacontainer_.get_data().nrow(), 0) {}
+      residuals_(datacontainer_.get_data().nrow(), 0),
+      residuals_current_(false) {}
 
 CGBMEngine::~CGBMEngine() {}
 
-FittedLearner* CGBMEngine::FitLearner(double* func_estimate) {
+FittedLearner* CGBMEngine::FitLearner(double* func_estimate,
+                                      FitTimings* timings) {
+  PhaseTimer residuals_timer(timings, kResidualsPhase);
+
   // Initialize adjustments to function estimate
   std::vector<double> delta_estimates(datacontainer_.get_data().nrow(), 0);
 
@@ -18,50 +22,68 @@ FittedLearner* CGBMEngine::FitLearner(double* func_estimate) {
   datacontainer_.BagData();
 
   // Set up tree
-  std::auto_ptr<CCARTTree> tree(new CCARTTree(tree_params_));
+  std::auto_ptr<CCARTTree> tree(new CCARTTree(tree_params_, node_arena_));
 
-  // Compute Residuals and fit tree
-  datacontainer_.ComputeResiduals(&func_estimate[0], residuals_);
+  // Compute Residuals, unless the last tree's sweep of the rows left
+  // those of the function estimate, and fit tree
+  if (!residuals_current_) {
+    datacontainer_.ComputeResiduals(&func_estimate[0], residuals_);
+  }
+  residuals_current_ = false;
+  residuals_timer.Stop();
 
   tree->Grow(residuals_, datacontainer_.get_data(), datacontainer_.get_bag(),
-             delta_estimates);
+             delta_estimates, splitter_arenas_, timings);
 
   // Now I have adF, adZ, and vecpTermNodes (new node assignments)
   // Fit the best constant within each terminal node
 
   // Adjust terminal node predictions and shrink
+  PhaseTimer terminal_timer(timings, kTerminalFitPhase);
   datacontainer_.ComputeBestTermNodePreds(&func_estimate[0], residuals_,
                                           *tree.get());
   tree->Adjust(delta_estimates);
+  terminal_timer.Stop();
 
-  // Compute the error improvement within bag
-  double oobag_improv = datacontainer_.ComputeBagImprovement(
-      &func_estimate[0], tree->get_shrinkage_factor(), delta_estimates);
-
-// Update the function estimate
-#pragma omp parallel for schedule(static, tree->get_array_chunk_size()) \
-  num_threads(tree->get_num_threads())
-  for (unsigned long i = 0; i < datacontainer_.get_data().get_trainsize();
-       i++) {
-    func_estimate[i] += tree->get_shrinkage_factor() * delta_estimates[i];
+  // Compute the error improvement within bag, update the function
+  // estimate and compute the training error - in one sweep of the training
+  // rows, which also computes the next tree's residuals, when the
+  // distribution has one
+  double oobag_improv = 0.0;
+  double train_error = 0.0;
+  PhaseTimer sweep_timer(timings, kUpdatePhase);
+  const bool kIsFused = datacontainer_.FusedUpdate(
+      &func_estimate[0], tree->get_shrinkage_factor(), delta_estimates,
+      residuals_, oobag_improv, train_error);
+  sweep_timer.Stop();
+  if (kIsFused) {
+    residuals_current_ = true;
+  } else {
+    PhaseTimer improvement_timer(timings, kDeviancePhase);
+    oobag_improv = datacontainer_.ComputeBagImprovement(
+        &func_estimate[0], tree->get_shrinkage_factor(), delta_estimates);
   }
 
-  // Make validation predictions
-  double train_error = datacontainer_.ComputeDeviance(&func_estimate[0], false);
-  tree->PredictValid(datacontainer_.get_data(),
-                     datacontainer_.get_data().get_validsize(),
-                     delta_estimates);
-
-#pragma omp parallel for schedule(static, tree->get_array_chunk_size()) \
-  num_threads(tree->get_num_threads())
-  for (unsigned long i = datacontainer_.get_data().get_trainsize();
-       i < datacontainer_.get_data().get_trainsize() +
-               datacontainer_.get_data().get_validsize();
-       i++) {
-    func_estimate[i] += delta_estimates[i];
+  // Update the function estimate, predicting the validation rows
+  PhaseTimer update_timer(timings, kUpdatePhase);
+  tree->UpdateFit(datacontainer_.get_data(), delta_estimates,
+                  &func_estimate[0],
+                  kIsFused ? datacontainer_.get_data().get_trainsize() : 0);
+  update_timer.Stop();
+
+  if (!kIsFused) {
+    PhaseTimer train_error_timer(timings, kDeviancePhase);
+    train_error = datacontainer_.ComputeDeviance(&func_estimate[0], false);
   }
 
+  PhaseTimer valid_error_timer(timings, kDeviancePhase);
   double valid_error = datacontainer_.ComputeDeviance(&func_estimate[0], true);
+  valid_error_timer.Stop();
+
+  if (timings) {
+    timings->bytes_allocated += delta_estimates.capacity() * sizeof(double);
+  }
+
   std::auto_ptr<FittedLearner> fit(new FittedLearner(
       tree, datacontainer_.get_data(), train_error, valid_error, oobag_improv));
 
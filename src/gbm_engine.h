@@ -18,12 +18,12 @@
 // Includes
 //------------------------------
 #include "datadistparams.h"
+#include "fit_timings.h"
 #include "fitted_learner.h"
 #include "gbm_datadistcontainer.h"
 #include "tree.h"
 #include "treeparams.h"
 #include <memory>
-#include <Rcpp.h>
 #include <vector>
 
 //------------------------------
@@ -44,7 +44,8 @@ class CGBMEngine {
   //---------------------
   // Public Functions
   //---------------------
-  FittedLearner* FitLearner(double* func_estimate);
+  FittedLearner* FitLearner(double* func_estimate,
+                            FitTimings* timings = NULL);
   double initial_function_estimate() {
     return datacontainer_.InitialFunctionEstimate();
   };
@@ -56,8 +57,20 @@ class CGBMEngine {
   CGBMDataDistContainer datacontainer_;
   TreeParams& tree_params_;
 
-  // Residuals and adjustments to function estimate
+  // Residuals and adjustments to function estimate, and whether they are
+  // already those of the function estimate - set by the fused sweep of
+  // FitLearner and cleared as the next tree starts.  The estimate is only
+  // written by FitLearner for the life of an engine: gbm_more and each CV
+  // fold build an engine of their own
   std::vector<double> residuals_;
+  bool residuals_current_;
+
+  // scratch space of the split searches, reused by every tree
+  SplitterArenas splitter_arenas_;
+
+  // the nodes of the latest tree, reset for each tree - a fitted learner's
+  // tree is only valid until the next is fitted
+  NodeArena node_arena_;
 };
 
 #endif  // GBMENGINE_H
@@ -10,6 +10,7 @@
 // Includes
 //-----------------------------------
 #include "gbm_fit.h"
+#include <algorithm>
 
 //-----------------------------------
 // Public Functions
@@ -22,23 +23,26 @@
 // Description: Constructor
 //
 // Parameters:
+//  kRecordTimings - whether to time the phases of fitting each tree
 //-----------------------------------
 GbmFit::GbmFit(const int kNumDataRows, const double kInitEstimate,
-               const int kNumTrees, const Rcpp::NumericVector& kPrevFuncEstimate)
+               const int kNumTrees, const Span<const double>& kPrevFuncEstimate,
+               const bool kRecordTimings)
     : current_fit_(),
       training_errors_(kNumTrees, 0.0),
       validation_errors_(kNumTrees, 0.0),
       outofbag_improvement_(kNumTrees, 0.0),
       func_estimate_(kNumDataRows),
       set_of_trees_(kNumTrees),
+      timings_(kRecordTimings ? kNumTrees : 0),
       initial_estimate_(kInitEstimate),
       tree_count_(0) {
-  if (ISNA(kPrevFuncEstimate[0]))  // check for old predictions
+  if (gbm_platform::IsNA(kPrevFuncEstimate[0]))  // check for old predictions
   {
     // set the initial value of F as a constant
-    func_estimate_.fill(initial_estimate_);
+    std::fill(func_estimate_.begin(), func_estimate_.end(), initial_estimate_);
   } else {
-    if (kPrevFuncEstimate.size() != func_estimate_.size()) {
+    if (kPrevFuncEstimate.size() != long(func_estimate_.size())) {
       throw gbm_exception::InvalidArgument(
           "old predictions are the wrong shape");
     }
@@ -48,40 +52,34 @@ GbmFit::GbmFit(const int kNumDataRows, const double kInitEstimate,
 }
 
 void GbmFit::accumulate(CGBMEngine& gbm) {
-  current_fit_.reset(gbm.FitLearner(func_estimate_.begin()));
+  FitTimings* timings = timings_.empty() ? NULL : &timings_[tree_count_];
+  current_fit_.reset(gbm.FitLearner(&func_estimate_[0], timings));
   training_errors_[tree_count_] += current_fit_->get_training_error();
   validation_errors_[tree_count_] += current_fit_->get_valid_error();
   outofbag_improvement_[tree_count_] += current_fit_->get_oobag_improv();
 }
 
 void GbmFit::CreateTreeRepresentation(const int kCatSplitsOld) {
+  FitTimings* timings = timings_.empty() ? NULL : &timings_[tree_count_];
+  PhaseTimer conversion_timer(timings, kConversionPhase);
+  const unsigned long kNumSplitCodes = split_codes_.size();
+
   // Vectors defining a tree
-  Rcpp::IntegerVector split_vars(current_fit_->get_size_of_tree());
-  Rcpp::NumericVector split_values(current_fit_->get_size_of_tree());
-  Rcpp::IntegerVector left_nodes(current_fit_->get_size_of_tree());
-  Rcpp::IntegerVector right_nodes(current_fit_->get_size_of_tree());
-  Rcpp::IntegerVector missing_nodes(current_fit_->get_size_of_tree());
-  Rcpp::NumericVector error_reduction(current_fit_->get_size_of_tree());
-  Rcpp::NumericVector weights(current_fit_->get_size_of_tree());
-  Rcpp::NumericVector node_predictions(current_fit_->get_size_of_tree());
+  TreeArrays& tree = set_of_trees_[tree_count_];
+  tree = TreeArrays(current_fit_->get_size_of_tree());
 
   current_fit_->get_tree()->TransferTreeToRList(
-      *current_fit_->get_data_for_fit(), split_vars.begin(),
-      split_values.begin(), left_nodes.begin(), right_nodes.begin(),
-      missing_nodes.begin(), error_reduction.begin(), weights.begin(),
-      node_predictions.begin(), split_codes_, kCatSplitsOld);
-
-  set_of_trees_[tree_count_] = Rcpp::List::create(
-      split_vars, split_values, left_nodes, right_nodes, missing_nodes,
-      error_reduction, weights, node_predictions);
-}
+      *current_fit_->get_data_for_fit(), &tree.split_vars[0],
+      &tree.split_values[0], &tree.left_nodes[0], &tree.right_nodes[0],
+      &tree.missing_nodes[0], &tree.error_reduction[0], &tree.weights[0],
+      &tree.node_predictions[0], split_codes_, kCatSplitsOld);
 
-Rcpp::List GbmFit::ROutput() {
-
-  return Rcpp::List::create(
-      _["initF"] = initial_estimate_, _["fit"] = func_estimate_,
-      _["train.error"] = training_errors_,
-      _["valid.error"] = validation_errors_,
-      _["oobag.improve"] = outofbag_improvement_, _["trees"] = set_of_trees_,
-      _["c.splits"] = split_codes_);
+  if (timings) {
+    timings->bytes_allocated +=
+        tree.size() * (4 * sizeof(int) + 4 * sizeof(double));
+    for (unsigned long split = kNumSplitCodes; split < split_codes_.size();
+         split++) {
+      timings->bytes_allocated += split_codes_[split].size() * sizeof(int);
+    }
+  }
 }
@@ -16,10 +16,11 @@
 //------------------------------
 // Includes
 //------------------------------
+#include "fit_timings.h"
 #include "gbm_engine.h"
-#include <Rcpp.h>
-
-using Rcpp::_;
+#include "span.h"
+#include "tree_arrays.h"
+#include <vector>
 
 //------------------------------
 // Class definition
@@ -30,14 +31,14 @@ class GbmFit {
   // Public Constructors
   //----------------------
   GbmFit(const int kNumDataRows, const double kInitEstimate,
-         const int kNumTrees, const Rcpp::NumericVector& kPrevFuncEstimate);
+         const int kNumTrees, const Span<const double>& kPrevFuncEstimate,
+         const bool kRecordTimings = false);
 
   //---------------------
   // Public Functions
   //---------------------
   void accumulate(CGBMEngine& gbm);
   void CreateTreeRepresentation(const int kCatSplitsOld);
-  Rcpp::List ROutput();
 
   // Inlined functions
   double get_tree_training_error() { return training_errors_[tree_count_]; }
@@ -45,17 +46,35 @@ class GbmFit {
   double get_tree_oobag_improv() { return outofbag_improvement_[tree_count_]; }
   void increment_count() { tree_count_++; }
 
+  // the fit, for the host to hand back
+  double initial_estimate() const { return initial_estimate_; }
+  const std::vector<double>& func_estimate() const { return func_estimate_; }
+  const std::vector<double>& training_errors() const {
+    return training_errors_;
+  }
+  const std::vector<double>& validation_errors() const {
+    return validation_errors_;
+  }
+  const std::vector<double>& outofbag_improvement() const {
+    return outofbag_improvement_;
+  }
+  const std::vector<TreeArrays>& trees() const { return set_of_trees_; }
+  const VecOfVectorCategories& split_codes() const { return split_codes_; }
+  // the timings of each tree, empty unless they were recorded
+  const std::vector<FitTimings>& timings() const { return timings_; }
+
  private:
   //---------------------
   // Private Variables
   //---------------------
   VecOfVectorCategories split_codes_;
   std::auto_ptr<FittedLearner> current_fit_;
-  Rcpp::NumericVector training_errors_;
-  Rcpp::NumericVector validation_errors_;
-  Rcpp::NumericVector outofbag_improvement_;
-  Rcpp::NumericVector func_estimate_;  // Fitted function
-  Rcpp::GenericVector set_of_trees_;
+  std::vector<double> training_errors_;
+  std::vector<double> validation_errors_;
+  std::vector<double> outofbag_improvement_;
+  std::vector<double> func_estimate_;  // Fitted function
+  std::vector<TreeArrays> set_of_trees_;
+  std::vector<FitTimings> timings_;
   double initial_estimate_;
   unsigned long tree_count_;
 };
@@ -8,6 +8,34 @@
 //
 //////////////////////////////////////////////
 #include "gbm_functions.h"
+#include <algorithm>
+#include <vector>
+
+namespace {
+// Compares rows by their value in a column of the data.
+class ColumnLess {
+ public:
+  explicit ColumnLess(const double* kColumn) : kColumn_(kColumn) {}
+  bool operator()(int lhs, int rhs) const {
+    return kColumn_[lhs] < kColumn_[rhs];
+  }
+
+ private:
+  const double* kColumn_;
+};
+
+// Compares rows by their observation id.
+class IdLess {
+ public:
+  explicit IdLess(const int* kObsIds) : kObsIds_(kObsIds) {}
+  bool operator()(int lhs, int rhs) const {
+    return kObsIds_[lhs] < kObsIds_[rhs];
+  }
+
+ private:
+  const int* kObsIds_;
+};
+}
 
 //  Function that counts the number of distinct groups in the input data.
 //  Used only with the pairwise distribution.
@@ -28,12 +56,83 @@ int gbm_functions::NumGroups(const double* kMisc, int num_training_rows) {
   return groups;
 }
 
-// Function that checks that a R vector is not NA.
-bool gbm_functions::has_value(const Rcpp::NumericVector& kVec) {
-  return !((kVec.size() == 1) && (ISNA(kVec[0])));
+// Function that checks that a vector is neither empty nor NA.
+bool gbm_functions::has_value(const Span<double>& kVec) {
+  return !kVec.empty() &&
+         !((kVec.size() == 1) && (gbm_platform::IsNA(kVec[0])));
 }
 
 // Function that shuffles an array.
 std::ptrdiff_t gbm_functions::PtrShuffler(std::ptrdiff_t n) {
-  return n * unif_rand();
+  return n * gbm_platform::UniformRandom();
+}
+
+//  Function that orders the first num_rows rows of each column of the
+//  data as order(x, na.last=FALSE) - 1 does in R: zero-based, missing
+//  values first and ties kept in row order.  Columns are sorted in
+//  parallel; order is column-major with num_rows entries per column.
+void gbm_functions::OrderPredictors(const MatrixSpan<const double>& kXMatrix,
+                                    int num_rows, int num_threads,
+                                    int* order) {
+  const double* kValues = kXMatrix.begin();
+  const int kNumRows = kXMatrix.nrow();
+
+#pragma omp parallel for schedule(static) num_threads(num_threads)
+  for (int var = 0; var < kXMatrix.ncol(); var++) {
+    const double* kColumn = kValues + (long)var * kNumRows;
+    int* var_order = order + (long)var * num_rows;
+
+    int num_missing = 0;
+    for (int row = 0; row < num_rows; row++) {
+      if (gbm_platform::IsNaN(kColumn[row])) var_order[num_missing++] = row;
+    }
+    int ind = num_missing;
+    for (int row = 0; row < num_rows; row++) {
+      if (!gbm_platform::IsNaN(kColumn[row])) var_order[ind++] = row;
+    }
+    std::stable_sort(var_order + num_missing, var_order + num_rows,
+                     ColumnLess(kColumn));
+  }
+}
+
+//  Function that restricts an order to the rows kept, renumbering them
+//  by their position amongst the kept rows.  The result is the order the
+//  kept rows would have been given by OrderPredictors.
+void gbm_functions::SubsetOrder(const MatrixSpan<const int>& kOrder,
+                                const int* kKeepRow, int* order) {
+  const int kNumRows = kOrder.nrow();
+  std::vector<int> new_row(kNumRows, -1);
+  int num_kept = 0;
+  for (int row = 0; row < kNumRows; row++) {
+    if (kKeepRow[row]) new_row[row] = num_kept++;
+  }
+
+  for (int var = 0; var < kOrder.ncol(); var++) {
+    const int* kVarOrder = kOrder.begin() + (long)var * kNumRows;
+    for (int ind = 0; ind < kNumRows; ind++) {
+      if (new_row[kVarOrder[ind]] >= 0) *order++ = new_row[kVarOrder[ind]];
+    }
+  }
+}
+
+//  Function that groups the first num_rows rows of the data by their
+//  observation id: ids in increasing order and, within an id, rows in row
+//  order.  The rows of the i-th observation are rows[starts[i]] up to
+//  rows[starts[i+1]-1].
+void gbm_functions::IndexObservations(const int* kObsIds, int num_rows,
+                                      std::vector<int>& rows,
+                                      std::vector<int>& starts) {
+  rows.resize(num_rows);
+  for (int row = 0; row < num_rows; row++) {
+    rows[row] = row;
+  }
+  std::stable_sort(rows.begin(), rows.end(), IdLess(kObsIds));
+
+  starts.clear();
+  for (int ind = 0; ind < num_rows; ind++) {
+    if ((ind == 0) || (kObsIds[rows[ind]] != kObsIds[rows[ind - 1]])) {
+      starts.push_back(ind);
+    }
+  }
+  starts.push_back(num_rows);
 }
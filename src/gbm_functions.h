@@ -11,12 +11,20 @@
 #ifndef GBMFUNC_H
 #define GBMFUNC_H
 
-#include <Rcpp.h>
+#include "gbm_platform.h"
+#include "span.h"
+#include <vector>
 
 namespace gbm_functions {
 int NumGroups(const double* kMisc, int num_training_rows);
-bool has_value(const Rcpp::NumericVector& kVec);
+bool has_value(const Span<double>& kVec);
 std::ptrdiff_t PtrShuffler(std::ptrdiff_t n);
+void OrderPredictors(const MatrixSpan<const double>& kXMatrix, int num_rows,
+                     int num_threads, int* order);
+void SubsetOrder(const MatrixSpan<const int>& kOrder, const int* kKeepRow,
+                 int* order);
+void IndexObservations(const int* kObsIds, int num_rows,
+                       std::vector<int>& rows, std::vector<int>& starts);
 }
 
 #endif  // GBMFUNC_H
@@ -0,0 +1,109 @@
+//////////////////////////////////////////////
+//
+// File: gbm_platform.cpp
+//
+// Description: the services the engine takes from its host and their
+//   defaults.
+//
+//////////////////////////////////////////////
+#include "gbm_platform.h"
+#include <cstdarg>
+#include <cstdio>
+#include <vector>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+namespace {
+// Park and Miller's minimal standard generator, with Schrage's method
+unsigned int default_state = 1;
+
+double DefaultUniform() {
+  const unsigned int kA = 16807, kM = 2147483647, kQ = 127773, kR = 2836;
+  const unsigned int kHigh = default_state / kQ, kLow = default_state % kQ;
+  const unsigned int kUp = kA * kLow, kDown = kR * kHigh;
+  default_state = (kUp > kDown) ? kUp - kDown : kUp + (kM - kDown);
+  return (default_state - 1) / double(kM - 1);
+}
+
+void DefaultMessage(const char* kMessage) { std::fputs(kMessage, stdout); }
+
+void DefaultWarning(const char* kMessage) {
+  std::fprintf(stderr, "Warning: %s\n", kMessage);
+}
+
+gbm_platform::UniformGenerator uniform_generator = DefaultUniform;
+gbm_platform::MessageWriter message_writer = DefaultMessage;
+gbm_platform::MessageWriter warning_writer = DefaultWarning;
+}
+
+// Function that sets the generator of uniform random numbers.
+void gbm_platform::set_uniform_generator(UniformGenerator generator) {
+  uniform_generator = generator ? generator : DefaultUniform;
+}
+
+// Function that draws a uniform random number.
+double gbm_platform::UniformRandom() { return uniform_generator(); }
+
+// Function that seeds the default generator - its state must be neither
+// 0 nor 2^31 - 1.
+void gbm_platform::SetSeed(unsigned int seed) {
+  default_state = seed % 2147483646u + 1;
+}
+
+// Function that sets where messages are written.
+void gbm_platform::set_message_writer(MessageWriter writer) {
+  message_writer = writer ? writer : DefaultMessage;
+}
+
+// Function that sets where warnings are written.
+void gbm_platform::set_warning_writer(MessageWriter writer) {
+  warning_writer = writer ? writer : DefaultWarning;
+}
+
+// Function that formats and writes a message.
+void gbm_platform::Printf(const char* kFormat, ...) {
+  std::vector<char> message(256);
+  va_list args;
+  va_start(args, kFormat);
+  int length = std::vsnprintf(&message[0], message.size(), kFormat, args);
+  va_end(args);
+  if (length >= int(message.size())) {
+    message.resize(length + 1);
+    va_start(args, kFormat);
+    std::vsnprintf(&message[0], message.size(), kFormat, args);
+    va_end(args);
+  }
+  message_writer(&message[0]);
+}
+
+// Function that writes a warning.
+void gbm_platform::Warning(const std::string& kMessage) {
+  warning_writer(kMessage.c_str());
+}
+
+// Function that reads the monotonic clock.
+double gbm_platform::MonotonicSeconds() {
+#ifdef _WIN32
+  LARGE_INTEGER count, frequency;
+  QueryPerformanceCounter(&count);
+  QueryPerformanceFrequency(&frequency);
+  return double(count.QuadPart) / double(frequency.QuadPart);
+#else
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + 1e-9 * now.tv_nsec;
+#endif
+}
+
+// Function that gives R's NA.
+double gbm_platform::NA() {
+  unsigned int words[2];
+  words[kLowWord] = 1954;
+  words[1 - kLowWord] = 0x7FF00000;
+  double na;
+  std::memcpy(&na, words, sizeof(na));
+  return na;
+}
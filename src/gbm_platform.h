@@ -0,0 +1,73 @@
+//------------------------------------------------------------------------------
+//
+//  File:       gbm_platform.h
+//
+//  Description: the few services the engine takes from its host - random
+//    numbers, messages and warnings - R's missing value conventions and a
+//    clock.
+//    R sets the services to its own in gbmentry.cpp; other hosts may set
+//    theirs or keep the defaults, a seeded generator and standard output.
+//
+//------------------------------------------------------------------------------
+
+#ifndef GBMPLATFORM_H
+#define GBMPLATFORM_H
+
+//------------------------------
+// Includes
+//------------------------------
+#include <cstring>
+#include <string>
+
+namespace gbm_platform {
+typedef double (*UniformGenerator)();
+typedef void (*MessageWriter)(const char* kMessage);
+
+// uniform random numbers in [0, 1)
+void set_uniform_generator(UniformGenerator generator);
+double UniformRandom();
+
+// the default generator's seed
+void SetSeed(unsigned int seed);
+
+// messages and warnings - messages are formatted as by printf
+void set_message_writer(MessageWriter writer);
+void set_warning_writer(MessageWriter writer);
+void Printf(const char* kFormat, ...);
+void Warning(const std::string& kMessage);
+
+// seconds from a monotonic clock, for timing phases of the fit
+double MonotonicSeconds();
+
+// R's NA is a NaN with 1954 in its low word - other NaNs are not missing
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+const int kLowWord = 1;
+#else
+const int kLowWord = 0;
+#endif
+
+inline bool IsNaN(double x) { return x != x; }
+
+inline bool IsNA(double x) {
+  if (!IsNaN(x)) return false;
+  unsigned int words[2];
+  std::memcpy(words, &x, sizeof(x));
+  return words[kLowWord] == 1954;
+}
+
+double NA();
+
+// the larger and smaller of two values, NaN if either is, as R's fmax2
+// and fmin2
+inline double Max(double x, double y) {
+  if (IsNaN(x) || IsNaN(y)) return x + y;
+  return (x < y) ? y : x;
+}
+
+inline double Min(double x, double y) {
+  if (IsNaN(x) || IsNaN(y)) return x + y;
+  return (x < y) ? x : y;
+}
+}
+
+#endif  // GBMPLATFORM_H
@@ -1,10 +1,22 @@
 // GBM by Greg Ridgeway  Copyright (C) 2003
 
+#include "compiled_model.h"
 #include "datadistparams.h"
+#include "fit_timings.h"
 #include "gbm_engine.h"
 #include "gbm_fit.h"
+#include "gbm_functions.h"
+#include "gbm_platform.h"
+#include "model_code.h"
+#include "model_file.h"
 #include "parallel_details.h"
+#include "prepared_data.h"
+#include "span.h"
+#include "trace.h"
+#include "tree_arrays.h"
 #include "treeparams.h"
+#include "vector_math.h"
+#include <algorithm>
 #include <memory>
 #include <utility>
 #include <Rcpp.h>
@@ -33,9 +45,178 @@ class NodeStack {
     Rcpp::List details(src);
     int num_threads = details["num_threads"];
     int array_chunk_size = details["array_chunk_size"];
-    return parallel_details(num_threads, array_chunk_size);
+
+    // objects created before histogram support have no split search
+    int histogram_bins = 0;
+    if (details.containsElementNamed("split_search")) {
+      const std::string split_search =
+          Rcpp::as<std::string>(details["split_search"]);
+      if (split_search == "histogram") {
+        histogram_bins = details["num_bins"];
+      } else if (split_search != "exact") {
+        throw gbm_exception::InvalidArgument(
+            "split search must be either \"exact\" or \"histogram\"");
+      }
+    }
+    return parallel_details(num_threads, array_chunk_size, histogram_bins);
+  }
+
+  // objects created before timings were recorded have no timings
+  inline bool timings_wrap(SEXP src) {
+    Rcpp::List details(src);
+    return details.containsElementNamed("timings") &&
+           Rcpp::as<bool>(details["timings"]);
+  }
+
+  // the file to write a trace of the fit to, empty for no trace
+  inline std::string trace_file_wrap(SEXP src) {
+    Rcpp::List details(src);
+    if (!details.containsElementNamed("trace_file")) return std::string();
+    return Rcpp::as<std::string>(details["trace_file"]);
+  }
+
+  inline PreparedData& prepared_data_wrap(SEXP src) {
+    Rcpp::XPtr<PreparedData> prepared(src);
+    // external pointers do not survive saving and reloading
+    if (prepared.get() == NULL) {
+      throw gbm_exception::InvalidArgument(
+          "prepared data are no longer available");
+    }
+    return *prepared;
+  }
+
+  inline CompiledModel& compiled_model_wrap(SEXP src) {
+    Rcpp::XPtr<CompiledModel> compiled(src);
+    // external pointers do not survive saving and reloading
+    if (compiled.get() == NULL) {
+      throw gbm_exception::InvalidArgument(
+          "compiled model is no longer available");
+    }
+    return *compiled;
   }
 
+  // views of R vectors and matrices for the engine - the R objects must
+  // outlive the views
+  template <typename T, typename RVector>
+  inline Span<T> span_wrap(RVector& src) {
+    return Span<T>(src.begin(), src.size());
+  }
+
+  template <typename T, typename RMatrix>
+  inline MatrixSpan<T> matrix_span_wrap(RMatrix& src) {
+    return MatrixSpan<T>(src.begin(), src.nrow(), src.ncol());
+  }
+
+  // compiles the R lists of the fitted trees and categorical splits - only
+  // the parts of the trees used in prediction are converted
+  inline CompiledModel* compiled_model_create(SEXP fitted_trees,
+                                              SEXP categorical_splits,
+                                              SEXP variable_type) {
+    const Rcpp::GenericVector kFittedTrees(fitted_trees);
+    const Rcpp::GenericVector kSplits(categorical_splits);
+    const Rcpp::IntegerVector kVarType(variable_type);
+
+    std::vector<TreeArrays> trees(kFittedTrees.size());
+    for (int tree = 0; tree < kFittedTrees.size(); tree++) {
+      const Rcpp::GenericVector kThisTree = kFittedTrees[tree];
+      const Rcpp::IntegerVector kSplitVar = kThisTree[0];
+      const Rcpp::NumericVector kSplitCode = kThisTree[1];
+      const Rcpp::IntegerVector kLeftNode = kThisTree[2];
+      const Rcpp::IntegerVector kRightNode = kThisTree[3];
+      const Rcpp::IntegerVector kMissingNode = kThisTree[4];
+      trees[tree].split_vars.assign(kSplitVar.begin(), kSplitVar.end());
+      trees[tree].split_values.assign(kSplitCode.begin(), kSplitCode.end());
+      trees[tree].left_nodes.assign(kLeftNode.begin(), kLeftNode.end());
+      trees[tree].right_nodes.assign(kRightNode.begin(), kRightNode.end());
+      trees[tree].missing_nodes.assign(kMissingNode.begin(),
+                                       kMissingNode.end());
+    }
+
+    std::vector<std::vector<int> > splits(kSplits.size());
+    for (int split = 0; split < kSplits.size(); split++) {
+      const Rcpp::IntegerVector kThisSplit = kSplits[split];
+      splits[split].assign(kThisSplit.begin(), kThisSplit.end());
+    }
+
+    return new CompiledModel(trees, splits,
+                             Span<const int>(kVarType.begin(),
+                                             kVarType.size()));
+  }
+
+  // the timings of the fit as a data frame, a row for each tree numbered
+  // from first_tree
+  inline Rcpp::List fit_timings_wrap(const std::vector<FitTimings>& kTimings,
+                                     int first_tree) {
+    const int kNumTrees = kTimings.size();
+    const int kNumColumns = kNumFitPhases + 4;
+    Rcpp::List columns(kNumColumns);
+    Rcpp::CharacterVector names(kNumColumns);
+
+    Rcpp::IntegerVector tree(kNumTrees);
+    for (int ind = 0; ind < kNumTrees; ind++) tree[ind] = first_tree + ind;
+    columns[0] = tree;
+    names[0] = "tree";
+    for (int phase = 0; phase < kNumFitPhases; phase++) {
+      Rcpp::NumericVector seconds(kNumTrees);
+      for (int ind = 0; ind < kNumTrees; ind++) {
+        seconds[ind] = kTimings[ind].seconds[phase];
+      }
+      columns[phase + 1] = seconds;
+      names[phase + 1] = FitPhaseName(phase);
+    }
+    Rcpp::NumericVector rows(kNumTrees), nodes(kNumTrees), bytes(kNumTrees);
+    for (int ind = 0; ind < kNumTrees; ind++) {
+      rows[ind] = kTimings[ind].rows_scanned;
+      nodes[ind] = kTimings[ind].nodes_searched;
+      bytes[ind] = kTimings[ind].bytes_allocated;
+    }
+    columns[kNumFitPhases + 1] = rows;
+    names[kNumFitPhases + 1] = "rows_scanned";
+    columns[kNumFitPhases + 2] = nodes;
+    names[kNumFitPhases + 2] = "nodes_searched";
+    columns[kNumFitPhases + 3] = bytes;
+    names[kNumFitPhases + 3] = "bytes_allocated";
+
+    columns.attr("names") = names;
+    columns.attr("row.names") =
+        Rcpp::IntegerVector::create(NA_INTEGER, -kNumTrees);
+    columns.attr("class") = "data.frame";
+    return columns;
+  }
+
+  // the fit as the R list gbm returns, each tree an unnamed list of its
+  // node arrays, and its timings if they were recorded
+  inline Rcpp::List fit_wrap(const GbmFit& kFit, int first_tree) {
+    Rcpp::List trees(kFit.trees().size());
+    for (unsigned long tree = 0; tree < kFit.trees().size(); tree++) {
+      const TreeArrays& kTree = kFit.trees()[tree];
+      trees[tree] = Rcpp::List::create(
+          Rcpp::wrap(kTree.split_vars), Rcpp::wrap(kTree.split_values),
+          Rcpp::wrap(kTree.left_nodes), Rcpp::wrap(kTree.right_nodes),
+          Rcpp::wrap(kTree.missing_nodes), Rcpp::wrap(kTree.error_reduction),
+          Rcpp::wrap(kTree.weights), Rcpp::wrap(kTree.node_predictions));
+    }
+
+    Rcpp::List fit = Rcpp::List::create(
+        Rcpp::Named("initF") = kFit.initial_estimate(),
+        Rcpp::Named("fit") = Rcpp::wrap(kFit.func_estimate()),
+        Rcpp::Named("train.error") = Rcpp::wrap(kFit.training_errors()),
+        Rcpp::Named("valid.error") = Rcpp::wrap(kFit.validation_errors()),
+        Rcpp::Named("oobag.improve") =
+            Rcpp::wrap(kFit.outofbag_improvement()),
+        Rcpp::Named("trees") = trees,
+        Rcpp::Named("c.splits") = Rcpp::wrap(kFit.split_codes()));
+    if (!kFit.timings().empty()) {
+      fit.push_back(fit_timings_wrap(kFit.timings(), first_tree), "timings");
+    }
+    return fit;
+  }
+
+  // R's services for the engine
+  double r_uniform() { return unif_rand(); }
+  void r_message(const char* kMessage) { Rprintf("%s", kMessage); }
+  void r_warning(const char* kMessage) { Rcpp::warning(kMessage); }
+
 }
 
 //----------------------------------------
@@ -49,7 +230,8 @@ extern "C" {
 // Returns: R List containing: the initial function estimate, the fit,
 //			training errors, validation errors, out of bag
 //			improvement, the trees and the categorical
-//			splits.
+//			splits, and the timings of the trees if
+//			par_details asks for them.
 //
 // Description: Fits a gbm model to data.
 //
@@ -61,9 +243,12 @@ extern "C" {
 //  via
 //				double ptr - NA for no offset
 //  covariates - SEXP containing the predictor values - becomes
-//  Rcpp::NumericMatrix
+//  Rcpp::NumericMatrix - or an external pointer to prepared data, which
+//  then also supply covar_order, intResponse and row_to_obs_id, or
+//  the predictors' bin codes in place of their values and order.
 //  covar_order - SEXP containing the order of predictor values to
-//  			be used in GBM formula - accessed via int ptr.
+//  			be used in GBM formula - accessed via int ptr - empty
+//  			for the histogram split search, which does not use it.
 //  obs_weight  - SEXP containing weights to be used in fitting
 //  				process - accessed via double ptr.
 //  misc - SEXP list object containing distribution dependent data
@@ -110,7 +295,8 @@ extern "C" {
 //						 first fit it is 0.
 //  prev_trees_fitted -  SEXP containing const int - number of previous trees
 //  fitted.
-//  par_details - SEXP giving details about parallelization
+//  par_details - SEXP giving details about parallelization, whether to
+//  record timings and the file to write a trace of the fit to
 //  isverbose - SEXP which is a const bool specifying whether the fitting should
 //  be
 //				silent or not.
@@ -130,39 +316,114 @@ SEXP gbm(SEXP response, SEXP intResponse, SEXP offset_vec, SEXP covariates,
   Rcpp::RObject result; // THIS MUST ALWAYS BE BEFORE RNGSCOPE
   Rcpp::RNGScope scope;
 
+  // the engine draws its random numbers from R and writes to R's console
+  gbm_platform::set_uniform_generator(r_uniform);
+  gbm_platform::set_message_writer(r_message);
+  gbm_platform::set_warning_writer(r_warning);
+
   // Set up consts for tree fitting and transfer to R API
   const int kNumTrees = Rcpp::as<int>(num_trees);
   const int kCatSplitsOld = Rcpp::as<int>(prev_category_splits);
   const int kTreesOld = Rcpp::as<int>(prev_trees_fitted);
   const bool kIsVerbose = Rcpp::as<bool>(isverbose);
+  const bool kRecordTimings = timings_wrap(par_details);
   const Rcpp::NumericVector kPrevFuncEst(prev_func_estimate);
 
   // extract parallelization info in one place
   // as it's used by both the distribution and the tree
   const parallel_details parallel(parallel_details_wrap(par_details));
+  TraceSession trace(trace_file_wrap(par_details), parallel.get_num_threads());
+
+  // prepared data stand in for the predictors, their order, the
+  // strata/sort vectors and the observation ids
+  const PreparedData* prepared = NULL;
+  if (TYPEOF(covariates) == EXTPTRSXP) {
+    prepared = &prepared_data_wrap(covariates);
+    if (prepared->num_trainrows() !=
+        Rcpp::as<unsigned long>(num_rows_in_training)) {
+      throw gbm_exception::InvalidArgument(
+          "shape mismatch (prepared data do not match training rows)");
+    }
+    covariates = prepared->xvalues();
+    covar_order = prepared->xorder();
+    intResponse = prepared->intresponse();
+    row_to_obs_id = prepared->observationids();
+  }
+
+  // the R data the engine views - these must outlive it
+  Rcpp::NumericMatrix response_mat(response);
+  Rcpp::IntegerMatrix int_response_mat(intResponse);
+  Rcpp::NumericVector offset(offset_vec);
+  Rcpp::NumericMatrix covariate_mat(covariates);
+  Rcpp::IntegerVector order(covar_order);
+  Rcpp::NumericVector weights(obs_weight);
+  Rcpp::IntegerVector obs_ids(row_to_obs_id);
+  Rcpp::IntegerVector classes(var_classes);
+  Rcpp::IntegerVector monotonicity(monotonicity_vec);
+  const Rcpp::List kMisc(misc);
+  const SEXP kMiscValue = kMisc[0];
+  Rcpp::NumericVector misc_values;
 
   // Set up parameters for initialization
-  DataDistParams datadistparams(
-      response, intResponse, offset_vec, covariates, covar_order, 
-      obs_weight, misc, prior_coeff_var, row_to_obs_id, var_classes,
-      monotonicity_vec, dist_family, fraction_inbag, num_rows_in_training,
-      num_obs_in_training, number_offeatures, parallel);
-  TreeParams treeparams(tree_depth, min_num_node_obs, shrinkageconstant,
-                        num_rows_in_training, parallel);
+  DataDistParams datadistparams;
+  datadistparams.response = matrix_span_wrap<double>(response_mat);
+  datadistparams.intResponse = matrix_span_wrap<int>(int_response_mat);
+  datadistparams.observationids = span_wrap<int>(obs_ids);
+  datadistparams.offset = span_wrap<double>(offset);
+  datadistparams.xvalues = matrix_span_wrap<double>(covariate_mat);
+  datadistparams.xorder = span_wrap<int>(order);
+  datadistparams.variable_weight = span_wrap<double>(weights);
+  datadistparams.variable_num_classes = span_wrap<int>(classes);
+  datadistparams.variable_monotonicity = span_wrap<int>(monotonicity);
+  // misc is the CoxPH ties method or numbers, NA if there are none
+  if (TYPEOF(kMiscValue) == STRSXP) {
+    datadistparams.misc_string = Rcpp::as<std::string>(kMiscValue);
+  } else {
+    misc_values = kMiscValue;
+    datadistparams.misc = span_wrap<double>(misc_values);
+  }
+  datadistparams.parallel = parallel;
+  datadistparams.num_trainrows = Rcpp::as<unsigned long>(num_rows_in_training);
+  datadistparams.num_trainobservations =
+      Rcpp::as<unsigned long>(num_obs_in_training);
+  datadistparams.num_features = Rcpp::as<unsigned long>(number_offeatures);
+  datadistparams.bagfraction = Rcpp::as<double>(fraction_inbag);
+  datadistparams.prior_coefficient_variation =
+      Rcpp::as<double>(prior_coeff_var);
+  datadistparams.family = Rcpp::as<std::string>(dist_family);
+  if (datadistparams.family.empty()) {
+    throw gbm_exception::Failure(
+        "configStructs - Can't specify IR metric as family not initialized.");
+  }
+  if (prepared) {
+    datadistparams.observation_rows = prepared->observation_rows();
+    datadistparams.observation_starts = prepared->observation_starts();
+    datadistparams.binned_features = prepared->binned_features();
+  }
+  TreeParams treeparams(Rcpp::as<unsigned long>(tree_depth),
+                        Rcpp::as<unsigned long>(min_num_node_obs),
+                        Rcpp::as<double>(shrinkageconstant),
+                        Rcpp::as<unsigned long>(num_rows_in_training),
+                        parallel);
 
   // Initialize GBM engine
   CGBMEngine gbm(datadistparams, treeparams);
 
   // Initialize the output object
   GbmFit gbmfit(datadistparams.response.nrow(), gbm.initial_function_estimate(),
-                kNumTrees, kPrevFuncEst);
+                kNumTrees, Span<const double>(kPrevFuncEst.begin(),
+                                              kPrevFuncEst.size()),
+                kRecordTimings);
 
 
   if (kIsVerbose) {
-    Rprintf("Iter   TrainDeviance   ValidDeviance   StepSize   Improve\n");
+    Rprintf("Iter   TrainDeviance   ValidDeviance   StepSize   Improve"
+            "     Rows/sec\n");
   }
   for (int treenum = 0; treenum < kNumTrees; treenum++) {
     Rcpp::checkUserInterrupt();
+    TraceScope tree_scope("tree", "tree", treenum + 1 + kTreesOld);
+    const double kTreeStart = gbm_platform::MonotonicSeconds();
 
     // Calculate Errors
     gbmfit.accumulate(gbm);
@@ -170,22 +431,26 @@ SEXP gbm(SEXP response, SEXP intResponse, SEXP offset_vec, SEXP covariates,
     // Create Trees
     gbmfit.CreateTreeRepresentation(kCatSplitsOld);
 
-    // print the information
+    // print the information, with the training rows fitted per second
     if ((kIsVerbose) &&
         ((treenum <= 9) || (0 == (treenum + 1 + kTreesOld) % 20) ||
          (treenum == kNumTrees - 1))) {
-      Rprintf("%6d %13.4f %15.4f %10.4f %9.4f\n", treenum + 1 + kTreesOld,
-              gbmfit.get_tree_training_error(), gbmfit.get_tree_valid_error(),
-              treeparams.shrinkage, gbmfit.get_tree_oobag_improv());
+      const double kSeconds = gbm_platform::MonotonicSeconds() - kTreeStart;
+      Rprintf("%6d %13.4f %15.4f %10.4f %9.4f %12.0f\n",
+              treenum + 1 + kTreesOld, gbmfit.get_tree_training_error(),
+              gbmfit.get_tree_valid_error(), treeparams.shrinkage,
+              gbmfit.get_tree_oobag_improv(),
+              (kSeconds > 0) ? datadistparams.num_trainrows / kSeconds : 0.0);
     }
 
     // Increment internal count
     gbmfit.increment_count();
   }
   if (kIsVerbose) Rprintf("\n");
+  trace.Finish();
 
   // DO NOT REMOVE!
-  result = gbmfit.ROutput();
+  result = fit_wrap(gbmfit, kTreesOld + 1);
 
   return result;
   END_RCPP
@@ -208,7 +473,8 @@ SEXP gbm(SEXP response, SEXP intResponse, SEXP offset_vec, SEXP covariates,
 // Rcpp::IntegerVector.
 //  initial_func_est - SEXP specifying initial prediction estimate - double.
 //  fitted_trees - SEXP containing lists defining the previously fitted trees -
-//					stored as const Rcpp::GenericVector.
+//					stored as const Rcpp::GenericVector - or an
+//  external pointer to the model compiled by gbm_compile_model.
 //  categorical_splits - SEXP containing  list of the categories of the split
 //  variables
 //						defining a tree - stored as a
@@ -220,104 +486,237 @@ SEXP gbm(SEXP response, SEXP intResponse, SEXP offset_vec, SEXP covariates,
 //  ret_single_tree_res - SEXP which is a const bool specifying whether the
 //  fitting should be
 //				only a single tree.
+//  par_details - SEXP giving details about parallelization
 //-----------------------------------
 
 SEXP gbm_pred(SEXP covariates, SEXP num_trees, SEXP initial_func_est,
               SEXP fitted_trees, SEXP categorical_splits, SEXP variable_type,
-              SEXP ret_single_tree_res) {
+              SEXP ret_single_tree_res, SEXP par_details) {
   BEGIN_RCPP
-  int tree_num = 0;
-  int obs_num = 0;
   const Rcpp::NumericMatrix kCovarMat(covariates);
   const int kNumCovarRows = kCovarMat.nrow();
   const Rcpp::IntegerVector kTrees(num_trees);
-  const Rcpp::GenericVector kFittedTrees(fitted_trees);
   const Rcpp::IntegerVector kVarType(variable_type);
-  const Rcpp::GenericVector kSplits(categorical_splits);
   const bool kSingleTree = Rcpp::as<bool>(ret_single_tree_res);
   const int kPredIterations = kTrees.size();
-  int prediction_iteration = 0;
-  int class_num = 0;
+  const parallel_details kParallel(parallel_details_wrap(par_details));
 
-  if ((kCovarMat.ncol() != kVarType.size())) {
+  // a model compiled by gbm_compile_model is used as it stands, the tree
+  // lists are compiled for this call only
+  std::auto_ptr<CompiledModel> compiled;
+  const CompiledModel* model = NULL;
+  if (TYPEOF(fitted_trees) == EXTPTRSXP) {
+    model = &compiled_model_wrap(fitted_trees);
+  } else {
+    compiled.reset(compiled_model_create(fitted_trees, categorical_splits,
+                                         variable_type));
+    model = compiled.get();
+  }
+
+  if ((kCovarMat.ncol() != kVarType.size()) ||
+      (kCovarMat.ncol() != model->num_vars())) {
     throw gbm_exception::InvalidArgument("shape mismatch");
   }
 
   Rcpp::NumericVector predicted_func(kNumCovarRows * kPredIterations);
+  model->Predict(kCovarMat.begin(), kNumCovarRows, kTrees.begin(),
+                 kPredIterations, Rcpp::as<double>(initial_func_est),
+                 kSingleTree, kParallel, predicted_func.begin());
+
+  return Rcpp::wrap(predicted_func);
+  END_RCPP
+}
+
+//-----------------------------------
+// Function: gbm_compile_model
+//
+// Returns: external pointer to the compiled model
+//
+// Description: packs the trees of a fitted model into flat arrays once,
+//              for gbm_pred to use in place of the tree lists.
+//
+// Parameters:
+//  fitted_trees - SEXP containing lists defining the fitted trees -
+//					stored as const Rcpp::GenericVector.
+//  categorical_splits - SEXP containing  list of the categories of the split
+//  variables
+//						defining a tree - stored as a
+// const
+// Rcpp::GenericVector.
+//  variable_type -  SEXP containing integers specifying whether the variable
+//					is continuous/nominal- stored as const
+// Rcpp::IntegerVector.
+//-----------------------------------
+SEXP gbm_compile_model(SEXP fitted_trees, SEXP categorical_splits,
+                       SEXP variable_type) {
+  BEGIN_RCPP
+  Rcpp::XPtr<CompiledModel> compiled(
+      compiled_model_create(fitted_trees, categorical_splits, variable_type),
+      true);
+  return compiled;
+  END_RCPP
+}  // gbm_compile_model
 
-  // initialize the predicted values
-  if (!kSingleTree) {
-    std::fill(predicted_func.begin(), predicted_func.begin() + kNumCovarRows,
-              Rcpp::as<double>(initial_func_est));
+//-----------------------------------
+// Function: gbm_compiled_model_valid
+//
+// Returns: logical, TRUE if the compiled model can still be used
+//
+// Description: checks a compiled model has not been lost - external
+//              pointers are cleared when saved and reloaded.
+//
+// Parameters:
+//  compiled_model - SEXP external pointer to a compiled model
+//-----------------------------------
+SEXP gbm_compiled_model_valid(SEXP compiled_model) {
+  BEGIN_RCPP
+  const bool kIsValid = (TYPEOF(compiled_model) == EXTPTRSXP) &&
+                        (R_ExternalPtrAddr(compiled_model) != NULL);
+  return Rcpp::wrap(kIsValid);
+  END_RCPP
+}  // gbm_compiled_model_valid
+
+//-----------------------------------
+// Function: gbm_generate_code
+//
+// Returns: character, the C source of the model
+//
+// Description: writes the first trees of a fitted model as standalone C
+//              source predicting as gbm_pred does.
+//
+// Parameters:
+//  fitted_trees - SEXP containing lists defining the fitted trees, or an
+//  external pointer to the model compiled by gbm_compile_model.
+//  categorical_splits - SEXP containing  list of the categories of the split
+//  variables - stored as a const Rcpp::GenericVector.
+//  variable_type -  SEXP containing integers specifying whether the variable
+//					is continuous/nominal- stored as const
+// Rcpp::IntegerVector.
+//  initial_func_est - SEXP specifying initial prediction estimate - double.
+//  num_trees - SEXP int, the number of trees to write.
+//  prefix - SEXP character, the prefix of the names in the source.
+//-----------------------------------
+SEXP gbm_generate_code(SEXP fitted_trees, SEXP categorical_splits,
+                       SEXP variable_type, SEXP initial_func_est,
+                       SEXP num_trees, SEXP prefix) {
+  BEGIN_RCPP
+  std::auto_ptr<CompiledModel> compiled;
+  const CompiledModel* model = NULL;
+  if (TYPEOF(fitted_trees) == EXTPTRSXP) {
+    model = &compiled_model_wrap(fitted_trees);
   } else {
-    predicted_func.fill(0.0);
+    compiled.reset(compiled_model_create(fitted_trees, categorical_splits,
+                                         variable_type));
+    model = compiled.get();
   }
-  tree_num = 0;
-  for (prediction_iteration = 0; prediction_iteration < kTrees.size();
-       prediction_iteration++) {
-    const int kCurrTree = kTrees[prediction_iteration];
-    if (kSingleTree) tree_num = kCurrTree - 1;
-    if (!kSingleTree && (prediction_iteration > 0)) {
-      // copy over from the last rcTrees
-      std::copy(
-          predicted_func.begin() + kNumCovarRows * (prediction_iteration - 1),
-          predicted_func.begin() + kNumCovarRows * prediction_iteration,
-          predicted_func.begin() + kNumCovarRows * prediction_iteration);
-    }
-    while (tree_num < kCurrTree) {
-      const Rcpp::GenericVector kThisFitTree = kFittedTrees[tree_num];
-      const Rcpp::IntegerVector kThisSplitVar = kThisFitTree[0];
-      const Rcpp::NumericVector kThisSplitCode = kThisFitTree[1];
-      const Rcpp::IntegerVector kThisLeftNode = kThisFitTree[2];
-      const Rcpp::IntegerVector kThisRightNode = kThisFitTree[3];
-      const Rcpp::IntegerVector kThisMissingNode = kThisFitTree[4];
-
-      for (obs_num = 0; obs_num < kNumCovarRows; obs_num++) {
-        int iCurrentNode = 0;
-        while (kThisSplitVar[iCurrentNode] != -1) {
-          const double dX =
-              kCovarMat[kThisSplitVar[iCurrentNode] * kNumCovarRows + obs_num];
-          // missing?
-          if (ISNA(dX)) {
-            iCurrentNode = kThisMissingNode[iCurrentNode];
-          }
-          // continuous?
-          else if (kVarType[kThisSplitVar[iCurrentNode]] == 0) {
-            if (dX < kThisSplitCode[iCurrentNode]) {
-              iCurrentNode = kThisLeftNode[iCurrentNode];
-            } else {
-              iCurrentNode = kThisRightNode[iCurrentNode];
-            }
-          } else  // categorical
-          {
-            const Rcpp::IntegerVector kMySplits =
-                kSplits[kThisSplitCode[iCurrentNode]];
-            if (kMySplits.size() < (int)dX + 1) {
-              iCurrentNode = kThisMissingNode[iCurrentNode];
-            } else {
-              const int iCatSplitIndicator = kMySplits[(int)dX];
-              if (iCatSplitIndicator == -1) {
-                iCurrentNode = kThisLeftNode[iCurrentNode];
-              } else if (iCatSplitIndicator == 1) {
-                iCurrentNode = kThisRightNode[iCurrentNode];
-              } else  // categorical level not present in training
-              {
-                iCurrentNode = kThisMissingNode[iCurrentNode];
-              }
-            }
-          }
-        }
-        predicted_func[kNumCovarRows * prediction_iteration +
-                       kNumCovarRows * class_num + obs_num] +=
-            kThisSplitCode[iCurrentNode];  // add the prediction
-      }                                    // iObs
-      tree_num++;
-    }  // iTree
-  }    // iPredIteration
 
-  return Rcpp::wrap(predicted_func);
+  const ModelCodeWriter kWriter(*model, Rcpp::as<double>(initial_func_est),
+                                Rcpp::as<int>(num_trees),
+                                Rcpp::as<std::string>(prefix));
+  return Rcpp::wrap(kWriter.Write());
   END_RCPP
-}
+}  // gbm_generate_code
+
+//-----------------------------------
+// Function: gbm_write_model
+//
+// Returns: none
+//
+// Description: writes the compiled trees of a fitted model to a model
+//              file that gbm_read_model maps back.
+//
+// Parameters:
+//  fitted_trees - SEXP containing lists defining the fitted trees, or an
+//  external pointer to the model compiled by gbm_compile_model.
+//  categorical_splits - SEXP containing  list of the categories of the split
+//  variables - stored as a const Rcpp::GenericVector.
+//  variable_type -  SEXP containing integers specifying whether the variable
+//					is continuous/nominal- stored as const
+// Rcpp::IntegerVector.
+//  initial_func_est - SEXP specifying initial prediction estimate - double.
+//  path - SEXP character, the path of the file.
+//-----------------------------------
+SEXP gbm_write_model(SEXP fitted_trees, SEXP categorical_splits,
+                     SEXP variable_type, SEXP initial_func_est, SEXP path) {
+  BEGIN_RCPP
+  std::auto_ptr<CompiledModel> compiled;
+  const CompiledModel* model = NULL;
+  if (TYPEOF(fitted_trees) == EXTPTRSXP) {
+    model = &compiled_model_wrap(fitted_trees);
+  } else {
+    compiled.reset(compiled_model_create(fitted_trees, categorical_splits,
+                                         variable_type));
+    model = compiled.get();
+  }
+
+  ModelFile::Write(*model, Rcpp::as<double>(initial_func_est),
+                   Rcpp::as<std::string>(path));
+  return R_NilValue;
+  END_RCPP
+}  // gbm_write_model
+
+//-----------------------------------
+// Function: gbm_read_model
+//
+// Returns: list of the compiled model, as an external pointer, its initial
+//          estimate and its numbers of trees and variables
+//
+// Description: maps a model file written by gbm_write_model into memory,
+//              for gbm_pred to score in place.
+//
+// Parameters:
+//  path - SEXP character, the path of the file.
+//-----------------------------------
+SEXP gbm_read_model(SEXP path) {
+  BEGIN_RCPP
+  std::auto_ptr<ModelFile> file(new ModelFile(Rcpp::as<std::string>(path)));
+  const double kInitialEstimate = file->initial_estimate();
+  Rcpp::XPtr<CompiledModel> compiled(new CompiledModel(file), true);
+
+  return Rcpp::List::create(
+      Rcpp::Named("compiled_model") = compiled,
+      Rcpp::Named("initF") = kInitialEstimate,
+      Rcpp::Named("num_trees") = compiled->num_trees(),
+      Rcpp::Named("num_vars") = compiled->num_vars());
+  END_RCPP
+}  // gbm_read_model
+
+//-----------------------------------
+// Function: gbm_math_kernels
+//
+// Returns: list with, for each set of kernels the machine supports, a list
+//          of exp and log(1 + exp) of the values
+//
+// Description: evaluates the vectorized exp and log(1 + exp) the
+//              distributions use with each set of kernels, to test them
+//              against R's.
+//
+// Parameters:
+//  values - SEXP containing the values - const Rcpp::NumericVector.
+//-----------------------------------
+SEXP gbm_math_kernels(SEXP values) {
+  BEGIN_RCPP
+  const Rcpp::NumericVector kValues(values);
+  Rcpp::List results;
+  for (int kernels = 0; kernels < gbm_vector_math::kNumKernels; kernels++) {
+    const gbm_vector_math::Kernels kKernels =
+        gbm_vector_math::Kernels(kernels);
+    if (!gbm_vector_math::IsSupported(kKernels)) continue;
+
+    Rcpp::NumericVector exp_values(kValues.size());
+    Rcpp::NumericVector log1pexp_values(kValues.size());
+    gbm_vector_math::Exp(kKernels, kValues.begin(), kValues.size(),
+                         exp_values.begin());
+    gbm_vector_math::Log1pExp(kKernels, kValues.begin(), kValues.size(),
+                              log1pexp_values.begin());
+    results.push_back(
+        Rcpp::List::create(Rcpp::Named("exp") = exp_values,
+                           Rcpp::Named("log1pexp") = log1pexp_values),
+        gbm_vector_math::KernelsName(kKernels));
+  }
+  return results;
+  END_RCPP
+}  // gbm_math_kernels
 
 //-----------------------------------
 // Function: gbm_plot
@@ -456,4 +855,170 @@ SEXP gbm_plot(
   END_RCPP
 }  // gbm_plot
 
+//-----------------------------------
+// Function: gbm_order_predictors
+//
+// Returns: integer matrix holding, for each predictor, the zero-based
+//          order of the training rows with missing values first.
+//
+// Description: computes the predictor order used by gbm, sorting the
+//              columns in parallel.
+//
+// Parameters:
+//  covariates - SEXP containing the predictor values - becomes
+//  Rcpp::NumericMatrix
+//  num_rows_in_training - SEXP containing the number of training rows,
+//                         which come first in the data.
+//  par_details - SEXP giving details about parallelization
+//-----------------------------------
+SEXP gbm_order_predictors(SEXP covariates, SEXP num_rows_in_training,
+                          SEXP par_details) {
+  BEGIN_RCPP
+  const Rcpp::NumericMatrix kCovarMat(covariates);
+  const int kNumTrainRows = Rcpp::as<int>(num_rows_in_training);
+  const parallel_details kParallel(parallel_details_wrap(par_details));
+
+  if ((kNumTrainRows < 0) || (kNumTrainRows > kCovarMat.nrow())) {
+    throw gbm_exception::InvalidArgument(
+        "your training instances don't make sense");
+  }
+
+  Rcpp::IntegerMatrix order(kNumTrainRows, kCovarMat.ncol());
+  gbm_functions::OrderPredictors(matrix_span_wrap<const double>(kCovarMat),
+                                 kNumTrainRows,
+                                 kParallel.get_num_threads(), order.begin());
+  return order;
+  END_RCPP
+}  // gbm_order_predictors
+
+//-----------------------------------
+// Function: gbm_subset_order
+//
+// Returns: integer matrix holding the predictor order of a subset of the
+//          rows.
+//
+// Description: reads the order of a subset of the training rows off the
+//              order of all of them, without sorting again.
+//
+// Parameters:
+//  covar_order - SEXP containing the zero-based predictor order - becomes
+//  Rcpp::IntegerMatrix
+//  rows_kept - SEXP containing a logical for each ordered row, TRUE if it
+//              is in the subset.
+//-----------------------------------
+SEXP gbm_subset_order(SEXP covar_order, SEXP rows_kept) {
+  BEGIN_RCPP
+  const Rcpp::IntegerMatrix kOrder(covar_order);
+  const Rcpp::LogicalVector kKeepRow(rows_kept);
+
+  if (kKeepRow.size() != kOrder.nrow()) {
+    throw gbm_exception::InvalidArgument(
+        "shape mismatch (rows kept does not match order)");
+  }
+
+  const int kNumKept = std::count(kKeepRow.begin(), kKeepRow.end(), TRUE);
+  Rcpp::IntegerMatrix order(kNumKept, kOrder.ncol());
+  gbm_functions::SubsetOrder(matrix_span_wrap<const int>(kOrder),
+                             kKeepRow.begin(), order.begin());
+  return order;
+  END_RCPP
+}  // gbm_subset_order
+
+//-----------------------------------
+// Function: gbm_prepare_data
+//
+// Returns: external pointer to the prepared data
+//
+// Description: converts a dataset once for repeated fits - the predictors,
+//              their order, the strata/sort vectors and the observation
+//              index are kept on the C++ side and passed to gbm in place
+//              of the predictors.  For the histogram split search only
+//              the predictors' bin codes are kept.
+//
+// Parameters:
+//  covariates - SEXP containing the predictor values - becomes
+//  Rcpp::NumericMatrix
+//  covar_order - SEXP containing the zero-based order of the training rows
+//                of each predictor, or an empty vector to compute it.
+//  var_classes - SEXP containing the number of levels of each predictor,
+//                0 if continuous.
+//  intResponse - SEXP containing integer components of response
+//  row_to_obs_id - SEXP storing integer ids mapping each row to
+//          		its observation - becomes Rcpp::IntegerVector.
+//  num_rows_in_training - SEXP containing the number of training rows,
+//                         which come first in the data.
+//  par_details - SEXP giving details about parallelization
+//-----------------------------------
+SEXP gbm_prepare_data(SEXP covariates, SEXP covar_order, SEXP var_classes,
+                      SEXP intResponse, SEXP row_to_obs_id,
+                      SEXP num_rows_in_training, SEXP par_details) {
+  BEGIN_RCPP
+  const parallel_details kParallel(parallel_details_wrap(par_details));
+  Rcpp::XPtr<PreparedData> prepared(
+      new PreparedData(Rcpp::NumericMatrix(covariates),
+                       Rcpp::IntegerVector(covar_order),
+                       Rcpp::IntegerVector(var_classes),
+                       Rcpp::IntegerMatrix(intResponse),
+                       Rcpp::IntegerVector(row_to_obs_id),
+                       Rcpp::as<unsigned long>(num_rows_in_training),
+                       kParallel),
+      true);
+  return prepared;
+  END_RCPP
+}  // gbm_prepare_data
+
+//-----------------------------------
+// Function: gbm_prepare_fold
+//
+// Returns: external pointer to the prepared data of a cross-validation fold
+//
+// Description: prepares the data of a fold from the prepared data of the
+//              whole training set, reading the predictor order off the
+//              parent's instead of sorting again.
+//
+// Parameters:
+//  prepared_data - SEXP external pointer to the prepared data of all rows
+//  rows_in_training - SEXP containing a logical for each row, TRUE if it
+//                     is in the training set.
+//  rows_in_fold - SEXP containing a logical for each training row, TRUE
+//                 if it is in the fold.
+//  intResponse - SEXP containing integer components of the fold's response
+//  row_to_obs_id - SEXP storing the observation id of each fold row
+//  par_details - SEXP giving details about parallelization
+//-----------------------------------
+SEXP gbm_prepare_fold(SEXP prepared_data, SEXP rows_in_training,
+                      SEXP rows_in_fold, SEXP intResponse,
+                      SEXP row_to_obs_id, SEXP par_details) {
+  BEGIN_RCPP
+  const parallel_details kParallel(parallel_details_wrap(par_details));
+  const PreparedData& kParent = prepared_data_wrap(prepared_data);
+  Rcpp::XPtr<PreparedData> prepared(
+      new PreparedData(kParent, Rcpp::LogicalVector(rows_in_training),
+                       Rcpp::LogicalVector(rows_in_fold),
+                       Rcpp::IntegerMatrix(intResponse),
+                       Rcpp::IntegerVector(row_to_obs_id), kParallel),
+      true);
+  return prepared;
+  END_RCPP
+}  // gbm_prepare_fold
+
+//-----------------------------------
+// Function: gbm_prepared_data_valid
+//
+// Returns: logical, TRUE if the prepared data can still be used
+//
+// Description: checks prepared data have not been lost - external
+//              pointers are cleared when saved and reloaded.
+//
+// Parameters:
+//  prepared_data - SEXP external pointer to prepared data
+//-----------------------------------
+SEXP gbm_prepared_data_valid(SEXP prepared_data) {
+  BEGIN_RCPP
+  const bool kIsValid = (TYPEOF(prepared_data) == EXTPTRSXP) &&
+                        (R_ExternalPtrAddr(prepared_data) != NULL);
+  return Rcpp::wrap(kIsValid);
+  END_RCPP
+}  // gbm_prepared_data_valid
+
 }  // end extern "C"
@@ -21,7 +21,9 @@
 // Includes
 //------------------------------
 #include "dataset.h"
-#include <Rcpp.h>
+#include "distribution.h"
+#include <cmath>
+#include <vector>
 
 //------------------------------
 // Generic Dispatch Definition
@@ -58,5 +60,29 @@ class GenericCoxState {
                                 const double* kFuncEstimate,
                                 const double kShrinkage,
                                 const std::vector<double>& kDeltaEstimate) = 0;
+
+ protected:
+  //---------------------
+  // Protected Functions
+  //---------------------
+  // risk_scores_[i] = exp(eta[i] + offset[i] - center) for the rows [0, n),
+  // computed in parallel ahead of the likelihood's scan of the rows, which
+  // is serial
+  void ComputeRiskScores(const CDistribution& kDist, int n,
+                         const CDataset& kData, const double* kEta,
+                         double center) {
+    risk_scores_.resize(n);
+
+#pragma omp parallel for schedule(static, kDist.get_array_chunk_size()) \
+    num_threads(kDist.get_num_threads())
+    for (int i = 0; i < n; i++) {
+      risk_scores_[i] = std::exp(kEta[i] + kData.offset_ptr()[i] - center);
+    }
+  }
+
+  //---------------------
+  // Protected Variables
+  //---------------------
+  std::vector<double> risk_scores_;
 };
 #endif  // GENERICCOXSTATE_H
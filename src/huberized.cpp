@@ -10,18 +10,20 @@
 // Includes
 //-----------------------------------
 #include "huberized.h"
+#include "block_sums.h"
 
 //----------------------------------------
 // Function Members - Private
 //----------------------------------------
-CHuberized::CHuberized() {}
+CHuberized::CHuberized(const parallel_details& parallel)
+    : CDistribution(parallel) {}
 
 //----------------------------------------
 // Function Members - Public
 //----------------------------------------
 
 CDistribution* CHuberized::Create(DataDistParams& distparams) {
-  return new CHuberized();
+  return new CHuberized(distparams.parallel);
 }
 
 CHuberized::~CHuberized() {}
@@ -29,11 +31,10 @@ CHuberized::~CHuberized() {}
 void CHuberized::ComputeWorkingResponse(const CDataset& kData, const Bag& kBag,
                                         const double* kFuncEstimate,
                                         std::vector<double>& residuals) {
-  unsigned long i = 0;
-  double delta_func_est = 0.0;
-
-  for (i = 0; i < kData.get_trainsize(); i++) {
-    delta_func_est = kFuncEstimate[i] + kData.offset_ptr()[i];
+#pragma omp parallel for schedule(static, get_array_chunk_size()) \
+    num_threads(get_num_threads())
+  for (unsigned long i = 0; i < kData.get_trainsize(); i++) {
+    const double delta_func_est = kFuncEstimate[i] + kData.offset_ptr()[i];
     if ((2 * kData.y_ptr()[i] - 1) * delta_func_est < -1) {
       residuals[i] = -4 * (2 * kData.y_ptr()[i] - 1);
     } else if (1 - (2 * kData.y_ptr()[i] - 1) * delta_func_est < 0) {
@@ -46,46 +47,65 @@ void CHuberized::ComputeWorkingResponse(const CDataset& kData, const Bag& kBag,
 }
 
 double CHuberized::InitF(const CDataset& kData) {
-  unsigned long i = 0;
-  double numerator = 0.0;
-  double denominator = 0.0;
-
-  for (i = 0; i < kData.get_trainsize(); i++) {
-    if (kData.y_ptr()[i] == 1.0) {
-      numerator += kData.weight_ptr()[i];
-    } else {
-      denominator += kData.weight_ptr()[i];
+  BlockSums sums(kData.get_trainsize(), 2);
+
+#pragma omp parallel for schedule( \
+    static, gbm_vector_math::BlocksPerChunk(get_array_chunk_size())) \
+    num_threads(get_num_threads())
+  for (unsigned long block = 0; block < sums.num_blocks(); block++) {
+    double numerator = 0.0;
+    double denominator = 0.0;
+    for (unsigned long i = sums.begin(block); i < sums.end(block); i++) {
+      if (kData.y_ptr()[i] == 1.0) {
+        numerator += kData.weight_ptr()[i];
+      } else {
+        denominator += kData.weight_ptr()[i];
+      }
     }
+    sums(block, 0) = numerator;
+    sums(block, 1) = denominator;
   }
 
+  double numerator = sums.Total(0);
+  double denominator = sums.Total(1);
+
   return numerator / denominator;
 }
 
 double CHuberized::Deviance(const CDataset& kData, const Bag& kBag,
                             const double* kFuncEstimate) {
-  unsigned long i = 0;
-  double loss = 0.0;
-  double delta_func_est = 0.0;
-  double weights = 0.0;
-
   unsigned long num_rows_in_set = kData.get_size_of_set();
 
-  for (i = 0; i < num_rows_in_set; i++) {
-    delta_func_est = kData.offset_ptr()[i] + kFuncEstimate[i];
-    if ((2 * kData.y_ptr()[i] - 1) * delta_func_est < -1) {
-      loss += -kData.weight_ptr()[i] * 4 * (2 * kData.y_ptr()[i] - 1) *
-              delta_func_est;
-      weights += kData.weight_ptr()[i];
-    } else if (1 - (2 * kData.y_ptr()[i] - 1) * delta_func_est < 0) {
-      loss += 0;
-      weights += kData.weight_ptr()[i];
-    } else {
-      loss += kData.weight_ptr()[i] *
-              (1 - (2 * kData.y_ptr()[i] - 1) * delta_func_est) *
-              (1 - (2 * kData.y_ptr()[i] - 1) * delta_func_est);
-      weights += kData.weight_ptr()[i];
+  BlockSums sums(num_rows_in_set, 2);
+
+#pragma omp parallel for schedule( \
+    static, gbm_vector_math::BlocksPerChunk(get_array_chunk_size())) \
+    num_threads(get_num_threads())
+  for (unsigned long block = 0; block < sums.num_blocks(); block++) {
+    double loss = 0.0;
+    double weights = 0.0;
+    for (unsigned long i = sums.begin(block); i < sums.end(block); i++) {
+      const double delta_func_est = kData.offset_ptr()[i] + kFuncEstimate[i];
+      if ((2 * kData.y_ptr()[i] - 1) * delta_func_est < -1) {
+        loss += -kData.weight_ptr()[i] * 4 * (2 * kData.y_ptr()[i] - 1) *
+                delta_func_est;
+        weights += kData.weight_ptr()[i];
+      } else if (1 - (2 * kData.y_ptr()[i] - 1) * delta_func_est < 0) {
+        loss += 0;
+        weights += kData.weight_ptr()[i];
+      } else {
+        loss += kData.weight_ptr()[i] *
+                (1 - (2 * kData.y_ptr()[i] - 1) * delta_func_est) *
+                (1 - (2 * kData.y_ptr()[i] - 1) * delta_func_est);
+        weights += kData.weight_ptr()[i];
+      }
     }
-  }  // close for(
+    sums(block, 0) = loss;
+    sums(block, 1) = weights;
+  }
+
+  double loss = sums.Total(0);
+  double weights = sums.Total(1);
 
   // TODO: Check if weights are all zero for validation set
   if ((weights == 0.0) && (loss == 0.0)) {
@@ -150,40 +170,50 @@ double CHuberized::BagImprovement(const CDataset& kData, const Bag& kBag,
                                   const double* kFuncEstimate,
                                   const double kShrinkage,
                                   const std::vector<double>& kDeltaEstimate) {
-  double returnvalue = 0.0;
-  double delta_func_est = 0.0;
-  double weight = 0.0;
-  unsigned long i = 0;
-
-  for (i = 0; i < kData.get_trainsize(); i++) {
-    if (!kBag.get_element(i)) {
-      delta_func_est = kFuncEstimate[i] + kData.offset_ptr()[i];
-
-      if ((2 * kData.y_ptr()[i] - 1) * delta_func_est < -1) {
-        returnvalue += kData.weight_ptr()[i] *
-                       (-4 * (2 * kData.y_ptr()[i] - 1) * delta_func_est -
-                        -4 * (2 * kData.y_ptr()[i] - 1) *
-                            (delta_func_est + kShrinkage * kDeltaEstimate[i]));
-        weight += kData.weight_ptr()[i];
-      } else if (1 - (2 * kData.y_ptr()[i] - 1) * delta_func_est < 0) {
-        returnvalue += 0;
-        weight += kData.weight_ptr()[i];
-      } else {
-        returnvalue +=
-            kData.weight_ptr()[i] *
-            ((1 - (2 * kData.y_ptr()[i] - 1) * delta_func_est) *
-                 (1 - (2 * kData.y_ptr()[i] - 1) * delta_func_est) -
-             (1 -
-              (2 * kData.y_ptr()[i] - 1) *
-                  (delta_func_est + kShrinkage * kDeltaEstimate[i])) *
-                 (1 -
-                  (2 * kData.y_ptr()[i] - 1) *
-                      (delta_func_est + kShrinkage * kDeltaEstimate[i])));
-        // TODO: Does this require an weight+= ?
+  BlockSums sums(kData.get_trainsize(), 2);
+
+#pragma omp parallel for schedule( \
+    static, gbm_vector_math::BlocksPerChunk(get_array_chunk_size())) \
+    num_threads(get_num_threads())
+  for (unsigned long block = 0; block < sums.num_blocks(); block++) {
+    double returnvalue = 0.0;
+    double weight = 0.0;
+    for (unsigned long i = sums.begin(block); i < sums.end(block); i++) {
+      if (!kBag.get_element(i)) {
+        const double delta_func_est = kFuncEstimate[i] + kData.offset_ptr()[i];
+
+        if ((2 * kData.y_ptr()[i] - 1) * delta_func_est < -1) {
+          returnvalue +=
+              kData.weight_ptr()[i] *
+              (-4 * (2 * kData.y_ptr()[i] - 1) * delta_func_est -
+               -4 * (2 * kData.y_ptr()[i] - 1) *
+                   (delta_func_est + kShrinkage * kDeltaEstimate[i]));
+          weight += kData.weight_ptr()[i];
+        } else if (1 - (2 * kData.y_ptr()[i] - 1) * delta_func_est < 0) {
+          returnvalue += 0;
+          weight += kData.weight_ptr()[i];
+        } else {
+          returnvalue +=
+              kData.weight_ptr()[i] *
+              ((1 - (2 * kData.y_ptr()[i] - 1) * delta_func_est) *
+                   (1 - (2 * kData.y_ptr()[i] - 1) * delta_func_est) -
+               (1 -
+                (2 * kData.y_ptr()[i] - 1) *
+                    (delta_func_est + kShrinkage * kDeltaEstimate[i])) *
+                   (1 -
+                    (2 * kData.y_ptr()[i] - 1) *
+                        (delta_func_est + kShrinkage * kDeltaEstimate[i])));
+          // TODO: Does this require an weight+= ?
+        }
       }
     }
+    sums(block, 0) = returnvalue;
+    sums(block, 1) = weight;
   }
 
+  double returnvalue = sums.Total(0);
+  double weight = sums.Total(1);
+
   // TODO: Check if weights are all zero for validation set
   if ((weight == 0.0) && (returnvalue == 0.0)) {
     return nan("");
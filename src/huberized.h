@@ -57,7 +57,7 @@ class CHuberized : public CDistribution {
   //----------------------
   // Private Constructors
   //----------------------
-  CHuberized();
+  CHuberized(const parallel_details& parallel);
 };
 
 #endif  // HUBERIZED_H
@@ -10,8 +10,23 @@
 // Includes
 //-----------------------------------
 #include "laplace.h"
+#include "block_sums.h"
 #include <vector>
 
+namespace {
+// the deviance from the total loss and weight of a set's rows
+double MeanDeviance(double loss, double weight) {
+  // TODO: Check if weights are all zero for validation set
+  if ((weight == 0.0) && (loss == 0.0)) {
+    return nan("");
+  } else if (weight == 0.0) {
+    return copysign(HUGE_VAL, loss);
+  }
+
+  return loss / weight;
+}
+}
+
 //----------------------------------------
 // Function Members - Private
 //----------------------------------------
@@ -55,27 +70,30 @@ double CLaplace::InitF(const CDataset& kData) {
 
 double CLaplace::Deviance(const CDataset& kData, const Bag& kBag,
                           const double* kFuncEstimates) {
-  double loss = 0.0;
-  double weight = 0.0;
-
   unsigned long num_rows_in_set = kData.get_size_of_set();
 
-#pragma omp parallel for schedule(static, get_array_chunk_size()) \
-    reduction(+ : loss, weight) num_threads(get_num_threads())
-  for (unsigned long i = 0; i < num_rows_in_set; i++) {
-    loss += kData.weight_ptr()[i] *
-            fabs(kData.y_ptr()[i] - kData.offset_ptr()[i] - kFuncEstimates[i]);
-    weight += kData.weight_ptr()[i];
+  BlockSums sums(num_rows_in_set, 2);
+
+#pragma omp parallel for schedule( \
+    static, gbm_vector_math::BlocksPerChunk(get_array_chunk_size())) \
+    num_threads(get_num_threads())
+  for (unsigned long block = 0; block < sums.num_blocks(); block++) {
+    double loss = 0.0;
+    double weight = 0.0;
+    for (unsigned long i = sums.begin(block); i < sums.end(block); i++) {
+      loss +=
+          kData.weight_ptr()[i] *
+          fabs(kData.y_ptr()[i] - kData.offset_ptr()[i] - kFuncEstimates[i]);
+      weight += kData.weight_ptr()[i];
+    }
+    sums(block, 0) = loss;
+    sums(block, 1) = weight;
   }
 
-  // TODO: Check if weights are all zero for validation set
-  if ((weight == 0.0) && (loss == 0.0)) {
-    return nan("");
-  } else if (weight == 0.0) {
-    return copysign(HUGE_VAL, loss);
-  }
+  double loss = sums.Total(0);
+  double weight = sums.Total(1);
 
-  return loss / weight;
+  return MeanDeviance(loss, weight);
 }
 
 // DEBUG: needs weighted median
@@ -118,22 +136,82 @@ double CLaplace::BagImprovement(const CDataset& kData, const Bag& kBag,
                                 const double* kFuncEstimate,
                                 const double kShrinkage,
                                 const std::vector<double>& kDeltaEstimate) {
-  double returnvalue = 0.0;
-  double weight = 0.0;
+  BlockSums sums(kData.get_trainsize(), 2);
+
+#pragma omp parallel for schedule( \
+    static, gbm_vector_math::BlocksPerChunk(get_array_chunk_size())) \
+    num_threads(get_num_threads())
+  for (unsigned long block = 0; block < sums.num_blocks(); block++) {
+    double returnvalue = 0.0;
+    double weight = 0.0;
+    for (unsigned long i = sums.begin(block); i < sums.end(block); i++) {
+      if (!kBag.get_element(i)) {
+        const double delta_func_est = kFuncEstimate[i] + kData.offset_ptr()[i];
+
+        returnvalue +=
+            kData.weight_ptr()[i] * (fabs(kData.y_ptr()[i] - delta_func_est) -
+                                     fabs(kData.y_ptr()[i] - delta_func_est -
+                                          kShrinkage * kDeltaEstimate[i]));
+        weight += kData.weight_ptr()[i];
+      }
+    }
+    sums(block, 0) = returnvalue;
+    sums(block, 1) = weight;
+  }
 
-#pragma omp parallel for schedule(static, get_array_chunk_size()) \
-    reduction(+ : returnvalue, weight) num_threads(get_num_threads())
-  for (unsigned long i = 0; i < kData.get_trainsize(); i++) {
-    if (!kBag.get_element(i)) {
-      const double delta_func_est = kFuncEstimate[i] + kData.offset_ptr()[i];
+  double returnvalue = sums.Total(0);
+  double weight = sums.Total(1);
 
-      returnvalue +=
-          kData.weight_ptr()[i] * (fabs(kData.y_ptr()[i] - delta_func_est) -
-                                   fabs(kData.y_ptr()[i] - delta_func_est -
-                                        kShrinkage * kDeltaEstimate[i]));
+  return returnvalue / weight;
+}
+
+bool CLaplace::FusedUpdate(const CDataset& kData, const Bag& kBag,
+                            const double kShrinkage,
+                            const std::vector<double>& kDeltaEstimate,
+                            double* func_estimate,
+                            std::vector<double>& residuals,
+                            double& oobag_improvement, double& deviance) {
+  BlockSums sums(kData.get_trainsize(), 4);
+
+#pragma omp parallel for schedule( \
+    static, gbm_vector_math::BlocksPerChunk(get_array_chunk_size())) \
+    num_threads(get_num_threads())
+  for (unsigned long block = 0; block < sums.num_blocks(); block++) {
+    double improvement = 0.0;
+    double oobag_weight = 0.0;
+    double loss = 0.0;
+    double weight = 0.0;
+    for (unsigned long i = sums.begin(block); i < sums.end(block); i++) {
+      if (!kBag.get_element(i)) {
+        const double delta_func_est = func_estimate[i] + kData.offset_ptr()[i];
+
+        improvement +=
+            kData.weight_ptr()[i] * (fabs(kData.y_ptr()[i] - delta_func_est) -
+                                     fabs(kData.y_ptr()[i] - delta_func_est -
+                                          kShrinkage * kDeltaEstimate[i]));
+        oobag_weight += kData.weight_ptr()[i];
+      }
+
+      func_estimate[i] += kShrinkage * kDeltaEstimate[i];
+
+      const double kError =
+          kData.y_ptr()[i] - kData.offset_ptr()[i] - func_estimate[i];
+      loss += kData.weight_ptr()[i] * fabs(kError);
       weight += kData.weight_ptr()[i];
+      residuals[i] = (kError > 0.0) ? 1.0 : -1.0;
     }
+    sums(block, 0) = improvement;
+    sums(block, 1) = oobag_weight;
+    sums(block, 2) = loss;
+    sums(block, 3) = weight;
   }
 
-  return returnvalue / weight;
+  double improvement = sums.Total(0);
+  double oobag_weight = sums.Total(1);
+  double loss = sums.Total(2);
+  double weight = sums.Total(3);
+
+  oobag_improvement = improvement / oobag_weight;
+  deviance = MeanDeviance(loss, weight);
+  return true;
 }
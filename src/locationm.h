@@ -13,7 +13,7 @@
 #include <utility>
 #include <vector>
 #include <algorithm>
-#include <R.h>
+#include <cmath>
 
 using namespace std;
 
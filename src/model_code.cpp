@@ -0,0 +1,304 @@
+//-----------------------------------
+//
+// File: model_code.cpp
+//
+// Description: writes a compiled model out as C source that predicts
+//   without R or gbm.
+//
+//-----------------------------------
+
+//-----------------------------------
+// Includes
+//-----------------------------------
+#include "model_code.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <iomanip>
+
+namespace {
+// Writes a value as a C constant, exactly - infinities and NaN as the
+// macros of <math.h>, which the generated code includes.
+std::string CDouble(double value) {
+  if (value != value) return "NAN";
+  if (value == HUGE_VAL) return "HUGE_VAL";
+  if (value == -HUGE_VAL) return "(-HUGE_VAL)";
+
+  std::ostringstream out;
+  out << std::setprecision(17) << value;
+  return out.str();
+}
+
+// Writes an entry of a static array, a few to a line.
+template <typename T>
+void WriteEntry(std::ostream& out, int index, const T& value,
+                const char* kSuffix = "") {
+  out << ((index % 10 == 0) ? "\n   " : "") << " " << value << kSuffix
+      << ",";
+}
+}
+
+//----------------------------------------
+// Function Members - Public
+//----------------------------------------
+//-----------------------------------
+// Function: ModelCodeWriter
+//
+// Returns: none
+//
+// Description: sets up the writer of the first trees of a compiled model.
+//
+// Parameters:
+//  kModel - the compiled model
+//  initial_estimate - the initial function estimate
+//  num_trees - the number of trees to predict with
+//  kPrefix - the prefix of the names in the generated code, a C identifier
+//-----------------------------------
+ModelCodeWriter::ModelCodeWriter(const CompiledModel& kModel,
+                                 double initial_estimate, int num_trees,
+                                 const std::string& kPrefix)
+    : kModel_(kModel),
+      initial_estimate_(initial_estimate),
+      num_trees_(num_trees),
+      prefix_(kPrefix) {
+  if ((num_trees < 0) || (num_trees > kModel.num_trees())) {
+    throw gbm_exception::InvalidArgument(
+        "number of trees out of range of the model");
+  }
+
+  bool is_identifier = !prefix_.empty() && !isdigit(prefix_[0]);
+  for (std::string::const_iterator it = prefix_.begin(); it != prefix_.end();
+       ++it) {
+    is_identifier = is_identifier && (isalnum(*it) || (*it == '_'));
+  }
+  if (!is_identifier) {
+    throw gbm_exception::InvalidArgument("prefix must be a C identifier");
+  }
+}
+
+//-----------------------------------
+// Function: Write
+//
+// Returns: the C source of the model
+//
+// Description: writes the model as C source defining
+//   <prefix>_predict(row), predicting one row, and
+//   <prefix>_predict_batch(x, num_rows, predictions), predicting the rows
+//   of column-major data and callable from R through .C.  The trees are
+//   summed in the order gbm_pred sums them, with split values and
+//   predictions written exactly, so the predictions are the same.
+//
+// Parameters: none
+//-----------------------------------
+std::string ModelCodeWriter::Write() const {
+  std::ostringstream out;
+  WriteHeader(out);
+  WriteCategorySplits(out);
+  for (int tree = 0; tree < num_trees_; tree++) {
+    WriteTree(out, tree);
+  }
+  WritePredict(out);
+  return out.str();
+}
+
+//----------------------------------------
+// Function Members - Private
+//----------------------------------------
+//-----------------------------------
+// Function: WriteHeader
+//
+// Returns: none
+//
+// Description: writes the description of the generated code and its
+//   missing value test - like gbm, only R's NA is missing and NaN goes
+//   the way of values not less than the split value.
+//
+// Parameters:
+//  out - the stream written to
+//-----------------------------------
+void ModelCodeWriter::WriteHeader(std::ostream& out) const {
+  out << "/* Generated by gbm: " << num_trees_ << " trees of "
+      << kModel_.num_vars() << " predictors.\n"
+      << " *\n"
+      << " * " << prefix_ << "_predict(row) predicts a row of the predictors "
+      << "in the order\n"
+      << " * they were fitted, factors as level codes from 0 and missing "
+      << "values as\n"
+      << " * R's NA.  " << prefix_ << "_predict_batch(x, num_rows, "
+      << "predictions) predicts\n"
+      << " * the rows of column-major data, as .C passes an R matrix.\n"
+      << " */\n"
+      << "#include <math.h>\n"
+      << "#include <stdint.h>\n"
+      << "#include <string.h>\n\n"
+      << "const int " << prefix_ << "_num_vars = " << kModel_.num_vars()
+      << ";\n\n"
+      << "static int " << prefix_ << "_is_na(double x) {\n"
+      << "  uint64_t bits;\n"
+      << "  if (x == x) return 0;\n"
+      << "  memcpy(&bits, &x, sizeof(bits));\n"
+      << "  return (bits & 0xFFFFFFFFu) == 1954;\n"
+      << "}\n\n";
+}
+
+//-----------------------------------
+// Function: WriteCategorySplits
+//
+// Returns: none
+//
+// Description: writes the categorical splits as static bitsets and the
+//   function giving the child a level goes to - 0 left, 1 right and 2
+//   missing, levels not seen in training going missing.
+//
+// Parameters:
+//  out - the stream written to
+//-----------------------------------
+void ModelCodeWriter::WriteCategorySplits(std::ostream& out) const {
+  const int kNumSplits = kModel_.num_category_splits();
+  if (kNumSplits == 0) return;
+
+  std::ostringstream levels, words, left_bits, right_bits;
+  int num_words = 0;
+  for (int split = 0; split < kNumSplits; split++) {
+    const int kLevels = kModel_.category_levels(split);
+    const int kSplitWords =
+        (kLevels + CompiledModel::kWordBits - 1) / CompiledModel::kWordBits;
+    WriteEntry(levels, split, kLevels);
+    WriteEntry(words, split, num_words);
+    for (int word = 0; word < kSplitWords; word++) {
+      WriteEntry(left_bits, num_words + word, kModel_.left_bits(split, word),
+                 "u");
+      WriteEntry(right_bits, num_words + word,
+                 kModel_.right_bits(split, word), "u");
+    }
+    num_words += kSplitWords;
+  }
+  // splits without levels have no words
+  if (num_words == 0) {
+    WriteEntry(left_bits, 0, 0, "u");
+    WriteEntry(right_bits, 0, 0, "u");
+  }
+
+  out << "static const int " << prefix_ << "_split_levels[] = {"
+      << levels.str() << "\n};\n"
+      << "static const int " << prefix_ << "_split_words[] = {" << words.str()
+      << "\n};\n"
+      << "static const unsigned int " << prefix_ << "_left_bits[] = {"
+      << left_bits.str() << "\n};\n"
+      << "static const unsigned int " << prefix_ << "_right_bits[] = {"
+      << right_bits.str() << "\n};\n\n"
+      << "static int " << prefix_ << "_category_child(int split, double x) "
+      << "{\n"
+      << "  int level, word;\n"
+      << "  unsigned int bit;\n"
+      << "  if (" << prefix_ << "_is_na(x) || (x != x)) return 2;\n"
+      << "  level = (int)x;\n"
+      << "  if ((level < 0) || (level >= " << prefix_
+      << "_split_levels[split])) return 2;\n"
+      << "  word = " << prefix_ << "_split_words[split] + level / "
+      << CompiledModel::kWordBits << ";\n"
+      << "  bit = 1u << (level % " << CompiledModel::kWordBits << ");\n"
+      << "  if (" << prefix_ << "_left_bits[word] & bit) return 0;\n"
+      << "  if (" << prefix_ << "_right_bits[word] & bit) return 1;\n"
+      << "  return 2;\n"
+      << "}\n\n";
+}
+
+//-----------------------------------
+// Function: WriteTree
+//
+// Returns: none
+//
+// Description: writes a tree as a function of the row.
+//
+// Parameters:
+//  out - the stream written to
+//  tree - the tree
+//-----------------------------------
+void ModelCodeWriter::WriteTree(std::ostream& out, int tree) const {
+  out << "static double " << prefix_ << "_tree_" << tree
+      << "(const double* x) {\n";
+  WriteNode(out, kModel_.tree_root(tree), 1);
+  out << "}\n\n";
+}
+
+//-----------------------------------
+// Function: WriteNode
+//
+// Returns: none
+//
+// Description: writes a node and its subtree as nested branches, each
+//   path returning the prediction of its leaf.
+//
+// Parameters:
+//  out - the stream written to
+//  node - the node
+//  depth - the depth of the node, for indentation
+//-----------------------------------
+void ModelCodeWriter::WriteNode(std::ostream& out, int node,
+                                int depth) const {
+  const std::string kIndent(2 * depth, ' ');
+  if (kModel_.split_var(node) == -1) {
+    out << kIndent << "return " << CDouble(kModel_.split_value(node))
+        << ";\n";
+    return;
+  }
+
+  if (kModel_.is_categorical(node)) {
+    out << kIndent << "switch (" << prefix_ << "_category_child("
+        << kModel_.category_split(node) << ", x["
+        << kModel_.split_var(node) << "])) {\n"
+        << kIndent << "case 0:\n";
+    WriteNode(out, kModel_.left_node(node), depth + 1);
+    out << kIndent << "case 1:\n";
+    WriteNode(out, kModel_.right_node(node), depth + 1);
+    out << kIndent << "default:\n";
+    WriteNode(out, kModel_.missing_node(node), depth + 1);
+    out << kIndent << "}\n";
+    return;
+  }
+
+  out << kIndent << "if (" << prefix_ << "_is_na(x["
+      << kModel_.split_var(node) << "])) {\n";
+  WriteNode(out, kModel_.missing_node(node), depth + 1);
+  out << kIndent << "} else if (x[" << kModel_.split_var(node) << "] < "
+      << CDouble(kModel_.split_value(node)) << ") {\n";
+  WriteNode(out, kModel_.left_node(node), depth + 1);
+  out << kIndent << "} else {\n";
+  WriteNode(out, kModel_.right_node(node), depth + 1);
+  out << kIndent << "}\n";
+}
+
+//-----------------------------------
+// Function: WritePredict
+//
+// Returns: none
+//
+// Description: writes the prediction of a row and of a batch of rows -
+//   the batch's row buffer has an entry even if there are no predictors,
+//   as C has no empty arrays.
+//
+// Parameters:
+//  out - the stream written to
+//-----------------------------------
+void ModelCodeWriter::WritePredict(std::ostream& out) const {
+  out << "double " << prefix_ << "_predict(const double* row) {\n"
+      << "  double prediction = " << CDouble(initial_estimate_) << ";\n";
+  for (int tree = 0; tree < num_trees_; tree++) {
+    out << "  prediction += " << prefix_ << "_tree_" << tree << "(row);\n";
+  }
+  out << "  return prediction;\n"
+      << "}\n\n"
+      << "void " << prefix_ << "_predict_batch(const double* x, "
+      << "const int* num_rows,\n"
+      << "    double* predictions) {\n"
+      << "  double row[" << std::max(kModel_.num_vars(), 1) << "];\n"
+      << "  int i, var;\n"
+      << "  for (i = 0; i < *num_rows; i++) {\n"
+      << "    for (var = 0; var < " << kModel_.num_vars() << "; var++) {\n"
+      << "      row[var] = x[var * *num_rows + i];\n"
+      << "    }\n"
+      << "    predictions[i] = " << prefix_ << "_predict(row);\n"
+      << "  }\n"
+      << "}\n";
+}
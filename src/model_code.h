@@ -0,0 +1,62 @@
+//------------------------------------------------------------------------------
+//
+//  File:       model_code.h
+//
+//  Description: header for the model code writer - writes a compiled model
+//    out as standalone C source, each tree a function of nested branches
+//    and the categorical splits static bitsets.
+//
+//------------------------------------------------------------------------------
+
+#ifndef MODELCODE_H
+#define MODELCODE_H
+
+//------------------------------
+// Includes
+//------------------------------
+#include "compiled_model.h"
+#include "gbm_exception.h"
+#include <sstream>
+#include <string>
+
+//------------------------------
+// Class definition
+//------------------------------
+class ModelCodeWriter {
+ public:
+  //----------------------
+  // Public Constructors
+  //----------------------
+  ModelCodeWriter(const CompiledModel& kModel, double initial_estimate,
+                  int num_trees, const std::string& kPrefix);
+
+  //---------------------
+  // Public destructor
+  //---------------------
+  ~ModelCodeWriter(){};
+
+  //---------------------
+  // Public Functions
+  //---------------------
+  std::string Write() const;
+
+ private:
+  //---------------------
+  // Private Functions
+  //---------------------
+  void WriteHeader(std::ostream& out) const;
+  void WriteCategorySplits(std::ostream& out) const;
+  void WriteTree(std::ostream& out, int tree) const;
+  void WriteNode(std::ostream& out, int node, int depth) const;
+  void WritePredict(std::ostream& out) const;
+
+  //-------------------
+  // Private Variables
+  //-------------------
+  const CompiledModel& kModel_;
+  double initial_estimate_;
+  int num_trees_;
+  std::string prefix_;
+};
+
+#endif  // MODELCODE_H
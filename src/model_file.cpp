@@ -0,0 +1,159 @@
+//-----------------------------------
+//
+// File: model_file.cpp
+//
+// Description: writes compiled models to model files and maps them back.
+//
+//-----------------------------------
+
+//-----------------------------------
+// Includes
+//-----------------------------------
+#include "model_file.h"
+#include "compiled_model.h"
+#include <cstring>
+#include <fstream>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+const char kMagic[8] = {'G', 'B', 'M', 'M', 'O', 'D', 'E', 'L'};
+}
+
+//----------------------------------------
+// Function Members - Public
+//----------------------------------------
+//-----------------------------------
+// Function: ModelFile
+//
+// Returns: none
+//
+// Description: maps a model file into memory, read only, and checks its
+//   header.  Where files cannot be mapped it is read in instead.
+//
+// Parameters:
+//  kPath - the path of the file
+//-----------------------------------
+ModelFile::ModelFile(const std::string& kPath) : data_(NULL), size_(0) {
+#ifndef _WIN32
+  const int kFile = open(kPath.c_str(), O_RDONLY);
+  if (kFile == -1) {
+    throw gbm_exception::Failure("cannot open model file " + kPath);
+  }
+  struct stat file_stat;
+  if ((fstat(kFile, &file_stat) == 0) && (file_stat.st_size > 0)) {
+    void* mapped = mmap(NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE,
+                        kFile, 0);
+    if (mapped != MAP_FAILED) {
+      data_ = static_cast<const char*>(mapped);
+      size_ = file_stat.st_size;
+    }
+  }
+  close(kFile);
+  if (data_ == NULL) {
+    throw gbm_exception::Failure("cannot map model file " + kPath);
+  }
+#else
+  std::ifstream in(kPath.c_str(), std::ios::in | std::ios::binary);
+  if (!in) {
+    throw gbm_exception::Failure("cannot open model file " + kPath);
+  }
+  in.seekg(0, std::ios::end);
+  size_ = in.tellg();
+  in.seekg(0, std::ios::beg);
+  // doubles keep the image aligned for its split values
+  buffer_.resize(size_ / sizeof(double) + 1);
+  in.read(reinterpret_cast<char*>(&buffer_[0]), size_);
+  if (!in) {
+    throw gbm_exception::Failure("cannot read model file " + kPath);
+  }
+  data_ = reinterpret_cast<const char*>(&buffer_[0]);
+#endif
+
+  const bool kValidHeader =
+      (size_ >= sizeof(Header)) &&
+      (std::memcmp(header().magic, kMagic, sizeof(kMagic)) == 0) &&
+      (header().byte_order == kByteOrder) &&
+      (header().version == kVersion) &&
+      (header().image_bytes_high == 0) &&
+      (header().image_bytes_low == image_bytes());
+  if (!kValidHeader) {
+    Unmap();
+    throw gbm_exception::InvalidArgument(
+        kPath + " is not a model file of this version of gbm");
+  }
+}
+
+//-----------------------------------
+// Function: ~ModelFile
+//
+// Returns: none
+//
+// Description: unmaps the file.
+//
+// Parameters: none
+//-----------------------------------
+ModelFile::~ModelFile() { Unmap(); }
+
+//-----------------------------------
+// Function: Write
+//
+// Returns: none
+//
+// Description: writes the image of a compiled model to a model file.
+//
+// Parameters:
+//  kModel - the compiled model
+//  initial_estimate - the initial function estimate of the model
+//  kPath - the path of the file
+//-----------------------------------
+void ModelFile::Write(const CompiledModel& kModel, double initial_estimate,
+                      const std::string& kPath) {
+  if (kModel.image_bytes() > 0xFFFFFFFFUL) {
+    throw gbm_exception::InvalidArgument(
+        "model is too large for a model file");
+  }
+
+  Header header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.byte_order = kByteOrder;
+  header.initial_estimate = initial_estimate;
+  header.image_bytes_low = kModel.image_bytes();
+
+  std::ofstream out(kPath.c_str(),
+                    std::ios::out | std::ios::binary | std::ios::trunc);
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  out.write(kModel.image(), kModel.image_bytes());
+  out.close();
+  if (!out) {
+    throw gbm_exception::Failure("cannot write model file " + kPath);
+  }
+}
+
+//----------------------------------------
+// Function Members - Private
+//----------------------------------------
+//-----------------------------------
+// Function: Unmap
+//
+// Returns: none
+//
+// Description: releases the memory holding the file.
+//
+// Parameters: none
+//-----------------------------------
+void ModelFile::Unmap() {
+#ifndef _WIN32
+  if (data_ != NULL) {
+    munmap(const_cast<char*>(data_), size_);
+  }
+#endif
+  data_ = NULL;
+  size_ = 0;
+}
@@ -0,0 +1,84 @@
+//------------------------------------------------------------------------------
+//
+//  File:       model_file.h
+//
+//  Description: header for model files - a compiled model's image after a
+//    64 byte header, so that the image can be mapped into memory and
+//    scored without being parsed.  Files are in the byte order of the
+//    machine that wrote them.
+//
+//------------------------------------------------------------------------------
+
+#ifndef MODELFILE_H
+#define MODELFILE_H
+
+//------------------------------
+// Includes
+//------------------------------
+#include "gbm_exception.h"
+#include <string>
+#include <vector>
+
+class CompiledModel;
+
+//------------------------------
+// Class definition
+//------------------------------
+class ModelFile {
+ public:
+  //----------------------
+  // Public Constructors
+  //----------------------
+  explicit ModelFile(const std::string& kPath);
+
+  //---------------------
+  // Public destructor
+  //---------------------
+  ~ModelFile();
+
+  //---------------------
+  // Public Functions
+  //---------------------
+  static void Write(const CompiledModel& kModel, double initial_estimate,
+                    const std::string& kPath);
+
+  double initial_estimate() const { return header().initial_estimate; };
+  const char* image() const { return data_ + sizeof(Header); };
+  unsigned long image_bytes() const { return size_ - sizeof(Header); };
+
+ private:
+  // the version is raised whenever the layout of the image changes
+  static const unsigned int kVersion = 1;
+  static const unsigned int kByteOrder = 0x01020304;
+
+  struct Header {
+    char magic[8];
+    unsigned int version;
+    unsigned int byte_order;
+    double initial_estimate;
+    unsigned int image_bytes_low, image_bytes_high;
+    char unused[32];
+  };
+
+  //---------------------
+  // Private Functions
+  //---------------------
+  ModelFile(const ModelFile&);
+  ModelFile& operator=(const ModelFile&);
+
+  const Header& header() const {
+    return *reinterpret_cast<const Header*>(data_);
+  };
+  void Unmap();
+
+  //-------------------
+  // Private Variables
+  //-------------------
+  const char* data_;
+  unsigned long size_;
+
+  // the file read into memory where it cannot be mapped
+  std::vector<double> buffer_;
+};
+
+#endif  // MODELFILE_H
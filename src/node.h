@@ -27,11 +27,6 @@
 #include "node_parameters.h"
 #include <vector>
 
-//------------------------------
-// Class Forwards and Type defs
-//------------------------------
-class GenericNodeStrategy;
-
 using namespace std;
 typedef vector<int> VectorCategories;
 typedef vector<VectorCategories> VecOfVectorCategories;
@@ -39,6 +34,9 @@ typedef vector<VectorCategories> VecOfVectorCategories;
 //------------------------------
 // Class definition
 //------------------------------
+// a node of a tree held in a NodeArena - its children are the three nodes
+// of the arena from first_child(), left, right then missing, and the left
+// categories of a categorical split are a bitset in the arena's words
 class CNode {
  public:
   //----------------------
@@ -54,27 +52,21 @@ class CNode {
   //---------------------
   // Public Functions
   //---------------------
-  void Adjust(unsigned long min_num_node_obs);
-  void Predict(const CDataset& kData, unsigned long rownum,
-               double& delta_estimate);
-
-  void GetVarRelativeInfluence(double* relative_influence);
-  void SplitNode(const NodeParams& childrenparams);
-  void PrintSubtree(unsigned long indent);
-  void TransferTreeToRList(int& node_iD, const CDataset& kData, int* splitvar,
-                           double* splitvalues, int* leftnodes, int* rightnodes,
-                           int* missingnodes, double* error_reduction,
-                           double* weights, double* predictions,
-                           VecOfVectorCategories& splitcodes_vec,
-                           int prev_categorical_splits, double shrinkage);
-  signed char WhichNode(const CDataset& kData, unsigned long obs_num);
+  // makes the node a split with children from first_child and, for a
+  // categorical split of num_levels levels, left categories from
+  // category_word
+  void SetSplit(const NodeParams& kChildrenParams, unsigned long first_child,
+                unsigned long category_word, unsigned long num_levels);
+
+  bool is_split() const { return split_type_ != kTerminal; }
+  bool is_categorical_split() const { return split_type_ == kCategorical; }
+  unsigned long first_child() const { return first_child_; }
+  unsigned long left_child() const { return first_child_; }
+  unsigned long right_child() const { return first_child_ + 1; }
+  unsigned long missing_child() const { return first_child_ + 2; }
+  unsigned long category_word() const { return category_word_; }
+  unsigned long num_levels() const { return num_levels_; }
 
-  CNode* left_child() { return left_node_ptr_.get(); }
-  const CNode* left_child() const { return left_node_ptr_.get(); }
-  CNode* right_child() { return right_node_ptr_.get(); }
-  const CNode* right_child() const { return right_node_ptr_.get(); }
-  CNode* missing_child() { return missing_node_ptr_.get(); }
-  const CNode* missing_child() const { return missing_node_ptr_.get(); }
   unsigned long get_split_var() const { return split_var_; }
   double get_improvement() const { return improvement_; }
   double get_splitvalue() const { return splitvalue_; }
@@ -82,8 +74,6 @@ class CNode {
   void set_prediction(double pred_val) { prediction_ = pred_val; }
   double get_totalweight() const { return totalweight_; }
   unsigned long get_numobs() const { return numobs_; }
-  std::vector<unsigned long>& get_leftcategory() { return leftcategory_; }
-  bool is_terminal() const;
   void SetToSplit() { splitdetermined_ = true; };
   bool is_split_determined() const { return splitdetermined_; };
 
@@ -93,34 +83,24 @@ class CNode {
   }
 
  private:
-  //---------------------
-  // Private Functions
-  //---------------------
-  void SetStrategy(bool is_continuous_split);
+  enum SplitType { kTerminal, kContinuous, kCategorical };
 
   //---------------------
   // Private Variables
   //---------------------
-  std::auto_ptr<GenericNodeStrategy> node_strategy_;
-
-  // Pointers to the Node's children
-  std::auto_ptr<CNode> left_node_ptr_;
-  std::auto_ptr<CNode> right_node_ptr_;
-  std::auto_ptr<CNode> missing_node_ptr_;
-
-  // TODO: Currently most useful in printing out tree
-  // This nodes parameters
-  unsigned long split_var_;
-  double improvement_;
-
   // Properties defining the node
   double prediction_;
   double totalweight_;    // total training weight in node
   unsigned long numobs_;  // number of training observations in node
 
-  // VARIABLES USED IN NODE SPLITTING
-  std::vector<unsigned long> leftcategory_;
+  // The split - continuous splits send values below splitvalue_ left
   double splitvalue_;
+  double improvement_;
+  unsigned long split_var_;
+  unsigned long first_child_;
+  unsigned long category_word_;
+  unsigned long num_levels_;
+  SplitType split_type_;
   bool splitdetermined_;
 };
 
@@ -0,0 +1,134 @@
+//------------------------------------------------------------------------------
+//
+//  File:       node_arena.h
+//
+//  Description: the nodes of the tree being fitted, held one after another
+//    in a single array with the left categories of their categorical splits
+//    as bitsets, kept from one tree to the next so that growing a tree does
+//    not allocate.
+//
+//------------------------------------------------------------------------------
+
+#ifndef NODE_ARENA_H
+#define NODE_ARENA_H
+
+//------------------------------
+// Includes
+//------------------------------
+#include "dataset.h"
+#include "gbm_exception.h"
+#include "gbm_platform.h"
+#include "node.h"
+#include "node_parameters.h"
+#include <vector>
+
+//------------------------------
+// Class definition
+//------------------------------
+// nodes are only ever added after the last, so children follow their
+// parents and pointers to the nodes stay valid until the next Reset
+class NodeArena {
+ public:
+  //----------------------
+  // Public Constructors
+  //----------------------
+  NodeArena(){};
+
+  //---------------------
+  // Public Functions
+  //---------------------
+  // drops the nodes of the last tree, making room for up to max_nodes
+  void Reset(unsigned long max_nodes) {
+    nodes_.clear();
+    nodes_.reserve(max_nodes);
+    category_words_.clear();
+  };
+
+  CNode* AddNode(const NodeDef& kDefn) {
+    if (nodes_.size() == nodes_.capacity()) {
+      throw gbm_exception::Failure("Tree has more nodes than its depth allows.");
+    }
+    nodes_.push_back(CNode(kDefn));
+    return &nodes_.back();
+  };
+
+  // splits a node of the arena as the parameters say, adding its children
+  void Split(CNode& node, const NodeParams& kChildrenParams,
+             const CDataset& kData) {
+    // Check that our nodes are defined
+    if (!kChildrenParams.nodes_have_obs()) {
+      throw gbm_exception::Failure("Best split has no observations!");
+    }
+
+    // the first categories of the ordering go left
+    unsigned long category_word = category_words_.size();
+    unsigned long num_levels = 0;
+    if (kChildrenParams.split_class() != 0) {
+      num_levels = kData.varclass(kChildrenParams.split_variable());
+      category_words_.resize(category_word + NumWords(num_levels), 0);
+      const unsigned long kNumLeft =
+          1 + (unsigned long)kChildrenParams.split_value();
+      for (unsigned long ind = 0; ind < kNumLeft; ind++) {
+        const unsigned long kLevel = kChildrenParams.get_ordering()[ind];
+        category_words_[category_word + kLevel / kWordBits] |=
+            1u << (kLevel % kWordBits);
+      }
+    }
+
+    const unsigned long kFirstChild = nodes_.size();
+    AddNode(kChildrenParams.get_left_def());
+    AddNode(kChildrenParams.get_right_def());
+    AddNode(kChildrenParams.get_missing_def());
+    node.SetSplit(kChildrenParams, kFirstChild, category_word, num_levels);
+  };
+
+  // the child of a split node a row of the data goes to
+  unsigned long NextNode(const CNode& kNode, const CDataset& kData,
+                         unsigned long obs_num) const {
+    const double kXValue = kData.x_value(obs_num, kNode.get_split_var());
+    if (gbm_platform::IsNA(kXValue)) return kNode.missing_child();
+
+    if (!kNode.is_categorical_split()) {
+      return (kXValue < kNode.get_splitvalue()) ? kNode.left_child()
+                                                : kNode.right_child();
+    }
+    return is_left_category(kNode, (unsigned long)kXValue)
+               ? kNode.left_child()
+               : kNode.right_child();
+  };
+
+  // whether a level of a categorical split goes left - all others go right
+  bool is_left_category(const CNode& kNode, unsigned long level) const {
+    if (level >= kNode.num_levels()) return false;
+    return (category_words_[kNode.category_word() + level / kWordBits] >>
+            (level % kWordBits)) & 1u;
+  };
+
+  unsigned long size() const { return nodes_.size(); };
+  CNode& operator[](unsigned long node_num) { return nodes_[node_num]; };
+  const CNode& operator[](unsigned long node_num) const {
+    return nodes_[node_num];
+  };
+
+  unsigned long allocated_bytes() const {
+    return nodes_.capacity() * sizeof(CNode) +
+           category_words_.capacity() * sizeof(unsigned int);
+  };
+
+ private:
+  NodeArena(const NodeArena&);
+  NodeArena& operator=(const NodeArena&);
+
+  static const unsigned long kWordBits = 32;
+  static unsigned long NumWords(unsigned long num_levels) {
+    return (num_levels + kWordBits - 1) / kWordBits;
+  };
+
+  //---------------------
+  // Private Variables
+  //---------------------
+  std::vector<CNode> nodes_;
+  std::vector<unsigned int> category_words_;
+};
+
+#endif  // NODE_ARENA_H
@@ -12,7 +12,9 @@
 //------------------------------
 // Includes
 //------------------------------
-#include <Rcpp.h>
+#include <climits>
+#include <cmath>
+#include <vector>
 
 //------------------------------
 // Struct Definition
@@ -145,6 +147,10 @@ class NodeParams {
     missing_.increment(predincrement, trainw_increment, numincrement);
     right_.increment(-predincrement, -trainw_increment, -numincrement);
   }
+  void UpdateMissingNode(const NodeDef& update) {
+    UpdateMissingNode(update.get_weightresid(), update.get_totalweight(),
+                      update.get_num_obs());
+  }
   void UpdateLeftNode(double predincrement, double trainw_increment,
                       long numincrement = 1) {
     // Move data point from right node to left node
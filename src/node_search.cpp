@@ -8,93 +8,266 @@
 // Includes
 //-----------------------------------
 #include "node_search.h"
+#include "trace.h"
+#include <algorithm>
+
+namespace {
+// the fewest rows in a shard of a node's rows whose histogram is built by
+// a task of its own
+const unsigned long kMinShardRows = 4096;
+
+// histograms are built from shards while there are fewer (node, feature)
+// tasks than this, enough to keep the threads of most machines busy - it
+// is fixed so that the shards, and the sums of their histograms, are the
+// same whatever the number of threads
+const unsigned long kMinSearchTasks = 16;
+
+// adds the in bag rows of a node to its histogram
+template <typename CodeType>
+void AccumulateHistogram(const CodeType* kCodes, const int* kRows,
+                         unsigned long num_rows, const double* kWeights,
+                         const vector<double>& residuals,
+                         vector<NodeDef>& histogram) {
+  for (unsigned long ind = 0; ind < num_rows; ind++) {
+    const int kObs = kRows[ind];
+    histogram[kCodes[kObs]].increment(kWeights[kObs] * residuals[kObs],
+                                      kWeights[kObs], 1);
+  }
+}
+
+// orders nodes by their number of in bag rows, most first
+class MoreBagRows {
+ public:
+  explicit MoreBagRows(const RowPartition& kPartition)
+      : kPartition_(kPartition) {}
+  bool operator()(unsigned long lhs, unsigned long rhs) const {
+    return kPartition_.num_bag_rows(lhs) > kPartition_.num_bag_rows(rhs);
+  }
+
+ private:
+  const RowPartition& kPartition_;
+};
+}
 
 //----------------------------------------
 // Function Members - Public
 //----------------------------------------
-CNodeSearch::CNodeSearch(unsigned long treedepth, unsigned long minobs,
-                         const parallel_details& parallel)
+CNodeSearch::CNodeSearch(const CDataset& kData, const Bag& kBag,
+                         unsigned long treedepth, unsigned long minobs,
+                         const parallel_details& parallel,
+                         SplitterArenas& arenas, NodeArena& nodes)
     : best_splits_(2 * treedepth + 1),
+      best_node_(0),
+      best_improvement_(-HUGE_VAL),
+      partition_(kData, kBag, 2 * treedepth + 1, parallel),
       num_terminal_nodes_(1),
       min_num_node_obs_(minobs),
+      split_node_(0),
+      num_shards_(1),
+      rows_scanned_(0.0),
+      nodes_searched_(0.0),
+      arenas_(arenas),
+      nodes_(nodes),
       parallel_(parallel) {}
 
 CNodeSearch::~CNodeSearch() {}
 
+// called by every thread of the team growing the tree, which share its
+// tasks - the master thread draws the features, as R's random numbers may
+// only be drawn on it, and one thread lists the nodes to search
 void CNodeSearch::GenerateAllSplits(vector<CNode*>& term_nodes_ptrs,
-                                    const CDataset& kData, const Bag& kBag,
-                                    const vector<double>& residuals,
-                                    vector<unsigned long>& data_node_assigns) {
-  const index_vector kColNumbers(kData.RandomOrder());
-  VecNodeParams best_splits_updates(best_splits_);
-
-#pragma omp parallel firstprivate(best_splits_updates) \
-    num_threads(get_num_threads())
+                                    const CDataset& kData,
+                                    const vector<double>& residuals) {
+  const unsigned long kNumFeatures = kData.get_num_features();
+
+#pragma omp master
+  col_numbers_ = kData.RandomOrder();
+#pragma omp barrier
+
+#pragma omp single
   {
-#pragma omp for schedule(static) nowait
-    for (unsigned long ind = 0; ind < kData.get_num_features(); ++ind) {
-      const int kVar = kColNumbers[ind];
-      const int KVarClasses = kData.varclass(kVar);
-
-      VecVarSplitters variable_splitters(num_terminal_nodes_, term_nodes_ptrs,
-                                         min_num_node_obs_, ind, kVar,
-                                         KVarClasses, kData.monotone(kVar));
-
-      // distribute the observations in order to the correct node search
-      for (unsigned long iOrderObs = 0; iOrderObs < kData.get_trainsize();
-           iOrderObs++) {
-        const unsigned long kWhichObs =
-            kData.order_ptr()[kVar * kData.get_trainsize() + iOrderObs];
-        if (kBag.get_element(kWhichObs)) {
-          const int kNode = data_node_assigns[kWhichObs];
-          const double kXVal = kData.x_value(kWhichObs, kVar);
-          variable_splitters[kNode].IncorporateObs(
-              kXVal, residuals[kWhichObs], kData.weight_ptr()[kWhichObs]);
-        }
+    // nodes whose best split was found at an earlier depth keep it in
+    // best_splits_ - only the children of the last split are searched,
+    // largest first so that their tasks are started first
+    search_nodes_.clear();
+    for (unsigned long node_num = 0; node_num < num_terminal_nodes_;
+         node_num++) {
+      if (!term_nodes_ptrs[node_num]->is_split_determined()) {
+        search_nodes_.push_back(node_num);
+        nodes_searched_++;
       }
+    }
+    std::stable_sort(search_nodes_.begin(), search_nodes_.end(),
+                     MoreBagRows(partition_));
 
-      for (unsigned long node_num = 0; node_num < num_terminal_nodes_;
-           node_num++) {
-        variable_splitters[node_num].WrapUpCurrentVariable();
+    if (kData.has_bins() && node_histograms_.empty()) {
+      node_histograms_.resize(best_splits_.size() * kData.ncol());
+      parent_histograms_.resize(kData.ncol());
+    }
+    task_splits_.resize(kNumFeatures * num_terminal_nodes_);
+    if (arenas_.size() < (unsigned long)get_num_threads()) {
+      arenas_.resize(get_num_threads());
+    }
+
+    // with few (node, feature) tasks - few features, or the root - each
+    // histogram is built from shards of the node's rows by tasks of their
+    // own and summed, if the rows are many enough.  The shards depend on
+    // the rows and tasks only; the threads just take the builds in turn
+    num_shards_ = 1;
+    if (kData.has_bins()) {
+      const unsigned long kNumSearchTasks =
+          search_nodes_.size() * kNumFeatures;
+      unsigned long max_bag_rows = 0;
+      for (unsigned long ind = 0; ind < search_nodes_.size(); ind++) {
+        max_bag_rows =
+            std::max(max_bag_rows, partition_.num_bag_rows(search_nodes_[ind]));
+      }
+      if ((kNumSearchTasks > 0) && (kNumSearchTasks < kMinSearchTasks)) {
+        num_shards_ = std::min(
+            (kMinSearchTasks + kNumSearchTasks - 1) / kNumSearchTasks,
+            std::max(1UL, max_bag_rows / kMinShardRows));
       }
+      shard_histograms_.resize(kNumSearchTasks * (num_shards_ - 1));
+    }
+  }
 
-      best_splits_updates += variable_splitters.proposal();
+  // a task searches a node on a feature - idle threads take the next task,
+  // and each leaves its best split in a slot of its own
+  const long kNumTasks = search_nodes_.size() * kNumFeatures;
+  double rows_scanned = 0.0;
+  TraceScope region_scope("GenerateAllSplits");
+
+  // histograms are built from rows before any is derived from them
+  if (kData.has_bins()) {
+    const long kNumBuilds = kNumTasks * num_shards_;
+#pragma omp for schedule(dynamic, 1)
+    for (long build = 0; build < kNumBuilds; build++) {
+      const long kTask = build / num_shards_;
+      const unsigned long kShard = build % num_shards_;
+      const int kVar = col_numbers_[kTask % kNumFeatures];
+      const unsigned long kNodeNum = search_nodes_[kTask / kNumFeatures];
+      vector<NodeDef>& histogram =
+          (kShard == 0)
+              ? node_histograms_[kNodeNum * kData.ncol() + kVar]
+              : shard_histograms_[kTask * (num_shards_ - 1) + kShard - 1];
+      rows_scanned += BuildHistogram(kVar, kNodeNum, kShard, histogram,
+                                     term_nodes_ptrs, kData, residuals);
+    }
+
+    // the shards are summed in order, whichever threads built them
+    if (num_shards_ > 1) {
+#pragma omp for schedule(static)
+      for (long task = 0; task < kNumTasks; task++) {
+        const int kVar = col_numbers_[task % kNumFeatures];
+        const unsigned long kNodeNum = search_nodes_[task / kNumFeatures];
+        if (kNodeNum == DerivedNode(kVar, term_nodes_ptrs)) continue;
+
+        vector<NodeDef>& histogram =
+            node_histograms_[kNodeNum * kData.ncol() + kVar];
+        for (unsigned long shard = 1; shard < num_shards_; shard++) {
+          const vector<NodeDef>& kShard =
+              shard_histograms_[task * (num_shards_ - 1) + shard - 1];
+          for (unsigned long bin = 0; bin < histogram.size(); bin++) {
+            histogram[bin].increment(kShard[bin].get_weightresid(),
+                                     kShard[bin].get_totalweight(),
+                                     kShard[bin].get_num_obs());
+          }
+        }
+      }
+    }
+  }
+
+#pragma omp for schedule(dynamic, 1)
+  for (long task = 0; task < kNumTasks; task++) {
+    const unsigned long kInd = task % kNumFeatures;
+    const unsigned long kNodeNum = search_nodes_[task / kNumFeatures];
+    const int kVar = col_numbers_[kInd];
+    TraceScope feature_scope(
+        kData.varclass(kVar) ? "categorical feature" : "continuous feature",
+        "feature", kVar);
+
+    if (kData.varclass(kVar)) {
+      rows_scanned += SearchNode<categorical_splitter_strategy>(
+          kInd, kVar, kNodeNum, term_nodes_ptrs, kData, residuals);
+    } else {
+      rows_scanned += SearchNode<cts_splitter_strategy>(
+          kInd, kVar, kNodeNum, term_nodes_ptrs, kData, residuals);
     }
+  }
 
-#pragma omp critical
-    { best_splits_ += best_splits_updates; }
+  // each node takes the best of its features' splits in feature order,
+  // so that draws go to the same feature whichever thread found them
+#pragma omp for schedule(static)
+  for (long ind = 0; ind < long(search_nodes_.size()); ind++) {
+    const unsigned long kNodeNum = search_nodes_[ind];
+    for (unsigned long feature = 0; feature < kNumFeatures; feature++) {
+      best_splits_[kNodeNum] +=
+          task_splits_[feature * num_terminal_nodes_ + kNodeNum];
+    }
   }
+
+#pragma omp atomic
+  rows_scanned_ += rows_scanned;
 }
 
+// called by every thread of the team growing the tree - one thread picks
+// and makes the split, then they share the reassignment of its rows
 double CNodeSearch::CalcImprovementAndSplit(
     vector<CNode*>& term_nodes_ptrs, const CDataset& kData,
     vector<unsigned long>& data_node_assigns) {
-  // search for the best split
-  unsigned long bestnode = 0;
-  double bestnode_improvement = -HUGE_VAL;
-  for (unsigned long node_num = 0; node_num < num_terminal_nodes_; node_num++) {
-    term_nodes_ptrs[node_num]->SetToSplit();
-    if (best_splits_[node_num].get_improvement() > bestnode_improvement) {
-      bestnode = node_num;
-      bestnode_improvement = best_splits_[node_num].get_improvement();
+#pragma omp single
+  {
+    // search for the best split
+    best_node_ = 0;
+    best_improvement_ = -HUGE_VAL;
+    for (unsigned long node_num = 0; node_num < num_terminal_nodes_;
+         node_num++) {
+      term_nodes_ptrs[node_num]->SetToSplit();
+      if (best_splits_[node_num].get_improvement() > best_improvement_) {
+        best_node_ = node_num;
+        best_improvement_ = best_splits_[node_num].get_improvement();
+      }
+    }
+
+    // Split Node if improvement is non-zero - a failure may not leave the
+    // parallel region, so it stops the tree and is passed on by the caller
+    if (best_improvement_ > 0.0) {
+      try {
+        nodes_.Split(*term_nodes_ptrs[best_node_], best_splits_[best_node_],
+                     kData);
+        num_terminal_nodes_ += 2;
+      } catch (const gbm_exception::Failure& kFailure) {
+        failure_ = kFailure.what();
+        best_improvement_ = -HUGE_VAL;
+      }
     }
   }
+  const unsigned long kBestNode = best_node_;
+  const double kBestImprovement = best_improvement_;
+  if (kBestImprovement <= 0.0) return kBestImprovement;
 
-  // Split Node if improvement is non-zero
-  if (bestnode_improvement > 0.0) {
-    // Split Node
-    term_nodes_ptrs[bestnode]->SplitNode(best_splits_[bestnode]);
-    num_terminal_nodes_ += 2;
+  // Move kData to children nodes
+  ReassignData(kBestNode, term_nodes_ptrs, kData, data_node_assigns);
 
-    // Move kData to children nodes
-    ReassignData(bestnode, term_nodes_ptrs, kData, data_node_assigns);
+#pragma omp single
+  {
+    // Keep the split node's histograms to derive a child from
+    if (kData.has_bins()) {
+      for (unsigned long var = 0; var < kData.ncol(); var++) {
+        parent_histograms_[var].swap(
+            node_histograms_[kBestNode * kData.ncol() + var]);
+        node_histograms_[kBestNode * kData.ncol() + var].clear();
+      }
+      split_node_ = kBestNode;
+    }
 
     // Add children to terminal node list
+    const CNode& kSplitNode = *term_nodes_ptrs[kBestNode];
     term_nodes_ptrs[num_terminal_nodes_ - 2] =
-        term_nodes_ptrs[bestnode]->right_child();
+        &nodes_[kSplitNode.right_child()];
     term_nodes_ptrs[num_terminal_nodes_ - 1] =
-        term_nodes_ptrs[bestnode]->missing_child();
-    term_nodes_ptrs[bestnode] = term_nodes_ptrs[bestnode]->left_child();
+        &nodes_[kSplitNode.missing_child()];
+    term_nodes_ptrs[kBestNode] = &nodes_[kSplitNode.left_child()];
 
     best_splits_[num_terminal_nodes_ - 2].ResetSplitProperties(
         term_nodes_ptrs[num_terminal_nodes_ - 2]->get_prediction() *
@@ -106,38 +279,175 @@ double CNodeSearch::CalcImprovementAndSplit(
             term_nodes_ptrs[num_terminal_nodes_ - 1]->get_totalweight(),
         term_nodes_ptrs[num_terminal_nodes_ - 1]->get_totalweight(),
         term_nodes_ptrs[num_terminal_nodes_ - 1]->get_numobs());
-    best_splits_[bestnode].ResetSplitProperties(
-        term_nodes_ptrs[bestnode]->get_prediction() *
-            term_nodes_ptrs[bestnode]->get_totalweight(),
-        term_nodes_ptrs[bestnode]->get_totalweight(),
-        term_nodes_ptrs[bestnode]->get_numobs());
+    best_splits_[kBestNode].ResetSplitProperties(
+        term_nodes_ptrs[kBestNode]->get_prediction() *
+            term_nodes_ptrs[kBestNode]->get_totalweight(),
+        term_nodes_ptrs[kBestNode]->get_totalweight(),
+        term_nodes_ptrs[kBestNode]->get_numobs());
   }
 
-  return bestnode_improvement;
+  return kBestImprovement;
+}
+
+unsigned long CNodeSearch::allocated_bytes() const {
+  unsigned long histogram_bins = 0;
+  for (unsigned long ind = 0; ind < node_histograms_.size(); ind++) {
+    histogram_bins += node_histograms_[ind].capacity();
+  }
+  for (unsigned long ind = 0; ind < parent_histograms_.size(); ind++) {
+    histogram_bins += parent_histograms_[ind].capacity();
+  }
+  for (unsigned long ind = 0; ind < shard_histograms_.size(); ind++) {
+    histogram_bins += shard_histograms_[ind].capacity();
+  }
+  return partition_.allocated_bytes() + histogram_bins * sizeof(NodeDef) +
+         task_splits_.capacity() * sizeof(NodeParams);
 }
 
 //----------------------------------------
 // Function Members - Private
 //----------------------------------------
+// the largest child of the last split whose histogram of var is its
+// parent's less its siblings', or num_terminal_nodes_ if there is none
+unsigned long CNodeSearch::DerivedNode(
+    int var, const vector<CNode*>& term_nodes_ptrs) const {
+  if (parent_histograms_[var].empty()) return num_terminal_nodes_;
+
+  unsigned long derived_node = split_node_;
+  for (unsigned long node_num = num_terminal_nodes_ - 2;
+       node_num < num_terminal_nodes_; node_num++) {
+    if (term_nodes_ptrs[node_num]->get_numobs() >
+        term_nodes_ptrs[derived_node]->get_numobs()) {
+      derived_node = node_num;
+    }
+  }
+  return derived_node;
+}
+
+// builds the histogram of a shard of the rows of a node to be searched,
+// returning the number of rows added
+unsigned long CNodeSearch::BuildHistogram(
+    int var, unsigned long node_num, unsigned long shard,
+    vector<NodeDef>& histogram, const vector<CNode*>& term_nodes_ptrs,
+    const CDataset& kData, const vector<double>& residuals) {
+  if (node_num == DerivedNode(var, term_nodes_ptrs)) return 0;
+
+  const BinnedFeatures& kBins = kData.bins();
+  histogram.assign(kBins.num_bins(var) + 1, NodeDef());
+
+  const unsigned long kNumBagRows = partition_.num_bag_rows(node_num);
+  const unsigned long kBegin = kNumBagRows * shard / num_shards_;
+  const unsigned long kNumShardRows =
+      kNumBagRows * (shard + 1) / num_shards_ - kBegin;
+  const int* kBagRows = partition_.bag_rows(node_num) + kBegin;
+  if (kBins.is_narrow(var)) {
+    AccumulateHistogram(kBins.narrow_codes(var), kBagRows, kNumShardRows,
+                        kData.weight_ptr(), residuals, histogram);
+  } else {
+    AccumulateHistogram(kBins.wide_codes(var), kBagRows, kNumShardRows,
+                        kData.weight_ptr(), residuals, histogram);
+  }
+  return kNumShardRows;
+}
+
+// searches a node on a feature with the calling thread's arena, leaving
+// its best split in the task's slot - returns the number of rows passed
+template <class Strategy>
+unsigned long CNodeSearch::SearchNode(unsigned long ind, int var,
+                                      unsigned long node_num,
+                                      const vector<CNode*>& term_nodes_ptrs,
+                                      const CDataset& kData,
+                                      const vector<double>& residuals) {
+  VarSplitter<Strategy> splitter(
+      *term_nodes_ptrs[node_num], min_num_node_obs_, ind, var,
+      kData.varclass(var), kData.monotone(var), arenas_[ThreadNumber()]);
+
+  unsigned long rows_scanned = 0;
+  if (kData.has_bins()) {
+    IncorporateBinnedVariable(splitter, var, node_num, term_nodes_ptrs, kData);
+  } else {
+    // pass the node's observations in order to its search
+    const int* kOrderedRows = partition_.ordered_rows(var, node_num);
+    const double* kXValues = kData.x_column(var);
+    const double* kWeights = kData.weight_ptr();
+    rows_scanned = partition_.num_bag_rows(node_num);
+    for (unsigned long row = 0; row < rows_scanned; row++) {
+      const int kWhichObs = kOrderedRows[row];
+      splitter.IncorporateObs(kXValues[kWhichObs], residuals[kWhichObs],
+                              kWeights[kWhichObs]);
+    }
+  }
+
+  splitter.WrapUpCurrentVariable();
+  task_splits_[ind * num_terminal_nodes_ + node_num] = splitter.best_split();
+  return rows_scanned;
+}
+
+template <class Strategy>
+void CNodeSearch::IncorporateBinnedVariable(
+    VarSplitter<Strategy>& splitter, int var, unsigned long node_num,
+    const vector<CNode*>& term_nodes_ptrs, const CDataset& kData) {
+  const BinnedFeatures& kBins = kData.bins();
+  const unsigned long kNumBins = kBins.num_bins(var) + 1;
+  const unsigned long kNumVars = kData.ncol();
+  vector<NodeDef>& histogram = node_histograms_[node_num * kNumVars + var];
+
+  // the siblings' histograms were all built from their rows
+  if (node_num == DerivedNode(var, term_nodes_ptrs)) {
+    histogram = parent_histograms_[var];
+    const unsigned long kSiblings[3] = {split_node_, num_terminal_nodes_ - 2,
+                                        num_terminal_nodes_ - 1};
+    for (int ind = 0; ind < 3; ind++) {
+      if (kSiblings[ind] == node_num) continue;
+      const vector<NodeDef>& kSibling =
+          node_histograms_[kSiblings[ind] * kNumVars + var];
+      for (unsigned long bin = 0; bin < kNumBins; bin++) {
+        histogram[bin].increment(-kSibling[bin].get_weightresid(),
+                                 -kSibling[bin].get_totalweight(),
+                                 -kSibling[bin].get_num_obs());
+      }
+    }
+  }
+
+  // missing bin first then the value bins in order
+  const NodeDef* kHistogram = &histogram[0];
+  const unsigned long kMissingBin = kBins.missing_bin(var);
+  if (kHistogram[kMissingBin].has_obs()) {
+    splitter.IncorporateBin(gbm_platform::NA(), kHistogram[kMissingBin]);
+  }
+  for (unsigned long bin = 0; bin < kMissingBin; bin++) {
+    if (kHistogram[bin].has_obs()) {
+      splitter.IncorporateBin(kBins.bin_value(var, bin), kHistogram[bin]);
+    }
+  }
+}
+
 void CNodeSearch::ReassignData(unsigned long splittednode_index,
                                vector<CNode*>& term_nodes_ptrs,
                                const CDataset& kData,
                                vector<unsigned long>& data_node_assigns) {
-// assign observations to the correct node
-#pragma omp parallel for schedule(static, get_array_chunk_size())	\
-    num_threads(get_num_threads())
-  for (unsigned long iObs = 0; iObs < kData.get_trainsize(); iObs++) {
-    if (data_node_assigns[iObs] == splittednode_index) {
-      signed char schWhichNode =
-          term_nodes_ptrs[splittednode_index]->WhichNode(kData, iObs);
-      if (schWhichNode == 1)  // goes right
+  const int* kRows = partition_.rows(splittednode_index);
+  const unsigned long kNumRows = partition_.num_rows(splittednode_index);
+  const CNode& kSplitNode = *term_nodes_ptrs[splittednode_index];
+
+  // assign the node's observations to the correct child
+  {
+    TraceScope region_scope("ReassignData");
+#pragma omp for schedule(static, get_array_chunk_size())
+    for (unsigned long ind = 0; ind < kNumRows; ind++) {
+      const int kObs = kRows[ind];
+      const unsigned long kChild = nodes_.NextNode(kSplitNode, kData, kObs);
+      if (kChild == kSplitNode.right_child())  // goes right
       {
-        data_node_assigns[iObs] = num_terminal_nodes_ - 2;
-      } else if (schWhichNode == 0)  // is missing
+        data_node_assigns[kObs] = num_terminal_nodes_ - 2;
+      } else if (kChild == kSplitNode.missing_child())  // is missing
       {
-        data_node_assigns[iObs] = num_terminal_nodes_ - 1;
+        data_node_assigns[kObs] = num_terminal_nodes_ - 1;
       }
       // those to the left stay with the same node assignment
     }
   }
+
+  partition_.Split(splittednode_index, num_terminal_nodes_ - 2,
+                   num_terminal_nodes_ - 1, data_node_assigns);
 }
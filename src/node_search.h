@@ -23,10 +23,14 @@
 #include "databag.h"
 #include "dataset.h"
 #include "node.h"
+#include "node_arena.h"
 #include "node_parameters.h"
-#include "vec_varsplitters.h"
+#include "varsplitter.h"
 #include "vec_nodeparams.h"
 #include "parallel_details.h"
+#include "row_partition.h"
+#include "splitter_arena.h"
+#include <string>
 
 #include <vector>
 
@@ -40,8 +44,10 @@ class CNodeSearch {
   //----------------------
   // Public Constructors
   //----------------------
-  CNodeSearch(unsigned long treedepth, unsigned long minobs,
-              const parallel_details& parallel);
+  CNodeSearch(const CDataset& kData, const Bag& kBag,
+              unsigned long treedepth, unsigned long minobs,
+              const parallel_details& parallel, SplitterArenas& arenas,
+              NodeArena& nodes);
 
   //---------------------
   // Public destructor
@@ -51,20 +57,49 @@ class CNodeSearch {
   //---------------------
   // Public Functions
   //---------------------
+  // the searches and splits, which add the children of the split nodes
+  // to nodes, are shared by the threads of the parallel
+  // region that calls them, each of which must call them in turn - called
+  // outside a parallel region they run on the one thread
   void GenerateAllSplits(vector<CNode*>& term_nodes_ptrs, const CDataset& kData,
-                         const Bag& kBag, const vector<double>& residuals,
-                         vector<unsigned long>& data_node_assigns);
+                         const vector<double>& residuals);
   double CalcImprovementAndSplit(vector<CNode*>& term_nodes_ptrs,
                                  const CDataset& kData,
                                  vector<unsigned long>& data_node_assigns);
 
   int get_num_threads() const { return parallel_.get_num_threads(); }
   int get_array_chunk_size() const { return parallel_.get_array_chunk_size(); }
-  
+
+  // the work done by the searches so far - the rows passed to the search
+  // of each predictor, the nodes searched and the memory held
+  double rows_scanned() const { return rows_scanned_; }
+  double nodes_searched() const { return nodes_searched_; }
+  unsigned long allocated_bytes() const;
+
+  // why the tree stopped growing, if a split failed - empty otherwise
+  const std::string& failure() const { return failure_; }
+
  private:
   //---------------------
   // Private Functions
   //---------------------
+  unsigned long DerivedNode(int var,
+                            const vector<CNode*>& term_nodes_ptrs) const;
+  unsigned long BuildHistogram(int var, unsigned long node_num,
+                               unsigned long shard, vector<NodeDef>& histogram,
+                               const vector<CNode*>& term_nodes_ptrs,
+                               const CDataset& kData,
+                               const vector<double>& residuals);
+  template <class Strategy>
+  unsigned long SearchNode(unsigned long ind, int var, unsigned long node_num,
+                           const vector<CNode*>& term_nodes_ptrs,
+                           const CDataset& kData,
+                           const vector<double>& residuals);
+  template <class Strategy>
+  void IncorporateBinnedVariable(VarSplitter<Strategy>& splitter, int var,
+                                 unsigned long node_num,
+                                 const vector<CNode*>& term_nodes_ptrs,
+                                 const CDataset& kData);
   void ReassignData(unsigned long splittednode_index,
                     vector<CNode*>& term_nodes_ptrs, const CDataset& kData,
                     vector<unsigned long>& data_node_assigns);
@@ -72,13 +107,48 @@ class CNodeSearch {
   //---------------------
   // Private Variables
   //---------------------
-  // Best Splits
+  // Best Splits, and those of each feature of each node searched
   VecNodeParams best_splits_;
+  vector<NodeParams> task_splits_;
+
+  // the features and nodes being searched, and the best split found,
+  // shared by the threads
+  index_vector col_numbers_;
+  vector<unsigned long> search_nodes_;
+  unsigned long best_node_;
+  double best_improvement_;
+
+  // Training rows of each terminal node
+  RowPartition partition_;
 
   // Number of terminal nodes
   unsigned long num_terminal_nodes_;
   unsigned long min_num_node_obs_;
 
+  // Histogram split search - bin totals per terminal node and variable,
+  // and those of the last node split which become its children's parent
+  vector<vector<NodeDef> > node_histograms_;
+  vector<vector<NodeDef> > parent_histograms_;
+  unsigned long split_node_;
+
+  // the number of shards of the rows of each histogram built, and the
+  // histograms of all but the first shard of each
+  unsigned long num_shards_;
+  vector<vector<NodeDef> > shard_histograms_;
+
+  // the failure of a split made within a parallel region, if any
+  std::string failure_;
+
+  // work done
+  double rows_scanned_;
+  double nodes_searched_;
+
+  // the scratch space of each thread's searches, kept between trees
+  SplitterArenas& arenas_;
+
+  // the nodes of the tree being grown
+  NodeArena& nodes_;
+
   // parallelization
   parallel_details parallel_;
 };
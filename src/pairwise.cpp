@@ -5,6 +5,7 @@
 #include "pairwise.h"
 #include "gbm_functions.h"
 #include <limits>
+#include <string>
 #include <iostream>
 #include <vector>
 #include <algorithm>
@@ -13,9 +14,11 @@ void CRanker::Init(unsigned int max_items_per_group) {
   // Allocate sorting buffers
   score_rank_vec_.resize(max_items_per_group);
   ptrs_to_score_rank_vec_.resize(max_items_per_group);
+  rankpos_vec_.resize(max_items_per_group + 1);
 }
 
 bool CRanker::SetGroupScores(const double* const kScores,
+                             const double* const kTieBreaks,
                              const unsigned int kNumItems) {
   const double eps = 1e-10;
 
@@ -32,7 +35,7 @@ bool CRanker::SetGroupScores(const double* const kScores,
 
   for (unsigned int i = 0; i < kNumItems; i++) {
     // Add small random number to break possible ties
-    score_rank_vec_[i].first = kScores[i] + eps * (unif_rand() - 0.5);
+    score_rank_vec_[i].first = kScores[i] + eps * (kTieBreaks[i] - 0.5);
 
     ptrs_to_score_rank_vec_[i] = &(score_rank_vec_[i]);
   }
@@ -341,14 +344,6 @@ double CMRR::SwapCost(int item_pos, int item_neg, const double* const kResponse,
               : 0.0);
 }
 
-void CMAP::Init(unsigned long max_group, unsigned long max_items_per_group,
-                unsigned int rank_cutoff) {
-  CIRMeasure::Init(max_group, max_items_per_group, rank_cutoff);
-
-  // Allocate rank buffer (note: ranks are 1-based)
-  rankpos_vec_.resize(max_items_per_group + 1);
-}
-
 // Auxiliary function to find the sorted ranks of positive items (veccRankPos),
 // and their number (cPos)
 inline void SortRankPos(const double* const kResponse, const CRanker& kRanker,
@@ -368,8 +363,9 @@ inline void SortRankPos(const double* const kResponse, const CRanker& kRanker,
 double CMAP::SwapCost(int item_pos, int item_neg, const double* const kResponse,
                       const CRanker& kRanker) const {
   unsigned int pos;
+  vector<int>& rankpos_vec = kRanker.get_rankpos_buffer();
 
-  SortRankPos(kResponse, kRanker, rankpos_vec_, pos);
+  SortRankPos(kResponse, kRanker, rankpos_vec, pos);
 
   if (pos == 0) {
     return 0.0;
@@ -383,17 +379,17 @@ double CMAP::SwapCost(int item_pos, int item_neg, const double* const kResponse,
 
   // Search for the position of the two items to swap
   const vector<int>::iterator kItItemPos = upper_bound(
-      rankpos_vec_.begin(), rankpos_vec_.begin() + pos, kRankItemPos);
+      rankpos_vec.begin(), rankpos_vec.begin() + pos, kRankItemPos);
   const vector<int>::iterator kItItemNeg = upper_bound(
-      rankpos_vec_.begin(), rankpos_vec_.begin() + pos, kRankItemNeg);
+      rankpos_vec.begin(), rankpos_vec.begin() + pos, kRankItemNeg);
 
   // The number of positive items up to and including iItemPos
-  const int kNumPosNotBelowItemPos = (int)(kItItemPos - rankpos_vec_.begin());
+  const int kNumPosNotBelowItemPos = (int)(kItItemPos - rankpos_vec.begin());
 
   // The number of positive items up to iItemNeg (Note: Cannot include iItemNeg
   // itself)
   const unsigned int kNumPosAboveItemNeg =
-      (unsigned int)(kItItemNeg - rankpos_vec_.begin());
+      (unsigned int)(kItItemNeg - rankpos_vec.begin());
 
   // Range of indices of positive items between iRankItemPos and iRankItemNeg
   // (exclusively)
@@ -435,7 +431,7 @@ double CMAP::SwapCost(int item_pos, int item_neg, const double* const kResponse,
 
   // The indirect effect for all items in between the two items
   for (int j = intermediatelow; j <= intermediatehigh; j++) {
-    diff += sign / rankpos_vec_[j];
+    diff += sign / rankpos_vec[j];
   }
 
   return diff / pos;
@@ -443,8 +439,9 @@ double CMAP::SwapCost(int item_pos, int item_neg, const double* const kResponse,
 
 double CMAP::Measure(const double* const kResponse, const CRanker& kRanker) {
   unsigned int kPos;
+  vector<int>& rankpos_vec = kRanker.get_rankpos_buffer();
 
-  SortRankPos(kResponse, kRanker, rankpos_vec_, kPos);
+  SortRankPos(kResponse, kRanker, rankpos_vec, kPos);
 
   if (kPos == 0) {
     return 0.0;
@@ -454,14 +451,15 @@ double CMAP::Measure(const double* const kResponse, const CRanker& kRanker) {
 
   double prec = 0.0;
   for (unsigned int j = 0; j < kPos; j++) {
-    prec += double(j + 1) / rankpos_vec_[j];
+    prec += double(j + 1) / rankpos_vec[j];
   }
 
   return prec / kPos;
 }
 
-CPairwise::CPairwise(const double* kGroups, const char* kIrMeasure,
-                     int num_training_rows) {
+CPairwise::CPairwise(const parallel_details& parallel, const double* kGroups,
+                     const char* kIrMeasure, int num_training_rows)
+    : CDistribution(parallel) {
   // Set up adGroup - this is not required
   kGroups_ = kGroups;
 
@@ -477,7 +475,7 @@ CPairwise::CPairwise(const double* kGroups, const char* kIrMeasure,
     pirm_.reset(new CMRR());
   } else {
     if (strcmp(kIrMeasure, "ndcg")) {
-      Rprintf(
+      gbm_platform::Printf(
           "Unknown IR measure '%s' in initialization, using 'ndcg' instead\n",
           kIrMeasure);
     }
@@ -487,7 +485,6 @@ CPairwise::CPairwise(const double* kGroups, const char* kIrMeasure,
 
 CDistribution* CPairwise::Create(DataDistParams& distparams) {
   // Create pointers to pairwise
-  Rcpp::NumericVector misc_vec(distparams.misc[0]);
   const double* kGroup = 0;
 
   std::size_t offset_tomeasure = distparams.family.find("_");
@@ -497,12 +494,13 @@ CDistribution* CPairwise::Create(DataDistParams& distparams) {
   }
   const char* kIrMeasure = distparams.family.c_str() + offset_tomeasure + 1;
 
-  if (!gbm_functions::has_value(misc_vec)) {
+  if (!gbm_functions::has_value(distparams.misc)) {
     throw gbm_exception::Failure("Pairwise requires misc to initialize");
   } else {
-    kGroup = misc_vec.begin();
+    kGroup = distparams.misc.begin();
   }
-  return new CPairwise(kGroup, kIrMeasure, distparams.num_trainrows);
+  return new CPairwise(distparams.parallel, kGroup, kIrMeasure,
+                       distparams.num_trainrows);
 }
 
 CPairwise::~CPairwise() {}
@@ -523,57 +521,101 @@ inline const double* OffsetVector(const double* const kCovariates,
   }
 }
 
-void CPairwise::ComputeWorkingResponse(const CDataset& kData, const Bag& kBag,
-                                       const double* kFuncEstimate,
-                                       std::vector<double>& residuals) {
-  if (kData.get_trainsize() <= 0) return;
-
-  // Iterate through all groups, compute gradients
+void CPairwise::ListGroups(const CDataset& kData, unsigned int num_rows,
+                           vector<CGroup>& groups) {
+  groups.clear();
 
   unsigned int item_start = 0;
   unsigned int item_end = 0;
 
-  while (item_start < kData.get_trainsize()) {
-    residuals[item_end] = 0;
-    hessian_[item_end] = 0;
-
-    const double dGroup = kGroups_[item_start];
+  while (item_start < num_rows) {
+    const double kGroup = kGroups_[item_start];
 
-    // Find end of current group, initialize working response
+    // Find end of current group
     for (item_end = item_start + 1;
-         item_end < kData.get_trainsize() && kGroups_[item_end] == dGroup;
-         item_end++) {
-      // Clear gradients from last iteration
-      residuals[item_end] = 0;
-      hessian_[item_end] = 0;
+         item_end < num_rows && kGroups_[item_end] == kGroup; item_end++)
+      ;
+
+    // TODO: Implement better way to ensure casting robust to overflow
+    int int_group = 0;
+    if (fabs(kGroup) > nextafter(INT_MAX, 0) || isnan(kGroup)) {
+      int_group = copysign(INT_MAX, kGroup);
+    } else {
+      int_group = (int)kGroup;
     }
 
-    if (kBag.get_element(item_start)) {
-      // Group is part of the training set
+    // The maximum measures are cached by the IR measure, so are found here,
+    // outside the parallel loops over the groups
+    CGroup group;
+    group.start = item_start;
+    group.end = item_end;
+    group.max_score = pirm_->MaxMeasure(
+        int_group, kData.y_ptr() + item_start, item_end - item_start);
+    groups.push_back(group);
 
-      const int kNumItems = item_end - item_start;
+    // Next group
+    item_start = item_end;
+  }
+}
 
-      // If offset given, add up current scores
-      const double* kFuncPlusOffset =
-          OffsetVector(kFuncEstimate, kData.offset_ptr(), item_start, item_end,
-                       func_est_plus_offset_);
+void CPairwise::DrawTieBreaks(const vector<CGroup>& kGroups) {
+  for (unsigned long group = 0; group < kGroups.size(); group++) {
+    for (unsigned int i = kGroups[group].start; i < kGroups[group].end; i++) {
+      tie_breaks_[i] = gbm_platform::UniformRandom();
+    }
+  }
+}
 
-      // Accumulate gradients
-      // TODO: Implement better way to ensure casting robust to overflow
-      int int_group = 0;
-      if (fabs(dGroup) > nextafter(INT_MAX, 0) || isnan(dGroup)) {
-        int_group = copysign(INT_MAX, dGroup);
-      } else {
-        int_group = (int)dGroup;
-      }
+void CPairwise::ComputeWorkingResponse(const CDataset& kData, const Bag& kBag,
+                                       const double* kFuncEstimate,
+                                       std::vector<double>& residuals) {
+  if (kData.get_trainsize() <= 0) return;
+
+  // Clear gradients from last iteration
+  std::fill(residuals.begin(), residuals.begin() + kData.get_trainsize(), 0.0);
+  std::fill(hessian_.begin(), hessian_.begin() + kData.get_trainsize(), 0.0);
 
-      ComputeLambdas(int_group, kNumItems, kData.y_ptr() + item_start,
-                     kFuncPlusOffset, kData.weight_ptr() + item_start,
-                     &residuals[item_start], &hessian_[item_start]);
+  // The groups in the training set with training pairs
+  // Assumption: Weights are constant within group
+  vector<CGroup> groups;
+  ListGroups(kData, kData.get_trainsize(), groups);
+
+  vector<CGroup> training_groups;
+  for (unsigned long group = 0; group < groups.size(); group++) {
+    if (kBag.get_element(groups[group].start) &&
+        kData.weight_ptr()[groups[group].start] > 0 &&
+        groups[group].max_score > 0.0) {
+      training_groups.push_back(groups[group]);
     }
+  }
+  DrawTieBreaks(training_groups);
+
+  // Iterate through all groups, compute gradients - a failure is passed on
+  // once the threads are done
+  std::string failure;
+
+#pragma omp parallel for schedule(dynamic, 1) num_threads(get_num_threads())
+  for (unsigned long group = 0; group < training_groups.size(); group++) {
+    const CGroup& kGroup = training_groups[group];
+    const int kThread = ThreadNumber();
+
+    // If offset given, add up current scores
+    const double* kFuncPlusOffset =
+        OffsetVector(kFuncEstimate, kData.offset_ptr(), kGroup.start,
+                     kGroup.end, func_est_plus_offset_[kThread]);
+
+    try {
+      ComputeLambdas(kGroup, kData.y_ptr() + kGroup.start, kFuncPlusOffset,
+                     rankers_[kThread], &residuals[kGroup.start],
+                     &hessian_[kGroup.start]);
+    } catch (const gbm_exception::Failure& kFailure) {
+#pragma omp critical(pairwise_failure)
+      failure = kFailure.what();
+    }
+  }
 
-    // Next group
-    item_start = item_end;
+  if (!failure.empty()) {
+    throw gbm_exception::Failure(failure);
   }
 }
 
@@ -619,27 +661,19 @@ void CPairwise::ComputeWorkingResponse(const CDataset& kData, const Bag& kBag,
 // (resp. d^2C/d^2s_i = gamma_i) over all instances falling into this leaf. This
 // summation is calculated later in CPairwise::FitBestConstant().
 
-void CPairwise::ComputeLambdas(int group, unsigned int num_items,
+void CPairwise::ComputeLambdas(const CGroup& kGroup,
                                const double* const kResponse,
                                const double* const kFuncEstimate,
-                               const double* const kWeights, double* residuals,
+                               CRanker& ranker, double* residuals,
                                double* deriv) {
-  // Assumption: Weights are constant within group
-  if (kWeights[0] <= 0) {
-    return;
-  }
+  const unsigned int num_items = kGroup.end - kGroup.start;
 
   // Normalize for maximum achievable group score
-  const double kMaxScore = pirm_->MaxMeasure(group, kResponse, num_items);
-
-  if (kMaxScore <= 0.0) {
-    // No pairs
-    return;
-  }
+  const double kMaxScore = kGroup.max_score;
 
   // Rank items by current score
-  ranker_.SetGroupScores(kFuncEstimate, num_items);
-  ranker_.Rank();
+  ranker.SetGroupScores(kFuncEstimate, &tie_breaks_[kGroup.start], num_items);
+  ranker.Rank();
 
   double label_current = kResponse[0];
 
@@ -661,7 +695,7 @@ void CPairwise::ComputeLambdas(int group, unsigned int num_items,
     for (unsigned int i = 0; i < label_current_start; i++) {
       // Instance i is better than j
 
-      const double kSwapCost = fabs(pirm_->SwapCost(i, j, kResponse, ranker_));
+      const double kSwapCost = fabs(pirm_->SwapCost(i, j, kResponse, ranker));
 
       if (!isfinite(kSwapCost)) {
         throw gbm_exception::Failure("infinite swap cost");
@@ -702,8 +736,9 @@ void CPairwise::ComputeLambdas(int group, unsigned int num_items,
 void CPairwise::Initialize(const CDataset& kData) {
   if (kData.nrow() <= 0) return;
 
-  // Allocate memory for derivative buffer
+  // Allocate memory for derivative and tie breaking buffers
   hessian_.resize(kData.nrow());
+  tie_breaks_.resize(kData.nrow());
 
   // Count the groups and number of items per group
   unsigned int max_items_per_group = 0;
@@ -732,11 +767,13 @@ void CPairwise::Initialize(const CDataset& kData) {
     item_start = item_end;
   }
 
-  // Allocate buffer for offset addition
-  func_est_plus_offset_.resize(max_items_per_group);
-
-  // Allocate ranker memory
-  ranker_.Init(max_items_per_group);
+  // Allocate buffers for offset addition and ranker memory, for each thread
+  func_est_plus_offset_.resize(get_num_threads());
+  rankers_.resize(get_num_threads());
+  for (int thread = 0; thread < get_num_threads(); thread++) {
+    func_est_plus_offset_[thread].resize(max_items_per_group);
+    rankers_[thread].Init(max_items_per_group);
+  }
 
   // Allocate IR measure memory
 
@@ -767,50 +804,49 @@ double CPairwise::Deviance(const CDataset& kData, const Bag& kBag,
     return 0;
   }
 
-  double loss = 0.0;
-  double weight = 0.0;
+  // The groups with pairs
+  vector<CGroup> groups;
+  ListGroups(kData, num_rows_in_set, groups);
 
-  unsigned int item_start = 0;
-  unsigned int item_end = item_start;
-  const unsigned int kEnd = num_rows_in_set;
+  vector<CGroup> scored_groups;
+  for (unsigned long group = 0; group < groups.size(); group++) {
+    if (groups[group].max_score > 0.0) {
+      scored_groups.push_back(groups[group]);
+    }
+  }
+  DrawTieBreaks(scored_groups);
 
-  while (item_start < kEnd) {
-    const double kGroup = kGroups_[item_start];
-    const double kWi = kData.weight_ptr()[item_start];
+  // The groups' losses are summed in order once all are computed
+  vector<double> group_loss(scored_groups.size());
 
-    // Find end of current group
-    for (item_end = item_start + 1;
-         item_end < kEnd && kGroups_[item_end] == kGroup; item_end++)
-      ;
+#pragma omp parallel for schedule(dynamic, 1) num_threads(get_num_threads())
+  for (unsigned long group = 0; group < scored_groups.size(); group++) {
+    const CGroup& kGroup = scored_groups[group];
+    const int kThread = ThreadNumber();
+    CRanker& ranker = rankers_[kThread];
 
-    const int cNumItems = item_end - item_start;
-    // TODO: Implement better way to ensure casting robust to overflow
-    int int_group = 0;
-    if (fabs(kGroup) > nextafter(INT_MAX, 0) || isnan(kGroup)) {
-      int_group = copysign(INT_MAX, kGroup);
-    } else {
-      int_group = (int)kGroup;
-    }
-    const double kMaxScore =
-        pirm_->MaxMeasure(int_group, kData.y_ptr() + item_start, cNumItems);
+    // Rank items by current score
 
-    if (kMaxScore > 0.0) {
-      // Rank items by current score
+    // If offset given, add up current scores
+    const double* kFuncPlusOffset =
+        OffsetVector(kfuncEstimate, kData.offset_ptr(), kGroup.start,
+                     kGroup.end, func_est_plus_offset_[kThread]);
 
-      // If offset given, add up current scores
-      const double* kFuncPlusOffset =
-          OffsetVector(kfuncEstimate, kData.offset_ptr(), item_start, item_end,
-                       func_est_plus_offset_);
+    ranker.SetGroupScores(kFuncPlusOffset, &tie_breaks_[kGroup.start],
+                          kGroup.end - kGroup.start);
+    ranker.Rank();
 
-      ranker_.SetGroupScores(kFuncPlusOffset, cNumItems);
-      ranker_.Rank();
+    group_loss[group] = kData.weight_ptr()[kGroup.start] *
+                        pirm_->Measure(kData.y_ptr() + kGroup.start, ranker) /
+                        kGroup.max_score;
+  }
 
-      loss +=
-          kWi * pirm_->Measure(kData.y_ptr() + item_start, ranker_) / kMaxScore;
-      weight += kWi;
-    }
-    // Next group
-    item_start = item_end;
+  double loss = 0.0;
+  double weight = 0.0;
+
+  for (unsigned long group = 0; group < scored_groups.size(); group++) {
+    loss += group_loss[group];
+    weight += kData.weight_ptr()[scored_groups[group].start];
   }
 
   // Loss = 1 - utility
@@ -862,67 +898,62 @@ double CPairwise::BagImprovement(const CDataset& kData, const Bag& kBag,
     return 0;
   }
 
-  double loss = 0.0;
-  double weight = 0.0;
+  // The groups held out of the training set with pairs
+  vector<CGroup> groups;
+  ListGroups(kData, kData.get_trainsize(), groups);
 
-  unsigned int item_start = 0;
-  unsigned int item_end = 0;
-
-  while (item_start < kData.get_trainsize()) {
-    const double kGroup = kGroups_[item_start];
-
-    // Find end of current group
-    for (item_end = item_start + 1;
-         item_end < kData.get_trainsize() && kGroups_[item_end] == kGroup;
-         item_end++)
-      ;
-
-    if (!kBag.get_element(item_start)) {
-      // Group was held out of training set
-
-      const unsigned int kNumItems = item_end - item_start;
-      // TODO: Implement better way to ensure casting robust to overflow
-      int int_group = 0;
-      if (fabs(kGroup) > nextafter(INT_MAX, 0) || isnan(kGroup)) {
-        int_group = copysign(INT_MAX, kGroup);
-      } else {
-        int_group = (int)kGroup;
-      }
-      const double dMaxScore =
-          pirm_->MaxMeasure(int_group, kData.y_ptr() + item_start, kNumItems);
-
-      if (dMaxScore > 0.0) {
-        // If offset given, add up current scores
-        const double* kFuncPlusOffset =
-            OffsetVector(kFuncEstimate, kData.offset_ptr(), item_start,
-                         item_end, func_est_plus_offset_);
-
-        // Compute score according to old score, adF
-        ranker_.SetGroupScores(kFuncPlusOffset, kNumItems);
-        ranker_.Rank();
-        const double kOldScore =
-            pirm_->Measure(kData.y_ptr() + item_start, ranker_);
-
-        // Compute score according to new score: adF' =  adF + dStepSize *
-        // adFadj
-        for (unsigned int i = 0; i < kNumItems; i++) {
-          ranker_.AddToScore(i, kDeltaEstimate[i + item_start] * kShrinkage);
-        }
-
-        const double kWi = kData.weight_ptr()[item_start];
+  vector<CGroup> held_out_groups;
+  for (unsigned long group = 0; group < groups.size(); group++) {
+    if (!kBag.get_element(groups[group].start) &&
+        groups[group].max_score > 0.0) {
+      held_out_groups.push_back(groups[group]);
+    }
+  }
+  DrawTieBreaks(held_out_groups);
+
+  // The groups' losses are summed in order once all are computed
+  vector<double> group_loss(held_out_groups.size(), 0.0);
+
+#pragma omp parallel for schedule(dynamic, 1) num_threads(get_num_threads())
+  for (unsigned long group = 0; group < held_out_groups.size(); group++) {
+    const CGroup& kGroup = held_out_groups[group];
+    const unsigned int kNumItems = kGroup.end - kGroup.start;
+    const int kThread = ThreadNumber();
+    CRanker& ranker = rankers_[kThread];
+
+    // If offset given, add up current scores
+    const double* kFuncPlusOffset =
+        OffsetVector(kFuncEstimate, kData.offset_ptr(), kGroup.start,
+                     kGroup.end, func_est_plus_offset_[kThread]);
+
+    // Compute score according to old score, adF
+    ranker.SetGroupScores(kFuncPlusOffset, &tie_breaks_[kGroup.start],
+                          kNumItems);
+    ranker.Rank();
+    const double kOldScore =
+        pirm_->Measure(kData.y_ptr() + kGroup.start, ranker);
+
+    // Compute score according to new score: adF' =  adF + dStepSize *
+    // adFadj
+    for (unsigned int i = 0; i < kNumItems; i++) {
+      ranker.AddToScore(i, kDeltaEstimate[i + kGroup.start] * kShrinkage);
+    }
 
-        if (ranker_.Rank()) {
-          // Ranking changed
-          const double kNewScore =
-              pirm_->Measure(kData.y_ptr() + item_start, ranker_);
-          loss += kWi * (kNewScore - kOldScore) / dMaxScore;
-        }
-        weight += kWi;
-      }
+    if (ranker.Rank()) {
+      // Ranking changed
+      const double kNewScore =
+          pirm_->Measure(kData.y_ptr() + kGroup.start, ranker);
+      group_loss[group] = kData.weight_ptr()[kGroup.start] *
+                          (kNewScore - kOldScore) / kGroup.max_score;
     }
+  }
 
-    // Next group
-    item_start = item_end;
+  double loss = 0.0;
+  double weight = 0.0;
+
+  for (unsigned long group = 0; group < held_out_groups.size(); group++) {
+    loss += group_loss[group];
+    weight += kData.weight_ptr()[held_out_groups[group].start];
   }
 
   return loss / weight;
@@ -950,7 +981,8 @@ void CPairwise::BagData(const CDataset& kData, Bag& bag) {
       }
 
       // Group changed, make a new decision
-      is_chosen = (unif_rand() * (get_num_groups() - seen_groups) <
+      is_chosen = (gbm_platform::UniformRandom() *
+                       (get_num_groups() - seen_groups) <
                    total_groupsinbag - bagged_groups);
       if (is_chosen) {
         bagged_groups++;
@@ -70,6 +70,7 @@
 #ifndef PAIRWISE_H
 #define PAIRWISE_H
 
+#include <climits>
 #include <memory>
 #include "distribution.h"
 #include "dataset.h"
@@ -87,7 +88,10 @@ class CRanker {
 
   // Initialize ranker with scores of items belonging to the same group
   // - adScores is a score array, (at least) cNumItems long
-  bool SetGroupScores(const double* const kScores, unsigned int num_items);
+  // - kTieBreaks are uniform random numbers, one per item, that break ties
+  //   in the scores
+  bool SetGroupScores(const double* const kScores,
+                      const double* const kTieBreaks, unsigned int num_items);
 
   // Perform the ranking
   // - Return true if any item changed its rank
@@ -102,6 +106,10 @@ class CRanker {
   void SetRank(int i, unsigned int r) { score_rank_vec_[i].second = r; }
   void AddToScore(int i, double delta) { score_rank_vec_[i].first += delta; }
 
+  // Scratch space for the IR measures, which is the ranker's so that each
+  // thread ranking groups has its own
+  vector<int>& get_rankpos_buffer() const { return rankpos_vec_; }
+
  protected:
   // Number of items in current group
   unsigned int num_items_;
@@ -113,6 +121,9 @@ class CRanker {
   // Note: We need a separate array for sorting in order to be able to
   // quickly look up the rank for any given item.
   vector<CDoubleUintPair*> ptrs_to_score_rank_vec_;
+
+  // Buffer to hold positions of positive examples (see CMAP)
+  mutable vector<int> rankpos_vec_;
 };
 
 // Abstract base class for all IR Measures
@@ -256,17 +267,10 @@ class CMRR : public CIRMeasure {
 
 class CMAP : public CIRMeasure {
  public:
-  void Init(unsigned long max_group, unsigned long num_items,
-            unsigned int rank_cutoff = UINT_MAX);
-
   double Measure(const double* const kResponse, const CRanker& kRanker);
 
   double SwapCost(int item_pos, int item_neg, const double* const kResponse,
                   const CRanker& kRanker) const;
-
- protected:
-  // Buffer to hold positions of positive examples
-  mutable vector<int> rankpos_vec_;
 };
 
 // Main class for 'pairwise' distribution
@@ -286,6 +290,11 @@ class CMAP : public CIRMeasure {
 //   functions, with same values for adY, adGroup, adWeight, and
 //   nTrain. Certain values have to be precomputed for
 //   efficiency.
+// * The groups are ranked in parallel, each thread with its own ranker.
+//   The maximum IR measures are cached by the measures, so are found
+//   before the groups are shared out, and the random numbers breaking ties
+//   in the scores are drawn beforehand in the order of the groups, so that
+//   the results do not depend on the number of threads.
 
 class CPairwise : public CDistribution {
  public:
@@ -319,20 +328,35 @@ class CPairwise : public CDistribution {
   }
 
  protected:
+  // A group of items, the rows [start, end) of a set, and the maximum
+  // achievable IR measure of the group
+  struct CGroup {
+    unsigned int start;
+    unsigned int end;
+    double max_score;
+  };
+
   // Constructor: determine IR measure as either "conc", "map", "mrr", or "ndcg"
-  CPairwise(const double* kGroups, const char* kIrMeasure,
-            int num_training_rows);
+  CPairwise(const parallel_details& parallel, const double* kGroups,
+            const char* kIrMeasure, int num_training_rows);
+
+  // The groups of the rows [0, num_rows) of a set, with their maximum IR
+  // measures
+  void ListGroups(const CDataset& kData, unsigned int num_rows,
+                  vector<CGroup>& groups);
+
+  // Draw the random numbers breaking ties in the scores of the groups'
+  // items, in the groups' order
+  void DrawTieBreaks(const vector<CGroup>& kGroups);
 
   // Calculate and accumulate up the gradients and Hessians from all training
   // pairs
-  void ComputeLambdas(int group, unsigned int num_items,
-                      const double* const kResponse,
-                      const double* const kFuncEstimate,
-                      const double* const kWeights, double* residuals,
-                      double* deriv);
+  void ComputeLambdas(const CGroup& kGroup, const double* const kResponse,
+                      const double* const kFuncEstimate, CRanker& ranker,
+                      double* residuals, double* deriv);
 
   std::auto_ptr<CIRMeasure> pirm_;  // The IR measure to use
-  CRanker ranker_;                  // The ranker
+  vector<CRanker> rankers_;         // The rankers, one for each thread
 
   vector<double> hessian_;  // Second derivative of loss function, for each
                             // training instance; used for Newton step
@@ -342,8 +366,13 @@ class CPairwise : public CDistribution {
   vector<double> fit_denominator_;  // Buffer used for denominator in
                                     // FitBestConstant(), for each node
 
-  vector<double> func_est_plus_offset_;  // Temporary buffer for (adF +
-                                         // adOffset), if the latter is not null
+  vector<vector<double> > func_est_plus_offset_;  // Temporary buffers for
+                                                  // (adF + adOffset), if the
+                                                  // latter is not null, one
+                                                  // for each thread
+
+  vector<double> tie_breaks_;  // Random numbers breaking ties in the scores,
+                               // for each instance of the groups ranked
 
   const double* kGroups_;
 };
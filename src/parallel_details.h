@@ -2,16 +2,22 @@
 #define PARALLELDETAILS_H
 
 #include "gbm_exception.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 // simple wrapper class to conceal details of parallelization
 
 class parallel_details {
  public:
-  parallel_details() : num_threads_(1), array_chunk_size_(1024) {}
+  parallel_details()
+      : num_threads_(1), array_chunk_size_(1024), histogram_bins_(0) {}
   parallel_details(int num_threads,
-		   int array_chunk_size)
+		   int array_chunk_size,
+		   int histogram_bins = 0)
     : num_threads_(num_threads),
-      array_chunk_size_(array_chunk_size) {
+      array_chunk_size_(array_chunk_size),
+      histogram_bins_(histogram_bins) {
     if (num_threads_ <= 0) {
       throw gbm_exception::InvalidArgument(
           "number of threads must be strictly positive");
@@ -21,14 +27,33 @@ class parallel_details {
       throw gbm_exception::InvalidArgument(
 	  "array chunk size must be strictly positive");
     }
+
+    // 0 bins means the exact (presorted) split search is used
+    if ((histogram_bins_ != 0) &&
+        ((histogram_bins_ < 2) || (histogram_bins_ > 65535))) {
+      throw gbm_exception::InvalidArgument(
+          "number of histogram bins must be between 2 and 65535");
+    }
   }
 
   int get_num_threads() const { return num_threads_; }
   int get_array_chunk_size() const { return array_chunk_size_; }
+  bool use_histograms() const { return histogram_bins_ > 0; }
+  int get_histogram_bins() const { return histogram_bins_; }
 
  private:
   int num_threads_;
   int array_chunk_size_;
+  int histogram_bins_;
 };
 
+// the number of the calling thread in its team, 0 outside parallel regions
+inline int ThreadNumber() {
+#ifdef _OPENMP
+  return omp_get_thread_num();
+#else
+  return 0;
+#endif
+}
+
 #endif
@@ -10,6 +10,21 @@
 // Includes
 //-----------------------------------
 #include "poisson.h"
+#include "block_sums.h"
+#include "vector_math.h"
+
+namespace {
+// the deviance from the total loss and weight of a set's rows
+double MeanDeviance(double loss, double weight) {
+  // TODO: Check if weights are all zero for validation set
+  if ((weight == 0.0) && (loss == 0.0)) {
+    return nan("");
+  } else if (weight == 0.0) {
+    return copysign(HUGE_VAL, -loss);
+  }
+  return -2 * loss / weight;
+}
+}
 
 //----------------------------------------
 // Function Members - Private
@@ -29,53 +44,90 @@ CPoisson::~CPoisson() {}
 void CPoisson::ComputeWorkingResponse(const CDataset& kData, const Bag& kBag,
                                       const double* kFuncEstimate,
                                       std::vector<double>& residuals) {
+  const unsigned long kNumRows = kData.get_trainsize();
+
 // compute working response
-#pragma omp parallel for schedule(static, get_array_chunk_size()) \
-  num_threads(get_num_threads())
-  for (unsigned long i = 0; i < kData.get_trainsize(); i++) {
-    const double delta_func_est = kFuncEstimate[i] + kData.offset_ptr()[i];
-    residuals[i] = kData.y_ptr()[i] - std::exp(delta_func_est);
+#pragma omp parallel for schedule( \
+    static, gbm_vector_math::BlocksPerChunk(get_array_chunk_size())) \
+    num_threads(get_num_threads())
+  for (unsigned long block = 0; block < gbm_vector_math::NumBlocks(kNumRows);
+       block++) {
+    const unsigned long kBegin = block * gbm_vector_math::kBlockSize;
+    const unsigned long kSize = gbm_vector_math::BlockSize(block, kNumRows);
+    double means[gbm_vector_math::kBlockSize];
+
+    for (unsigned long j = 0; j < kSize; j++) {
+      means[j] = kFuncEstimate[kBegin + j] + kData.offset_ptr()[kBegin + j];
+    }
+    gbm_vector_math::Exp(means, kSize, means);
+
+    for (unsigned long j = 0; j < kSize; j++) {
+      residuals[kBegin + j] = kData.y_ptr()[kBegin + j] - means[j];
+    }
   }
 }
 
 double CPoisson::InitF(const CDataset& kData) {
-  double sum = 0.0;
-  double denom = 0.0;
-
-#pragma omp parallel for schedule(static, get_array_chunk_size()) \
-    reduction(+ : sum, denom) num_threads(get_num_threads())
-  for (unsigned long i = 0; i < kData.get_trainsize(); i++) {
-    sum += kData.weight_ptr()[i] * kData.y_ptr()[i];
-    denom += kData.weight_ptr()[i] * std::exp(kData.offset_ptr()[i]);
+  BlockSums sums(kData.get_trainsize(), 2);
+
+#pragma omp parallel for schedule( \
+    static, gbm_vector_math::BlocksPerChunk(get_array_chunk_size())) \
+    num_threads(get_num_threads())
+  for (unsigned long block = 0; block < sums.num_blocks(); block++) {
+    double sum = 0.0;
+    double denom = 0.0;
+    for (unsigned long i = sums.begin(block); i < sums.end(block); i++) {
+      sum += kData.weight_ptr()[i] * kData.y_ptr()[i];
+      denom += kData.weight_ptr()[i] * std::exp(kData.offset_ptr()[i]);
+    }
+    sums(block, 0) = sum;
+    sums(block, 1) = denom;
   }
 
+  double sum = sums.Total(0);
+  double denom = sums.Total(1);
+
   return std::log(sum / denom);
 }
 
 double CPoisson::Deviance(const CDataset& kData, const Bag& kBag,
                           const double* kFuncEstimate) {
-  double loss = 0.0;
-  double weight = 0.0;
-
   // Switch to validation set if necessary
-  unsigned long num_rows_in_set = kData.get_size_of_set();
-
-#pragma omp parallel for schedule(static, get_array_chunk_size()) \
-    reduction(+ : loss, weight) num_threads(get_num_threads())
-  for (unsigned long i = 0; i < num_rows_in_set; i++) {
-    loss += kData.weight_ptr()[i] *
-            (kData.y_ptr()[i] * (kData.offset_ptr()[i] + kFuncEstimate[i]) -
-             std::exp(kData.offset_ptr()[i] + kFuncEstimate[i]));
-    weight += kData.weight_ptr()[i];
-  }
+  const unsigned long kNumRows = kData.get_size_of_set();
+  BlockSums sums(kNumRows, 2);
 
-  // TODO: Check if weights are all zero for validation set
-  if ((weight == 0.0) && (loss == 0.0)) {
-    return nan("");
-  } else if (weight == 0.0) {
-    return copysign(HUGE_VAL, -loss);
+#pragma omp parallel for schedule( \
+    static, gbm_vector_math::BlocksPerChunk(get_array_chunk_size())) \
+    num_threads(get_num_threads())
+  for (unsigned long block = 0; block < sums.num_blocks(); block++) {
+    const unsigned long kBegin = block * gbm_vector_math::kBlockSize;
+    const unsigned long kSize = gbm_vector_math::BlockSize(block, kNumRows);
+    double delta_func_est[gbm_vector_math::kBlockSize];
+    double means[gbm_vector_math::kBlockSize];
+    double loss = 0.0;
+    double weight = 0.0;
+
+    for (unsigned long j = 0; j < kSize; j++) {
+      delta_func_est[j] =
+          kData.offset_ptr()[kBegin + j] + kFuncEstimate[kBegin + j];
+    }
+    gbm_vector_math::Exp(delta_func_est, kSize, means);
+
+    for (unsigned long j = 0; j < kSize; j++) {
+      const unsigned long i = kBegin + j;
+      loss += kData.weight_ptr()[i] *
+              (kData.y_ptr()[i] * delta_func_est[j] - means[j]);
+      weight += kData.weight_ptr()[i];
+    }
+
+    sums(block, 0) = loss;
+    sums(block, 1) = weight;
   }
-  return -2 * loss / weight;
+
+  double loss = sums.Total(0);
+  double weight = sums.Total(1);
+
+  return MeanDeviance(loss, weight);
 }
 
 void CPoisson::FitBestConstant(const CDataset& kData, const Bag& kBag,
@@ -115,11 +167,13 @@ void CPoisson::FitBestConstant(const CDataset& kData, const Bag& kBag,
             std::log(numerator_vec[node_num] / denominator_vec[node_num]));
       }
       tree.get_terminal_nodes()[node_num]->set_prediction(
-          R::fmin2(tree.get_terminal_nodes()[node_num]->get_prediction(),
-                   19 - max_vec[node_num]));
+          gbm_platform::Min(
+              tree.get_terminal_nodes()[node_num]->get_prediction(),
+              19 - max_vec[node_num]));
       tree.get_terminal_nodes()[node_num]->set_prediction(
-          R::fmax2(tree.get_terminal_nodes()[node_num]->get_prediction(),
-                   -19 - min_vec[node_num]));
+          gbm_platform::Max(
+              tree.get_terminal_nodes()[node_num]->get_prediction(),
+              -19 - min_vec[node_num]));
     }
   }
 }
@@ -128,23 +182,110 @@ double CPoisson::BagImprovement(const CDataset& kData, const Bag& kBag,
                                 const double* kFuncEstimate,
                                 const double kShrinkage,
                                 const std::vector<double>& kDeltaEstimate) {
-  double returnvalue = 0.0;
-  double weight = 0.0;
+  const unsigned long kNumRows = kData.get_trainsize();
+  BlockSums sums(kNumRows, 2);
 
-#pragma omp parallel for schedule(static, get_array_chunk_size()) \
-    reduction(+ : returnvalue, weight) num_threads(get_num_threads())
-  for (unsigned long i = 0; i < kData.get_trainsize(); i++) {
-    if (!kBag.get_element(i)) {
-      const double delta_func_est = kFuncEstimate[i] + kData.offset_ptr()[i];
+  // the terms of every row are computed, and those of the rows in the bag
+  // then dropped, so that the kernels run over whole blocks
+#pragma omp parallel for schedule( \
+    static, gbm_vector_math::BlocksPerChunk(get_array_chunk_size())) \
+    num_threads(get_num_threads())
+  for (unsigned long block = 0; block < sums.num_blocks(); block++) {
+    const unsigned long kBegin = block * gbm_vector_math::kBlockSize;
+    const unsigned long kSize = gbm_vector_math::BlockSize(block, kNumRows);
+    double means[gbm_vector_math::kBlockSize];
+    double new_means[gbm_vector_math::kBlockSize];
+    double returnvalue = 0.0;
+    double weight = 0.0;
 
-      returnvalue +=
+    for (unsigned long j = 0; j < kSize; j++) {
+      const unsigned long i = kBegin + j;
+      means[j] = kFuncEstimate[i] + kData.offset_ptr()[i];
+      new_means[j] = kData.offset_ptr()[i] +
+                     (kFuncEstimate[i] + kShrinkage * kDeltaEstimate[i]);
+    }
+    gbm_vector_math::Exp(means, kSize, means);
+    gbm_vector_math::Exp(new_means, kSize, new_means);
+
+    for (unsigned long j = 0; j < kSize; j++) {
+      const unsigned long i = kBegin + j;
+      const double kTerm =
           kData.weight_ptr()[i] *
-          (kData.y_ptr()[i] * kShrinkage * kDeltaEstimate[i] -
-           std::exp(delta_func_est + kShrinkage * kDeltaEstimate[i]) +
-           std::exp(delta_func_est));
-      weight += kData.weight_ptr()[i];
+          (kData.y_ptr()[i] * kShrinkage * kDeltaEstimate[i] - new_means[j] +
+           means[j]);
+      returnvalue += kBag.get_element(i) ? 0.0 : kTerm;
+      weight += kBag.get_element(i) ? 0.0 : kData.weight_ptr()[i];
     }
+
+    sums(block, 0) = returnvalue;
+    sums(block, 1) = weight;
   }
 
+  double returnvalue = sums.Total(0);
+  double weight = sums.Total(1);
+
   return returnvalue / weight;
 }
+
+bool CPoisson::FusedUpdate(const CDataset& kData, const Bag& kBag,
+                            const double kShrinkage,
+                            const std::vector<double>& kDeltaEstimate,
+                            double* func_estimate,
+                            std::vector<double>& residuals,
+                            double& oobag_improvement, double& deviance) {
+  const unsigned long kNumRows = kData.get_trainsize();
+  BlockSums sums(kNumRows, 4);
+
+#pragma omp parallel for schedule( \
+    static, gbm_vector_math::BlocksPerChunk(get_array_chunk_size())) \
+    num_threads(get_num_threads())
+  for (unsigned long block = 0; block < sums.num_blocks(); block++) {
+    const unsigned long kBegin = block * gbm_vector_math::kBlockSize;
+    const unsigned long kSize = gbm_vector_math::BlockSize(block, kNumRows);
+    double means[gbm_vector_math::kBlockSize];
+    double delta_func_est[gbm_vector_math::kBlockSize];
+    double new_means[gbm_vector_math::kBlockSize];
+    double improvement = 0.0;
+    double oobag_weight = 0.0;
+    double loss = 0.0;
+    double weight = 0.0;
+
+    for (unsigned long j = 0; j < kSize; j++) {
+      const unsigned long i = kBegin + j;
+      means[j] = func_estimate[i] + kData.offset_ptr()[i];
+      func_estimate[i] += kShrinkage * kDeltaEstimate[i];
+      delta_func_est[j] = kData.offset_ptr()[i] + func_estimate[i];
+    }
+    gbm_vector_math::Exp(means, kSize, means);
+    gbm_vector_math::Exp(delta_func_est, kSize, new_means);
+
+    for (unsigned long j = 0; j < kSize; j++) {
+      const unsigned long i = kBegin + j;
+      const double kTerm =
+          kData.weight_ptr()[i] *
+          (kData.y_ptr()[i] * kShrinkage * kDeltaEstimate[i] - new_means[j] +
+           means[j]);
+      improvement += kBag.get_element(i) ? 0.0 : kTerm;
+      oobag_weight += kBag.get_element(i) ? 0.0 : kData.weight_ptr()[i];
+
+      loss += kData.weight_ptr()[i] *
+              (kData.y_ptr()[i] * delta_func_est[j] - new_means[j]);
+      weight += kData.weight_ptr()[i];
+      residuals[i] = kData.y_ptr()[i] - new_means[j];
+    }
+
+    sums(block, 0) = improvement;
+    sums(block, 1) = oobag_weight;
+    sums(block, 2) = loss;
+    sums(block, 3) = weight;
+  }
+
+  double improvement = sums.Total(0);
+  double oobag_weight = sums.Total(1);
+  double loss = sums.Total(2);
+  double weight = sums.Total(3);
+
+  oobag_improvement = improvement / oobag_weight;
+  deviance = MeanDeviance(loss, weight);
+  return true;
+}
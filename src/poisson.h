@@ -16,7 +16,7 @@
 // Includes
 //------------------------------
 #include "distribution.h"
-#include <Rmath.h>
+#include <cmath>
 #include <memory>
 
 //------------------------------
@@ -55,6 +55,12 @@ class CPoisson : public CDistribution {
                         const double* kFuncEstimate, const double kShrinkage,
                         const std::vector<double>& kDeltaEstimate);
 
+  bool FusedUpdate(const CDataset& kData, const Bag& kBag,
+                   const double kShrinkage,
+                   const std::vector<double>& kDeltaEstimate,
+                   double* func_estimate, std::vector<double>& residuals,
+                   double& oobag_improvement, double& deviance);
+
  private:
   //----------------------
   // Private Constructors
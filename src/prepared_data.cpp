@@ -0,0 +1,191 @@
+//-----------------------------------
+//
+// File: prepared_data.cpp
+//
+// Description: the predictors, their order and the observation index of
+//   a dataset prepared once for many fits.
+//
+//-----------------------------------
+
+//-----------------------------------
+// Includes
+//-----------------------------------
+#include "prepared_data.h"
+#include "gbm_functions.h"
+#include <algorithm>
+
+//----------------------------------------
+// Function Members - Public
+//----------------------------------------
+//-----------------------------------
+// Function: PreparedData
+//
+// Returns: none
+//
+// Description: prepares a dataset, ordering the predictors if no order
+//   is given.  For the histogram split search the predictors are binned
+//   instead, and the values let go of so that R can free them.
+//
+// Parameters:
+//  kCovariates - the predictor values, training rows first
+//  kCovarOrder - the zero-based order of the training rows of each
+//                predictor, or empty to compute it
+//  kVarClasses - 0 for continuous predictors, the number of levels for
+//                categorical ones
+//  kIntResponse - integer components of the response
+//  kRowToObsId - the observation id of each row
+//  num_trainrows - the number of training rows
+//  kParallel - parallelization-related constants
+//-----------------------------------
+PreparedData::PreparedData(const Rcpp::NumericMatrix& kCovariates,
+                           const Rcpp::IntegerVector& kCovarOrder,
+                           const Rcpp::IntegerVector& kVarClasses,
+                           const Rcpp::IntegerMatrix& kIntResponse,
+                           const Rcpp::IntegerVector& kRowToObsId,
+                           unsigned long num_trainrows,
+                           const parallel_details& kParallel)
+    : xvalues_(kCovariates),
+      intresponse_(kIntResponse),
+      observationids_(kRowToObsId),
+      num_trainrows_(num_trainrows) {
+  if ((num_trainrows_ <= 0) || (xvalues_.nrow() < int(num_trainrows_))) {
+    throw gbm_exception::InvalidArgument(
+        "your training instances don't make sense");
+  }
+
+  if (kParallel.use_histograms()) {
+    if (kVarClasses.size() != xvalues_.ncol()) {
+      throw gbm_exception::InvalidArgument(
+          "shape mismatch (var classes does not match data)");
+    }
+    std::vector<int> var_classes(kVarClasses.begin(), kVarClasses.end());
+    binned_features_.Initialize(
+        values_span(), num_trainrows_,
+        Span<int>(&var_classes[0], var_classes.size()),
+        kParallel.get_histogram_bins(), kParallel.get_num_threads());
+    xvalues_ = Rcpp::NumericMatrix();
+  } else {
+    xorder_ = Rcpp::IntegerMatrix(num_trainrows_, xvalues_.ncol());
+    if (kCovarOrder.size() == 0) {
+      gbm_functions::OrderPredictors(values_span(), num_trainrows_,
+                                     kParallel.get_num_threads(),
+                                     xorder_.begin());
+    } else if (kCovarOrder.size() == xorder_.size()) {
+      std::copy(kCovarOrder.begin(), kCovarOrder.end(), xorder_.begin());
+    } else {
+      throw gbm_exception::InvalidArgument(
+          "shape mismatch (order does not match data)");
+    }
+  }
+
+  IndexObservations();
+}
+
+//-----------------------------------
+// Function: PreparedData
+//
+// Returns: none
+//
+// Description: prepares a cross-validation fold of a prepared dataset.
+//   The training rows outside the fold come first, followed by those in
+//   the fold, as split_and_join arranges them in R; rows outside the
+//   training set are dropped.  Binned data keep the parent's bins, as the
+//   values to bin the fold's training rows again are no longer kept.
+//
+// Parameters:
+//  kParent - the prepared dataset the fold is taken from
+//  kRowsInTraining - TRUE for each row of the parent in the training set
+//  kRowsInFold - TRUE for each training row in the fold
+//  kIntResponse - integer components of the response of the fold data
+//  kRowToObsId - the observation id of each row of the fold data
+//  kParallel - parallelization-related constants
+//-----------------------------------
+PreparedData::PreparedData(const PreparedData& kParent,
+                           const Rcpp::LogicalVector& kRowsInTraining,
+                           const Rcpp::LogicalVector& kRowsInFold,
+                           const Rcpp::IntegerMatrix& kIntResponse,
+                           const Rcpp::IntegerVector& kRowToObsId,
+                           const parallel_details& kParallel)
+    : intresponse_(kIntResponse), observationids_(kRowToObsId) {
+  const int kParentRows = kParent.num_rows();
+  if (kRowsInTraining.size() != kParentRows) {
+    throw gbm_exception::InvalidArgument(
+        "shape mismatch (rows in training does not match data)");
+  }
+
+  std::vector<int> training_rows;
+  for (int row = 0; row < kParentRows; row++) {
+    if (kRowsInTraining[row]) training_rows.push_back(row);
+  }
+  if (kRowsInFold.size() != int(training_rows.size())) {
+    throw gbm_exception::InvalidArgument(
+        "shape mismatch (rows in fold does not match training rows)");
+  }
+
+  std::vector<int> fold_rows;
+  Rcpp::LogicalVector keep_row(kRowsInFold.size());
+  for (int ind = 0; ind < kRowsInFold.size(); ind++) {
+    keep_row[ind] = !kRowsInFold[ind];
+    if (keep_row[ind]) fold_rows.push_back(training_rows[ind]);
+  }
+  num_trainrows_ = fold_rows.size();
+  if (num_trainrows_ <= 0) {
+    throw gbm_exception::InvalidArgument("you've <= 0 training instances");
+  }
+  for (int ind = 0; ind < kRowsInFold.size(); ind++) {
+    if (!keep_row[ind]) fold_rows.push_back(training_rows[ind]);
+  }
+
+  if (kParent.binned_features()) {
+    binned_features_.Initialize(kParent.binned_features_, fold_rows);
+  } else {
+    const int kNumRows = fold_rows.size();
+    xvalues_ = Rcpp::NumericMatrix(kNumRows, kParent.xvalues_.ncol());
+    for (int var = 0; var < xvalues_.ncol(); var++) {
+      const double* kParentColumn =
+          kParent.xvalues_.begin() + (long)var * kParentRows;
+      double* column = xvalues_.begin() + (long)var * kNumRows;
+      for (int row = 0; row < kNumRows; row++) {
+        column[row] = kParentColumn[fold_rows[row]];
+      }
+    }
+
+    // when the training rows are exactly those the parent ordered, the
+    // fold's order is read off the parent's without sorting again
+    xorder_ = Rcpp::IntegerMatrix(num_trainrows_, xvalues_.ncol());
+    if ((training_rows.size() == kParent.num_trainrows_) &&
+        (training_rows.back() == int(kParent.num_trainrows_) - 1)) {
+      gbm_functions::SubsetOrder(
+          MatrixSpan<const int>(kParent.xorder_.begin(), kParent.xorder_.nrow(),
+                                kParent.xorder_.ncol()),
+          keep_row.begin(), xorder_.begin());
+    } else {
+      gbm_functions::OrderPredictors(values_span(), num_trainrows_,
+                                     kParallel.get_num_threads(),
+                                     xorder_.begin());
+    }
+  }
+
+  IndexObservations();
+}
+
+//----------------------------------------
+// Function Members - Private
+//----------------------------------------
+//-----------------------------------
+// Function: IndexObservations
+//
+// Returns: none
+//
+// Description: groups the training rows by observation for bagging.
+//
+// Parameters: none
+//-----------------------------------
+void PreparedData::IndexObservations() {
+  if (observationids_.size() < int(num_trainrows_)) {
+    throw gbm_exception::InvalidArgument(
+        "shape mismatch (observation ids do not match training rows)");
+  }
+  gbm_functions::IndexObservations(observationids_.begin(), num_trainrows_,
+                                   observation_rows_, observation_starts_);
+}
@@ -0,0 +1,99 @@
+//------------------------------------------------------------------------------
+//
+//  File:       prepared_data.h
+//
+//  Description: header for the prepared data - the converted predictors,
+//    their order, the strata/sort vectors and the observation index kept
+//    on the C++ side so that repeated fits on the same data, their folds
+//    and further boosting need not rebuild them from R objects.  For the
+//    histogram split search only the predictors' bin codes are kept.
+//
+//------------------------------------------------------------------------------
+
+#ifndef PREPAREDDATA_H
+#define PREPAREDDATA_H
+
+//------------------------------
+// Includes
+//------------------------------
+#include "binned_features.h"
+#include "gbm_exception.h"
+#include "parallel_details.h"
+#include "span.h"
+#include <vector>
+#include <Rcpp.h>
+
+//------------------------------
+// Class definition
+//------------------------------
+class PreparedData {
+ public:
+  //----------------------
+  // Public Constructors
+  //----------------------
+  PreparedData(const Rcpp::NumericMatrix& kCovariates,
+               const Rcpp::IntegerVector& kCovarOrder,
+               const Rcpp::IntegerVector& kVarClasses,
+               const Rcpp::IntegerMatrix& kIntResponse,
+               const Rcpp::IntegerVector& kRowToObsId,
+               unsigned long num_trainrows,
+               const parallel_details& kParallel);
+  PreparedData(const PreparedData& kParent,
+               const Rcpp::LogicalVector& kRowsInTraining,
+               const Rcpp::LogicalVector& kRowsInFold,
+               const Rcpp::IntegerMatrix& kIntResponse,
+               const Rcpp::IntegerVector& kRowToObsId,
+               const parallel_details& kParallel);
+
+  //---------------------
+  // Public destructor
+  //---------------------
+  ~PreparedData(){};
+
+  //---------------------
+  // Public Functions
+  //---------------------
+  // the predictor values and their order are empty when the predictors
+  // are binned, and the bins NULL when they are not
+  SEXP xvalues() const { return xvalues_; };
+  SEXP xorder() const { return xorder_; };
+  const BinnedFeatures* binned_features() const {
+    return binned_features_.empty() ? NULL : &binned_features_;
+  };
+  SEXP intresponse() const { return intresponse_; };
+  SEXP observationids() const { return observationids_; };
+  unsigned long num_trainrows() const { return num_trainrows_; };
+
+  const std::vector<int>& observation_rows() const {
+    return observation_rows_;
+  };
+  const std::vector<int>& observation_starts() const {
+    return observation_starts_;
+  };
+
+ private:
+  //---------------------
+  // Private Functions
+  //---------------------
+  void IndexObservations();
+  int num_rows() const {
+    return binned_features_.empty() ? xvalues_.nrow()
+                                    : binned_features_.num_rows();
+  };
+  MatrixSpan<const double> values_span() const {
+    return MatrixSpan<const double>(xvalues_.begin(), xvalues_.nrow(),
+                                    xvalues_.ncol());
+  };
+
+  //-------------------
+  // Private Variables
+  //-------------------
+  Rcpp::NumericMatrix xvalues_;
+  Rcpp::IntegerMatrix xorder_, intresponse_;
+  Rcpp::IntegerVector observationids_;
+  BinnedFeatures binned_features_;
+  unsigned long num_trainrows_;
+  std::vector<int> observation_rows_, observation_starts_;
+};
+
+#endif  // PREPAREDDATA_H
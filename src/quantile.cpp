@@ -10,6 +10,7 @@
 // Includes
 //-----------------------------------
 #include "quantile.h"
+#include "block_sums.h"
 
 //----------------------------------------
 // Function Members - Private
@@ -24,11 +25,11 @@ CQuantile::CQuantile(double alpha, const parallel_details& parallel)
 //----------------------------------------
 CDistribution* CQuantile::Create(DataDistParams& distparams) {
   // Check that misc exists
-  double alpha = Rcpp::as<double>(distparams.misc[0]);
-  if (!gbm_functions::has_value(alpha)) {
+  if (!gbm_functions::has_value(distparams.misc)) {
     throw gbm_exception::Failure(
         "Quantile dist requires misc to initialization.");
   }
+  const double alpha = distparams.misc[0];
   return new CQuantile(alpha, distparams.parallel);
 }
 
@@ -60,25 +61,34 @@ double CQuantile::InitF(const CDataset& kData) {
 
 double CQuantile::Deviance(const CDataset& kData, const Bag& kBag,
                            const double* kFuncEstimate) {
-  double loss = 0.0;
-  double weight = 0.0;
-
   // Switch to validation set if necessary
   unsigned long num_rows_in_set = kData.get_size_of_set();
 
-#pragma omp parallel for schedule(static, get_array_chunk_size()) \
-    reduction(+ : loss, weight) num_threads(get_num_threads())
-  for (unsigned long i = 0; i < num_rows_in_set; i++) {
-    if (kData.y_ptr()[i] > kFuncEstimate[i] + kData.offset_ptr()[i]) {
-      loss += kData.weight_ptr()[i] * alpha_ *
-              (kData.y_ptr()[i] - kFuncEstimate[i] - kData.offset_ptr()[i]);
-    } else {
-      loss += kData.weight_ptr()[i] * (1.0 - alpha_) *
-              (kFuncEstimate[i] + kData.offset_ptr()[i] - kData.y_ptr()[i]);
+  BlockSums sums(num_rows_in_set, 2);
+
+#pragma omp parallel for schedule( \
+    static, gbm_vector_math::BlocksPerChunk(get_array_chunk_size())) \
+    num_threads(get_num_threads())
+  for (unsigned long block = 0; block < sums.num_blocks(); block++) {
+    double loss = 0.0;
+    double weight = 0.0;
+    for (unsigned long i = sums.begin(block); i < sums.end(block); i++) {
+      if (kData.y_ptr()[i] > kFuncEstimate[i] + kData.offset_ptr()[i]) {
+        loss += kData.weight_ptr()[i] * alpha_ *
+                (kData.y_ptr()[i] - kFuncEstimate[i] - kData.offset_ptr()[i]);
+      } else {
+        loss += kData.weight_ptr()[i] * (1.0 - alpha_) *
+                (kFuncEstimate[i] + kData.offset_ptr()[i] - kData.y_ptr()[i]);
+      }
+      weight += kData.weight_ptr()[i];
     }
-    weight += kData.weight_ptr()[i];
+    sums(block, 0) = loss;
+    sums(block, 1) = weight;
   }
 
+  double loss = sums.Total(0);
+  double weight = sums.Total(1);
+
   // TODO: Check if weights are all zero for validation set
   if ((weight == 0.0) && (loss == 0.0)) {
     return nan("");
@@ -127,34 +137,44 @@ double CQuantile::BagImprovement(const CDataset& kData, const Bag& kBag,
                                  const double* kFuncEstimate,
                                  const double kShrinkage,
                                  const std::vector<double>& kDeltaEstimate) {
-  double returnvalue = 0.0;
-  double weight = 0.0;
-
-#pragma omp parallel for schedule(static, get_array_chunk_size()) \
-    reduction(+ : returnvalue, weight) num_threads(get_num_threads())
-  for (unsigned long i = 0; i < kData.get_trainsize(); i++) {
-    if (!kBag.get_element(i)) {
-      const double delta_func_est = kFuncEstimate[i] + kData.offset_ptr()[i];
-
-      if (kData.y_ptr()[i] > delta_func_est) {
-        returnvalue += kData.weight_ptr()[i] * alpha_ *
-                       (kData.y_ptr()[i] - delta_func_est);
-      } else {
-        returnvalue += kData.weight_ptr()[i] * (1 - alpha_) *
-                       (delta_func_est - kData.y_ptr()[i]);
-      }
+  BlockSums sums(kData.get_trainsize(), 2);
+
+#pragma omp parallel for schedule( \
+    static, gbm_vector_math::BlocksPerChunk(get_array_chunk_size())) \
+    num_threads(get_num_threads())
+  for (unsigned long block = 0; block < sums.num_blocks(); block++) {
+    double returnvalue = 0.0;
+    double weight = 0.0;
+    for (unsigned long i = sums.begin(block); i < sums.end(block); i++) {
+      if (!kBag.get_element(i)) {
+        const double delta_func_est = kFuncEstimate[i] + kData.offset_ptr()[i];
+
+        if (kData.y_ptr()[i] > delta_func_est) {
+          returnvalue += kData.weight_ptr()[i] * alpha_ *
+                         (kData.y_ptr()[i] - delta_func_est);
+        } else {
+          returnvalue += kData.weight_ptr()[i] * (1 - alpha_) *
+                         (delta_func_est - kData.y_ptr()[i]);
+        }
 
-      if (kData.y_ptr()[i] > delta_func_est + kShrinkage * kDeltaEstimate[i]) {
-        returnvalue -= kData.weight_ptr()[i] * alpha_ *
-                       (kData.y_ptr()[i] - delta_func_est -
-                        kShrinkage * kDeltaEstimate[i]);
-      } else {
-        returnvalue -= kData.weight_ptr()[i] * (1 - alpha_) *
-                       (delta_func_est + kShrinkage * kDeltaEstimate[i] -
-                        kData.y_ptr()[i]);
+        if (kData.y_ptr()[i] >
+            delta_func_est + kShrinkage * kDeltaEstimate[i]) {
+          returnvalue -= kData.weight_ptr()[i] * alpha_ *
+                         (kData.y_ptr()[i] - delta_func_est -
+                          kShrinkage * kDeltaEstimate[i]);
+        } else {
+          returnvalue -= kData.weight_ptr()[i] * (1 - alpha_) *
+                         (delta_func_est + kShrinkage * kDeltaEstimate[i] -
+                          kData.y_ptr()[i]);
+        }
+        weight += kData.weight_ptr()[i];
       }
-      weight += kData.weight_ptr()[i];
     }
+    sums(block, 0) = returnvalue;
+    sums(block, 1) = weight;
   }
+
+  double returnvalue = sums.Total(0);
+  double weight = sums.Total(1);
   return returnvalue / weight;
 }
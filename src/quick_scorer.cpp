@@ -0,0 +1,206 @@
+//-----------------------------------
+//
+// File: quick_scorer.cpp
+//
+// Description: bitvector (QuickScorer) prediction of models whose trees
+//   have few leaves.
+//
+//-----------------------------------
+
+//-----------------------------------
+// Includes
+//-----------------------------------
+#include "quick_scorer.h"
+#include "compiled_model.h"
+#include <algorithm>
+
+namespace {
+// Compares continuous splits by variable then split value.
+class SplitLess {
+ public:
+  explicit SplitLess(const CompiledModel& kModel) : kModel_(kModel) {}
+  bool operator()(int lhs, int rhs) const {
+    if (kModel_.split_var(lhs) != kModel_.split_var(rhs)) {
+      return kModel_.split_var(lhs) < kModel_.split_var(rhs);
+    }
+    return kModel_.split_value(lhs) < kModel_.split_value(rhs);
+  }
+
+ private:
+  const CompiledModel& kModel_;
+};
+}
+
+//----------------------------------------
+// Function Members - Public
+//----------------------------------------
+//-----------------------------------
+// Function: Initialize
+//
+// Returns: none
+//
+// Description: numbers the leaves of each tree left to right - left,
+//   right then missing child - and gathers the splits by variable.  A
+//   node going right rules out the leaves of its left child, one going
+//   missing those of its left and right children, so the leftmost leaf
+//   left once every node has been applied is the one the row reaches.
+//   Left empty if any tree has more than kMaxLeaves leaves.
+//
+// Parameters:
+//  kModel - the compiled model
+//-----------------------------------
+void QuickScorer::Initialize(const CompiledModel& kModel) {
+  std::vector<unsigned int> right_masks, missing_masks;
+  std::vector<int> tree_of_node;
+  std::vector<int> continuous_nodes;
+
+  for (int tree = 0; tree < kModel.num_trees(); tree++) {
+    leaf_begin_.push_back(leaf_values_.size());
+    const int kNumLeaves = AssignLeaves(kModel, kModel.tree_root(tree), 0,
+                                        right_masks, missing_masks);
+    if (kNumLeaves > kMaxLeaves) {
+      *this = QuickScorer();
+      return;
+    }
+    tree_of_node.resize(right_masks.size(), tree);
+  }
+
+  for (int node = 0; node < int(right_masks.size()); node++) {
+    if (kModel.split_var(node) == -1) continue;
+    if (kModel.is_categorical(node)) {
+      category_vars_.push_back(kModel.split_var(node));
+      category_trees_.push_back(tree_of_node[node]);
+      category_missing_masks_.push_back(missing_masks[node]);
+      level_begin_.push_back(level_masks_.size());
+      for (int level = 0; level < kModel.num_levels(node); level++) {
+        const int kChild = kModel.NextNode(node, level);
+        if (kChild == kModel.left_node(node)) {
+          level_masks_.push_back(~0u);
+        } else if (kChild == kModel.right_node(node)) {
+          level_masks_.push_back(right_masks[node]);
+        } else {
+          level_masks_.push_back(missing_masks[node]);
+        }
+      }
+    } else {
+      continuous_nodes.push_back(node);
+    }
+  }
+  level_begin_.push_back(level_masks_.size());
+
+  std::stable_sort(continuous_nodes.begin(), continuous_nodes.end(),
+                   SplitLess(kModel));
+  var_begin_.assign(kModel.num_vars() + 1, 0);
+  for (std::vector<int>::const_iterator node = continuous_nodes.begin();
+       node != continuous_nodes.end(); ++node) {
+    var_begin_[kModel.split_var(*node) + 1]++;
+    thresholds_.push_back(kModel.split_value(*node));
+    threshold_trees_.push_back(tree_of_node[*node]);
+    right_masks_.push_back(right_masks[*node]);
+    missing_masks_.push_back(missing_masks[*node]);
+  }
+  for (int var = 0; var < kModel.num_vars(); var++) {
+    var_begin_[var + 1] += var_begin_[var];
+  }
+}
+
+//-----------------------------------
+// Function: ScoreRow
+//
+// Returns: none
+//
+// Description: finds the leaves of each tree a row can reach.  The
+//   splits of a variable are applied in increasing order of split value
+//   until one sends the row left, which all of the later ones do too;
+//   categorical splits look up the leaves ruled out by the row's level.
+//
+// Parameters:
+//  kModel - the compiled model
+//  kCovariates - the predictor values, column-major
+//  num_rows - the number of rows of the data
+//  row - the row to score
+//  leaf_bits - set to the reachable leaves of each tree
+//-----------------------------------
+void QuickScorer::ScoreRow(const CompiledModel& kModel,
+                           const double* kCovariates, long num_rows,
+                           long row, unsigned int* leaf_bits) const {
+  std::fill(leaf_bits, leaf_bits + leaf_begin_.size(), ~0u);
+
+  for (int var = 0; var < kModel.num_vars(); var++) {
+    const unsigned long kEnd = var_begin_[var + 1];
+    unsigned long split = var_begin_[var];
+    if (split == kEnd) continue;
+
+    const double kXValue = kCovariates[var * num_rows + row];
+    if (gbm_platform::IsNA(kXValue)) {
+      for (; split < kEnd; split++) {
+        leaf_bits[threshold_trees_[split]] &= missing_masks_[split];
+      }
+    } else {
+      // not less than the split value, or NaN, goes right
+      for (; (split < kEnd) && !(kXValue < thresholds_[split]); split++) {
+        leaf_bits[threshold_trees_[split]] &= right_masks_[split];
+      }
+    }
+  }
+
+  for (unsigned long split = 0; split < category_vars_.size(); split++) {
+    const double kXValue = kCovariates[category_vars_[split] * num_rows + row];
+    const int kLevel = gbm_platform::IsNA(kXValue) ? -1 : (int)kXValue;
+    if ((kLevel < 0) ||
+        (level_begin_[split] + kLevel >= level_begin_[split + 1])) {
+      leaf_bits[category_trees_[split]] &= category_missing_masks_[split];
+    } else {
+      leaf_bits[category_trees_[split]] &=
+          level_masks_[level_begin_[split] + kLevel];
+    }
+  }
+}
+
+//----------------------------------------
+// Function Members - Private
+//----------------------------------------
+//-----------------------------------
+// Function: AssignLeaves
+//
+// Returns: the number of the first leaf after the node's subtree
+//
+// Description: numbers the leaves below a node left to right, storing the
+//   leaves ruled out by each node of the subtree going right and missing.
+//
+// Parameters:
+//  kModel - the compiled model
+//  node - the node
+//  first_leaf - the number of the node's leftmost leaf
+//  right_masks, missing_masks - grown to hold the masks of every node
+//-----------------------------------
+int QuickScorer::AssignLeaves(const CompiledModel& kModel, int node,
+                              int first_leaf,
+                              std::vector<unsigned int>& right_masks,
+                              std::vector<unsigned int>& missing_masks) {
+  if (int(right_masks.size()) <= node) {
+    right_masks.resize(node + 1, ~0u);
+    missing_masks.resize(node + 1, ~0u);
+  }
+
+  if (kModel.split_var(node) == -1) {
+    if (first_leaf < kMaxLeaves) {
+      leaf_values_.push_back(kModel.split_value(node));
+    }
+    return first_leaf + 1;
+  }
+
+  const int kRightLeaf = AssignLeaves(kModel, kModel.left_node(node),
+                                      first_leaf, right_masks, missing_masks);
+  const int kMissingLeaf = AssignLeaves(kModel, kModel.right_node(node),
+                                        kRightLeaf, right_masks,
+                                        missing_masks);
+  const int kEndLeaf =
+      AssignLeaves(kModel, kModel.missing_node(node), kMissingLeaf,
+                   right_masks, missing_masks);
+  if (kEndLeaf <= kMaxLeaves) {
+    right_masks[node] = ~LeafRange(first_leaf, kRightLeaf);
+    missing_masks[node] = ~LeafRange(first_leaf, kMissingLeaf);
+  }
+  return kEndLeaf;
+}
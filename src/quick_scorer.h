@@ -0,0 +1,104 @@
+//------------------------------------------------------------------------------
+//
+//  File:       quick_scorer.h
+//
+//  Description: header for the QuickScorer prediction of small trees.
+//    Each tree keeps a bitvector of the leaves that can still be reached;
+//    the nodes of every tree are visited feature by feature in order of
+//    their split values, each clearing the leaves it rules out, and a
+//    tree's prediction is its leftmost remaining leaf.
+//
+//------------------------------------------------------------------------------
+
+#ifndef QUICKSCORER_H
+#define QUICKSCORER_H
+
+//------------------------------
+// Includes
+//------------------------------
+#include <vector>
+
+class CompiledModel;
+
+//------------------------------
+// Class definition
+//------------------------------
+class QuickScorer {
+ public:
+  //----------------------
+  // Public Constructors
+  //----------------------
+  QuickScorer(){};
+
+  //---------------------
+  // Public destructor
+  //---------------------
+  ~QuickScorer(){};
+
+  //---------------------
+  // Public Functions
+  //---------------------
+  // trees with more leaves than this are not scored
+  static const int kMaxLeaves = 32;
+
+  void Initialize(const CompiledModel& kModel);
+  bool empty() const { return leaf_begin_.empty(); };
+
+  // sets the reachable leaves of each tree for a row of column-major data
+  void ScoreRow(const CompiledModel& kModel, const double* kCovariates,
+                long num_rows, long row, unsigned int* leaf_bits) const;
+
+  // prediction of a tree from its reachable leaves
+  double leaf_value(int tree, unsigned int leaf_bits) const {
+    return leaf_values_[leaf_begin_[tree] + LowestBit(leaf_bits)];
+  };
+
+ private:
+  //---------------------
+  // Private Functions
+  //---------------------
+  int AssignLeaves(const CompiledModel& kModel, int node, int first_leaf,
+                   std::vector<unsigned int>& right_masks,
+                   std::vector<unsigned int>& missing_masks);
+
+  static unsigned int LeafRange(int begin, int end) {
+    const unsigned int kBits =
+        (end - begin == kMaxLeaves) ? ~0u : ((1u << (end - begin)) - 1u);
+    return kBits << begin;
+  };
+
+  static int LowestBit(unsigned int bits) {
+#if defined(__GNUC__)
+    return __builtin_ctz(bits);
+#else
+    int bit = 0;
+    while (!(bits & 1u)) {
+      bits >>= 1;
+      bit++;
+    }
+    return bit;
+#endif
+  };
+
+  //-------------------
+  // Private Variables
+  //-------------------
+  // leaves of each tree, left to right
+  std::vector<unsigned long> leaf_begin_;
+  std::vector<double> leaf_values_;
+
+  // continuous splits of each variable in increasing order of split value,
+  // with the leaves they rule out going right and going missing
+  std::vector<unsigned long> var_begin_;
+  std::vector<double> thresholds_;
+  std::vector<int> threshold_trees_;
+  std::vector<unsigned int> right_masks_, missing_masks_;
+
+  // categorical splits, checked for every row, with the leaves each level
+  // rules out - levels not seen in training go missing
+  std::vector<int> category_vars_, category_trees_;
+  std::vector<unsigned long> level_begin_;
+  std::vector<unsigned int> level_masks_, category_missing_masks_;
+};
+
+#endif  // QUICKSCORER_H
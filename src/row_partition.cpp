@@ -0,0 +1,180 @@
+//-----------------------------------
+//
+// File: row_partition.cpp
+//
+// Description: keeps the training rows of each terminal node in
+//   contiguous ranges so that splitting a node only touches its rows.
+//
+//-----------------------------------
+
+//-----------------------------------
+// Includes
+//-----------------------------------
+#include "row_partition.h"
+#include "trace.h"
+
+//----------------------------------------
+// Function Members - Public
+//----------------------------------------
+//-----------------------------------
+// Function: RowPartition
+//
+// Returns: none
+//
+// Description: puts all of the training rows in the root node.
+//
+// Parameters:
+//  kData - the dataset the tree is grown on
+//  kBag - the rows in bag for this tree
+//  max_num_nodes - the maximum number of terminal nodes in the tree
+//  parallel - parallelization-related constants
+//-----------------------------------
+RowPartition::RowPartition(const CDataset& kData, const Bag& kBag,
+                           unsigned long max_num_nodes,
+                           const parallel_details& parallel)
+    : rows_(kData.get_trainsize()),
+      row_begin_(max_num_nodes, 0),
+      row_end_(max_num_nodes, 0),
+      bag_begin_(max_num_nodes, 0),
+      bag_end_(max_num_nodes, 0),
+      num_vars_(kData.ncol()),
+      parallel_(parallel) {
+  for (unsigned long row = 0; row < kData.get_trainsize(); row++) {
+    rows_[row] = row;
+    if (kBag.get_element(row)) {
+      bag_rows_.push_back(row);
+    }
+  }
+  row_end_[0] = rows_.size();
+  bag_end_[0] = bag_rows_.size();
+
+  // the histogram split search does not need the rows in order
+  if (kData.has_bins()) {
+    num_vars_ = 0;
+    return;
+  }
+
+  ordered_rows_.resize(num_vars_ * bag_rows_.size());
+#pragma omp parallel for schedule(static) num_threads(get_num_threads())
+  for (unsigned long var = 0; var < num_vars_; var++) {
+    const int* kOrder = kData.order_ptr() + var * kData.get_trainsize();
+    int* ordered = &ordered_rows_[var * bag_rows_.size()];
+    for (unsigned long ind = 0; ind < kData.get_trainsize(); ind++) {
+      if (kBag.get_element(kOrder[ind])) {
+        *ordered++ = kOrder[ind];
+      }
+    }
+  }
+}
+
+//-----------------------------------
+// Function: Split
+//
+// Returns: none
+//
+// Description: moves the rows of a node that has just been split into
+//   the ranges of its children.  The left child keeps the node's index.
+//   Called by every thread of a parallel region, which share the sorted
+//   rows of the variables.
+//
+// Parameters:
+//  node - index of the node split, and of its left child
+//  right_node - index of the right child
+//  missing_node - index of the missing child
+//  kDataNodeAssigns - the terminal node of each training row, already
+//                     updated for the split
+//-----------------------------------
+void RowPartition::Split(unsigned long node, unsigned long right_node,
+                         unsigned long missing_node,
+                         const std::vector<unsigned long>& kDataNodeAssigns) {
+  // the sorted rows of each variable split the same way
+  {
+    TraceScope region_scope("partition sorted rows");
+    const unsigned long kBagBegin = bag_begin_[node];
+    const unsigned long kBagEnd = bag_end_[node];
+    std::vector<int> var_buffer;
+    unsigned long var_left = 0, var_right = 0;
+
+#pragma omp for schedule(static)
+    for (unsigned long var = 0; var < num_vars_; var++) {
+      int* ordered = &ordered_rows_[var * bag_rows_.size()];
+      PartitionRange(ordered + kBagBegin, ordered + kBagEnd, node, right_node,
+                     kDataNodeAssigns, var_buffer, var_left, var_right);
+    }
+  }
+
+#pragma omp single
+  {
+    std::vector<int> buffer;
+    unsigned long num_left = 0, num_right = 0;
+
+    PartitionRange(&rows_[0] + row_begin_[node], &rows_[0] + row_end_[node],
+                   node, right_node, kDataNodeAssigns, buffer, num_left,
+                   num_right);
+    row_begin_[right_node] = row_begin_[node] + num_left;
+    row_begin_[missing_node] = row_end_[right_node] =
+        row_begin_[right_node] + num_right;
+    row_end_[missing_node] = row_end_[node];
+    row_end_[node] = row_begin_[right_node];
+
+    const unsigned long kBagBegin = bag_begin_[node];
+    const unsigned long kBagEnd = bag_end_[node];
+    PartitionRange(&bag_rows_[0] + kBagBegin, &bag_rows_[0] + kBagEnd, node,
+                   right_node, kDataNodeAssigns, buffer, num_left, num_right);
+    bag_begin_[right_node] = kBagBegin + num_left;
+    bag_begin_[missing_node] = bag_end_[right_node] =
+        bag_begin_[right_node] + num_right;
+    bag_end_[missing_node] = kBagEnd;
+    bag_end_[node] = bag_begin_[right_node];
+  }
+}
+
+//----------------------------------------
+// Function Members - Private
+//----------------------------------------
+//-----------------------------------
+// Function: PartitionRange
+//
+// Returns: none
+//
+// Description: stable partition of a range of rows into those in the
+//   left, right and missing children, in that order.
+//
+// Parameters:
+//  begin, end - the range of rows
+//  node - index of the left child
+//  right_node - index of the right child
+//  kDataNodeAssigns - the terminal node of each training row
+//  buffer - scratch space
+//  num_left, num_right - set to the number of rows in the left and right
+//                        children
+//-----------------------------------
+void RowPartition::PartitionRange(
+    int* begin, int* end, unsigned long node, unsigned long right_node,
+    const std::vector<unsigned long>& kDataNodeAssigns,
+    std::vector<int>& buffer, unsigned long& num_left,
+    unsigned long& num_right) const {
+  num_left = num_right = 0;
+  for (int* row = begin; row != end; ++row) {
+    if (kDataNodeAssigns[*row] == node) {
+      num_left++;
+    } else if (kDataNodeAssigns[*row] == right_node) {
+      num_right++;
+    }
+  }
+
+  buffer.assign(begin, end);
+  int* left = begin;
+  int* right = begin + num_left;
+  int* missing = right + num_right;
+  for (std::vector<int>::const_iterator row = buffer.begin();
+       row != buffer.end(); ++row) {
+    if (kDataNodeAssigns[*row] == node) {
+      *left++ = *row;
+    } else if (kDataNodeAssigns[*row] == right_node) {
+      *right++ = *row;
+    } else {
+      *missing++ = *row;
+    }
+  }
+}
@@ -0,0 +1,98 @@
+//------------------------------------------------------------------------------
+//
+//  File:       row_partition.h
+//
+//  Description: header for the per-node partition of the training rows
+//    used while growing a tree.
+//
+//------------------------------------------------------------------------------
+
+#ifndef ROWPARTITION_H
+#define ROWPARTITION_H
+
+//------------------------------
+// Includes
+//------------------------------
+#include "databag.h"
+#include "dataset.h"
+#include "parallel_details.h"
+#include <vector>
+
+//------------------------------
+// Class definition
+//------------------------------
+class RowPartition {
+ public:
+  //----------------------
+  // Public Constructors
+  //----------------------
+  RowPartition(const CDataset& kData, const Bag& kBag,
+               unsigned long max_num_nodes, const parallel_details& parallel);
+
+  //---------------------
+  // Public destructor
+  //---------------------
+  ~RowPartition(){};
+
+  //---------------------
+  // Public Functions
+  //---------------------
+  void Split(unsigned long node, unsigned long right_node,
+             unsigned long missing_node,
+             const std::vector<unsigned long>& kDataNodeAssigns);
+
+  // all of the training rows in a node
+  unsigned long num_rows(unsigned long node) const {
+    return row_end_[node] - row_begin_[node];
+  };
+  const int* rows(unsigned long node) const {
+    return &rows_[0] + row_begin_[node];
+  };
+
+  // the in bag training rows in a node
+  unsigned long num_bag_rows(unsigned long node) const {
+    return bag_end_[node] - bag_begin_[node];
+  };
+  const int* bag_rows(unsigned long node) const {
+    return &bag_rows_[0] + bag_begin_[node];
+  };
+
+  // the in bag training rows in a node sorted by a variable - only
+  // available when the data are not binned
+  const int* ordered_rows(int var, unsigned long node) const {
+    return &ordered_rows_[var * bag_rows_.size() + bag_begin_[node]];
+  };
+
+  // the memory held by the partition
+  unsigned long allocated_bytes() const {
+    return (rows_.capacity() + bag_rows_.capacity() +
+            ordered_rows_.capacity()) * sizeof(int) +
+           (row_begin_.capacity() + row_end_.capacity() +
+            bag_begin_.capacity() + bag_end_.capacity()) *
+               sizeof(unsigned long);
+  };
+
+ private:
+  //---------------------
+  // Private Functions
+  //---------------------
+  void PartitionRange(int* begin, int* end, unsigned long node,
+                      unsigned long right_node,
+                      const std::vector<unsigned long>& kDataNodeAssigns,
+                      std::vector<int>& buffer, unsigned long& num_left,
+                      unsigned long& num_right) const;
+
+  int get_num_threads() const { return parallel_.get_num_threads(); }
+
+  //-------------------
+  // Private Variables
+  //-------------------
+  std::vector<int> rows_, bag_rows_, ordered_rows_;
+  std::vector<unsigned long> row_begin_, row_end_, bag_begin_, bag_end_;
+  unsigned long num_vars_;
+
+  // parallelization
+  parallel_details parallel_;
+};
+
+#endif  // ROWPARTITION_H
@@ -0,0 +1,75 @@
+//------------------------------------------------------------------------------
+//
+//  File:       span.h
+//
+//  Description: views of vectors and column-major matrices held by the
+//    caller - the engine reads its data through these rather than the
+//    containers of its host, which must keep the data alive while in use.
+//
+//------------------------------------------------------------------------------
+
+#ifndef SPAN_H
+#define SPAN_H
+
+//------------------------------
+// Includes
+//------------------------------
+#include <cstddef>
+
+//------------------------------
+// Class definitions
+//------------------------------
+template <typename T>
+class Span {
+ public:
+  //----------------------
+  // Public Constructors
+  //----------------------
+  Span() : data_(NULL), size_(0){};
+  Span(T* data, long size) : data_(data), size_(size){};
+
+  //---------------------
+  // Public Functions
+  //---------------------
+  T* begin() const { return data_; };
+  T* end() const { return data_ + size_; };
+  long size() const { return size_; };
+  bool empty() const { return size_ == 0; };
+  T& operator[](long index) const { return data_[index]; };
+
+ private:
+  //-------------------
+  // Private Variables
+  //-------------------
+  T* data_;
+  long size_;
+};
+
+template <typename T>
+class MatrixSpan {
+ public:
+  //----------------------
+  // Public Constructors
+  //----------------------
+  MatrixSpan() : data_(NULL), nrow_(0), ncol_(0){};
+  MatrixSpan(T* data, int nrow, int ncol)
+      : data_(data), nrow_(nrow), ncol_(ncol){};
+
+  //---------------------
+  // Public Functions
+  //---------------------
+  T* begin() const { return data_; };
+  int nrow() const { return nrow_; };
+  int ncol() const { return ncol_; };
+  T* column(int col) const { return data_ + (long)col * nrow_; };
+  T& operator()(int row, int col) const { return column(col)[row]; };
+
+ private:
+  //-------------------
+  // Private Variables
+  //-------------------
+  T* data_;
+  int nrow_, ncol_;
+};
+
+#endif  // SPAN_H
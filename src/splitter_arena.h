@@ -0,0 +1,41 @@
+//------------------------------------------------------------------------------
+//
+//  File:       splitter_arena.h
+//
+//  Description: scratch space of the split searches of a thread, kept from
+//    one search to the next so that searching does not allocate.
+//
+//------------------------------------------------------------------------------
+
+#ifndef SPLITTER_ARENA_H
+#define SPLITTER_ARENA_H
+
+//------------------------------
+// Includes
+//------------------------------
+#include "node_parameters.h"
+#include <utility>
+#include <vector>
+
+//------------------------------
+// Struct definition
+//------------------------------
+struct SplitterArena {
+  //-------------------
+  // Public Variables
+  //-------------------
+  //  groups - the totals of each category of a categorical variable
+  //  group_means - the categories ordered by their mean residual
+  std::vector<NodeDef> groups;
+  std::vector<std::pair<double, int> > group_means;
+
+  std::size_t allocated_bytes() const {
+    return groups.capacity() * sizeof(NodeDef) +
+           group_means.capacity() * sizeof(std::pair<double, int>);
+  };
+};
+
+// an arena for each thread, indexed by its number in the team
+typedef std::vector<SplitterArena> SplitterArenas;
+
+#endif  // SPLITTER_ARENA_H
@@ -1,7 +1,6 @@
 #ifndef SPLITTER_STRATEGIES_H
 #define SPLITTER_STRATEGIES_H
 
-#include "presplit_splitter_strategy.h"
 #include "cts_splitter_strategy.h"
 #include "categorical_splitter_strategy.h"
 
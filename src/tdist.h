@@ -59,7 +59,7 @@ class CTDist : public CDistribution {
   //----------------------
   // Private Constructors
   //----------------------
-  CTDist(double nu);
+  CTDist(const parallel_details& parallel, double nu);
 
   //-------------------
   // Private Variables
@@ -0,0 +1,128 @@
+//-----------------------------------
+//
+// File: trace.cpp
+//
+// Description: the per thread event buffers of the tracer and their
+//   Chrome trace.
+//
+//-----------------------------------
+
+//-----------------------------------
+// Includes
+//-----------------------------------
+#include "trace.h"
+#include "gbm_exception.h"
+#include "parallel_details.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace {
+// events kept per thread - 2.5MB of each thread's latest events
+const unsigned long kEventsPerThread = 1UL << 16;
+
+struct Event {
+  const char* name;
+  const char* arg_name;
+  long arg;
+  double start;
+  double end;
+};
+
+// a thread's ring of events, padded so that threads recording at once do
+// not share cache lines
+struct ThreadEvents {
+  ThreadEvents() : num_recorded(0) {
+    std::memset(padding, 0, sizeof(padding));
+  }
+  std::vector<Event> ring;
+  unsigned long num_recorded;
+  char padding[64];
+};
+
+bool is_enabled = false;
+double start_time = 0.0;
+std::vector<ThreadEvents> thread_events;
+}
+
+// Function that starts recording, with a ring for each thread.
+void gbm_trace::Start(int num_threads) {
+  thread_events.assign(num_threads, ThreadEvents());
+  for (int thread = 0; thread < num_threads; thread++) {
+    thread_events[thread].ring.resize(kEventsPerThread);
+  }
+  start_time = gbm_platform::MonotonicSeconds();
+  is_enabled = true;
+}
+
+// Function that stops recording - the events are kept until the next
+// start.
+void gbm_trace::Stop() { is_enabled = false; }
+
+// Function that says whether events are being recorded.
+bool gbm_trace::IsEnabled() { return is_enabled; }
+
+// Function that records an event in the ring of the calling thread - only
+// that thread writes to it.
+void gbm_trace::Record(const char* kName, double start, double end,
+                       const char* kArgName, long arg) {
+  const int kThread = ThreadNumber();
+  if (!is_enabled || (kThread >= int(thread_events.size()))) return;
+
+  ThreadEvents& events = thread_events[kThread];
+  Event& event = events.ring[events.num_recorded % kEventsPerThread];
+  event.name = kName;
+  event.arg_name = kArgName;
+  event.arg = arg;
+  event.start = start;
+  event.end = end;
+  events.num_recorded++;
+}
+
+// Function that writes the events of each thread, oldest first, as
+// complete events in microseconds from the start of recording.
+void gbm_trace::Write(const std::string& kPath) {
+  std::FILE* out = std::fopen(kPath.c_str(), "w");
+  if (out == NULL) {
+    throw gbm_exception::Failure("cannot open trace file " + kPath);
+  }
+
+  unsigned long num_dropped = 0;
+  std::fprintf(out, "{\"traceEvents\":[\n");
+  for (unsigned long thread = 0; thread < thread_events.size(); thread++) {
+    std::fprintf(out,
+                 "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+                 "\"tid\":%lu,\"args\":{\"name\":\"thread %lu\"}}",
+                 thread ? ",\n" : "", thread, thread);
+  }
+
+  for (unsigned long thread = 0; thread < thread_events.size(); thread++) {
+    const ThreadEvents& kEvents = thread_events[thread];
+    unsigned long first = 0;
+    if (kEvents.num_recorded > kEventsPerThread) {
+      first = kEvents.num_recorded - kEventsPerThread;
+      num_dropped += first;
+    }
+    for (unsigned long ind = first; ind < kEvents.num_recorded; ind++) {
+      const Event& kEvent = kEvents.ring[ind % kEventsPerThread];
+      std::fprintf(out,
+                   ",\n{\"name\":\"%s\",\"cat\":\"gbm\",\"ph\":\"X\","
+                   "\"pid\":1,\"tid\":%lu,\"ts\":%.3f,\"dur\":%.3f",
+                   kEvent.name, thread, 1e6 * (kEvent.start - start_time),
+                   1e6 * (kEvent.end - kEvent.start));
+      if (kEvent.arg_name) {
+        std::fprintf(out, ",\"args\":{\"%s\":%ld}", kEvent.arg_name,
+                     kEvent.arg);
+      }
+      std::fprintf(out, "}");
+    }
+  }
+  std::fprintf(out,
+               "\n],\n\"displayTimeUnit\":\"ms\",\n"
+               "\"otherData\":{\"dropped_events\":%lu}}\n",
+               num_dropped);
+
+  if (std::fclose(out) != 0) {
+    throw gbm_exception::Failure("cannot write trace file " + kPath);
+  }
+}
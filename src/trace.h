@@ -0,0 +1,97 @@
+//------------------------------------------------------------------------------
+//
+//  File:       trace.h
+//
+//  Description: an optional tracer of what each thread does while fitting,
+//    written as a Chrome trace that chrome://tracing or Perfetto display
+//    as a timeline per thread.  Each thread records into a ring buffer of
+//    its own, so recording takes no locks; the oldest events of a thread
+//    are overwritten once its buffer is full.
+//
+//------------------------------------------------------------------------------
+
+#ifndef TRACE_H
+#define TRACE_H
+
+//------------------------------
+// Includes
+//------------------------------
+#include "gbm_platform.h"
+#include <string>
+
+namespace gbm_trace {
+// starts recording events from up to num_threads threads, dropping any
+// recorded before
+void Start(int num_threads);
+
+// stops recording
+void Stop();
+
+bool IsEnabled();
+
+// records a span of a thread's time - names are string literals, the
+// argument is shown when arg_name is not NULL
+void Record(const char* kName, double start, double end,
+            const char* kArgName = NULL, long arg = 0);
+
+// writes the events recorded as a Chrome trace
+void Write(const std::string& kPath);
+}
+
+//------------------------------
+// Class definitions
+//------------------------------
+// records its lifetime as an event of the thread that made it
+class TraceScope {
+ public:
+  explicit TraceScope(const char* kName, const char* kArgName = NULL,
+                      long arg = 0)
+      : kName_(kName),
+        kArgName_(kArgName),
+        arg_(arg),
+        start_(gbm_trace::IsEnabled() ? gbm_platform::MonotonicSeconds()
+                                      : -1.0){};
+  ~TraceScope() {
+    if (start_ >= 0.0) {
+      gbm_trace::Record(kName_, start_, gbm_platform::MonotonicSeconds(),
+                        kArgName_, arg_);
+    }
+  };
+
+ private:
+  TraceScope(const TraceScope&);
+  TraceScope& operator=(const TraceScope&);
+
+  const char* kName_;
+  const char* kArgName_;
+  long arg_;
+  double start_;
+};
+
+// traces from construction to destruction, writing the events to a file
+// on Finish - nothing is traced without a file
+class TraceSession {
+ public:
+  TraceSession(const std::string& kPath, int num_threads) : path_(kPath) {
+    if (!path_.empty()) gbm_trace::Start(num_threads);
+  };
+  ~TraceSession() {
+    if (!path_.empty()) gbm_trace::Stop();
+  };
+
+  void Finish() {
+    if (!path_.empty()) {
+      gbm_trace::Stop();
+      gbm_trace::Write(path_);
+      path_.clear();
+    }
+  };
+
+ private:
+  TraceSession(const TraceSession&);
+  TraceSession& operator=(const TraceSession&);
+
+  std::string path_;
+};
+
+#endif  // TRACE_H
@@ -8,13 +8,13 @@
 //----------------------------------------
 // Function Members - Public
 //----------------------------------------
-CCARTTree::CCARTTree(const TreeParams& treeconfig)
+CCARTTree::CCARTTree(const TreeParams& treeconfig, NodeArena& nodes)
     : min_num_node_obs_(treeconfig.min_obs_in_node),
       kTreeDepth_(treeconfig.depth),
       kShrinkage_(treeconfig.shrinkage),
       error_(0.0),
       totalnodecount_(1),
-      rootnode_(),
+      nodes_(nodes),
       terminalnode_ptrs_(2 * kTreeDepth_ + 1, 0),
       data_node_assignment_(treeconfig.num_trainrows, 0),
       parallel_(treeconfig.parallel) {
@@ -24,16 +24,19 @@ CCARTTree::CCARTTree(const TreeParams& treeconfig)
 }
 
 //------------------------------------------------------------------------------
-// Grows a regression tree
+// Grows a regression tree, searching with the threads' arenas - with
+// timings, times its split searches and reassignments and counts their work
 //------------------------------------------------------------------------------
 void CCARTTree::Grow(const std::vector<double>& residuals,
 		     const CDataset& kData,
                      const Bag& kBag,
-                     const std::vector<double>& kDeltaEstimate) {
+                     const std::vector<double>& kDeltaEstimate,
+                     SplitterArenas& arenas, FitTimings* timings) {
   if ((residuals.size() < kData.get_trainsize()) ||
       (kDeltaEstimate.size() < kData.get_trainsize())) {
     throw gbm_exception::InvalidArgument();
   }
+  PhaseTimer root_timer(timings, kSplitSearchPhase);
 
   double sumz = 0.0;
   double sum_zsquared = 0.0;
@@ -51,43 +54,97 @@ void CCARTTree::Grow(const std::vector<double>& residuals,
   }
 
   error_ = sum_zsquared - sumz * sumz / totalw;
-  rootnode_.reset(new CNode(NodeDef(sumz, totalw, kBag.get_total_in_bag())));
-  terminalnode_ptrs_[0] = rootnode_.get();
-  CNodeSearch new_node_searcher(kTreeDepth_, min_num_node_obs_, parallel_);
-
-  // build the tree structure
-  for (long cDepth = 0; cDepth < kTreeDepth_; cDepth++) {
-    // Generate all splits
-    new_node_searcher.GenerateAllSplits(terminalnode_ptrs_, kData, kBag,
-                                        residuals, data_node_assignment_);
-    double bestImprov = new_node_searcher.CalcImprovementAndSplit(
-        terminalnode_ptrs_, kData, data_node_assignment_);
-
-    // Make the best split if possible
-    if (bestImprov <= 0) {
-      break;
-    }
-    // setup the new nodes and add them to the tree
+  // each split adds three nodes to the root
+  nodes_.Reset(1 + 3 * kTreeDepth_);
+  terminalnode_ptrs_[0] =
+      nodes_.AddNode(NodeDef(sumz, totalw, kBag.get_total_in_bag()));
+  CNodeSearch new_node_searcher(kData, kBag, kTreeDepth_, min_num_node_obs_,
+                                parallel_, arenas, nodes_);
+  root_timer.Stop();
+
+  // build the tree structure - one team of threads grows the whole tree,
+  // sharing the search and reassignment of each depth
+#pragma omp parallel num_threads(parallel_.get_num_threads())
+  {
+    FitTimings* thread_timings = (ThreadNumber() == 0) ? timings : NULL;
+    for (long cDepth = 0; cDepth < kTreeDepth_; cDepth++) {
+      // Generate all splits
+      PhaseTimer search_timer(thread_timings, kSplitSearchPhase);
+      new_node_searcher.GenerateAllSplits(terminalnode_ptrs_, kData,
+                                          residuals);
+      search_timer.Stop();
+
+      PhaseTimer reassign_timer(thread_timings, kReassignPhase);
+      double bestImprov = new_node_searcher.CalcImprovementAndSplit(
+          terminalnode_ptrs_, kData, data_node_assignment_);
+      reassign_timer.Stop();
 
-    totalnodecount_ += 3;
+      // Make the best split if possible
+      if (bestImprov <= 0) {
+        break;
+      }
+    }  // end tree growing
+  }
+  if (!new_node_searcher.failure().empty()) {
+    throw gbm_exception::Failure(new_node_searcher.failure());
+  }
+  totalnodecount_ = nodes_.size();
 
-  }  // end tree growing
+  if (timings) {
+    timings->rows_scanned += new_node_searcher.rows_scanned();
+    timings->nodes_searched += new_node_searcher.nodes_searched();
+    timings->bytes_allocated +=
+        new_node_searcher.allocated_bytes() +
+        terminalnode_ptrs_.capacity() * sizeof(CNode*) +
+        data_node_assignment_.capacity() * sizeof(unsigned long) +
+        nodes_.allocated_bytes();
+  }
   // DEBUG
   // Print();
 }
 
-void CCARTTree::PredictValid(const CDataset& kData,
-                             unsigned long num_validation_points,
-                             std::vector<double>& delta_estimates) {
-  unsigned int i = 0;
-  for (i = kData.nrow() - num_validation_points; i < kData.nrow(); i++) {
-    rootnode_->Predict(kData, i, delta_estimates[i]);
-    delta_estimates[i] *= kShrinkage_;
+void CCARTTree::UpdateFit(const CDataset& kData,
+                          const std::vector<double>& kDeltaEstimates,
+                          double* func_estimate,
+                          unsigned long first_row) const {
+  const unsigned long kTrainSize = kData.get_trainsize();
+  const unsigned long kNumRows = kTrainSize + kData.get_validsize();
+#pragma omp parallel for schedule(static, get_array_chunk_size()) \
+  num_threads(get_num_threads())
+  for (unsigned long i = first_row; i < kNumRows; i++) {
+    if (i < kTrainSize) {
+      func_estimate[i] += kShrinkage_ * kDeltaEstimates[i];
+    } else {
+      func_estimate[i] += kShrinkage_ * PredictRow(kData, i);
+    }
   }
 }
 
+// sets the prediction of each split node to the weighted mean of its
+// children's, visiting the children first as they follow their parents
 void CCARTTree::Adjust(std::vector<double>& delta_estimates) {
-  rootnode_->Adjust(min_num_node_obs_);
+  for (unsigned long node_num = nodes_.size(); node_num-- > 0;) {
+    CNode& node = nodes_[node_num];
+    if (!node.is_split()) continue;
+
+    const CNode& kLeft = nodes_[node.left_child()];
+    const CNode& kRight = nodes_[node.right_child()];
+    CNode& missing = nodes_[node.missing_child()];
+    if (missing.is_split() && (missing.get_numobs() < min_num_node_obs_)) {
+      node.set_prediction(
+          (kLeft.get_totalweight() * kLeft.get_prediction() +
+           kRight.get_totalweight() * kRight.get_prediction()) /
+          (kLeft.get_totalweight() + kRight.get_totalweight()));
+      missing.set_prediction(node.get_prediction());
+    } else {
+      node.set_prediction(
+          (kLeft.get_totalweight() * kLeft.get_prediction() +
+           kRight.get_totalweight() * kRight.get_prediction() +
+           missing.get_totalweight() * missing.get_prediction()) /
+          (kLeft.get_totalweight() + kRight.get_totalweight() +
+           missing.get_totalweight()));
+    }
+  }
 
   // predict for the training observations
   for (unsigned long obs_num = 0; obs_num < data_node_assignment_.size();
@@ -98,11 +155,40 @@ void CCARTTree::Adjust(std::vector<double>& delta_estimates) {
 }
 
 void CCARTTree::Print() {
-  if (rootnode_.get() != 0) {
-    rootnode_->PrintSubtree(0);
-    Rprintf("shrinkage: %f\n", kShrinkage_);
-    Rprintf("initial error: %f\n\n", error_);
+  if (nodes_.size() == 0) return;
+
+  // the nodes still to print, each with its depth and the branch of its
+  // parent that leads to it - 0 for the root
+  std::vector<PrintVisit> stack(1, PrintVisit(0, 0, 0, 0));
+  while (!stack.empty()) {
+    const PrintVisit kVisit = stack.back();
+    stack.pop_back();
+
+    if (kVisit.depth > 0) {
+      PrintBranch(nodes_[kVisit.parent], kVisit.branch, kVisit.depth - 1);
+    }
+    const CNode& kNode = nodes_[kVisit.node];
+    for (unsigned long i = 0; i < kVisit.depth; i++) gbm_platform::Printf("  ");
+    if (!kNode.is_split()) {
+      gbm_platform::Printf("N=%f, Prediction=%f *\n", kNode.get_totalweight(),
+                           kNode.get_prediction());
+      continue;
+    }
+    gbm_platform::Printf("N=%f, Improvement=%f, Prediction=%f, NA pred=%f\n",
+                         kNode.get_totalweight(), kNode.get_improvement(),
+                         kNode.get_prediction(),
+                         nodes_[kNode.missing_child()].get_prediction());
+
+    // pushed in reverse so that left is printed first
+    stack.push_back(PrintVisit(kNode.missing_child(), kVisit.depth + 1,
+                               kVisit.node, 2));
+    stack.push_back(PrintVisit(kNode.right_child(), kVisit.depth + 1,
+                               kVisit.node, 1));
+    stack.push_back(PrintVisit(kNode.left_child(), kVisit.depth + 1,
+                               kVisit.node, 0));
   }
+  gbm_platform::Printf("shrinkage: %f\n", kShrinkage_);
+  gbm_platform::Printf("initial error: %f\n\n", error_);
 }
 
 //-----------------------------------
@@ -110,9 +196,15 @@ void CCARTTree::Print() {
 //
 // Returns: none
 //
-// Description:
+// Description: writes the nodes in preorder - each node, then its left,
+//   right and missing subtrees - and the left categories of categorical
+//   splits, -1 for left and 1 for right, to splitcodes_vec.
 //
 // Parameters:
+//  kData - the data the tree was fitted to
+//  splitvar ... predictions - the node arrays, of size_of_tree() entries
+//  splitcodes_vec - the categorical splits, added to
+//  prev_categorical_splits - the categorical splits of earlier trees
 //
 //-----------------------------------
 void CCARTTree::TransferTreeToRList(const CDataset& kData, int* splitvar,
@@ -122,14 +214,93 @@ void CCARTTree::TransferTreeToRList(const CDataset& kData, int* splitvar,
                                     double* predictions,
                                     VecOfVectorCategories& splitcodes_vec,
                                     int prev_categorical_splits) {
-  int nodeid = 0;
-  if (rootnode_.get() != 0) {
-    rootnode_->TransferTreeToRList(
-        nodeid, kData, splitvar, splitvalues, leftnodes, rightnodes,
-        missingnodes, error_reduction, weights, predictions, splitcodes_vec,
-        prev_categorical_splits, kShrinkage_);
-  } else {
+  if (nodes_.size() == 0) {
     throw gbm_exception::Failure(
         "Can't transfer to list - RootNode does not exist.");
   }
+
+  // the nodes still to write, each with the child array of its parent to
+  // give its number in
+  std::vector<std::pair<unsigned long, int*> > stack(
+      1, std::make_pair(0UL, static_cast<int*>(NULL)));
+  int nodeid = 0;
+  while (!stack.empty()) {
+    const CNode& kNode = nodes_[stack.back().first];
+    if (stack.back().second) *stack.back().second = nodeid;
+    stack.pop_back();
+
+    weights[nodeid] = kNode.get_totalweight();
+    predictions[nodeid] = kShrinkage_ * kNode.get_prediction();
+    if (!kNode.is_split()) {
+      splitvar[nodeid] = -1;
+      splitvalues[nodeid] = kShrinkage_ * kNode.get_prediction();
+      leftnodes[nodeid] = -1;
+      rightnodes[nodeid] = -1;
+      missingnodes[nodeid] = -1;
+      error_reduction[nodeid] = 0.0;
+      nodeid++;
+      continue;
+    }
+
+    splitvar[nodeid] = kNode.get_split_var();
+    error_reduction[nodeid] = kNode.get_improvement();
+    if (kNode.is_categorical_split()) {
+      // 0 based
+      splitvalues[nodeid] = splitcodes_vec.size() + prev_categorical_splits;
+      splitcodes_vec.push_back(
+          VectorCategories(kData.varclass(kNode.get_split_var()), 1));
+      VectorCategories& splitcodes = splitcodes_vec.back();
+      for (unsigned long level = 0; level < splitcodes.size(); level++) {
+        if (nodes_.is_left_category(kNode, level)) splitcodes[level] = -1;
+      }
+    } else {
+      splitvalues[nodeid] = kNode.get_splitvalue();
+    }
+
+    // pushed in reverse so that left is written first
+    stack.push_back(
+        std::make_pair(kNode.missing_child(), &missingnodes[nodeid]));
+    stack.push_back(std::make_pair(kNode.right_child(), &rightnodes[nodeid]));
+    stack.push_back(std::make_pair(kNode.left_child(), &leftnodes[nodeid]));
+    nodeid++;
+  }
+}
+
+//----------------------------------------
+// Function Members - Private
+//----------------------------------------
+// the prediction of the terminal node a row of the data reaches
+double CCARTTree::PredictRow(const CDataset& kData,
+                             unsigned long row_num) const {
+  unsigned long node_num = 0;
+  while (nodes_[node_num].is_split()) {
+    node_num = nodes_.NextNode(nodes_[node_num], kData, row_num);
+  }
+  return nodes_[node_num].get_prediction();
+}
+
+// prints the line before a child of a split naming the branch to it
+void CCARTTree::PrintBranch(const CNode& kParent, int branch,
+                            unsigned long depth) const {
+  for (unsigned long i = 0; i < depth; i++) gbm_platform::Printf("  ");
+  if (branch == 2) {
+    gbm_platform::Printf("missing\n");
+    return;
+  }
+
+  gbm_platform::Printf("V%lu ", kParent.get_split_var());
+  if (!kParent.is_categorical_split()) {
+    gbm_platform::Printf("%s %f\n", (branch == 0) ? "<" : ">=",
+                         kParent.get_splitvalue());
+    return;
+  }
+  gbm_platform::Printf((branch == 0) ? "in " : "not in ");
+  const char* separator = "";
+  for (unsigned long level = 0; level < kParent.num_levels(); level++) {
+    if (nodes_.is_left_category(kParent, level)) {
+      gbm_platform::Printf("%s%lu", separator, level);
+      separator = ",";
+    }
+  }
+  gbm_platform::Printf("\n");
 }
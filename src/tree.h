@@ -22,6 +22,8 @@
 //------------------------------
 #include "databag.h"
 #include "dataset.h"
+#include "fit_timings.h"
+#include "node_arena.h"
 #include "node_search.h"
 #include "parallel_details.h"
 #include "treeparams.h"
@@ -39,7 +41,8 @@ class CCARTTree {
   //----------------------
   // Public Constructors
   //----------------------
-  CCARTTree(const TreeParams& treeconfig);
+  // the tree's nodes are kept in the arena until it is reset for another
+  CCARTTree(const TreeParams& treeconfig, NodeArena& nodes);
 
   //---------------------
   // Public destructor
@@ -50,10 +53,16 @@ class CCARTTree {
   // Public Functions
   //---------------------
   void Grow(const std::vector<double>& residuals, const CDataset& kData,
-            const Bag& kBag, const std::vector<double>& kDeltaEstimate);
+            const Bag& kBag, const std::vector<double>& kDeltaEstimate,
+            SplitterArenas& arenas, FitTimings* timings = NULL);
 
-  void PredictValid(const CDataset& kData, unsigned long num_validation_points,
-                    std::vector<double>& delta_estimates);
+  // adds the shrunken tree to the fit of the rows from first_row on - the
+  // training rows' adjusted predictions are in kDeltaEstimates, the
+  // validation rows walk the tree - sharing the rows between the threads
+  // in chunks
+  void UpdateFit(const CDataset& kData,
+                 const std::vector<double>& kDeltaEstimates,
+                 double* func_estimate, unsigned long first_row = 0) const;
   void Adjust(std::vector<double>& delta_estimates);
 
   void TransferTreeToRList(const CDataset& kData, int* splitvar,
@@ -81,6 +90,28 @@ class CCARTTree {
   int get_array_chunk_size() const { return parallel_.get_array_chunk_size(); }
   
  private:
+  // a node of Print's walk, with the branch of its parent leading to it -
+  // 0 for left, 1 for right and 2 for missing
+  struct PrintVisit {
+    PrintVisit(unsigned long node_num, unsigned long node_depth,
+               unsigned long parent_num, int parent_branch)
+        : node(node_num),
+          depth(node_depth),
+          parent(parent_num),
+          branch(parent_branch){};
+    unsigned long node;
+    unsigned long depth;
+    unsigned long parent;
+    int branch;
+  };
+
+  //---------------------
+  // Private Functions
+  //---------------------
+  double PredictRow(const CDataset& kData, unsigned long row_num) const;
+  void PrintBranch(const CNode& kParent, int branch,
+                   unsigned long depth) const;
+
   //---------------------
   // Private Variables
   //---------------------
@@ -90,7 +121,7 @@ class CCARTTree {
   double error_;  // total squared error before carrying out the splits
   unsigned long totalnodecount_;
 
-  auto_ptr<CNode> rootnode_;
+  NodeArena& nodes_;
   vector<CNode*> terminalnode_ptrs_;
   vector<unsigned long> data_node_assignment_;
 
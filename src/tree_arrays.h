@@ -0,0 +1,59 @@
+//------------------------------------------------------------------------------
+//
+//  File:       tree_arrays.h
+//
+//  Description: a fitted tree as parallel arrays over its nodes - the
+//    form the engine hands its trees to the host and takes them back for
+//    prediction.
+//
+//------------------------------------------------------------------------------
+
+#ifndef TREEARRAYS_H
+#define TREEARRAYS_H
+
+//------------------------------
+// Includes
+//------------------------------
+#include <vector>
+
+//------------------------------
+// Struct definition
+//------------------------------
+struct TreeArrays {
+  //----------------------
+  // Public Constructors
+  //----------------------
+  TreeArrays(){};
+  explicit TreeArrays(unsigned long num_nodes)
+      : split_vars(num_nodes),
+        split_values(num_nodes),
+        left_nodes(num_nodes),
+        right_nodes(num_nodes),
+        missing_nodes(num_nodes),
+        error_reduction(num_nodes),
+        weights(num_nodes),
+        node_predictions(num_nodes){};
+
+  unsigned long size() const { return split_vars.size(); };
+
+  //-------------------
+  // Public Variables
+  //-------------------
+  //  split_vars - the variable split on, -1 for terminal nodes
+  //  split_values - the split value of a continuous split, the index of
+  //    the categorical split otherwise, the prediction of terminal nodes
+  //  left_nodes, right_nodes, missing_nodes - the children of each split
+  //  error_reduction - the improvement of each split
+  //  weights - the total weight of the rows reaching each node
+  //  node_predictions - the prediction of each node
+  std::vector<int> split_vars;
+  std::vector<double> split_values;
+  std::vector<int> left_nodes;
+  std::vector<int> right_nodes;
+  std::vector<int> missing_nodes;
+  std::vector<double> error_reduction;
+  std::vector<double> weights;
+  std::vector<double> node_predictions;
+};
+
+#endif  // TREEARRAYS_H
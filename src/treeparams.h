@@ -18,7 +18,6 @@
 //------------------------------
 #include "gbm_exception.h"
 #include "parallel_details.h"
-#include <Rcpp.h>
 
 //------------------------------
 // Struct definitions
@@ -35,23 +34,20 @@ struct TreeParams {
   // Description: Constructor for TreeParams struc.
   //
   // Parameters:
-  //  tree_depth - SEXP specifying the maximum depth of each tree - ulong.
-  //  min_num_node_obs - SEXP specifying the minimum number of obs.
-  //					a node must have - ulong.
-  //  shrinkageconstant - SEXP defining the shrinkage applied to
-  //				  each tree fit - double.
-  //  num_rows_in_training - SEXP containing ulong specify the number of data
-  //  points in
-  //							training set
+  //  tree_depth - the maximum depth of each tree.
+  //  min_num_node_obs - the minimum number of obs. a node must have.
+  //  shrinkageconstant - the shrinkage applied to each tree fit.
+  //  num_rows_in_training - the number of data points in the training set
   //  parallel - parallelization-related constants
   //-----------------------------------
 
-  TreeParams(SEXP tree_depth, SEXP min_num_node_obs, SEXP shrinkageconstant,
-             SEXP num_rows_in_training, const parallel_details& parallel)
-      : depth(Rcpp::as<unsigned long>(tree_depth)),
-        min_obs_in_node(Rcpp::as<unsigned long>(min_num_node_obs)),
-        shrinkage(Rcpp::as<double>(shrinkageconstant)),
-        num_trainrows(Rcpp::as<unsigned long>(num_rows_in_training)),
+  TreeParams(unsigned long tree_depth, unsigned long min_num_node_obs,
+             double shrinkageconstant, unsigned long num_rows_in_training,
+             const parallel_details& parallel)
+      : depth(tree_depth),
+        min_obs_in_node(min_num_node_obs),
+        shrinkage(shrinkageconstant),
+        num_trainrows(num_rows_in_training),
         parallel(parallel) {}
 
   //----------------------
@@ -12,6 +12,8 @@
 // Includes
 //-----------------------------------
 #include "tweedie.h"
+#include "block_sums.h"
+#include "vector_math.h"
 #include <math.h>
 #include <typeinfo>
 #include <iostream>
@@ -22,19 +24,22 @@
 //----------------------------------------
 // Function Members - Private
 //----------------------------------------
-CTweedie::CTweedie(double power) { power_ = power; }
+CTweedie::CTweedie(const parallel_details& parallel, double power)
+    : CDistribution(parallel) {
+  power_ = power;
+}
 
 //----------------------------------------
 // Function Members - Public
 //----------------------------------------
 CDistribution* CTweedie::Create(DataDistParams& distparams) {
   // Extract misc from second column of response
-  double power = Rcpp::as<double>(distparams.misc[0]);
-  if (!gbm_functions::has_value(power)) {
+  if (!gbm_functions::has_value(distparams.misc)) {
     throw gbm_exception::Failure(
         "Tweedie distribution requires misc to initialization.");
   }
-  return new CTweedie(power);
+  const double power = distparams.misc[0];
+  return new CTweedie(distparams.parallel, power);
 }
 
 CTweedie::~CTweedie() {}
@@ -42,37 +47,65 @@ CTweedie::~CTweedie() {}
 void CTweedie::ComputeWorkingResponse(const CDataset& kData, const Bag& kBag,
                                       const double* kFuncEstimates,
                                       std::vector<double>& residuals) {
-  unsigned long i = 0;
-  double delta_func_est = 0.0;
-
   if (!(kData.y_ptr() && kFuncEstimates &&
         kData.weight_ptr())) {
     throw gbm_exception::InvalidArgument();
   }
 
-  for (i = 0; i < kData.get_trainsize(); i++) {
-    delta_func_est = kFuncEstimates[i] + kData.offset_ptr()[i];
-    residuals[i] =
-        kData.y_ptr()[i] * std::exp(delta_func_est * (1.0 - power_)) -
-        exp(delta_func_est * (2.0 - power_));
+  const unsigned long kNumRows = kData.get_trainsize();
+
+#pragma omp parallel for schedule( \
+    static, gbm_vector_math::BlocksPerChunk(get_array_chunk_size())) \
+    num_threads(get_num_threads())
+  for (unsigned long block = 0; block < gbm_vector_math::NumBlocks(kNumRows);
+       block++) {
+    const unsigned long kBegin = block * gbm_vector_math::kBlockSize;
+    const unsigned long kSize = gbm_vector_math::BlockSize(block, kNumRows);
+    double exp_terms1[gbm_vector_math::kBlockSize];
+    double exp_terms2[gbm_vector_math::kBlockSize];
+
+    for (unsigned long j = 0; j < kSize; j++) {
+      const double kDeltaFuncEst =
+          kFuncEstimates[kBegin + j] + kData.offset_ptr()[kBegin + j];
+      exp_terms1[j] = kDeltaFuncEst * (1.0 - power_);
+      exp_terms2[j] = kDeltaFuncEst * (2.0 - power_);
+    }
+    gbm_vector_math::Exp(exp_terms1, kSize, exp_terms1);
+    gbm_vector_math::Exp(exp_terms2, kSize, exp_terms2);
+
+    for (unsigned long j = 0; j < kSize; j++) {
+      residuals[kBegin + j] =
+          kData.y_ptr()[kBegin + j] * exp_terms1[j] - exp_terms2[j];
+    }
   }
 }
 
 double CTweedie::InitF(const CDataset& kData) {
-  double sum = 0.0;
-  double totalweight = 0.0;
   double min = -19.0;
   double max = +19.0;
-  unsigned long i = 0;
   double init_func_est = 0.0;
 
-  for (i = 0; i < kData.get_trainsize(); i++) {
-    sum += kData.weight_ptr()[i] * kData.y_ptr()[i] *
-           std::exp(kData.offset_ptr()[i] * (1.0 - power_));
-    totalweight += kData.weight_ptr()[i] *
-                   std::exp(kData.offset_ptr()[i] * (2.0 - power_));
+  BlockSums sums(kData.get_trainsize(), 2);
+
+#pragma omp parallel for schedule( \
+    static, gbm_vector_math::BlocksPerChunk(get_array_chunk_size())) \
+    num_threads(get_num_threads())
+  for (unsigned long block = 0; block < sums.num_blocks(); block++) {
+    double sum = 0.0;
+    double totalweight = 0.0;
+    for (unsigned long i = sums.begin(block); i < sums.end(block); i++) {
+      sum += kData.weight_ptr()[i] * kData.y_ptr()[i] *
+             std::exp(kData.offset_ptr()[i] * (1.0 - power_));
+      totalweight += kData.weight_ptr()[i] *
+                     std::exp(kData.offset_ptr()[i] * (2.0 - power_));
+    }
+    sums(block, 0) = sum;
+    sums(block, 1) = totalweight;
   }
 
+  double sum = sums.Total(0);
+  double totalweight = sums.Total(1);
+
   if (sum <= 0.0) {
     init_func_est = min;
   } else {
@@ -91,25 +124,47 @@ double CTweedie::InitF(const CDataset& kData) {
 
 double CTweedie::Deviance(const CDataset& kData, const Bag& kBag,
                           const double* kFuncEstimate) {
-  double delta_func_est = 0.0;
-  unsigned long i = 0;
-  double loss = 0.0;
-  double weight = 0.0;
-
   // Switch to validation set if necessary
-  unsigned long num_rows_in_set = kData.get_size_of_set();
-
-  for (i = 0; i < num_rows_in_set; i++) {
-    delta_func_est = kFuncEstimate[i] + kData.offset_ptr()[i];
-    loss += kData.weight_ptr()[i] *
-            (pow(kData.y_ptr()[i], 2.0 - power_) /
-                 ((1.0 - power_) * (2.0 - power_)) -
-             kData.y_ptr()[i] * std::exp(delta_func_est * (1.0 - power_)) /
-                 (1.0 - power_) +
-             exp(delta_func_est * (2.0 - power_)) / (2.0 - power_));
-    weight += kData.weight_ptr()[i];
+  const unsigned long kNumRows = kData.get_size_of_set();
+  BlockSums sums(kNumRows, 2);
+
+#pragma omp parallel for schedule( \
+    static, gbm_vector_math::BlocksPerChunk(get_array_chunk_size())) \
+    num_threads(get_num_threads())
+  for (unsigned long block = 0; block < sums.num_blocks(); block++) {
+    const unsigned long kBegin = block * gbm_vector_math::kBlockSize;
+    const unsigned long kSize = gbm_vector_math::BlockSize(block, kNumRows);
+    double exp_terms1[gbm_vector_math::kBlockSize];
+    double exp_terms2[gbm_vector_math::kBlockSize];
+    double loss = 0.0;
+    double weight = 0.0;
+
+    for (unsigned long j = 0; j < kSize; j++) {
+      const double kDeltaFuncEst =
+          kFuncEstimate[kBegin + j] + kData.offset_ptr()[kBegin + j];
+      exp_terms1[j] = kDeltaFuncEst * (1.0 - power_);
+      exp_terms2[j] = kDeltaFuncEst * (2.0 - power_);
+    }
+    gbm_vector_math::Exp(exp_terms1, kSize, exp_terms1);
+    gbm_vector_math::Exp(exp_terms2, kSize, exp_terms2);
+
+    for (unsigned long j = 0; j < kSize; j++) {
+      const unsigned long i = kBegin + j;
+      loss += kData.weight_ptr()[i] *
+              (pow(kData.y_ptr()[i], 2.0 - power_) /
+                   ((1.0 - power_) * (2.0 - power_)) -
+               kData.y_ptr()[i] * exp_terms1[j] / (1.0 - power_) +
+               exp_terms2[j] / (2.0 - power_));
+      weight += kData.weight_ptr()[i];
+    }
+
+    sums(block, 0) = loss;
+    sums(block, 1) = weight;
   }
 
+  double loss = sums.Total(0);
+  double weight = sums.Total(1);
+
   // TODO: Check if weights are all zero for validation set
   if ((weight == 0.0) && (loss == 0.0)) {
     return nan("");
@@ -147,9 +202,9 @@ void CTweedie::FitBestConstant(const CDataset& kData, const Bag& kBag,
           std::exp(delta_func_est * (2.0 - power_));
 
       // Keep track of largest and smallest prediction in each node
-      max_vec[tree.get_node_assignments()[obs_num]] = R::fmax2(
+      max_vec[tree.get_node_assignments()[obs_num]] = gbm_platform::Max(
           delta_func_est, max_vec[tree.get_node_assignments()[obs_num]]);
-      min_vec[tree.get_node_assignments()[obs_num]] = R::fmin2(
+      min_vec[tree.get_node_assignments()[obs_num]] = gbm_platform::Min(
           delta_func_est, min_vec[tree.get_node_assignments()[obs_num]]);
     }
   }
@@ -195,26 +250,54 @@ double CTweedie::BagImprovement(const CDataset& kData, const Bag& kBag,
                                 const double* kFuncEstimate,
                                 const double kShrinkage,
                                 const std::vector<double>& kDeltaEstimate) {
-  double returnvalue = 0.0;
-  double delta_func_estimate = 0.0;
-  double weight = 0.0;
-  unsigned long i = 0;
+  const unsigned long kNumRows = kData.get_trainsize();
+  BlockSums sums(kNumRows, 2);
+
+  // the terms of every row are computed, and those of the rows in the bag
+  // then dropped, so that the kernels run over whole blocks
+#pragma omp parallel for schedule( \
+    static, gbm_vector_math::BlocksPerChunk(get_array_chunk_size())) \
+    num_threads(get_num_threads())
+  for (unsigned long block = 0; block < sums.num_blocks(); block++) {
+    const unsigned long kBegin = block * gbm_vector_math::kBlockSize;
+    const unsigned long kSize = gbm_vector_math::BlockSize(block, kNumRows);
+    double exp_terms1[gbm_vector_math::kBlockSize];
+    double exp_terms2[gbm_vector_math::kBlockSize];
+    double step_factors1[gbm_vector_math::kBlockSize];
+    double step_factors2[gbm_vector_math::kBlockSize];
+    double returnvalue = 0.0;
+    double weight = 0.0;
 
-  for (i = 0; i < kData.get_trainsize(); i++) {
-    if (!kBag.get_element(i)) {
-      delta_func_estimate = kFuncEstimate[i] + kData.offset_ptr()[i];
+    for (unsigned long j = 0; j < kSize; j++) {
+      const unsigned long i = kBegin + j;
+      const double kDeltaFuncEst = kFuncEstimate[i] + kData.offset_ptr()[i];
+      exp_terms1[j] = kDeltaFuncEst * (1.0 - power_);
+      exp_terms2[j] = kDeltaFuncEst * (2.0 - power_);
+      step_factors1[j] = kShrinkage * kDeltaEstimate[i] * (1.0 - power_);
+      step_factors2[j] = kShrinkage * kDeltaEstimate[i] * (2.0 - power_);
+    }
+    gbm_vector_math::Exp(exp_terms1, kSize, exp_terms1);
+    gbm_vector_math::Exp(exp_terms2, kSize, exp_terms2);
+    gbm_vector_math::Exp(step_factors1, kSize, step_factors1);
+    gbm_vector_math::Exp(step_factors2, kSize, step_factors2);
 
-      returnvalue +=
+    for (unsigned long j = 0; j < kSize; j++) {
+      const unsigned long i = kBegin + j;
+      const double kTerm =
           kData.weight_ptr()[i] *
-          (std::exp(delta_func_estimate * (1.0 - power_)) * kData.y_ptr()[i] /
-               (1.0 - power_) *
-               (std::exp(kShrinkage * kDeltaEstimate[i] * (1.0 - power_)) -
-                1.0) +
-           std::exp(delta_func_estimate * (2.0 - power_)) / (2.0 - power_) *
-               (1.0 - exp(kShrinkage * kDeltaEstimate[i] * (2.0 - power_))));
-      weight += kData.weight_ptr()[i];
+          (exp_terms1[j] * kData.y_ptr()[i] / (1.0 - power_) *
+               (step_factors1[j] - 1.0) +
+           exp_terms2[j] / (2.0 - power_) * (1.0 - step_factors2[j]));
+      returnvalue += kBag.get_element(i) ? 0.0 : kTerm;
+      weight += kBag.get_element(i) ? 0.0 : kData.weight_ptr()[i];
     }
+
+    sums(block, 0) = returnvalue;
+    sums(block, 1) = weight;
   }
 
+  double returnvalue = sums.Total(0);
+  double weight = sums.Total(1);
+
   return 2.0 * returnvalue / weight;
 }
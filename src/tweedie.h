@@ -13,8 +13,7 @@
 // Includes
 //------------------------------
 #include "distribution.h"
-#include <Rmath.h>
-#include <Rcpp.h>
+#include <cmath>
 #include <memory>
 
 //------------------------------
@@ -57,7 +56,7 @@ class CTweedie : public CDistribution {
   //----------------------
   // Private Constructors
   //----------------------
-  CTweedie(double power);
+  CTweedie(const parallel_details& parallel, double power);
 
   //-------------------
   // Private Variables
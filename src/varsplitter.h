@@ -14,55 +14,65 @@
 //------------------------------
 #include "node.h"
 #include "node_parameters.h"
-#include "generic_splitter_strategy.h"
-#include <memory>
+#include "splitter_arena.h"
+#include "splitter_strategies.h"
 
 //------------------------------
 // Class Definition
 //------------------------------
+// Strategy - cts_splitter_strategy or categorical_splitter_strategy,
+// called directly so that the search of each observation inlines
+template <class Strategy>
 class VarSplitter {
  public:
   //----------------------
   // Public Constructors
   //----------------------
-  VarSplitter(CNode& nodetosplit, unsigned long min_num_node_obs,
+  VarSplitter(const CNode& nodetosplit, unsigned long min_num_node_obs,
               unsigned long bias, unsigned long whichvar,
-              unsigned long numvar_classes, long monotone);
-
-  VarSplitter(const VarSplitter& rhs)
-      : initial_(rhs.initial_),
-        bestsplit_(rhs.bestsplit_),
-        proposedsplit_(rhs.proposedsplit_) {
-    splitter_.reset(rhs.splitter_->clone());
-  }
-
-  VarSplitter& operator=(const VarSplitter& rhs) {
-    if (this == &rhs) {
-      return *this;
-    }
-    initial_ = rhs.initial_;
-    bestsplit_ = rhs.bestsplit_;
-    proposedsplit_ = rhs.proposedsplit_;
-    splitter_.reset(rhs.splitter_->clone());
-    return *this;
-  };
+              unsigned long numvar_classes, long monotone,
+              SplitterArena& arena)
+      : initial_(nodetosplit.as_node_def()),
+        bestsplit_(initial_, bias),
+        proposedsplit_(initial_, bias, numvar_classes, whichvar),
+        splitter_(min_num_node_obs, numvar_classes, monotone, arena) {}
 
   //---------------------
   // Public Functions
   //---------------------
+  void IncorporateObs(double xval, double residval, double weight) {
+    splitter_.incorporate_obs(bestsplit_, proposedsplit_, xval, residval,
+                              weight);
+  }
+  void IncorporateBin(double xval, const NodeDef& bin) {
+    splitter_.incorporate_bin(bestsplit_, proposedsplit_, xval, bin);
+  }
+  void WrapUpCurrentVariable() {
+    splitter_.wrap_up(bestsplit_, proposedsplit_);
 
-  void IncorporateObs(double xval, double residval, double weight);
-  void WrapUpCurrentVariable();
+    if (proposedsplit_.split_variable() == bestsplit_.split_variable()) {
+      if (proposedsplit_.has_missing()) {
+        bestsplit_.set_missing_def(proposedsplit_.get_missing_def());
+      } else  // DEBUG: consider a weighted average with parent node?
+      {
+        bestsplit_.set_missing_def(
+            NodeDef(initial_.get_weightresid(), initial_.get_totalweight(), 0));
+      }
+    }
+  }
 
   const NodeParams& best_split() const { return bestsplit_; };
 
  private:
+  VarSplitter(const VarSplitter&);
+  VarSplitter& operator=(const VarSplitter&);
+
   //---------------------
   // Private Variables
   //---------------------
   NodeDef initial_;
 
   NodeParams bestsplit_, proposedsplit_;
-  std::auto_ptr<generic_splitter_strategy> splitter_;
+  Strategy splitter_;
 };
 #endif  // VARSPLITTER_H
@@ -0,0 +1,412 @@
+//-----------------------------------
+//
+// File: vector_math.cpp
+//
+// Description: the exp and log(1 + exp) kernels.  exp reduces its
+//   argument to r in [-ln 2 / 2, ln 2 / 2] with x = k ln 2 + r and takes
+//   exp(r) from Cephes' rational approximation; log(1 + exp(x)) is
+//   max(x, 0) + log1p(exp(-|x|)), with log1p as in fdlibm.  Fused
+//   multiply-adds would round differently from one instruction set to the
+//   next, so none are used.
+//
+//-----------------------------------
+
+// contracting a * b + c to one instruction changes the rounding
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+//-----------------------------------
+// Includes
+//-----------------------------------
+#include "vector_math.h"
+#include <cmath>
+
+#if (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define GBM_VECTOR_MATH_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+// arguments beyond these give zero and infinity
+const double kExpLow = -746.0;
+const double kExpHigh = 710.0;
+const double kLog2E = 1.4426950408889634073599;
+const double kLn2Hi = 6.93145751953125E-1;
+const double kLn2Lo = 1.42860682030941723212E-6;
+const double kSqrt2 = 1.41421356237309504880;
+
+// Cephes' exp(r) = 1 + 2 r P(r^2) / (Q(r^2) - r P(r^2))
+const double kP0 = 1.26177193074810590878E-4;
+const double kP1 = 3.02994407707441961300E-2;
+const double kP2 = 9.99999999999999999910E-1;
+const double kQ0 = 3.00198505138664455042E-6;
+const double kQ1 = 2.52448340349684104192E-3;
+const double kQ2 = 2.27265548208155028766E-1;
+const double kQ3 = 2.00000000000000000009E0;
+
+// fdlibm's log(1 + f) = f - (f^2 / 2 - s (f^2 / 2 + R(s^2))), s = f / (2 + f)
+const double kFdlibmLn2Hi = 6.93147180369123816490e-01;
+const double kFdlibmLn2Lo = 1.90821492927058770002e-10;
+const double kLg1 = 6.666666666666735130e-01;
+const double kLg2 = 3.999999999940941908e-01;
+const double kLg3 = 2.857142874366239149e-01;
+const double kLg4 = 2.222219843214978396e-01;
+const double kLg5 = 1.818357216161805012e-01;
+const double kLg6 = 1.531383769920937332e-01;
+const double kLg7 = 1.479819860511658591e-01;
+
+//-----------------------------------
+// Scalar kernels
+//-----------------------------------
+inline double ExpScalar(double x) {
+  if (x != x) return x;
+  x = std::min(std::max(x, kExpLow), kExpHigh);
+
+  const double k = std::floor(x * kLog2E + 0.5);
+  const double r = (x - k * kLn2Hi) - k * kLn2Lo;
+  const double rr = r * r;
+  const double px = r * ((kP0 * rr + kP1) * rr + kP2);
+  const double qx = ((kQ0 * rr + kQ1) * rr + kQ2) * rr + kQ3;
+  const double exp_r = 1.0 + 2.0 * (px / (qx - px));
+
+  // 2^k in two factors so that neither leaves the normal doubles
+  const double k1 = std::floor(k * 0.5);
+  return exp_r * std::ldexp(1.0, int(k1)) * std::ldexp(1.0, int(k - k1));
+}
+
+inline double Log1pExpScalar(double x) {
+  if (x != x) return x;
+
+  // log1p(y) for y = exp(-|x|) in (0, 1], from u = 1 + y and the error c
+  // in rounding it
+  const double y = ExpScalar(-std::fabs(x));
+  const double u = 1.0 + y;
+  const double c = (y - (u - 1.0)) / u;
+  const bool kHalve = (u > kSqrt2);
+  const double e = kHalve ? 1.0 : 0.0;
+  const double f = (kHalve ? u * 0.5 : u) - 1.0;
+
+  const double s = f / (2.0 + f);
+  const double z = s * s;
+  const double w = z * z;
+  const double t1 = w * (kLg2 + w * (kLg4 + w * kLg6));
+  const double t2 = z * (kLg1 + w * (kLg3 + w * (kLg5 + w * kLg7)));
+  const double hfsq = 0.5 * f * f;
+  const double log1p_y =
+      e * kFdlibmLn2Hi -
+      ((hfsq - (s * (hfsq + (t2 + t1)) + (e * kFdlibmLn2Lo + c))) - f);
+  return std::max(x, 0.0) + log1p_y;
+}
+
+void ExpScalarBlock(const double* kX, unsigned long n, double* out) {
+  for (unsigned long i = 0; i < n; i++) out[i] = ExpScalar(kX[i]);
+}
+
+void Log1pExpScalarBlock(const double* kX, unsigned long n, double* out) {
+  for (unsigned long i = 0; i < n; i++) out[i] = Log1pExpScalar(kX[i]);
+}
+
+#ifdef GBM_VECTOR_MATH_X86
+//-----------------------------------
+// AVX2 kernels - four doubles at a time
+//-----------------------------------
+__attribute__((target("avx2"))) inline __m256d ExpAvx2(__m256d x) {
+  const __m256d kIsNaN = _mm256_cmp_pd(x, x, _CMP_UNORD_Q);
+  const __m256d kClamped = _mm256_min_pd(
+      _mm256_max_pd(x, _mm256_set1_pd(kExpLow)), _mm256_set1_pd(kExpHigh));
+
+  const __m256d k = _mm256_floor_pd(_mm256_add_pd(
+      _mm256_mul_pd(kClamped, _mm256_set1_pd(kLog2E)), _mm256_set1_pd(0.5)));
+  const __m256d r = _mm256_sub_pd(
+      _mm256_sub_pd(kClamped, _mm256_mul_pd(k, _mm256_set1_pd(kLn2Hi))),
+      _mm256_mul_pd(k, _mm256_set1_pd(kLn2Lo)));
+  const __m256d rr = _mm256_mul_pd(r, r);
+  const __m256d px = _mm256_mul_pd(
+      r, _mm256_add_pd(
+             _mm256_mul_pd(_mm256_add_pd(_mm256_mul_pd(_mm256_set1_pd(kP0), rr),
+                                         _mm256_set1_pd(kP1)),
+                           rr),
+             _mm256_set1_pd(kP2)));
+  const __m256d qx = _mm256_add_pd(
+      _mm256_mul_pd(
+          _mm256_add_pd(
+              _mm256_mul_pd(_mm256_add_pd(_mm256_mul_pd(_mm256_set1_pd(kQ0), rr),
+                                          _mm256_set1_pd(kQ1)),
+                            rr),
+              _mm256_set1_pd(kQ2)),
+          rr),
+      _mm256_set1_pd(kQ3));
+  const __m256d exp_r = _mm256_add_pd(
+      _mm256_set1_pd(1.0),
+      _mm256_mul_pd(_mm256_set1_pd(2.0),
+                    _mm256_div_pd(px, _mm256_sub_pd(qx, px))));
+
+  // 2^k1 and 2^k2 from their exponent bits
+  const __m256d k1 = _mm256_floor_pd(_mm256_mul_pd(k, _mm256_set1_pd(0.5)));
+  const __m256d k2 = _mm256_sub_pd(k, k1);
+  const __m256i kBias = _mm256_set1_epi64x(1023);
+  const __m256d kScale1 = _mm256_castsi256_pd(_mm256_slli_epi64(
+      _mm256_add_epi64(_mm256_cvtepi32_epi64(_mm256_cvtpd_epi32(k1)), kBias),
+      52));
+  const __m256d kScale2 = _mm256_castsi256_pd(_mm256_slli_epi64(
+      _mm256_add_epi64(_mm256_cvtepi32_epi64(_mm256_cvtpd_epi32(k2)), kBias),
+      52));
+
+  return _mm256_blendv_pd(
+      _mm256_mul_pd(_mm256_mul_pd(exp_r, kScale1), kScale2), x, kIsNaN);
+}
+
+__attribute__((target("avx2"))) inline __m256d Log1pExpAvx2(__m256d x) {
+  const __m256d kIsNaN = _mm256_cmp_pd(x, x, _CMP_UNORD_Q);
+  const __m256d kOne = _mm256_set1_pd(1.0);
+  const __m256d kAbs = _mm256_andnot_pd(_mm256_set1_pd(-0.0), x);
+
+  const __m256d y = ExpAvx2(_mm256_sub_pd(_mm256_setzero_pd(), kAbs));
+  const __m256d u = _mm256_add_pd(kOne, y);
+  const __m256d c = _mm256_div_pd(_mm256_sub_pd(y, _mm256_sub_pd(u, kOne)), u);
+  const __m256d kHalve = _mm256_cmp_pd(u, _mm256_set1_pd(kSqrt2), _CMP_GT_OQ);
+  const __m256d e = _mm256_and_pd(kHalve, kOne);
+  const __m256d f = _mm256_sub_pd(
+      _mm256_blendv_pd(u, _mm256_mul_pd(u, _mm256_set1_pd(0.5)), kHalve),
+      kOne);
+
+  const __m256d s = _mm256_div_pd(f, _mm256_add_pd(_mm256_set1_pd(2.0), f));
+  const __m256d z = _mm256_mul_pd(s, s);
+  const __m256d w = _mm256_mul_pd(z, z);
+  const __m256d t1 = _mm256_mul_pd(
+      w, _mm256_add_pd(
+             _mm256_set1_pd(kLg2),
+             _mm256_mul_pd(
+                 w, _mm256_add_pd(_mm256_set1_pd(kLg4),
+                                  _mm256_mul_pd(w, _mm256_set1_pd(kLg6))))));
+  const __m256d t2 = _mm256_mul_pd(
+      z,
+      _mm256_add_pd(
+          _mm256_set1_pd(kLg1),
+          _mm256_mul_pd(
+              w, _mm256_add_pd(
+                     _mm256_set1_pd(kLg3),
+                     _mm256_mul_pd(
+                         w, _mm256_add_pd(
+                                _mm256_set1_pd(kLg5),
+                                _mm256_mul_pd(w, _mm256_set1_pd(kLg7))))))));
+  const __m256d hfsq = _mm256_mul_pd(_mm256_mul_pd(_mm256_set1_pd(0.5), f), f);
+  const __m256d kInner = _mm256_add_pd(
+      _mm256_mul_pd(s, _mm256_add_pd(hfsq, _mm256_add_pd(t2, t1))),
+      _mm256_add_pd(_mm256_mul_pd(e, _mm256_set1_pd(kFdlibmLn2Lo)), c));
+  const __m256d log1p_y = _mm256_sub_pd(
+      _mm256_mul_pd(e, _mm256_set1_pd(kFdlibmLn2Hi)),
+      _mm256_sub_pd(_mm256_sub_pd(hfsq, kInner), f));
+
+  return _mm256_blendv_pd(
+      _mm256_add_pd(_mm256_max_pd(x, _mm256_setzero_pd()), log1p_y), x,
+      kIsNaN);
+}
+
+__attribute__((target("avx2"))) void ExpAvx2Block(const double* kX,
+                                                  unsigned long n,
+                                                  double* out) {
+  unsigned long i = 0;
+  for (; i + 4 <= n; i += 4) {
+    _mm256_storeu_pd(out + i, ExpAvx2(_mm256_loadu_pd(kX + i)));
+  }
+  ExpScalarBlock(kX + i, n - i, out + i);
+}
+
+__attribute__((target("avx2"))) void Log1pExpAvx2Block(const double* kX,
+                                                       unsigned long n,
+                                                       double* out) {
+  unsigned long i = 0;
+  for (; i + 4 <= n; i += 4) {
+    _mm256_storeu_pd(out + i, Log1pExpAvx2(_mm256_loadu_pd(kX + i)));
+  }
+  Log1pExpScalarBlock(kX + i, n - i, out + i);
+}
+
+//-----------------------------------
+// AVX-512 kernels - eight doubles at a time
+//-----------------------------------
+// GCC takes the undefined source operands of the AVX-512 intrinsics for
+// uninitialized variables
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+__attribute__((target("avx512f"))) inline __m512d ExpAvx512(__m512d x) {
+  const __mmask8 kIsNaN = _mm512_cmp_pd_mask(x, x, _CMP_UNORD_Q);
+  const __m512d kClamped = _mm512_min_pd(
+      _mm512_max_pd(x, _mm512_set1_pd(kExpLow)), _mm512_set1_pd(kExpHigh));
+
+  const __m512d k = _mm512_roundscale_pd(
+      _mm512_add_pd(_mm512_mul_pd(kClamped, _mm512_set1_pd(kLog2E)),
+                    _mm512_set1_pd(0.5)),
+      _MM_FROUND_TO_NEG_INF);
+  const __m512d r = _mm512_sub_pd(
+      _mm512_sub_pd(kClamped, _mm512_mul_pd(k, _mm512_set1_pd(kLn2Hi))),
+      _mm512_mul_pd(k, _mm512_set1_pd(kLn2Lo)));
+  const __m512d rr = _mm512_mul_pd(r, r);
+  const __m512d px = _mm512_mul_pd(
+      r, _mm512_add_pd(
+             _mm512_mul_pd(_mm512_add_pd(_mm512_mul_pd(_mm512_set1_pd(kP0), rr),
+                                         _mm512_set1_pd(kP1)),
+                           rr),
+             _mm512_set1_pd(kP2)));
+  const __m512d qx = _mm512_add_pd(
+      _mm512_mul_pd(
+          _mm512_add_pd(
+              _mm512_mul_pd(_mm512_add_pd(_mm512_mul_pd(_mm512_set1_pd(kQ0), rr),
+                                          _mm512_set1_pd(kQ1)),
+                            rr),
+              _mm512_set1_pd(kQ2)),
+          rr),
+      _mm512_set1_pd(kQ3));
+  const __m512d exp_r = _mm512_add_pd(
+      _mm512_set1_pd(1.0),
+      _mm512_mul_pd(_mm512_set1_pd(2.0),
+                    _mm512_div_pd(px, _mm512_sub_pd(qx, px))));
+
+  // 2^k1 and 2^k2 from their exponent bits
+  const __m512d k1 = _mm512_roundscale_pd(
+      _mm512_mul_pd(k, _mm512_set1_pd(0.5)), _MM_FROUND_TO_NEG_INF);
+  const __m512d k2 = _mm512_sub_pd(k, k1);
+  const __m512i kBias = _mm512_set1_epi64(1023);
+  const __m512d kScale1 = _mm512_castsi512_pd(_mm512_slli_epi64(
+      _mm512_add_epi64(_mm512_cvtepi32_epi64(_mm512_cvtpd_epi32(k1)), kBias),
+      52));
+  const __m512d kScale2 = _mm512_castsi512_pd(_mm512_slli_epi64(
+      _mm512_add_epi64(_mm512_cvtepi32_epi64(_mm512_cvtpd_epi32(k2)), kBias),
+      52));
+
+  return _mm512_mask_blend_pd(
+      kIsNaN, _mm512_mul_pd(_mm512_mul_pd(exp_r, kScale1), kScale2), x);
+}
+
+__attribute__((target("avx512f"))) inline __m512d Log1pExpAvx512(__m512d x) {
+  const __mmask8 kIsNaN = _mm512_cmp_pd_mask(x, x, _CMP_UNORD_Q);
+  const __m512d kOne = _mm512_set1_pd(1.0);
+  const __m512d kAbs = _mm512_castsi512_pd(_mm512_andnot_si512(
+      _mm512_castpd_si512(_mm512_set1_pd(-0.0)), _mm512_castpd_si512(x)));
+
+  const __m512d y = ExpAvx512(_mm512_sub_pd(_mm512_setzero_pd(), kAbs));
+  const __m512d u = _mm512_add_pd(kOne, y);
+  const __m512d c = _mm512_div_pd(_mm512_sub_pd(y, _mm512_sub_pd(u, kOne)), u);
+  const __mmask8 kHalve =
+      _mm512_cmp_pd_mask(u, _mm512_set1_pd(kSqrt2), _CMP_GT_OQ);
+  const __m512d e = _mm512_mask_blend_pd(kHalve, _mm512_setzero_pd(), kOne);
+  const __m512d f = _mm512_sub_pd(
+      _mm512_mask_blend_pd(kHalve, u, _mm512_mul_pd(u, _mm512_set1_pd(0.5))),
+      kOne);
+
+  const __m512d s = _mm512_div_pd(f, _mm512_add_pd(_mm512_set1_pd(2.0), f));
+  const __m512d z = _mm512_mul_pd(s, s);
+  const __m512d w = _mm512_mul_pd(z, z);
+  const __m512d t1 = _mm512_mul_pd(
+      w, _mm512_add_pd(
+             _mm512_set1_pd(kLg2),
+             _mm512_mul_pd(
+                 w, _mm512_add_pd(_mm512_set1_pd(kLg4),
+                                  _mm512_mul_pd(w, _mm512_set1_pd(kLg6))))));
+  const __m512d t2 = _mm512_mul_pd(
+      z,
+      _mm512_add_pd(
+          _mm512_set1_pd(kLg1),
+          _mm512_mul_pd(
+              w, _mm512_add_pd(
+                     _mm512_set1_pd(kLg3),
+                     _mm512_mul_pd(
+                         w, _mm512_add_pd(
+                                _mm512_set1_pd(kLg5),
+                                _mm512_mul_pd(w, _mm512_set1_pd(kLg7))))))));
+  const __m512d hfsq = _mm512_mul_pd(_mm512_mul_pd(_mm512_set1_pd(0.5), f), f);
+  const __m512d kInner = _mm512_add_pd(
+      _mm512_mul_pd(s, _mm512_add_pd(hfsq, _mm512_add_pd(t2, t1))),
+      _mm512_add_pd(_mm512_mul_pd(e, _mm512_set1_pd(kFdlibmLn2Lo)), c));
+  const __m512d log1p_y = _mm512_sub_pd(
+      _mm512_mul_pd(e, _mm512_set1_pd(kFdlibmLn2Hi)),
+      _mm512_sub_pd(_mm512_sub_pd(hfsq, kInner), f));
+
+  return _mm512_mask_blend_pd(
+      kIsNaN, _mm512_add_pd(_mm512_max_pd(x, _mm512_setzero_pd()), log1p_y),
+      x);
+}
+
+__attribute__((target("avx512f"))) void ExpAvx512Block(const double* kX,
+                                                       unsigned long n,
+                                                       double* out) {
+  unsigned long i = 0;
+  for (; i + 8 <= n; i += 8) {
+    _mm512_storeu_pd(out + i, ExpAvx512(_mm512_loadu_pd(kX + i)));
+  }
+  ExpScalarBlock(kX + i, n - i, out + i);
+}
+
+__attribute__((target("avx512f"))) void Log1pExpAvx512Block(const double* kX,
+                                                            unsigned long n,
+                                                            double* out) {
+  unsigned long i = 0;
+  for (; i + 8 <= n; i += 8) {
+    _mm512_storeu_pd(out + i, Log1pExpAvx512(_mm512_loadu_pd(kX + i)));
+  }
+  Log1pExpScalarBlock(kX + i, n - i, out + i);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif  // GBM_VECTOR_MATH_X86
+
+gbm_vector_math::Kernels DetectKernels() {
+#ifdef GBM_VECTOR_MATH_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) return gbm_vector_math::kAvx512Kernels;
+  if (__builtin_cpu_supports("avx2")) return gbm_vector_math::kAvx2Kernels;
+#endif
+  return gbm_vector_math::kScalarKernels;
+}
+
+const gbm_vector_math::Kernels kBestKernels = DetectKernels();
+}
+
+//----------------------------------------
+// Functions - Public
+//----------------------------------------
+gbm_vector_math::Kernels gbm_vector_math::BestKernels() { return kBestKernels; }
+
+const char* gbm_vector_math::KernelsName(Kernels kernels) {
+  static const char* kNames[kNumKernels] = {"scalar", "avx2", "avx512"};
+  return kNames[kernels];
+}
+
+bool gbm_vector_math::IsSupported(Kernels kernels) {
+  return kernels <= kBestKernels;
+}
+
+void gbm_vector_math::Exp(const double* kX, unsigned long n, double* out) {
+  Exp(kBestKernels, kX, n, out);
+}
+
+void gbm_vector_math::Exp(Kernels kernels, const double* kX, unsigned long n,
+                          double* out) {
+#ifdef GBM_VECTOR_MATH_X86
+  if (kernels == kAvx512Kernels) return ExpAvx512Block(kX, n, out);
+  if (kernels == kAvx2Kernels) return ExpAvx2Block(kX, n, out);
+#endif
+  ExpScalarBlock(kX, n, out);
+}
+
+void gbm_vector_math::Log1pExp(const double* kX, unsigned long n,
+                               double* out) {
+  Log1pExp(kBestKernels, kX, n, out);
+}
+
+void gbm_vector_math::Log1pExp(Kernels kernels, const double* kX,
+                               unsigned long n, double* out) {
+#ifdef GBM_VECTOR_MATH_X86
+  if (kernels == kAvx512Kernels) return Log1pExpAvx512Block(kX, n, out);
+  if (kernels == kAvx2Kernels) return Log1pExpAvx2Block(kX, n, out);
+#endif
+  Log1pExpScalarBlock(kX, n, out);
+}
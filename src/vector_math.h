@@ -0,0 +1,61 @@
+//------------------------------------------------------------------------------
+//
+//  File:       vector_math.h
+//
+//  Description: exp and log(1 + exp) over blocks of doubles, for the link
+//    and loss functions of the distributions.  The kernels use AVX-512 or
+//    AVX2 when the machine has them, chosen as the library loads, and plain
+//    C++ otherwise.  Every kernel does the same floating point operations
+//    in the same order, so their results are identical - to within 2 ulp
+//    of the exact values.
+//
+//------------------------------------------------------------------------------
+
+#ifndef VECTORMATH_H
+#define VECTORMATH_H
+
+//------------------------------
+// Includes
+//------------------------------
+#include <algorithm>
+
+namespace gbm_vector_math {
+// the kernels of each instruction set
+enum Kernels { kScalarKernels, kAvx2Kernels, kAvx512Kernels, kNumKernels };
+
+// the fastest kernels the machine supports, and their name
+Kernels BestKernels();
+const char* KernelsName(Kernels kernels);
+bool IsSupported(Kernels kernels);
+
+// out[i] = exp(kX[i]) for i < n, where out may be kX - results below the
+// smallest normal double are rounded to subnormals or zero and those above
+// the largest are infinite
+void Exp(const double* kX, unsigned long n, double* out);
+void Exp(Kernels kernels, const double* kX, unsigned long n, double* out);
+
+// out[i] = log(1 + exp(kX[i])) for i < n, where out may be kX, accurately
+// for large and small kX[i] alike
+void Log1pExp(const double* kX, unsigned long n, double* out);
+void Log1pExp(Kernels kernels, const double* kX, unsigned long n,
+              double* out);
+
+// the loops calling the kernels take their rows in blocks of kBlockSize,
+// whose buffers fit in the first level cache
+const unsigned long kBlockSize = 256;
+
+inline unsigned long NumBlocks(unsigned long num_rows) {
+  return (num_rows + kBlockSize - 1) / kBlockSize;
+}
+
+inline unsigned long BlockSize(unsigned long block, unsigned long num_rows) {
+  return std::min(kBlockSize, num_rows - block * kBlockSize);
+}
+
+// the blocks in a chunk of a parallel loop of array_chunk_size rows
+inline int BlocksPerChunk(int array_chunk_size) {
+  return std::max(1, array_chunk_size / int(kBlockSize));
+}
+}
+
+#endif  // VECTORMATH_H
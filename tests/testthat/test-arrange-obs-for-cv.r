@@ -577,6 +577,38 @@ test_that("split_and_join updates x_order so as to only use data in training fol
   # Then returned object is a GBMData object with x_order updated so as to only 
   expect_equal(as.matrix(returned_obj$x_order), as.matrix(x_order_with_training_folds))
 })
+test_that("split_and_join reads the training folds' x_order off an existing x_order", {
+  # Given ordered numeric gbm_data, rows_in_fold and rows_in_training
+  set.seed(1)
+  N <- 1000
+  X1 <- runif(N)
+  X2 <- sample(1:10, N, replace=TRUE)
+  X3 <- 3*runif(N)
+  X1[sample(1:N,size=100)] <- NA
+  Y <- X1 + X2 + X3 + rnorm(N)
+  data <- data.frame(X1=X1,X2=X2,X3=X3)
+  
+  params <- training_params(num_trees=2000, interaction_depth=3, min_num_obs_in_node=10, 
+                            shrinkage=0.005, bag_fraction=0.5, id=seq_len(nrow(data)), num_train=N/2, num_features=3)
+  dist <- gbm_dist("Gaussian")
+  gdata <- gbm_data(data, Y, rep(1, N), rep(0, N))
+  gdata <- predictor_order(gdata, params)
+  cv_groups <- create_cv_groups(gbm_data_obj = gdata, dist, params, 5, FALSE, NULL)
+  
+  rows_in_training_set <- params$id %in% seq_len(params$num_train_rows)
+  params$id <- params$id[rows_in_training_set]
+  rows_in_fold <- params$id %in% seq_len(params$num_train_rows)[(cv_groups == 1)]
+  params$num_train_rows <- length(which(cv_groups != 1))
+  params$num_train <- length(unique(params$id[!rows_in_fold]))
+  
+  # When split_and_join called
+  returned_obj <- split_and_join(gdata, params, rows_in_training_set, rows_in_fold)
+  
+  # Then x_order is that of the training folds' data
+  gdata_train <- gdata
+  gdata_train$x <- as.data.frame(gdata_train$x[rows_in_training_set, ,drop=FALSE][!rows_in_fold, ,drop=FALSE])
+  expect_equal(returned_obj$x_order, predictor_order(gdata_train, params)$x_order)
+})
 test_that("update_fold_dist_data returns the original distribution object if NOT Pairwise or CoxPH", {
   # Given gbm_data, a distribution obj, rows_in_fold and rows_in_training
   ## test Gaussian distribution gbm model
@@ -0,0 +1,76 @@
+context("test fit timings")
+
+make_timings_test_data <- function(N=1000) {
+  X1 <- runif(N)
+  X2 <- 2*runif(N)
+  X3 <- factor(sample(letters[1:4],N,replace=T))
+  mu <- c(-1,0,1,2)[as.numeric(X3)]
+  Y <- X1**1.5 + 2 * (X2**.5) + mu + rnorm(N,0,0.5)
+  X1[sample(1:N,size=100)] <- NA
+
+  data.frame(Y=Y,X1=X1,X2=X2,X3=X3)
+}
+
+test_that("fits have no timings unless they are asked for", {
+  set.seed(1)
+  data <- make_timings_test_data()
+  params <- training_params(num_trees=20, interaction_depth=3,
+                            min_num_obs_in_node=10, shrinkage=0.01,
+                            bag_fraction=0.5, id=seq(nrow(data)),
+                            num_train=nrow(data)/2, num_features=3)
+
+  fit <- gbmt(Y~X1+X2+X3, data=data, train_params=params,
+              par_details=gbmParallel())
+
+  expect_null(fit$timings)
+})
+
+test_that("timings give the phases and work of each tree", {
+  set.seed(1)
+  data <- make_timings_test_data()
+  params <- training_params(num_trees=20, interaction_depth=3,
+                            min_num_obs_in_node=10, shrinkage=0.01,
+                            bag_fraction=0.5, id=seq(nrow(data)),
+                            num_train=nrow(data)/2, num_features=3)
+
+  set.seed(2)
+  fit <- gbmt(Y~X1+X2+X3, data=data, train_params=params,
+              par_details=gbmParallel(timings=TRUE))
+  set.seed(2)
+  fit_untimed <- gbmt(Y~X1+X2+X3, data=data, train_params=params,
+                      par_details=gbmParallel())
+
+  # Then there is a row for each tree
+  expect_true(is.data.frame(fit$timings))
+  expect_equal(fit$timings$tree, 1:20)
+  expect_equal(names(fit$timings),
+               c("tree", "residuals", "split_search", "reassign",
+                 "terminal_fit", "update", "deviance", "conversion",
+                 "rows_scanned", "nodes_searched", "bytes_allocated"))
+  expect_true(all(fit$timings[, -1] >= 0))
+
+  # And each tree searches its root and the children of its splits
+  expect_true(all(fit$timings$nodes_searched ==
+                  1 + 3 * (params$interaction_depth - 1)))
+  expect_true(all(fit$timings$rows_scanned > 0))
+  expect_true(all(fit$timings$bytes_allocated > 0))
+
+  # And recording them does not change the fit
+  expect_equal(fit$fit, fit_untimed$fit)
+  expect_equal(fit$trees, fit_untimed$trees)
+})
+
+test_that("gbm_more adds the timings of its trees", {
+  set.seed(1)
+  data <- make_timings_test_data()
+  params <- training_params(num_trees=20, interaction_depth=3,
+                            min_num_obs_in_node=10, shrinkage=0.01,
+                            bag_fraction=0.5, id=seq(nrow(data)),
+                            num_train=nrow(data)/2, num_features=3)
+
+  fit <- gbmt(Y~X1+X2+X3, data=data, train_params=params,
+              keep_gbm_data=TRUE, par_details=gbmParallel(timings=TRUE))
+  fit_more <- gbm_more(fit, num_new_trees=10, is_verbose=FALSE)
+
+  expect_equal(fit_more$timings$tree, 1:30)
+})
@@ -708,4 +708,72 @@ test_that("When num_trees specified exceeds total number in fit then number in f
   # Then predictions are evaluated at num_trees = length(fit$trees)
   expect_equal(predict(fit, data2, num_trees=length(fit$trees) + 1),
                predict(fit, data2, num_trees=length(fit$trees)))
-})
\ No newline at end of file
+})
+test_that("Compiled model predicts the same as the tree lists", {
+  # Given a fit with missing values and categorical predictors and a copy
+  # that has been saved and reloaded, which loses the compiled model
+  set.seed(1)
+  N <- 1000
+  X1 <- runif(N)
+  X2 <- runif(N)
+  X3 <- factor(sample(letters[1:4],N,replace=T))
+  mu <- c(-1,0,1,2)[as.numeric(X3)]
+  
+  p <- 1/(1+exp(-(sin(3*X1) - 4*X2 + mu)))
+  Y <- rbinom(N,1,p)
+  X1[sample(1:N,size=100)] <- NA
+  X3[sample(1:N,size=100)] <- NA
+  data <- data.frame(Y=Y,X1=X1,X2=X2,X3=X3)
+  
+  params <- training_params(num_trees=100, interaction_depth=3, min_num_obs_in_node=10, 
+                            shrinkage=0.01, bag_fraction=0.5, id=seq(nrow(data)), num_train=N/2, num_features=3)
+  fit <- gbmt(Y~X1+X2+X3, data=data, distribution=gbm_dist("Bernoulli"),
+              train_params=params, is_verbose = FALSE)
+  reloaded <- unserialize(serialize(fit, NULL))
+  
+  expect_true(has_compiled_model(fit))
+  expect_false(has_compiled_model(reloaded))
+  
+  # When predicting with each, including a level unseen in training
+  data2 <- data
+  data2$X3 <- factor(as.character(data2$X3), levels=c(letters[1:4], "z"))
+  data2$X3[1:10] <- "z"
+  
+  # Then the predictions are identical
+  expect_identical(predict(fit, data2, num_trees=c(10, 50, 100)),
+                   predict(reloaded, data2, num_trees=c(10, 50, 100)))
+  expect_identical(predict(fit, data2, num_trees=c(1, 100), single_tree=TRUE),
+                   predict(reloaded, data2, num_trees=c(1, 100), single_tree=TRUE))
+})
+test_that("Bitvector scoring of small trees predicts the same as walking them", {
+  # Given a fit of shallow trees with missing values and categorical
+  # predictors
+  set.seed(1)
+  N <- 1000
+  X1 <- runif(N)
+  X2 <- runif(N)
+  X3 <- factor(sample(letters[1:4],N,replace=T))
+  mu <- c(-1,0,1,2)[as.numeric(X3)]
+  
+  Y <- X1**1.5 + 2 * (X2**.5) + mu + rnorm(N,0,0.1)
+  X1[sample(1:N,size=100)] <- NA
+  X3[sample(1:N,size=100)] <- NA
+  data <- data.frame(Y=Y,X1=X1,X2=X2,X3=X3)
+  
+  params <- training_params(num_trees=100, interaction_depth=2, min_num_obs_in_node=10, 
+                            shrinkage=0.01, bag_fraction=0.5, id=seq(nrow(data)), num_train=N/2, num_features=3)
+  fit <- gbmt(Y~X1+X2+X3, data=data, distribution=gbm_dist("Gaussian"),
+              train_params=params, is_verbose = FALSE)
+  
+  # When predicting with most of the trees, which scores their leaf
+  # bitvectors, and with few of them, which walks the trees - including
+  # NaN and a level unseen in training
+  data2 <- data
+  data2$X1[1:10] <- NaN
+  data2$X3 <- factor(as.character(data2$X3), levels=c(letters[1:4], "z"))
+  data2$X3[11:20] <- "z"
+  
+  # Then the predictions are identical
+  expect_identical(predict(fit, data2, num_trees=c(10, 100))[, 1],
+                   predict(fit, data2, num_trees=10))
+})
@@ -0,0 +1,47 @@
+context("test generated C code")
+
+test_that("Generated C code predicts the same as predict.GBMFit", {
+  skip_on_cran()
+  
+  # Given a fit with missing values and categorical predictors
+  set.seed(1)
+  N <- 1000
+  X1 <- runif(N)
+  X2 <- runif(N)
+  X3 <- factor(sample(letters[1:4],N,replace=T))
+  mu <- c(-1,0,1,2)[as.numeric(X3)]
+  
+  p <- 1/(1+exp(-(sin(3*X1) - 4*X2 + mu)))
+  Y <- rbinom(N,1,p)
+  X1[sample(1:N,size=100)] <- NA
+  X3[sample(1:N,size=100)] <- NA
+  data <- data.frame(Y=Y,X1=X1,X2=X2,X3=X3)
+  
+  params <- training_params(num_trees=100, interaction_depth=3, min_num_obs_in_node=10, 
+                            shrinkage=0.01, bag_fraction=0.5, id=seq(nrow(data)), num_train=N/2, num_features=3)
+  fit <- gbmt(Y~X1+X2+X3, data=data, distribution=gbm_dist("Bernoulli"),
+              train_params=params, is_verbose = FALSE)
+  
+  # When its C code is built into a shared library and used to predict
+  # random data
+  source_file <- tempfile(fileext=".c")
+  gbm_generate_c(fit, num_trees=80, file=source_file, prefix="test_model")
+  status <- system2(file.path(R.home("bin"), "R"),
+                    c("CMD", "SHLIB", shQuote(source_file)),
+                    stdout=FALSE, stderr=FALSE)
+  expect_equal(status, 0)
+  library_file <- sub("\\.c$", .Platform$dynlib.ext, source_file)
+  dyn.load(library_file)
+  on.exit(dyn.unload(library_file))
+  
+  new_data <- data.frame(X1=runif(N), X2=runif(N),
+                         X3=factor(sample(letters[1:4],N,replace=T), levels=letters[1:4]))
+  new_data$X1[sample(1:N,size=100)] <- NA
+  new_data$X3[sample(1:N,size=100)] <- NA
+  x <- cbind(new_data$X1, new_data$X2, as.numeric(new_data$X3)-1)
+  predictions <- .C("test_model_predict_batch", as.double(x), as.integer(N),
+                    predictions=double(N))$predictions
+  
+  # Then the predictions are the same as predict's
+  expect_equal(predictions, predict(fit, new_data, num_trees=80))
+})
@@ -0,0 +1,107 @@
+context("test histogram split search")
+
+make_histogram_test_data <- function(N=2000) {
+  X1 <- runif(N)
+  X2 <- 2*runif(N)
+  X3 <- factor(sample(letters[1:4],N,replace=T))
+  X4 <- ordered(sample(letters[1:6],N,replace=T))
+  X5 <- factor(sample(letters[1:3],N,replace=T))
+  X6 <- 3*runif(N)
+  mu <- c(-1,0,1,2)[as.numeric(X3)]
+
+  SNR <- 10 # signal-to-noise ratio
+  Y <- X1**1.5 + 2 * (X2**.5) + mu
+  sigma <- sqrt(var(Y)/SNR)
+  Y <- Y + rnorm(N,0,sigma)
+
+  ## create a bunch of missing values
+  X1[sample(1:N,size=100)] <- NA
+  X3[sample(1:N,size=300)] <- NA
+
+  data.frame(Y=Y,X1=X1,X2=X2,X3=X3,X4=X4,X5=X5,X6=X6)
+}
+
+test_that("histogram split search fits as well as the exact search", {
+  set.seed(1)
+  data <- make_histogram_test_data()
+  params <- training_params(num_trees=500, interaction_depth=3,
+                            min_num_obs_in_node=10, shrinkage=0.01,
+                            bag_fraction=0.5, id=seq(nrow(data)),
+                            num_train=nrow(data)/2, num_features=6)
+
+  set.seed(2)
+  fit_exact <- gbmt(Y~X1+X2+X3+X4+X5+X6, data=data,
+                    train_params=params, keep_gbm_data=TRUE,
+                    par_details=gbmParallel())
+  set.seed(2)
+  fit_hist <- gbmt(Y~X1+X2+X3+X4+X5+X6, data=data,
+                   train_params=params, keep_gbm_data=TRUE,
+                   par_details=gbmParallel(split_search="histogram",
+                                           num_bins=32))
+
+  # Then the validation error is within a few percent of the exact fit
+  expect_true(tail(fit_hist$valid.error, 1) <
+              1.05 * tail(fit_exact$valid.error, 1))
+
+  # And predictions agree with the fitted values
+  expect_equal(predict(fit_hist, data[seq_len(nrow(data)/2), ], 500),
+               fit_hist$fit[seq_len(nrow(data)/2)])
+})
+
+test_that("histogram split search is reproducible", {
+  set.seed(1)
+  data <- make_histogram_test_data(500)
+  params <- training_params(num_trees=50, interaction_depth=3,
+                            min_num_obs_in_node=10, shrinkage=0.01,
+                            bag_fraction=0.5, id=seq(nrow(data)),
+                            num_train=nrow(data), num_features=6)
+
+  set.seed(2)
+  fit1 <- gbmt(Y~X1+X2+X3+X4+X5+X6, data=data, train_params=params,
+               par_details=gbmParallel(split_search="histogram"))
+  set.seed(2)
+  fit2 <- gbmt(Y~X1+X2+X3+X4+X5+X6, data=data, train_params=params,
+               par_details=gbmParallel(split_search="histogram"))
+
+  expect_equal(fit1$fit, fit2$fit)
+})
+
+test_that("histogram split search works with more than 256 bins", {
+  set.seed(1)
+  data <- make_histogram_test_data()
+  params <- training_params(num_trees=100, interaction_depth=3,
+                            min_num_obs_in_node=10, shrinkage=0.01,
+                            bag_fraction=0.5, id=seq(nrow(data)),
+                            num_train=nrow(data)/2, num_features=6)
+
+  set.seed(2)
+  fit <- gbmt(Y~X1+X2+X3+X4+X5+X6, data=data, train_params=params,
+              par_details=gbmParallel(split_search="histogram",
+                                      num_bins=1000))
+
+  # Then the validation set predictions match the fitted values
+  valid_rows <- seq(nrow(data)/2 + 1, nrow(data))
+  expect_equal(predict(fit, data[valid_rows, ], 100),
+               fit$fit[valid_rows])
+})
+
+test_that("gbm refuses to work with an insane number of bins", {
+  set.seed(1)
+  data <- make_histogram_test_data(500)
+
+  expect_error(gbmt(Y~X1+X2+X3+X4+X5+X6, data=data,
+                    par_details=gbmParallel(split_search="histogram",
+                                            num_bins=1)),
+               "number of histogram bins must be between 2 and 65535",
+               fixed=TRUE)
+})
+
+test_that("gbm refuses to work with an unknown split search", {
+  set.seed(1)
+  data <- make_histogram_test_data(500)
+
+  expect_error(gbmt(Y~X1+X2+X3+X4+X5+X6, data=data,
+                    par_details=gbmParallel(split_search="approximate")),
+               "split search must be either \"exact\" or \"histogram\"",
+               fixed=TRUE)
+})
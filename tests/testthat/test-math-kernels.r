@@ -0,0 +1,80 @@
+context("test vectorized math kernels")
+
+math_kernel_test_values <- function() {
+  set.seed(1)
+  c(0, 1e-300, -1e-300, 0.5, -0.5, log(2), 37, -37, 709.78, -745.1,
+    seq(-745, 709, length.out=10007), runif(10000, -40, 40),
+    rnorm(1000, 0, 1e-8))
+}
+
+relative_error <- function(value, expected) {
+  abs(value - expected) / abs(expected)
+}
+
+test_that("exp agrees with R's to within a few ulp", {
+  x <- math_kernel_test_values()
+  kernels <- .Call("gbm_math_kernels", x, PACKAGE="gbm")
+  expected <- exp(x)
+  normal <- expected > .Machine$double.xmin & is.finite(expected)
+
+  for (name in names(kernels)) {
+    value <- kernels[[name]]$exp
+    expect_true(max(relative_error(value[normal], expected[normal])) <
+                  4 * .Machine$double.eps, info=name)
+    expect_true(max(abs(value[!normal] - expected[!normal])) <=
+                  2 * 4.9406564584124654e-324, info=name)
+  }
+})
+
+test_that("log(1 + exp) agrees with R's to within a few ulp", {
+  x <- math_kernel_test_values()
+  kernels <- .Call("gbm_math_kernels", x, PACKAGE="gbm")
+  expected <- ifelse(x > 0, x + log1p(exp(-x)), log1p(exp(x)))
+  normal <- expected > .Machine$double.xmin
+
+  for (name in names(kernels)) {
+    value <- kernels[[name]]$log1pexp
+    expect_true(max(relative_error(value[normal], expected[normal])) <
+                  4 * .Machine$double.eps, info=name)
+  }
+})
+
+test_that("the kernels handle infinities, NaN and the ends of the range", {
+  x <- c(Inf, -Inf, NaN, 710, 1000, -746, -1000)
+  kernels <- .Call("gbm_math_kernels", x, PACKAGE="gbm")
+
+  for (name in names(kernels)) {
+    expect_equal(kernels[[name]]$exp, c(Inf, 0, NaN, Inf, Inf, 0, 0),
+                 info=name)
+    expect_equal(kernels[[name]]$log1pexp, c(Inf, 0, NaN, 710, 1000, 0, 0),
+                 info=name)
+  }
+})
+
+test_that("every set of kernels gives the same results", {
+  x <- math_kernel_test_values()
+  kernels <- .Call("gbm_math_kernels", x, PACKAGE="gbm")
+
+  expect_true("scalar" %in% names(kernels))
+  for (name in names(kernels)) {
+    expect_identical(kernels[[name]], kernels$scalar, info=name)
+  }
+})
+
+test_that("the training deviance agrees with one computed in R", {
+  set.seed(1)
+  N <- 1000
+  X1 <- runif(N)
+  X2 <- runif(N)
+  Y <- rbinom(N, 1, plogis(2 * X1 - X2))
+  data <- data.frame(Y=Y, X1=X1, X2=X2)
+
+  fit <- gbm(Y ~ X1 + X2, data=data, distribution="bernoulli",
+             n.trees=50, interaction.depth=2, shrinkage=0.1)
+
+  # the deviance of the fit's own predictions, computed in R
+  f <- fit$fit
+  deviance <- -2 * mean(Y * f - log1p(exp(f)))
+
+  expect_equal(fit$train.error[50], deviance, tolerance=1e-12)
+})
@@ -0,0 +1,85 @@
+context("test model files")
+
+test_that("Model read from a file predicts the same as the fit", {
+  # Given a fit with missing values and categorical predictors written to
+  # a model file
+  set.seed(1)
+  N <- 1000
+  X1 <- runif(N)
+  X2 <- runif(N)
+  X3 <- factor(sample(letters[1:4],N,replace=T))
+  mu <- c(-1,0,1,2)[as.numeric(X3)]
+  
+  p <- 1/(1+exp(-(sin(3*X1) - 4*X2 + mu)))
+  Y <- rbinom(N,1,p)
+  X1[sample(1:N,size=100)] <- NA
+  X3[sample(1:N,size=100)] <- NA
+  data <- data.frame(Y=Y,X1=X1,X2=X2,X3=X3)
+  
+  params <- training_params(num_trees=100, interaction_depth=3, min_num_obs_in_node=10, 
+                            shrinkage=0.01, bag_fraction=0.5, id=seq(nrow(data)), num_train=N/2, num_features=3)
+  fit <- gbmt(Y~X1+X2+X3, data=data, distribution=gbm_dist("Bernoulli"),
+              train_params=params, is_verbose = FALSE)
+  model_file <- tempfile(fileext=".gbm")
+  on.exit(unlink(model_file))
+  write_gbm_model(fit, model_file)
+  
+  # When it is read back into the fit without its trees
+  no_trees <- fit
+  no_trees$trees <- NULL
+  no_trees$c.splits <- NULL
+  no_trees$compiled_model <- NULL
+  read_back <- read_gbm_model(model_file, no_trees)
+  
+  # Then the predictions are identical
+  expect_true(has_compiled_model(read_back))
+  expect_identical(predict(read_back, data, num_trees=c(10, 50, 100)),
+                   predict(fit, data, num_trees=c(10, 50, 100)))
+})
+
+test_that("Reading a model file checks it", {
+  # Given a fit and a file that is not a model file
+  set.seed(1)
+  N <- 100
+  data <- data.frame(Y=rnorm(N), X1=runif(N))
+  params <- training_params(num_trees=10, interaction_depth=2, min_num_obs_in_node=5, 
+                            shrinkage=0.1, bag_fraction=0.5, id=seq(N), num_train=N, num_features=1)
+  fit <- gbmt(Y~X1, data=data, train_params=params, is_verbose = FALSE)
+  other_file <- tempfile()
+  on.exit(unlink(other_file))
+  writeLines("not a model", other_file)
+  
+  # When read as a model file
+  # Then an error is thrown
+  expect_error(read_gbm_model(other_file, fit))
+})
+
+test_that("Reading a model file checks its trees", {
+  # Given a model file whose first split sends its right branch to the
+  # node of its left, making the tree a graph
+  set.seed(1)
+  N <- 100
+  data <- data.frame(Y=rnorm(N), X1=runif(N))
+  params <- training_params(num_trees=10, interaction_depth=2, min_num_obs_in_node=5, 
+                            shrinkage=0.1, bag_fraction=0.5, id=seq(N), num_train=N, num_features=1)
+  fit <- gbmt(Y~X1, data=data, train_params=params, is_verbose = FALSE)
+  model_file <- tempfile(fileext=".gbm")
+  on.exit(unlink(model_file))
+  write_gbm_model(fit, model_file)
+
+  # the image follows a 64 byte header - six integer sizes, the split
+  # values, then the tree roots, split variables and left and right nodes
+  bytes <- readBin(model_file, "raw", file.info(model_file)$size)
+  sizes <- readBin(bytes[65:88], "integer", 6, size=4)
+  num_trees <- sizes[2]
+  num_nodes <- sizes[3]
+  left <- 88 + 8*num_nodes + 4*num_trees + 4*num_nodes
+  right <- left + 4*num_nodes
+  expect_true(readBin(bytes[left + 1:4], "integer", size=4) >= 0)
+  bytes[right + 1:4] <- bytes[left + 1:4]
+  writeBin(bytes, model_file)
+
+  # When read as a model file
+  # Then an error is thrown
+  expect_error(read_gbm_model(model_file, fit), "invalid node")
+})
@@ -323,4 +323,21 @@ test_that("Can order by predictors - check predictor_order", {
   # Then can order by predictors
   data <- predictor_order(data, train_p)
   expect_equal(data$x_order, apply(data$x[seq_len(train_p$num_train_rows),,drop=FALSE], 2, order,na.last=FALSE)-1)
-})
\ No newline at end of file
+})test_that("Native predictor order matches R's order with ties and missing values", {
+  # Given numeric gbm data with ties and missing values
+  set.seed(1)
+  N <- 1000
+  X1 <- runif(N)
+  X2 <- sample(1:5, N, replace=TRUE)
+  X3 <- round(rnorm(N), 1)
+  X1[sample(1:N,size=100)] <- NA
+  X2[sample(1:N,size=50)] <- NA
+  data <- gbm_data(data.frame(X1, X2, X3), rnorm(N), rep(1, N), rep(0, N))
+  train_p <- training_params(id=seq_len(N), num_train=N/2, num_features=3)
+  
+  # When ordered on several threads
+  data <- predictor_order(data, train_p, gbmParallel(num_threads=2))
+  
+  # Then the order matches order() on each column
+  expect_equal(data$x_order, apply(data$x[seq_len(train_p$num_train_rows),,drop=FALSE], 2, order,na.last=FALSE)-1)
+})
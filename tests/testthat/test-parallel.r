@@ -148,3 +148,138 @@ test_that("gaussian works in parallel- old api", {
     expect_true(cor(data2$Y, f.predict) > 0.990)
     expect_true(sd(data2$Y-f.predict) < sigma)
 })
+
+test_that("parallel predictions are identical to serial ones", {
+  skip_on_cran()
+  set.seed(1)
+
+  # create some data
+  N <- 5000
+  X1 <- runif(N)
+  X2 <- 2*runif(N)
+  X3 <- factor(sample(letters[1:4],N,replace=TRUE))
+  mu <- c(-1,0,1,2)[as.numeric(X3)]
+  Y <- X1**1.5 + 2 * (X2**.5) + mu + rnorm(N)
+  X1[sample(1:N,size=500)] <- NA
+  X3[sample(1:N,size=500)] <- NA
+  data <- data.frame(Y=Y,X1=X1,X2=X2,X3=X3)
+
+  params <- training_params(num_trees=200, interaction_depth=3, min_num_obs_in_node=10,
+                            shrinkage=0.01, bag_fraction=0.5, id=seq(nrow(data)),
+                            num_train=N/2, num_features=3)
+  fit <- gbmt(Y~X1+X2+X3, data=data, train_params=params,
+              par_details=gbmParallel(num_threads=1))
+
+  # When predicting with several threads and small blocks of rows
+  serial <- predict(fit, data, num_trees=c(50, 200))
+  fit$par_details <- gbmParallel(num_threads=4, array_chunk_size=100)
+  parallel <- predict(fit, data, num_trees=c(50, 200))
+
+  # Then the predictions are identical
+  expect_identical(parallel, serial)
+})
+
+test_that("fits are identical whatever the number of threads", {
+  skip_on_cran()
+  require(survival)
+  set.seed(1)
+
+  # create some data
+  N <- 4000
+  X1 <- runif(N)
+  X2 <- 2*runif(N)
+  X3 <- factor(sample(letters[1:4],N,replace=TRUE))
+  mu <- c(-1,0,1,2)[as.numeric(X3)]
+  f <- X1**1.5 + 2 * (X2**.5) + mu
+  X1[sample(1:N,size=400)] <- NA
+  query <- sample(1:200,N,replace=TRUE)
+  tt.surv <- rexp(N,exp(f/4))
+  tt.cens <- rexp(N,0.5)
+  data <- data.frame(Y=f + rnorm(N), B=rbinom(N,1,plogis(f - 1)),
+                     P=rpois(N,exp(f/2)), G=rgamma(N,shape=2,rate=2*exp(-f/4)),
+                     R=pmin(pmax(round(f), 0), 4),
+                     tt=pmin(tt.surv,tt.cens), delta=as.numeric(tt.surv <= tt.cens),
+                     query=query, X1=X1, X2=X2, X3=X3)
+
+  params <- training_params(num_trees=50, interaction_depth=3, min_num_obs_in_node=10,
+                            shrinkage=0.05, bag_fraction=0.5, id=seq(nrow(data)),
+                            num_train=N/2, num_features=3)
+  fits <- list(list(Y~X1+X2+X3, gbm_dist("Gaussian")),
+               list(B~X1+X2+X3, gbm_dist("Bernoulli")),
+               list(B~X1+X2+X3, gbm_dist("Huberized")),
+               list(B~X1+X2+X3, gbm_dist("AdaBoost")),
+               list(P~X1+X2+X3, gbm_dist("Poisson")),
+               list(G~X1+X2+X3, gbm_dist("Gamma")),
+               list(Y~X1+X2+X3, gbm_dist("Laplace")),
+               list(Y~X1+X2+X3, gbm_dist("Quantile", alpha=0.25)),
+               list(Y~X1+X2+X3, gbm_dist("TDist")),
+               list(P~X1+X2+X3, gbm_dist("Tweedie")),
+               list(Surv(tt,delta)~X1+X2+X3, gbm_dist("CoxPH", prior_node_coeff_var=10)),
+               list(R~X1+X2+X3, gbm_dist("Pairwise", metric="ndcg", group="query")))
+
+  for (i in seq_along(fits)) {
+    # When fitting with one thread and with several threads and small chunks
+    set.seed(2)
+    serial <- gbmt(fits[[i]][[1]], data=data, distribution=fits[[i]][[2]],
+                   train_params=params, is_verbose=FALSE,
+                   par_details=gbmParallel(num_threads=1))
+    set.seed(2)
+    parallel <- gbmt(fits[[i]][[1]], data=data, distribution=fits[[i]][[2]],
+                     train_params=params, is_verbose=FALSE,
+                     par_details=gbmParallel(num_threads=4, array_chunk_size=256))
+
+    # Then the fits are identical
+    name <- class(fits[[i]][[2]])[1]
+    expect_identical(parallel$fit, serial$fit, info=name)
+    expect_identical(parallel$train.error, serial$train.error, info=name)
+    expect_identical(parallel$valid.error, serial$valid.error, info=name)
+    expect_identical(parallel$oobag.improve, serial$oobag.improve, info=name)
+    expect_identical(parallel$trees, serial$trees, info=name)
+  }
+})
+
+test_that("histogram fits are identical whatever the number of threads", {
+  skip_on_cran()
+  set.seed(1)
+
+  # create data with enough rows in bag that the histograms of the first
+  # nodes are built from several shards
+  N <- 40000
+  X1 <- runif(N)
+  X2 <- 2*runif(N)
+  X3 <- factor(sample(letters[1:4],N,replace=TRUE))
+  mu <- c(-1,0,1,2)[as.numeric(X3)]
+  f <- X1**1.5 + 2 * (X2**.5) + mu
+  X1[sample(1:N,size=4000)] <- NA
+  data <- data.frame(Y=f + rnorm(N), B=rbinom(N,1,plogis(f - 1)),
+                     X1=X1, X2=X2, X3=X3)
+
+  params <- training_params(num_trees=20, interaction_depth=3, min_num_obs_in_node=10,
+                            shrinkage=0.05, bag_fraction=0.5, id=seq(nrow(data)),
+                            num_train=N/2, num_features=3)
+  expect_true(params$num_train * params$bag_fraction >= 8192)
+  fits <- list(list(Y~X1+X2+X3, gbm_dist("Gaussian")),
+               list(B~X1+X2+X3, gbm_dist("Bernoulli")))
+
+  for (i in seq_along(fits)) {
+    # When fitting from histograms with one thread and with eight
+    set.seed(2)
+    serial <- gbmt(fits[[i]][[1]], data=data, distribution=fits[[i]][[2]],
+                   train_params=params, is_verbose=FALSE,
+                   par_details=gbmParallel(num_threads=1,
+                                           split_search="histogram"))
+    set.seed(2)
+    parallel <- gbmt(fits[[i]][[1]], data=data, distribution=fits[[i]][[2]],
+                     train_params=params, is_verbose=FALSE,
+                     par_details=gbmParallel(num_threads=8,
+                                             split_search="histogram"))
+
+    # Then the fits are identical
+    name <- class(fits[[i]][[2]])[1]
+    expect_identical(parallel$fit, serial$fit, info=name)
+    expect_identical(parallel$train.error, serial$train.error, info=name)
+    expect_identical(parallel$valid.error, serial$valid.error, info=name)
+    expect_identical(parallel$oobag.improve, serial$oobag.improve, info=name)
+    expect_identical(parallel$trees, serial$trees, info=name)
+  }
+})
@@ -0,0 +1,111 @@
+context("test prepared data")
+
+make_prepared_test_data <- function(N=1000) {
+  X1 <- runif(N)
+  X2 <- 2*runif(N)
+  X3 <- factor(sample(letters[1:4],N,replace=T))
+  X4 <- 3*runif(N)
+  mu <- c(-1,0,1,2)[as.numeric(X3)]
+
+  SNR <- 10 # signal-to-noise ratio
+  Y <- X1**1.5 + 2 * (X2**.5) + mu
+  sigma <- sqrt(var(Y)/SNR)
+  Y <- Y + rnorm(N,0,sigma)
+
+  ## create a bunch of missing values
+  X1[sample(1:N,size=100)] <- NA
+  X3[sample(1:N,size=100)] <- NA
+
+  data.frame(Y=Y,X1=X1,X2=X2,X3=X3,X4=X4)
+}
+
+test_that("gbm_more gives the same fit with the prepared data as without", {
+  # Given a fit keeping its data and a copy that has been saved and
+  # reloaded, which loses the prepared data
+  set.seed(1)
+  data <- make_prepared_test_data()
+  params <- training_params(num_trees=50, interaction_depth=3,
+                            min_num_obs_in_node=10, shrinkage=0.01,
+                            bag_fraction=0.5, id=seq(nrow(data)),
+                            num_train=nrow(data)/2, num_features=4)
+  fit <- gbmt(Y~X1+X2+X3+X4, data=data, train_params=params,
+              keep_gbm_data=TRUE)
+  reloaded <- unserialize(serialize(fit, NULL))
+
+  expect_true(has_prepared_data(fit$gbm_data_obj))
+  expect_false(has_prepared_data(reloaded$gbm_data_obj))
+
+  # When more trees are fitted to each
+  set.seed(2)
+  more_prepared <- gbm_more(fit, num_new_trees=50)
+  set.seed(2)
+  more_reloaded <- gbm_more(reloaded, num_new_trees=50)
+
+  # Then the fits are the same
+  expect_equal(more_prepared$fit, more_reloaded$fit)
+  expect_equal(more_prepared$trees, more_reloaded$trees)
+})
+
+test_that("CV folds fit the same with the prepared data as without", {
+  # Given data ordered and prepared as gbmt_fit does
+  set.seed(1)
+  data <- make_prepared_test_data()
+  params <- training_params(num_trees=50, interaction_depth=3,
+                            min_num_obs_in_node=10, shrinkage=0.01,
+                            bag_fraction=0.5, id=seq(nrow(data)),
+                            num_train=nrow(data)/2, num_features=4)
+  dist <- gbm_dist("Gaussian")
+  gdata <- gbm_data(data[, -1], data$Y, rep(1, nrow(data)), rep(0, nrow(data)))
+  variables <- var_container(gdata, NULL, NULL)
+  dist <- create_strata(gdata, params, dist)
+  gdata <- convert_factors(gdata)
+  gdata <- validate_gbm_data(gdata, dist)
+  gdata <- order_data(gdata, dist, params)
+  params$id <- params$id[params$id_order]
+  cv_groups <- create_cv_groups(gdata, dist, params, 3, FALSE, NULL)
+  gdata_prepared <- prepare_gbm_data(gdata, dist, params, variables)
+
+  # When a fold is fitted from each
+  fold <- extract_obs_in_fold(gdata, dist, params, cv_groups, fold_num=2)
+  fold_prepared <- extract_obs_in_fold(gdata_prepared, dist, params, cv_groups, fold_num=2)
+  expect_true(has_prepared_data(fold_prepared$data))
+
+  set.seed(2)
+  fit <- gbm_call(fold$data, fold$dist, fold$params, variables,
+                  gbmParallel(), FALSE)
+  set.seed(2)
+  fit_prepared <- gbm_call(fold_prepared$data, fold_prepared$dist,
+                           fold_prepared$params, variables, gbmParallel(), FALSE)
+
+  # Then the fits are the same
+  expect_equal(fit_prepared$fit, fit$fit)
+  expect_equal(fit_prepared$trees, fit$trees)
+})
+
+test_that("gbm_more gives the same histogram fit with the binned data as without", {
+  # Given a histogram fit keeping only the bin codes of its predictors and
+  # a reloaded copy, which bins the predictors again
+  set.seed(1)
+  data <- make_prepared_test_data()
+  params <- training_params(num_trees=50, interaction_depth=3,
+                            min_num_obs_in_node=10, shrinkage=0.01,
+                            bag_fraction=0.5, id=seq(nrow(data)),
+                            num_train=nrow(data)/2, num_features=4)
+  fit <- gbmt(Y~X1+X2+X3+X4, data=data, train_params=params,
+              keep_gbm_data=TRUE,
+              par_details=gbmParallel(split_search="histogram", num_bins=16))
+  reloaded <- unserialize(serialize(fit, NULL))
+
+  expect_true(has_prepared_data(fit$gbm_data_obj))
+  expect_null(fit$gbm_data_obj$x_order)
+
+  # When more trees are fitted to each
+  set.seed(2)
+  more_prepared <- gbm_more(fit, num_new_trees=50)
+  set.seed(2)
+  more_reloaded <- gbm_more(reloaded, num_new_trees=50)
+
+  # Then the fits are the same
+  expect_equal(more_prepared$fit, more_reloaded$fit)
+  expect_equal(more_prepared$trees, more_reloaded$trees)
+})
@@ -0,0 +1,47 @@
+context("test trace of the fit")
+
+test_that("a trace of each thread is written at the end of the fit", {
+  set.seed(1)
+  N <- 1000
+  X1 <- runif(N)
+  X2 <- factor(sample(letters[1:4],N,replace=T))
+  Y <- X1 + c(-1,0,1,2)[as.numeric(X2)] + rnorm(N,0,0.5)
+  data <- data.frame(Y=Y,X1=X1,X2=X2)
+  params <- training_params(num_trees=10, interaction_depth=2,
+                            min_num_obs_in_node=10, shrinkage=0.01,
+                            bag_fraction=0.5, id=seq(nrow(data)),
+                            num_train=nrow(data)/2, num_features=2)
+  trace_file <- tempfile(fileext=".json")
+
+  fit <- gbmt(Y~X1+X2, data=data, train_params=params,
+              par_details=gbmParallel(num_threads=2, trace_file=trace_file))
+
+  # Then the trace has the trees and the searches of the predictors
+  expect_true(file.exists(trace_file))
+  trace <- paste(readLines(trace_file), collapse="\n")
+  expect_true(grepl("\"traceEvents\"", trace))
+  expect_equal(length(gregexpr("\"name\":\"tree\"", trace)[[1]]), 10)
+  expect_true(grepl("\"name\":\"GenerateAllSplits\"", trace))
+  expect_true(grepl("\"name\":\"categorical feature\"", trace))
+  expect_true(grepl("\"name\":\"continuous feature\"", trace))
+  unlink(trace_file)
+})
+
+test_that("fits are not traced without a trace file", {
+  set.seed(1)
+  N <- 200
+  data <- data.frame(Y=rnorm(N), X1=runif(N))
+  params <- training_params(num_trees=5, interaction_depth=2,
+                            min_num_obs_in_node=10, shrinkage=0.01,
+                            bag_fraction=0.5, id=seq(nrow(data)),
+                            num_train=nrow(data), num_features=1)
+  trace_dir <- tempfile()
+  dir.create(trace_dir)
+  old_dir <- setwd(trace_dir)
+  on.exit(setwd(old_dir))
+
+  fit <- gbmt(Y~X1, data=data, train_params=params,
+              par_details=gbmParallel())
+
+  expect_equal(length(list.files(trace_dir)), 0)
+})
@@ -0,0 +1,718 @@
+//-----------------------------------
+//
+// File: gbm_bench.cpp
+//
+// Description: benchmarks of the engine's hot paths on synthetic data,
+//   written as JSON so that results can be compared release over release.
+//
+//   gbm-bench [--quick] [--threads 1,2,4] [--repeats 5]
+//             [--output results.json]
+//
+//   Times, for a range of rows, predictors, categorical levels, missing
+//   rates and threads:
+//    - split_search: CNodeSearch::GenerateAllSplits, exact and histogram
+//    - reassign_data: CNodeSearch::CalcImprovementAndSplit, which makes
+//      the best split and reassigns the rows by ReassignData
+//    - working_response, deviance, fit_best_constant: each
+//      distribution's ComputeWorkingResponse, Deviance and
+//      FitBestConstant.  Pairwise working responses are
+//      CPairwise::ComputeLambdas and the CoxPH kernels run its
+//      LogLikelihood loops, for right censored and counting data.
+//    - fused_update: CDistribution::FusedUpdate, the one sweep of the
+//      rows after a tree of the distributions that have one
+//    - predict: CompiledModel::Predict, the scoring behind gbm_pred
+//    - fit: whole Gaussian fits of many small trees by
+//      CGBMEngine::FitLearner, where the cost of starting and stopping
+//      the threads of each tree shows
+//
+//   Each result gives the best and mean of the repeats in seconds and the
+//   rows processed per second at the best.  The header names the exp and
+//   log(1 + exp) kernels the distributions ran with.
+//
+//-----------------------------------
+
+//-----------------------------------
+// Includes
+//-----------------------------------
+#include "compiled_model.h"
+#include "datadistparams.h"
+#include "gbm_datadistcontainer.h"
+#include "gbm_engine.h"
+#include "gbm_exception.h"
+#include "gbm_fit.h"
+#include "gbm_functions.h"
+#include "gbm_platform.h"
+#include "node_search.h"
+#include "parallel_details.h"
+#include "span.h"
+#include "tree.h"
+#include "treeparams.h"
+#include "vector_math.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace {
+const int kTreeDepth = 4;
+const int kMinObsInNode = 10;
+const int kChunkSize = 1024;
+const int kNumPredictTrees = 100;
+const int kGroupSize = 20;
+const int kFitRows = 10000;
+const int kFitVars = 10;
+
+double Now() {
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + 1e-9 * now.tv_nsec;
+}
+
+// The shape of a synthetic dataset - every other predictor is
+// categorical when num_levels is not 0.
+struct DataSpec {
+  int num_rows;
+  int num_vars;
+  int num_levels;
+  double missing_rate;
+
+  DataSpec(int rows, int vars, int levels, double missing)
+      : num_rows(rows), num_vars(vars), num_levels(levels),
+        missing_rate(missing) {}
+};
+
+// Best and mean times of a benchmark.
+struct Result {
+  std::string benchmark;
+  std::string distribution;
+  std::string split_search;
+  DataSpec spec;
+  int trees;
+  int threads;
+  int repeats;
+  double best;
+  double mean;
+
+  Result(const std::string& kBenchmark, const DataSpec& kSpec, int threads_in)
+      : benchmark(kBenchmark), spec(kSpec), trees(0), threads(threads_in),
+        repeats(0), best(0.0), mean(0.0) {}
+
+  void add(double seconds) {
+    best = (repeats == 0) ? seconds : std::min(best, seconds);
+    mean = (mean * repeats + seconds) / (repeats + 1);
+    repeats++;
+  }
+};
+
+double Uniform() { return gbm_platform::UniformRandom(); }
+
+double Normal() {
+  // Box-Muller, with the first uniform kept away from 0
+  const double kU = 1.0 - Uniform();
+  const double kAngle = 6.283185307179586 * Uniform();
+  return std::sqrt(-2.0 * std::log(kU)) * std::cos(kAngle);
+}
+
+//-----------------------------------
+// Class: SyntheticData
+//
+// Description: predictors and a response of a distribution, generated
+//   from a seed and held for the engine to view.  All rows are training
+//   rows and each is an observation of its own.
+//-----------------------------------
+class SyntheticData {
+ public:
+  SyntheticData(const DataSpec& kSpec, const std::string& kFamily)
+      : kSpec_(kSpec), family_(kFamily) {
+    const int kRows = kSpec.num_rows;
+    const int kVars = kSpec.num_vars;
+    gbm_platform::SetSeed(kRows + 7 * kVars + 31 * kSpec.num_levels);
+
+    xvalues_.resize((long)kRows * kVars);
+    var_classes_.assign(kVars, 0);
+    std::vector<double> signal(kRows, 0.0);
+    for (int var = 0; var < kVars; var++) {
+      const bool kIsCategorical = (kSpec.num_levels > 0) && (var % 2 == 1);
+      var_classes_[var] = kIsCategorical ? kSpec.num_levels : 0;
+      const double kEffect = (var < 5) ? 1.0 / (var + 1) : 0.0;
+      double* column = &xvalues_[(long)var * kRows];
+      for (int row = 0; row < kRows; row++) {
+        const double kValue = kIsCategorical
+                                  ? double(int(Uniform() * kSpec.num_levels))
+                                  : Uniform();
+        signal[row] += kEffect * (kIsCategorical ? int(kValue) % 2 : kValue);
+        column[row] = (Uniform() < kSpec.missing_rate) ? gbm_platform::NA()
+                                                       : kValue;
+      }
+    }
+
+    MakeResponse(signal);
+    observation_ids_.resize(kRows);
+    for (int row = 0; row < kRows; row++) observation_ids_[row] = row;
+    weights_.assign(kRows, 1.0);
+    monotonicity_.assign(kVars, 0);
+  }
+
+  const DataSpec& spec() const { return kSpec_; }
+  const double* xvalues() const { return &xvalues_[0]; }
+  const std::vector<int>& var_classes() const { return var_classes_; }
+
+  // Fills the engine's parameters with views of the data.
+  void View(DataDistParams& params, const parallel_details& kParallel) {
+    const int kRows = kSpec_.num_rows;
+    const int kVars = kSpec_.num_vars;
+    order_.resize((long)kRows * kVars);
+    gbm_functions::OrderPredictors(
+        MatrixSpan<const double>(&xvalues_[0], kRows, kVars), kRows,
+        kParallel.get_num_threads(), &order_[0]);
+
+    params.response = MatrixSpan<double>(&response_[0], kRows,
+                                         response_.size() / kRows);
+    if (!int_response_.empty()) {
+      params.intResponse = MatrixSpan<int>(&int_response_[0], kRows,
+                                           int_response_.size() / kRows);
+    }
+    params.observationids =
+        Span<int>(&observation_ids_[0], observation_ids_.size());
+    params.misc = Span<double>(&misc_[0], misc_.size());
+    params.misc_string = misc_string_;
+    params.parallel = kParallel;
+    params.xvalues = MatrixSpan<double>(&xvalues_[0], kRows, kVars);
+    params.xorder = Span<int>(&order_[0], order_.size());
+    params.variable_weight = Span<double>(&weights_[0], weights_.size());
+    params.variable_num_classes =
+        Span<int>(&var_classes_[0], var_classes_.size());
+    params.variable_monotonicity =
+        Span<int>(&monotonicity_[0], monotonicity_.size());
+    params.num_trainrows = kRows;
+    params.num_trainobservations = kRows;
+    params.num_features = kVars;
+    params.bagfraction = 0.5;
+    params.prior_coefficient_variation = 1000.0;
+    params.family = (family_ == "coxph_counting") ? "coxph" : family_;
+  }
+
+ private:
+  void MakeResponse(const std::vector<double>& kSignal) {
+    const int kRows = kSpec_.num_rows;
+    misc_.assign(1, gbm_platform::NA());
+    if ((family_ == "bernoulli") || (family_ == "adaboost") ||
+        (family_ == "huberized")) {
+      for (int row = 0; row < kRows; row++) {
+        response_.push_back(Uniform() < 1 / (1 + std::exp(1.5 - kSignal[row])));
+      }
+    } else if (family_ == "poisson") {
+      for (int row = 0; row < kRows; row++) {
+        // inversion of the Poisson distribution function
+        const double kMean = std::exp(kSignal[row] - 1);
+        double count = 0, prob = std::exp(-kMean), total = prob;
+        const double kU = Uniform();
+        while ((kU > total) && (count < 100)) {
+          count++;
+          prob *= kMean / count;
+          total += prob;
+        }
+        response_.push_back(count);
+      }
+    } else if ((family_ == "gamma") || (family_ == "tweedie")) {
+      for (int row = 0; row < kRows; row++) {
+        const bool kIsZero = (family_ == "tweedie") && (Uniform() < 0.3);
+        const double kGamma = -std::log(1.0 - Uniform());
+        response_.push_back(kIsZero ? 0.0 : kGamma * std::exp(kSignal[row]));
+      }
+      if (family_ == "tweedie") misc_[0] = 1.5;
+    } else if ((family_ == "coxph") || (family_ == "coxph_counting")) {
+      MakeSurvival(kSignal);
+    } else if (family_.compare(0, 8, "pairwise") == 0) {
+      // groups of kGroupSize items rated 0 to 4, no rank cutoff
+      misc_.clear();
+      for (int row = 0; row < kRows; row++) {
+        response_.push_back(
+            std::min(4.0, std::floor(kSignal[row] + 2 * Uniform())));
+        misc_.push_back(1 + row / kGroupSize);
+      }
+      misc_.push_back(0);
+    } else {
+      for (int row = 0; row < kRows; row++) {
+        response_.push_back(kSignal[row] + 0.5 * Normal());
+      }
+      if (family_ == "quantile") misc_[0] = 0.25;
+      if (family_ == "tdist") misc_[0] = 4;
+    }
+  }
+
+  // Survival times in a single stratum, right censored or in counting
+  // process form, with the strata and sort orders CoxPH expects.
+  void MakeSurvival(const std::vector<double>& kSignal) {
+    const int kRows = kSpec_.num_rows;
+    const bool kIsCounting = (family_ == "coxph_counting");
+    std::vector<double> start(kRows, 0.0), stop(kRows), status(kRows);
+    for (int row = 0; row < kRows; row++) {
+      stop[row] = -std::log(1.0 - Uniform()) * std::exp(-kSignal[row]);
+      status[row] = (Uniform() < 0.7);
+      if (kIsCounting) {
+        start[row] = stop[row] * Uniform();
+      }
+    }
+    if (kIsCounting) response_.insert(response_.end(), start.begin(),
+                                      start.end());
+    response_.insert(response_.end(), stop.begin(), stop.end());
+    response_.insert(response_.end(), status.begin(), status.end());
+
+    // the strata column counts the rows of the stratum, the sort columns
+    // order the rows by decreasing time
+    int_response_.assign(kRows, INT_MIN);
+    int_response_[0] = kRows;
+    const int kNumTimes = kIsCounting ? 2 : 1;
+    for (int times = 0; times < kNumTimes; times++) {
+      const std::vector<double>& kTimes =
+          (kIsCounting && (times == 0)) ? start : stop;
+      std::vector<std::pair<double, int> > by_time(kRows);
+      for (int row = 0; row < kRows; row++) {
+        by_time[row] = std::make_pair(-kTimes[row], row);
+      }
+      std::sort(by_time.begin(), by_time.end());
+      for (int row = 0; row < kRows; row++) {
+        int_response_.push_back(by_time[row].second);
+      }
+    }
+    misc_string_ = "efron";
+  }
+
+  const DataSpec kSpec_;
+  std::string family_;
+  std::vector<double> xvalues_, response_, weights_, misc_;
+  std::vector<int> order_, int_response_, observation_ids_, var_classes_,
+      monotonicity_;
+  std::string misc_string_;
+};
+
+//-----------------------------------
+// Function: BenchSplitSearch
+//
+// Returns: none
+//
+// Description: grows trees of kTreeDepth levels from Gaussian residuals,
+//   timing the split search and the reassignment of rows separately.
+//
+// Parameters:
+//  data - the synthetic data
+//  threads - the number of threads
+//  num_bins - the number of histogram bins, 0 for the exact search
+//  repeats - the number of trees grown
+//  results - the results, added to
+//-----------------------------------
+void BenchSplitSearch(SyntheticData& data, int threads, int num_bins,
+                      int repeats, std::vector<Result>& results) {
+  const parallel_details kParallel(threads, kChunkSize, num_bins);
+  DataDistParams params;
+  data.View(params, kParallel);
+  CGBMDataDistContainer container(params);
+  const CDataset& kData = container.get_data();
+
+  std::vector<double> func_estimate(kData.nrow(),
+                                    container.InitialFunctionEstimate());
+  std::vector<double> residuals(kData.nrow(), 0.0);
+  container.BagData();
+  container.ComputeResiduals(&func_estimate[0], residuals);
+
+  SplitterArenas arenas;
+  NodeArena nodes;
+  Result search("split_search", data.spec(), threads);
+  Result reassign("reassign_data", data.spec(), threads);
+  search.split_search = reassign.split_search =
+      (num_bins > 0) ? "histogram" : "exact";
+  for (int repeat = 0; repeat <= repeats; repeat++) {
+    double sumz = 0.0, totalw = 0.0;
+    for (unsigned long row = 0; row < kData.get_trainsize(); row++) {
+      if (container.get_bag().get_element(row)) {
+        sumz += kData.weight_ptr()[row] * residuals[row];
+        totalw += kData.weight_ptr()[row];
+      }
+    }
+    nodes.Reset(1 + 3 * kTreeDepth);
+    std::vector<CNode*> terminal_nodes(2 * kTreeDepth + 1, 0);
+    terminal_nodes[0] = nodes.AddNode(
+        NodeDef(sumz, totalw, container.get_bag().get_total_in_bag()));
+    std::vector<unsigned long> node_assignments(kData.get_trainsize(), 0);
+    CNodeSearch searcher(kData, container.get_bag(), kTreeDepth,
+                         kMinObsInNode, kParallel, arenas, nodes);
+
+    // a team of threads shares the searches, as in CCARTTree::Grow
+    double search_seconds = 0.0, reassign_seconds = 0.0;
+#pragma omp parallel num_threads(threads)
+    for (int depth = 0; depth < kTreeDepth; depth++) {
+      const double kStart = Now();
+      searcher.GenerateAllSplits(terminal_nodes, kData, residuals);
+      const double kSearched = Now();
+      const double kImprovement = searcher.CalcImprovementAndSplit(
+          terminal_nodes, kData, node_assignments);
+#pragma omp master
+      {
+        reassign_seconds += Now() - kSearched;
+        search_seconds += kSearched - kStart;
+      }
+      if (kImprovement <= 0) break;
+    }
+    // the first tree warms up
+    if (repeat > 0) {
+      search.add(search_seconds);
+      reassign.add(reassign_seconds);
+    }
+  }
+  results.push_back(search);
+  results.push_back(reassign);
+}
+
+//-----------------------------------
+// Function: BenchDistribution
+//
+// Returns: none
+//
+// Description: times a distribution's working response, deviance and
+//   best constants in the nodes of a tree grown from its residuals.
+//
+// Parameters:
+//  data - the synthetic data of the distribution
+//  kFamily - the distribution's name
+//  threads - the number of threads
+//  repeats - the number of repeats
+//  results - the results, added to
+//-----------------------------------
+void BenchDistribution(SyntheticData& data, const std::string& kFamily,
+                       int threads, int repeats, std::vector<Result>& results) {
+  const parallel_details kParallel(threads, kChunkSize);
+  DataDistParams params;
+  data.View(params, kParallel);
+  TreeParams tree_params(kTreeDepth, kMinObsInNode, 0.1,
+                         data.spec().num_rows, kParallel);
+  CGBMDataDistContainer container(params);
+  const CDataset& kData = container.get_data();
+
+  std::vector<double> func_estimate(kData.nrow(),
+                                    container.InitialFunctionEstimate());
+  std::vector<double> residuals(kData.nrow(), 0.0);
+  std::vector<double> delta_estimates(kData.nrow(), 0.0);
+  container.BagData();
+  container.ComputeResiduals(&func_estimate[0], residuals);
+  NodeArena nodes;
+  CCARTTree tree(tree_params, nodes);
+  SplitterArenas arenas;
+  tree.Grow(residuals, kData, container.get_bag(), delta_estimates, arenas);
+
+  Result working_response("working_response", data.spec(), threads);
+  Result deviance("deviance", data.spec(), threads);
+  Result best_constant("fit_best_constant", data.spec(), threads);
+  Result fused_update("fused_update", data.spec(), threads);
+  bool is_fused = false;
+  for (int repeat = 0; repeat <= repeats; repeat++) {
+    const double kStart = Now();
+    container.ComputeResiduals(&func_estimate[0], residuals);
+    const double kResiduals = Now();
+    container.ComputeDeviance(&func_estimate[0], false);
+    const double kDeviance = Now();
+    container.ComputeBestTermNodePreds(&func_estimate[0], residuals, tree);
+    const double kBestConstant = Now();
+    // the deltas are all zero, so the fit stays as it is
+    double oobag_improvement = 0.0, train_error = 0.0;
+    is_fused = container.FusedUpdate(&func_estimate[0], 0.1, delta_estimates,
+                                     residuals, oobag_improvement,
+                                     train_error);
+    const double kEnd = Now();
+    if (repeat > 0) {
+      working_response.add(kResiduals - kStart);
+      deviance.add(kDeviance - kResiduals);
+      best_constant.add(kBestConstant - kDeviance);
+      fused_update.add(kEnd - kBestConstant);
+    }
+  }
+  working_response.distribution = deviance.distribution =
+      best_constant.distribution = fused_update.distribution = kFamily;
+  results.push_back(working_response);
+  results.push_back(deviance);
+  results.push_back(best_constant);
+  if (is_fused) results.push_back(fused_update);
+}
+
+//-----------------------------------
+// Function: BenchPredict
+//
+// Returns: none
+//
+// Description: fits kNumPredictTrees Gaussian trees and times scoring the
+//   rows with them at each number of threads.
+//
+// Parameters:
+//  data - the synthetic data
+//  kThreads - the numbers of threads
+//  repeats - the number of repeats
+//  results - the results, added to
+//-----------------------------------
+void BenchPredict(SyntheticData& data, const std::vector<int>& kThreads,
+                  int repeats, std::vector<Result>& results) {
+  const parallel_details kFitParallel(kThreads.back(), kChunkSize);
+  DataDistParams params;
+  data.View(params, kFitParallel);
+  TreeParams tree_params(kTreeDepth, kMinObsInNode, 0.1,
+                         data.spec().num_rows, kFitParallel);
+  CGBMEngine gbm(params, tree_params);
+  const double kNoEstimate = gbm_platform::NA();
+  GbmFit fit(data.spec().num_rows, gbm.initial_function_estimate(),
+             kNumPredictTrees, Span<const double>(&kNoEstimate, 1));
+  for (int tree = 0; tree < kNumPredictTrees; tree++) {
+    fit.accumulate(gbm);
+    fit.CreateTreeRepresentation(0);
+    fit.increment_count();
+  }
+  const CompiledModel kModel(fit.trees(), fit.split_codes(),
+                             Span<const int>(&data.var_classes()[0],
+                                             data.var_classes().size()));
+
+  std::vector<double> predictions(data.spec().num_rows);
+  for (unsigned long ind = 0; ind < kThreads.size(); ind++) {
+    const parallel_details kParallel(kThreads[ind], kChunkSize);
+    Result predict("predict", data.spec(), kThreads[ind]);
+    for (int repeat = 0; repeat <= repeats; repeat++) {
+      const double kStart = Now();
+      kModel.Predict(data.xvalues(), data.spec().num_rows, &kNumPredictTrees,
+                     1, fit.initial_estimate(), false, kParallel,
+                     &predictions[0]);
+      if (repeat > 0) predict.add(Now() - kStart);
+    }
+    results.push_back(predict);
+  }
+}
+
+//-----------------------------------
+// Function: BenchFit
+//
+// Returns: none
+//
+// Description: times Gaussian fits of num_trees trees of kTreeDepth
+//   levels, without keeping the trees.
+//
+// Parameters:
+//  data - the synthetic data
+//  threads - the number of threads
+//  num_trees - the number of trees of each fit
+//  repeats - the number of fits
+//  results - the results, added to
+//-----------------------------------
+void BenchFit(SyntheticData& data, int threads, int num_trees, int repeats,
+              std::vector<Result>& results) {
+  const parallel_details kParallel(threads, kChunkSize);
+  DataDistParams params;
+  data.View(params, kParallel);
+  TreeParams tree_params(kTreeDepth, kMinObsInNode, 0.01,
+                         data.spec().num_rows, kParallel);
+
+  Result fit("fit", data.spec(), threads);
+  fit.trees = num_trees;
+  for (int repeat = 0; repeat < repeats; repeat++) {
+    CGBMEngine gbm(params, tree_params);
+    std::vector<double> func_estimate(data.spec().num_rows,
+                                      gbm.initial_function_estimate());
+    const double kStart = Now();
+    for (int tree = 0; tree < num_trees; tree++) {
+      std::auto_ptr<FittedLearner> learner(gbm.FitLearner(&func_estimate[0]));
+    }
+    fit.add(Now() - kStart);
+  }
+  results.push_back(fit);
+}
+
+void WriteJson(std::ostream& out, const std::vector<Result>& kResults,
+               bool is_quick) {
+  int max_threads = 1;
+#ifdef _OPENMP
+  max_threads = omp_get_max_threads();
+#endif
+  out << "{\n  \"format\": \"gbm-bench\",\n  \"version\": 1,\n"
+      << "  \"quick\": " << (is_quick ? "true" : "false") << ",\n"
+      << "  \"max_threads\": " << max_threads << ",\n"
+      << "  \"tree_depth\": " << kTreeDepth << ",\n"
+      << "  \"math_kernels\": \""
+      << gbm_vector_math::KernelsName(gbm_vector_math::BestKernels())
+      << "\",\n"
+      << "  \"results\": [";
+  out.precision(6);
+  for (unsigned long ind = 0; ind < kResults.size(); ind++) {
+    const Result& kResult = kResults[ind];
+    out << (ind ? "," : "") << "\n    {\"benchmark\": \"" << kResult.benchmark
+        << "\"";
+    if (!kResult.distribution.empty()) {
+      out << ", \"distribution\": \"" << kResult.distribution << "\"";
+    }
+    if (!kResult.split_search.empty()) {
+      out << ", \"split_search\": \"" << kResult.split_search << "\"";
+    }
+    if (kResult.trees > 0) {
+      out << ", \"trees\": " << kResult.trees;
+    }
+    out << ", \"rows\": " << kResult.spec.num_rows
+        << ", \"predictors\": " << kResult.spec.num_vars
+        << ", \"levels\": " << kResult.spec.num_levels
+        << ", \"missing_rate\": " << kResult.spec.missing_rate
+        << ", \"threads\": " << kResult.threads
+        << ", \"repeats\": " << kResult.repeats
+        << ", \"best_seconds\": " << kResult.best
+        << ", \"mean_seconds\": " << kResult.mean << ", \"rows_per_second\": "
+        << ((kResult.best > 0) ? kResult.spec.num_rows / kResult.best : 0.0)
+        << "}";
+  }
+  out << "\n  ]\n}\n";
+}
+
+std::vector<int> ParseThreads(const std::string& kList) {
+  std::vector<int> threads;
+  std::istringstream in(kList);
+  std::string item;
+  while (std::getline(in, item, ',')) {
+    const int kThreads = std::atoi(item.c_str());
+    if (kThreads <= 0) {
+      throw gbm_exception::InvalidArgument("threads must be positive");
+    }
+    threads.push_back(kThreads);
+  }
+  if (threads.empty()) {
+    throw gbm_exception::InvalidArgument("no numbers of threads given");
+  }
+  std::sort(threads.begin(), threads.end());
+  return threads;
+}
+}
+
+int main(int argc, char** argv) {
+  bool is_quick = false;
+  int repeats = 5;
+  std::string output;
+  std::string thread_list = "1";
+#ifdef _OPENMP
+  {
+    std::ostringstream threads;
+    threads << "1";
+    for (int num = 2; num <= omp_get_max_threads(); num *= 2) {
+      threads << "," << num;
+    }
+    thread_list = threads.str();
+  }
+#endif
+
+  try {
+    for (int arg = 1; arg < argc; arg++) {
+      const std::string kArg(argv[arg]);
+      const bool kHasValue = (arg + 1 < argc);
+      if (kArg == "--quick") {
+        is_quick = true;
+      } else if ((kArg == "--threads") && kHasValue) {
+        thread_list = argv[++arg];
+      } else if ((kArg == "--repeats") && kHasValue) {
+        repeats = std::max(1, std::atoi(argv[++arg]));
+      } else if ((kArg == "--output") && kHasValue) {
+        output = argv[++arg];
+      } else {
+        std::fprintf(stderr,
+                     "usage: gbm-bench [--quick] [--threads 1,2,4] "
+                     "[--repeats 5] [--output results.json]\n");
+        return 2;
+      }
+    }
+    const std::vector<int> kThreads = ParseThreads(thread_list);
+
+    std::vector<int> rows, vars, levels;
+    std::vector<double> missing;
+    if (is_quick) {
+      rows.push_back(5000);
+      vars.push_back(10);
+      levels.push_back(0);
+      levels.push_back(16);
+      missing.push_back(0.1);
+    } else {
+      rows.push_back(10000);
+      rows.push_back(100000);
+      vars.push_back(10);
+      vars.push_back(50);
+      levels.push_back(0);
+      levels.push_back(8);
+      levels.push_back(64);
+      missing.push_back(0.0);
+      missing.push_back(0.2);
+    }
+
+    std::vector<Result> results;
+    for (unsigned long n = 0; n < rows.size(); n++) {
+      for (unsigned long p = 0; p < vars.size(); p++) {
+        for (unsigned long l = 0; l < levels.size(); l++) {
+          for (unsigned long m = 0; m < missing.size(); m++) {
+            const DataSpec kSpec(rows[n], vars[p], levels[l], missing[m]);
+            std::fprintf(stderr, "split search and predict: n=%d p=%d "
+                         "levels=%d missing=%g\n", kSpec.num_rows,
+                         kSpec.num_vars, kSpec.num_levels,
+                         kSpec.missing_rate);
+            SyntheticData data(kSpec, "gaussian");
+            for (unsigned long t = 0; t < kThreads.size(); t++) {
+              BenchSplitSearch(data, kThreads[t], 0, repeats, results);
+              BenchSplitSearch(data, kThreads[t], 256, repeats, results);
+            }
+            BenchPredict(data, kThreads, repeats, results);
+          }
+        }
+      }
+    }
+
+    const char* kFamilies[] = {
+        "gaussian", "bernoulli", "poisson",  "adaboost",
+        "laplace",  "quantile",  "tdist",    "huberized",
+        "gamma",    "tweedie",   "coxph",    "coxph_counting",
+        "pairwise_ndcg"};
+    const DataSpec kDistSpec(rows.back(), vars.front(), 0, 0.0);
+    for (unsigned long dist = 0; dist < sizeof(kFamilies) / sizeof(char*);
+         dist++) {
+      std::fprintf(stderr, "distribution: %s\n", kFamilies[dist]);
+      SyntheticData data(kDistSpec, kFamilies[dist]);
+      for (unsigned long t = 0; t < kThreads.size(); t++) {
+        BenchDistribution(data, kFamilies[dist], kThreads[t], repeats,
+                          results);
+      }
+    }
+
+    // fits of many small trees - the full run fits 10000 trees once
+    const DataSpec kFitSpec(kFitRows, kFitVars, 0, 0.0);
+    std::fprintf(stderr, "fit: n=%d p=%d\n", kFitSpec.num_rows,
+                 kFitSpec.num_vars);
+    SyntheticData fit_data(kFitSpec, "gaussian");
+    for (unsigned long t = 0; t < kThreads.size(); t++) {
+      if (is_quick) {
+        BenchFit(fit_data, kThreads[t], 500, repeats, results);
+      } else {
+        BenchFit(fit_data, kThreads[t], 10000, 1, results);
+      }
+    }
+
+    if (output.empty()) {
+      WriteJson(std::cout, results, is_quick);
+    } else {
+      std::ofstream out(output.c_str());
+      WriteJson(out, results, is_quick);
+      if (!out) {
+        throw gbm_exception::InvalidArgument("cannot write " + output);
+      }
+    }
+  } catch (std::exception& error) {
+    std::fprintf(stderr, "gbm-bench: %s\n", error.what());
+    return 1;
+  }
+  return 0;
+}
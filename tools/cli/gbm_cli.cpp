@@ -0,0 +1,470 @@
+//-----------------------------------
+//
+// File: gbm_cli.cpp
+//
+// Description: command line front end to the gbm engine, without R.
+//   Trains a model on a data file and writes it as a model file, or
+//   predicts a data file from a model file.
+//
+//   gbm-cli train --data FILE --response NAME|COLUMN --model FILE
+//                 [--distribution gaussian] [--trees 100] [--depth 1]
+//                 [--shrinkage 0.001] [--bag 0.5] [--min-obs 10]
+//                 [--train-fraction 1] [--threads 1] [--bins 0]
+//                 [--seed 1] [--misc VALUE] [--categorical NAME,...]
+//                 [--verbose] [--trace FILE]
+//   gbm-cli predict --model FILE --data FILE [--response NAME|COLUMN]
+//                   [--trees N] [--threads 1] [--output FILE]
+//
+//   Data files are CSV with a header row, NA or empty fields missing, or
+//   binary: "GBMDATA\0", the numbers of rows and columns as 32 bit
+//   unsigned integers and the values as column-major doubles, the
+//   columns named V1, V2, ...  Categorical columns hold level codes from
+//   0.  The CoxPH and pairwise distributions need data the files cannot
+//   carry and are not supported.  --trace writes a Chrome trace of what
+//   each thread did while training.
+//
+//-----------------------------------
+
+//-----------------------------------
+// Includes
+//-----------------------------------
+#include "compiled_model.h"
+#include "datadistparams.h"
+#include "gbm_engine.h"
+#include "gbm_exception.h"
+#include "gbm_fit.h"
+#include "gbm_functions.h"
+#include "gbm_platform.h"
+#include "model_file.h"
+#include "parallel_details.h"
+#include "span.h"
+#include "trace.h"
+#include "treeparams.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+// A data file read into memory, column-major.
+struct DataTable {
+  std::vector<std::string> names;
+  std::vector<double> values;
+  int num_rows;
+  int num_cols;
+
+  DataTable() : num_rows(0), num_cols(0) {}
+  const double* column(int col) const {
+    return &values[0] + (long)col * num_rows;
+  }
+};
+
+// Options given as --name value, or --name alone for flags.
+class Options {
+ public:
+  Options(int argc, char** argv) {
+    for (int arg = 2; arg < argc; arg++) {
+      const std::string kName(argv[arg]);
+      if (kName.compare(0, 2, "--") != 0) {
+        throw gbm_exception::InvalidArgument("unexpected argument " + kName);
+      }
+      if ((arg + 1 < argc) && (std::strncmp(argv[arg + 1], "--", 2) != 0)) {
+        values_[kName.substr(2)] = argv[++arg];
+      } else {
+        values_[kName.substr(2)] = "";
+      }
+    }
+  }
+
+  bool has(const std::string& kName) const {
+    return values_.find(kName) != values_.end();
+  }
+
+  std::string get(const std::string& kName,
+                  const std::string& kDefault) const {
+    std::map<std::string, std::string>::const_iterator it =
+        values_.find(kName);
+    return (it == values_.end()) ? kDefault : it->second;
+  }
+
+  std::string get(const std::string& kName) const {
+    if (!has(kName) || get(kName, "").empty()) {
+      throw gbm_exception::InvalidArgument("--" + kName + " is required");
+    }
+    return get(kName, "");
+  }
+
+  double number(const std::string& kName, double default_value) const {
+    if (!has(kName)) return default_value;
+    const std::string kValue = get(kName);
+    char* end = NULL;
+    const double kNumber = std::strtod(kValue.c_str(), &end);
+    if (*end != '\0') {
+      throw gbm_exception::InvalidArgument("--" + kName +
+                                           " must be a number");
+    }
+    return kNumber;
+  }
+
+ private:
+  std::map<std::string, std::string> values_;
+};
+
+std::vector<std::string> SplitFields(const std::string& kLine, char sep) {
+  std::vector<std::string> fields;
+  std::string::size_type start = 0;
+  while (true) {
+    const std::string::size_type kEnd = kLine.find(sep, start);
+    std::string field = kLine.substr(start, kEnd - start);
+    // trim spaces and quotes
+    const std::string::size_type kFirst = field.find_first_not_of(" \t\"\r");
+    const std::string::size_type kLast = field.find_last_not_of(" \t\"\r");
+    fields.push_back((kFirst == std::string::npos)
+                         ? std::string()
+                         : field.substr(kFirst, kLast - kFirst + 1));
+    if (kEnd == std::string::npos) break;
+    start = kEnd + 1;
+  }
+  return fields;
+}
+
+void ReadBinary(std::ifstream& in, const std::string& kPath,
+                DataTable& table) {
+  unsigned int sizes[2];
+  in.read(reinterpret_cast<char*>(sizes), sizeof(sizes));
+  table.num_rows = sizes[0];
+  table.num_cols = sizes[1];
+  table.values.resize((unsigned long)sizes[0] * sizes[1]);
+  if (!table.values.empty()) {
+    in.read(reinterpret_cast<char*>(&table.values[0]),
+            table.values.size() * sizeof(double));
+  }
+  if (!in) {
+    throw gbm_exception::InvalidArgument("cannot read data file " + kPath);
+  }
+  for (int col = 0; col < table.num_cols; col++) {
+    std::ostringstream name;
+    name << "V" << col + 1;
+    table.names.push_back(name.str());
+  }
+}
+
+void ReadCsv(std::ifstream& in, const std::string& kPath, DataTable& table) {
+  std::string line;
+  if (!std::getline(in, line)) {
+    throw gbm_exception::InvalidArgument("empty data file " + kPath);
+  }
+  table.names = SplitFields(line, ',');
+  table.num_cols = table.names.size();
+
+  // read row-major, then transpose
+  std::vector<double> rows;
+  while (std::getline(in, line)) {
+    if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+    const std::vector<std::string> kFields = SplitFields(line, ',');
+    if (int(kFields.size()) != table.num_cols) {
+      std::ostringstream message;
+      message << kPath << " line " << table.num_rows + 2 << " has "
+              << kFields.size() << " fields, not " << table.num_cols;
+      throw gbm_exception::InvalidArgument(message.str());
+    }
+    for (int col = 0; col < table.num_cols; col++) {
+      if (kFields[col].empty() || (kFields[col] == "NA")) {
+        rows.push_back(gbm_platform::NA());
+        continue;
+      }
+      char* end = NULL;
+      rows.push_back(std::strtod(kFields[col].c_str(), &end));
+      if (*end != '\0') {
+        throw gbm_exception::InvalidArgument(
+            kPath + " has a value that is not a number: " + kFields[col]);
+      }
+    }
+    table.num_rows++;
+  }
+
+  table.values.resize(rows.size());
+  for (int row = 0; row < table.num_rows; row++) {
+    for (int col = 0; col < table.num_cols; col++) {
+      table.values[(long)col * table.num_rows + row] =
+          rows[(long)row * table.num_cols + col];
+    }
+  }
+}
+
+void ReadData(const std::string& kPath, DataTable& table) {
+  std::ifstream in(kPath.c_str(), std::ios::in | std::ios::binary);
+  if (!in) {
+    throw gbm_exception::InvalidArgument("cannot open data file " + kPath);
+  }
+  char magic[8] = {0};
+  in.read(magic, sizeof(magic));
+  if (in && (std::memcmp(magic, "GBMDATA\0", sizeof(magic)) == 0)) {
+    ReadBinary(in, kPath, table);
+  } else {
+    in.clear();
+    in.seekg(0, std::ios::beg);
+    ReadCsv(in, kPath, table);
+  }
+  if (table.num_rows == 0) {
+    throw gbm_exception::InvalidArgument("no rows in data file " + kPath);
+  }
+}
+
+// The column named, or numbered from 1.
+int FindColumn(const DataTable& kTable, const std::string& kName) {
+  for (int col = 0; col < kTable.num_cols; col++) {
+    if (kTable.names[col] == kName) return col;
+  }
+  const int kNumber = std::atoi(kName.c_str());
+  if ((kNumber >= 1) && (kNumber <= kTable.num_cols)) return kNumber - 1;
+  throw gbm_exception::InvalidArgument("no column " + kName);
+}
+
+// The predictors - the columns other than the response, if any.
+void SelectPredictors(const DataTable& kTable, int response_col,
+                      std::vector<int>& predictor_cols,
+                      std::vector<double>& predictors) {
+  for (int col = 0; col < kTable.num_cols; col++) {
+    if (col == response_col) continue;
+    predictor_cols.push_back(col);
+    predictors.insert(predictors.end(), kTable.column(col),
+                      kTable.column(col) + kTable.num_rows);
+  }
+}
+
+void Message(const char* kMessage) { std::fputs(kMessage, stderr); }
+
+//-----------------------------------
+// Function: Train
+//
+// Returns: none
+//
+// Description: fits a model as gbm() does with its defaults and writes
+//   it as a model file.  The first rows are used for training, the rest
+//   for validation.
+//
+// Parameters:
+//  kOptions - the command line options
+//-----------------------------------
+void Train(const Options& kOptions) {
+  DataTable table;
+  ReadData(kOptions.get("data"), table);
+  const int kResponseCol = FindColumn(table, kOptions.get("response"));
+  std::vector<int> predictor_cols;
+  std::vector<double> xvalues;
+  SelectPredictors(table, kResponseCol, predictor_cols, xvalues);
+  std::vector<double> response(table.column(kResponseCol),
+                               table.column(kResponseCol) + table.num_rows);
+
+  // the columns have been copied out of the table
+  std::vector<double>().swap(table.values);
+
+  const std::string kFamily = kOptions.get("distribution", "gaussian");
+  if ((kFamily == "coxph") || (kFamily.compare(0, 8, "pairwise") == 0)) {
+    throw gbm_exception::InvalidArgument(kFamily +
+                                         " is not supported from files");
+  }
+  const int kNumRows = table.num_rows;
+  const int kNumVars = predictor_cols.size();
+  const int kNumTrees = int(kOptions.number("trees", 100));
+  const int kNumTrainRows =
+      int(kOptions.number("train-fraction", 1.0) * kNumRows);
+  if ((kNumVars == 0) || (kNumTrainRows <= 0) || (kNumTrees <= 0)) {
+    throw gbm_exception::InvalidArgument(
+        "need predictors, training rows and trees");
+  }
+
+  // categorical predictors hold level codes from 0
+  std::vector<int> var_classes(kNumVars, 0);
+  if (kOptions.has("categorical")) {
+    const std::vector<std::string> kNames =
+        SplitFields(kOptions.get("categorical"), ',');
+    for (unsigned long ind = 0; ind < kNames.size(); ind++) {
+      const int kCol = FindColumn(table, kNames[ind]);
+      int var = 0;
+      while ((var < kNumVars) && (predictor_cols[var] != kCol)) var++;
+      if (var == kNumVars) {
+        throw gbm_exception::InvalidArgument(
+            "the response cannot be categorical");
+      }
+      for (int row = 0; row < kNumRows; row++) {
+        const double kLevel = xvalues[(long)var * kNumRows + row];
+        if (gbm_platform::IsNA(kLevel)) continue;
+        if ((kLevel < 0) || (kLevel != int(kLevel))) {
+          throw gbm_exception::InvalidArgument(
+              "categorical column " + kNames[ind] +
+              " must hold level codes from 0");
+        }
+        var_classes[var] = std::max(var_classes[var], int(kLevel) + 1);
+      }
+    }
+  }
+
+  const parallel_details kParallel(int(kOptions.number("threads", 1)), 1024,
+                                   int(kOptions.number("bins", 0)));
+  // the histogram split search bins the predictors without their order
+  std::vector<int> order;
+  if (!kParallel.use_histograms()) {
+    order.resize((long)kNumTrainRows * kNumVars);
+    gbm_functions::OrderPredictors(
+        MatrixSpan<const double>(&xvalues[0], kNumRows, kNumVars),
+        kNumTrainRows, kParallel.get_num_threads(), &order[0]);
+  }
+
+  // every row is an observation of its own, of weight 1 and no offset
+  std::vector<int> observation_ids(kNumRows);
+  for (int row = 0; row < kNumRows; row++) observation_ids[row] = row;
+  std::vector<double> weights(kNumRows, 1.0);
+  std::vector<int> monotonicity(kNumVars, 0);
+  std::vector<double> misc(1, kOptions.number("misc", gbm_platform::NA()));
+
+  DataDistParams datadistparams;
+  datadistparams.response = MatrixSpan<double>(&response[0], kNumRows, 1);
+  datadistparams.observationids =
+      Span<int>(&observation_ids[0], observation_ids.size());
+  datadistparams.misc = Span<double>(&misc[0], misc.size());
+  datadistparams.parallel = kParallel;
+  datadistparams.xvalues =
+      MatrixSpan<double>(&xvalues[0], kNumRows, kNumVars);
+  if (!order.empty()) {
+    datadistparams.xorder = Span<int>(&order[0], order.size());
+  }
+  datadistparams.variable_weight = Span<double>(&weights[0], weights.size());
+  datadistparams.variable_num_classes =
+      Span<int>(&var_classes[0], var_classes.size());
+  datadistparams.variable_monotonicity =
+      Span<int>(&monotonicity[0], monotonicity.size());
+  datadistparams.num_trainrows = kNumTrainRows;
+  datadistparams.num_trainobservations = kNumTrainRows;
+  datadistparams.num_features = kNumVars;
+  datadistparams.bagfraction = kOptions.number("bag", 0.5);
+  datadistparams.family = kFamily;
+  TreeParams treeparams(int(kOptions.number("depth", 1)),
+                        int(kOptions.number("min-obs", 10)),
+                        kOptions.number("shrinkage", 0.001), kNumTrainRows,
+                        kParallel);
+
+  gbm_platform::SetSeed(int(kOptions.number("seed", 1)));
+  TraceSession trace(kOptions.has("trace") ? kOptions.get("trace") : "",
+                     kParallel.get_num_threads());
+  CGBMEngine gbm(datadistparams, treeparams);
+
+  // binned predictors are trained from their codes alone
+  if (kParallel.use_histograms()) {
+    std::vector<double>().swap(xvalues);
+  }
+  const double kNoEstimate = gbm_platform::NA();
+  GbmFit gbmfit(kNumRows, gbm.initial_function_estimate(), kNumTrees,
+                Span<const double>(&kNoEstimate, 1));
+
+  const bool kIsVerbose = kOptions.has("verbose");
+  if (kIsVerbose) {
+    gbm_platform::Printf(
+        "Iter   TrainDeviance   ValidDeviance   StepSize   Improve\n");
+  }
+  for (int treenum = 0; treenum < kNumTrees; treenum++) {
+    TraceScope tree_scope("tree", "tree", treenum + 1);
+    gbmfit.accumulate(gbm);
+    gbmfit.CreateTreeRepresentation(0);
+    if (kIsVerbose && ((treenum <= 9) || (0 == (treenum + 1) % 20) ||
+                       (treenum == kNumTrees - 1))) {
+      gbm_platform::Printf("%6d %13.4f %15.4f %10.4f %9.4f\n", treenum + 1,
+                           gbmfit.get_tree_training_error(),
+                           gbmfit.get_tree_valid_error(),
+                           treeparams.shrinkage,
+                           gbmfit.get_tree_oobag_improv());
+    }
+    gbmfit.increment_count();
+  }
+  trace.Finish();
+
+  const CompiledModel kModel(
+      gbmfit.trees(), gbmfit.split_codes(),
+      Span<const int>(&var_classes[0], var_classes.size()));
+  ModelFile::Write(kModel, gbmfit.initial_estimate(), kOptions.get("model"));
+}
+
+//-----------------------------------
+// Function: Predict
+//
+// Returns: none
+//
+// Description: predicts the rows of a data file from a model file, one
+//   prediction a line, on the scale of the model's function estimate.
+//
+// Parameters:
+//  kOptions - the command line options
+//-----------------------------------
+void Predict(const Options& kOptions) {
+  std::auto_ptr<ModelFile> file(new ModelFile(kOptions.get("model")));
+  const double kInitialEstimate = file->initial_estimate();
+  const CompiledModel kModel(file);
+
+  DataTable table;
+  ReadData(kOptions.get("data"), table);
+  const int kResponseCol = kOptions.has("response")
+                               ? FindColumn(table, kOptions.get("response"))
+                               : -1;
+  std::vector<int> predictor_cols;
+  std::vector<double> xvalues;
+  SelectPredictors(table, kResponseCol, predictor_cols, xvalues);
+  if (int(predictor_cols.size()) != kModel.num_vars()) {
+    throw gbm_exception::InvalidArgument(
+        "the data do not have the model's number of predictors");
+  }
+
+  const int kNumTrees = int(kOptions.number("trees", kModel.num_trees()));
+  const parallel_details kParallel(int(kOptions.number("threads", 1)), 1024);
+  std::vector<double> predictions(table.num_rows);
+  kModel.Predict(&xvalues[0], table.num_rows, &kNumTrees, 1,
+                 kInitialEstimate, false, kParallel, &predictions[0]);
+
+  std::ofstream file_out;
+  if (kOptions.has("output")) {
+    file_out.open(kOptions.get("output").c_str());
+    if (!file_out) {
+      throw gbm_exception::InvalidArgument("cannot write " +
+                                           kOptions.get("output"));
+    }
+  }
+  std::ostream& out = kOptions.has("output") ? file_out : std::cout;
+  out.precision(17);
+  for (int row = 0; row < table.num_rows; row++) {
+    out << predictions[row] << "\n";
+  }
+}
+}
+
+int main(int argc, char** argv) {
+  const std::string kCommand = (argc > 1) ? argv[1] : "";
+  if ((kCommand != "train") && (kCommand != "predict")) {
+    std::fprintf(stderr,
+                 "usage: gbm-cli train --data FILE --response COLUMN "
+                 "--model FILE [options]\n"
+                 "       gbm-cli predict --model FILE --data FILE "
+                 "[options]\n");
+    return 2;
+  }
+
+  gbm_platform::set_message_writer(Message);
+  try {
+    const Options kOptions(argc, argv);
+    if (kCommand == "train") {
+      Train(kOptions);
+    } else {
+      Predict(kOptions);
+    }
+  } catch (std::exception& error) {
+    std::fprintf(stderr, "gbm-cli: %s\n", error.what());
+    return 1;
+  }
+  return 0;
+}